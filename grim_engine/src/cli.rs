@@ -2,6 +2,8 @@ use std::path::PathBuf;
 
 use clap::Parser;
 
+use crate::lua_host::DEFAULT_MAX_CATCH_UP;
+
 #[derive(Parser, Debug)]
 #[command(about = "Minimal host for driving the Grim intro sequence", version)]
 struct Args {
@@ -28,6 +30,14 @@ struct Args {
     /// Path to a file that unblocks the live stream loop once the retail capture is ready
     #[arg(long, value_hint = clap::ValueHint::FilePath)]
     stream_ready_file: Option<PathBuf>,
+
+    /// Time every script resume and write a sorted report here (plus a Chrome trace beside it)
+    #[arg(long, value_hint = clap::ValueHint::FilePath)]
+    profile_scripts: Option<PathBuf>,
+
+    /// Most ticks simulated back to back after a slow frame; older backlog is dropped
+    #[arg(long, value_name = "TICKS", default_value_t = DEFAULT_MAX_CATCH_UP)]
+    max_catch_up: u32,
 }
 
 #[derive(Debug, Clone)]
@@ -38,6 +48,8 @@ pub struct RunLuaArgs {
     pub lab_root: Option<PathBuf>,
     pub stream_bind: Option<String>,
     pub stream_ready_file: Option<PathBuf>,
+    pub profile_scripts: Option<PathBuf>,
+    pub max_catch_up: u32,
 }
 
 pub fn parse() -> RunLuaArgs {
@@ -49,5 +61,7 @@ pub fn parse() -> RunLuaArgs {
         lab_root: args.lab_root,
         stream_bind: args.stream_bind,
         stream_ready_file: args.stream_ready_file,
+        profile_scripts: args.profile_scripts,
+        max_catch_up: args.max_catch_up,
     }
 }
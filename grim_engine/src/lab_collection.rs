@@ -1,8 +1,9 @@
+use std::borrow::Cow;
 use std::fs;
 use std::path::Path;
 
 use anyhow::{bail, Context, Result};
-use grim_formats::{LabArchive, LabEntry};
+use grim_formats::{AssetSource, LabArchive, LabEntry};
 
 /// Slim wrapper around the retail LAB archives we need for the intro sequence.
 #[derive(Debug)]
@@ -60,3 +61,10 @@ impl LabCollection {
         None
     }
 }
+
+impl AssetSource for LabCollection {
+    fn read_asset(&self, name: &str) -> Option<Cow<'_, [u8]>> {
+        self.find_entry(name)
+            .map(|(archive, entry)| Cow::Borrowed(archive.read_entry_bytes(entry)))
+    }
+}
@@ -1,12 +1,14 @@
 use std::cell::RefCell;
-use std::collections::{BTreeMap, HashMap};
+use std::collections::{BTreeMap, BTreeSet, HashMap};
 use std::path::{Path, PathBuf};
 use std::rc::Rc;
+use std::sync::Arc;
 
 mod achievements;
 mod actors;
 mod audio;
 mod bindings;
+mod costumes;
 mod cutscenes;
 mod geometry;
 mod geometry_export;
@@ -15,6 +17,9 @@ mod menus;
 mod movement;
 mod objects;
 mod pause;
+mod preload;
+mod profiler;
+mod scheduler;
 mod scripts;
 mod sets;
 
@@ -22,6 +27,7 @@ use achievements::{AchievementRuntime, AchievementRuntimeAdapter, AchievementRun
 use actors::{runtime::ActorRuntime, ActorSnapshot, ActorStore};
 pub use audio::AudioCallback;
 use audio::{AudioRuntime, AudioRuntimeAdapter, AudioRuntimeView, MusicState, SfxState};
+use costumes::CostumeRuntime;
 use cutscenes::{
     CommentaryRecord, CutsceneRuntime, CutsceneRuntimeAdapter, CutsceneRuntimeView, DialogState,
     FullscreenMoviePlayback,
@@ -32,6 +38,8 @@ use menus::{MenuRegistry, MenuRegistryView, MenuState};
 use movement::{MovementRuntimeAdapter, MovementRuntimeView};
 use objects::{ObjectRuntime, ObjectRuntimeAdapter, ObjectSnapshot};
 use pause::{PauseLabel, PauseRuntimeView, PauseState};
+use profiler::ScriptProfiler;
+use scheduler::WaitCondition;
 use scripts::{ScriptCleanup, ScriptRuntime, ScriptRuntimeAdapter, ScriptRuntimeView};
 use sets::{SectorToggleResult, SetRuntime, SetRuntimeAdapter, SetRuntimeSnapshot, SetRuntimeView};
 
@@ -45,6 +53,7 @@ use super::types::{Vec3, MANNY_OFFICE_SEED_POS, MANNY_OFFICE_SEED_ROT};
 use crate::geometry_snapshot::LuaGeometrySnapshot;
 use crate::lab_collection::LabCollection;
 use crate::stream::StreamServer;
+use anyhow::Result;
 use grim_analysis::resources::{ResourceGraph, SetMetadata};
 use grim_stream::{MovieAction, MovieControl, MovieStart};
 use mlua::RegistryKey;
@@ -469,10 +478,12 @@ pub(super) struct EngineContext {
     install_root: PathBuf,
     stream: Option<Rc<StreamServer>>,
     scripts: ScriptRuntime,
+    script_profiler: Option<ScriptProfiler>,
     events: Vec<String>,
     coverage: CoverageTracker,
     sets: SetRuntime,
     actors: ActorStore,
+    costumes: CostumeRuntime,
     inventory: InventoryState,
     menus: MenuRegistry,
     voice_effect: Option<String>,
@@ -487,21 +498,24 @@ impl EngineContext {
     pub(super) fn new(
         resources: Rc<ResourceGraph>,
         verbose: bool,
-        lab_collection: Option<Rc<LabCollection>>,
+        lab_collection: Option<Arc<LabCollection>>,
         audio_callback: Option<Rc<dyn AudioCallback>>,
         install_root: PathBuf,
     ) -> Self {
         let coverage = CoverageTracker::from_resources(&resources);
+        let costumes = CostumeRuntime::new(verbose, lab_collection.clone());
         let sets = SetRuntime::new(resources.clone(), verbose, lab_collection);
         EngineContext {
             verbose,
             install_root,
             stream: None,
             scripts: ScriptRuntime::new(),
+            script_profiler: None,
             events: Vec::new(),
             coverage,
             sets,
             actors: ActorStore::new(1100),
+            costumes,
             inventory: InventoryState::new(),
             menus: MenuRegistry::new(),
             voice_effect: None,
@@ -943,6 +957,113 @@ impl EngineContext {
         self.script_runtime().complete_script(handle)
     }
 
+    /// Advances the scheduler clock by one engine tick: wakes sleepers whose
+    /// deadline passed and polls the fullscreen movie for parked waiters.
+    /// Only `EngineRuntime` calls this, so sleeps measure frames rather than
+    /// how often scripts happen to be driven.
+    pub(super) fn advance_script_clock(&mut self) {
+        self.script_runtime().scheduler().begin_tick();
+        self.advance_movie_waiters();
+    }
+
+    fn restore_script_budget(&mut self, max_yields: u32) {
+        self.script_runtime().restore_budget(max_yields);
+    }
+
+    fn running_script(&self) -> Option<u32> {
+        self.script_view().running()
+    }
+
+    fn take_runnable_scripts(&mut self) -> BTreeSet<u32> {
+        self.script_runtime().scheduler().take_runnable()
+    }
+
+    fn requeue_script(&mut self, handle: u32) {
+        self.script_runtime().scheduler().requeue(handle);
+    }
+
+    fn exhaust_script(&mut self, handle: u32) {
+        self.script_runtime().scheduler().exhaust(handle);
+    }
+
+    fn enter_script(&mut self, handle: u32) -> Option<u32> {
+        if let Some(profiler) = self.script_profiler.as_mut() {
+            profiler.begin_resume(handle);
+        }
+        self.script_runtime().scheduler().enter(handle)
+    }
+
+    fn leave_script(&mut self, handle: u32, previous: Option<u32>) {
+        self.script_runtime().scheduler().leave(previous);
+        if let Some(profiler) = self.script_profiler.as_mut() {
+            let label = self.scripts.label(handle).unwrap_or("<completed>");
+            profiler.end_resume(label);
+        }
+    }
+
+    /// Starts timing every script resume; see [`ScriptProfiler`].
+    pub(super) fn enable_script_profiler(&mut self, path: &Path) -> Result<()> {
+        self.script_profiler = Some(ScriptProfiler::create(path)?);
+        Ok(())
+    }
+
+    pub(super) fn end_script_profile_tick(&mut self) {
+        if let Some(profiler) = self.script_profiler.as_mut() {
+            profiler.end_tick();
+        }
+    }
+
+    pub(super) fn flush_script_profile(&mut self) -> Result<()> {
+        match self.script_profiler.as_mut() {
+            Some(profiler) => profiler.flush(),
+            None => Ok(()),
+        }
+    }
+
+    /// Writes the final report and closes the trace, returning both paths.
+    pub(super) fn finish_script_profile(&mut self) -> Result<Option<(PathBuf, PathBuf)>> {
+        self.script_profiler
+            .as_mut()
+            .map(|profiler| profiler.finish())
+            .transpose()
+    }
+
+    fn sleep_running_script(&mut self, millis: f64) -> bool {
+        self.script_runtime()
+            .sleep_running(scheduler::ticks_for_millis(millis))
+    }
+
+    fn wait_for_script_completion(&mut self, handle: u32) -> bool {
+        self.script_runtime().wait_for_script(handle)
+    }
+
+    /// Parks the running script until the fullscreen movie ends. Countdown
+    /// playback only advances when polled, so it is left to the caller's
+    /// own per-resume polling and only viewer playback parks.
+    fn wait_for_fullscreen_movie(&mut self) -> bool {
+        if self
+            .cutscene_view()
+            .fullscreen_movie_viewer_generation()
+            .is_none()
+        {
+            return false;
+        }
+        self.script_runtime().wait_for_movie()
+    }
+
+    /// Polls the fullscreen movie once per tick on behalf of scripts parked
+    /// in `wait_for_movie`, waking them when it ends.
+    fn advance_movie_waiters(&mut self) {
+        if !self.script_view().has_waiters(WaitCondition::Movie) {
+            return;
+        }
+        if self.poll_fullscreen_movie() {
+            self.log_event("cut_scene.fullscreen.poll".to_string());
+        } else {
+            self.script_runtime().scheduler().wake(WaitCondition::Movie);
+        }
+    }
+
     fn ensure_actor_mut(&mut self, id: &str, label: &str) -> &mut ActorSnapshot {
         self.actors.ensure_actor_mut(id, label)
     }
@@ -1038,6 +1159,15 @@ impl EngineContext {
 
     fn set_actor_costume(&mut self, id: &str, label: &str, costume: Option<String>) {
         self.actor_runtime().set_actor_costume(id, label, costume);
+        self.refresh_costume_handle(id, label);
+    }
+
+    /// Points the actor's resolved costume at its current costume name;
+    /// swapping back to a costume seen before reuses the cached handle.
+    fn refresh_costume_handle(&mut self, id: &str, label: &str) {
+        let current = self.actors.get(id).and_then(|actor| actor.costume.clone());
+        let handle = current.and_then(|name| self.costumes.resolve(&name));
+        self.ensure_actor_mut(id, label).costume_handle = handle;
     }
 
     fn set_actor_base_costume(&mut self, id: &str, label: &str, costume: Option<String>) {
@@ -1058,11 +1188,15 @@ impl EngineContext {
     }
 
     fn push_actor_costume(&mut self, id: &str, label: &str, costume: String) -> usize {
-        self.actor_runtime().push_actor_costume(id, label, costume)
+        let depth = self.actor_runtime().push_actor_costume(id, label, costume);
+        self.refresh_costume_handle(id, label);
+        depth
     }
 
     fn pop_actor_costume(&mut self, id: &str, label: &str) -> Option<String> {
-        self.actor_runtime().pop_actor_costume(id, label)
+        let next = self.actor_runtime().pop_actor_costume(id, label);
+        self.refresh_costume_handle(id, label);
+        next
     }
 
     fn set_actor_current_chore(
@@ -1468,16 +1602,21 @@ pub(crate) fn distance_between(a: Vec3, b: Vec3) -> f32 {
 #[cfg(test)]
 mod tests {
     use super::super::types::Vec3;
-    use super::bindings::{candidate_paths, value_slice_to_vec3};
+    use super::bindings::{
+        candidate_paths, drive_active_scripts, install_script_waits, install_sleep_for,
+        value_slice_to_vec3,
+    };
     use super::geometry::ParsedSetGeometry;
     use super::menus::install_menu_common;
     use super::objects::ObjectSnapshot;
     use super::pause::{install_game_pauser, PauseEvent, PauseLabel};
+    use super::scheduler::{ScriptScheduler, WaitCondition};
     use super::{AudioCallback, EngineContext, EngineContextHandle};
     use grim_analysis::resources::{ResourceGraph, SetMetadata, SetupSlot};
-    use grim_formats::SetFile as SetFileData;
+    use grim_formats::SetView;
     use mlua::{Function, Lua, Table, Value};
     use std::cell::RefCell;
+    use std::collections::BTreeSet;
     use std::path::PathBuf;
     use std::rc::Rc;
 
@@ -1769,15 +1908,15 @@ mod tests {
         }
     }
 
-    fn manny_geometry_set() -> SetFileData {
+    fn manny_geometry_set() -> SetView<'static> {
         let raw = "section: setups\n\tnumsetups\t5\n\tsetup\tmo_ddtws\n\tposition\t0.6\t2.0\t0.0\n\tinterest\t0.6\t2.2\t0.0\n\tsetup\tmo_winws\n\tposition\t0.2\t2.6\t0.0\n\tinterest\t0.2\t2.8\t0.0\n\tsetup\tmo_comin\n\tposition\t1.35\t0.25\t0.0\n\tinterest\t1.35\t0.45\t0.0\n\tsetup\tmo_mcecu\n\tposition\t0.62\t2.05\t0.0\n\tinterest\t0.62\t2.25\t0.0\n\tsetup\tmo_mnycu\n\tposition\t1.3\t0.2\t0.0\n\tinterest\t1.2\t0.4\t0.0\n\nsection: sectors\n\tsector\t\tmo_walk_default\n\tID\t\t6002\n\ttype\t\twalk\n\tdefault visibility\t\tvisible\n\theight\t\t0.0\n\tnumvertices\t4\n\tvertices:\t\t0.3\t1.7\t0.0\n\t         \t\t0.9\t1.7\t0.0\n\t         \t\t0.9\t2.3\t0.0\n\t         \t\t0.3\t2.3\t0.0\n\tnumtris 2\n\ttriangles:\t\t0 1 2\n\t\t\t\t0 2 3\n\tsector\t\tmo_window_walk\n\tID\t\t6100\n\ttype\t\twalk\n\tdefault visibility\t\tvisible\n\theight\t\t0.0\n\tnumvertices\t4\n\tvertices:\t\t-0.1\t2.3\t0.0\n\t         \t\t0.3\t2.3\t0.0\n\t         \t\t0.3\t2.8\t0.0\n\t         \t\t-0.1\t2.8\t0.0\n\tnumtris 2\n\ttriangles:\t\t0 1 2\n\t\t\t\t0 2 3\n\tsector\t\tmo_entry_walk\n\tID\t\t6200\n\ttype\t\twalk\n\tdefault visibility\t\tvisible\n\theight\t\t0.0\n\tnumvertices\t4\n\tvertices:\t\t1.1\t0.0\t0.0\n\t         \t\t1.6\t0.0\t0.0\n\t         \t\t1.6\t0.5\t0.0\n\t         \t\t1.1\t0.5\t0.0\n\tnumtris 2\n\ttriangles:\t\t0 1 2\n\t\t\t\t0 2 3\n";
-        SetFileData::parse(raw.as_bytes()).expect("parse manny geometry")
+        SetView::parse(raw.as_bytes()).expect("parse manny geometry")
     }
 
     fn install_manny_geometry(ctx: &mut EngineContext) {
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(manny_geometry_set()),
+            ParsedSetGeometry::from_set_view(&manny_geometry_set()),
         );
         ctx.ensure_sector_state_map("mo.set");
     }
@@ -1823,6 +1962,36 @@ mod tests {
         assert_eq!(window_hit.name, "mo_winws");
     }
 
+    #[test]
+    fn camera_sector_selects_its_named_setup() {
+        let mut ctx = make_context();
+        let raw = "section: setups\n\tnumsetups\t2\n\tsetup\tmo_ddtws\n\tposition\t0.6\t2.0\t0.0\n\tinterest\t0.6\t2.2\t0.0\n\tsetup\tmo_winws\n\tposition\t0.2\t2.6\t0.0\n\tinterest\t0.2\t2.8\t0.0\n\nsection: sectors\n\tsector\t\tmo_winws\n\tID\t\t7000\n\ttype\t\tcamera\n\tdefault visibility\t\tvisible\n\theight\t\t0.0\n\tnumvertices\t4\n\tvertices:\t\t0.0\t1.8\t0.0\n\t         \t\t0.5\t1.8\t0.0\n\t         \t\t0.5\t2.9\t0.0\n\t         \t\t0.0\t2.9\t0.0\n\tnumtris 2\n\ttriangles:\t\t0 1 2\n\t\t\t\t0 2 3\n";
+        let geometry = ParsedSetGeometry::from_set_view(
+            &SetView::parse(raw.as_bytes()).expect("parse camera set"),
+        );
+
+        // Inside the camera sector its setup wins over the nearer target.
+        let inside = geometry.best_setup_for_point((0.45, 2.0)).expect("setup");
+        assert_eq!(inside.name, "mo_winws");
+        let outside = geometry.best_setup_for_point((0.62, 2.05)).expect("setup");
+        assert_eq!(outside.name, "mo_ddtws");
+
+        ctx.sets.insert_geometry_for_tests("mo.set", geometry);
+        ctx.ensure_sector_state_map("mo.set");
+        prepare_manny(
+            &mut ctx,
+            Vec3 {
+                x: 0.45,
+                y: 2.0,
+                z: 0.0,
+            },
+        );
+        assert_eq!(
+            ctx.default_sector_hit("manny", Some("camera")).name,
+            "mo_winws"
+        );
+    }
+
     #[test]
     fn audio_callbacks_receive_music_and_sfx_events() {
         let callback = Rc::new(RecordingCallback::default());
@@ -1884,9 +2053,9 @@ mod tests {
             .iter()
             .any(|entry| entry.starts_with("sfx.stop")));
     }
-    fn sample_geometry_set() -> SetFileData {
+    fn sample_geometry_set() -> SetView<'static> {
         let raw = "section: setups\n\tnumsetups\t1\n\tsetup\tcam_a\n\tposition\t0.0\t0.0\t0.0\n\tinterest\t0.3\t0.3\t0.0\n\troll\t\t0.0\n\tfov\t\t45.0\n\tnclip\t\t0.1\n\tfclip\t\t100.0\n\nsection: sectors\n\tsector\t\tdesk_walk\n\tID\t\t10\n\ttype\t\twalk\n\tdefault visibility\t\tvisible\n\theight\t\t0.0\n\tnumvertices\t4\n\tvertices:\t\t0.0\t0.0\t0.0\n\t         \t\t1.0\t0.0\t0.0\n\t         \t\t1.0\t1.0\t0.0\n\t         \t\t0.0\t1.0\t0.0\n\tnumtris 2\n\ttriangles:\t\t0 1 2\n\t\t\t\t0 2 3\n";
-        SetFileData::parse(raw.as_bytes()).expect("parse sample set")
+        SetView::parse(raw.as_bytes()).expect("parse sample set")
     }
 
     #[test]
@@ -1894,7 +2063,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let (id, _handle) = ctx.register_actor_with_handle("Guard", Some(2002));
@@ -2010,7 +2179,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let object_handle = 3100;
@@ -2042,7 +2211,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let (actor_id, actor_handle) = ctx.register_actor_with_handle("Helper", Some(2100));
@@ -2083,7 +2252,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let object_handle = 3300;
@@ -2127,7 +2296,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let (manny_id, _handle) = ctx.register_actor_with_handle("Manny", Some(1001));
@@ -2173,7 +2342,7 @@ mod tests {
         let mut ctx = make_context();
         ctx.sets.insert_geometry_for_tests(
             "mo.set",
-            ParsedSetGeometry::from_set_file(sample_geometry_set()),
+            ParsedSetGeometry::from_set_view(&sample_geometry_set()),
         );
         ctx.switch_to_set("mo.set");
         let snapshot = ctx.geometry_snapshot();
@@ -2209,4 +2378,222 @@ mod tests {
         let current = snapshot.current_set.expect("current set snapshot");
         assert_eq!(current.set_file, "mo.set");
     }
+
+    fn scheduling_lua(context: &Rc<RefCell<EngineContext>>) -> Lua {
+        let lua = Lua::new();
+        install_sleep_for(&lua, context.clone()).expect("sleep_for installed");
+        install_script_waits(&lua, context.clone()).expect("script waits installed");
+        lua
+    }
+
+    fn script_steps(lua: &Lua) -> String {
+        lua.globals().get("steps").expect("steps global")
+    }
+
+    fn script_events(context: &Rc<RefCell<EngineContext>>) -> Vec<String> {
+        context
+            .borrow()
+            .events()
+            .iter()
+            .filter(|event| event.starts_with("script."))
+            .cloned()
+            .collect()
+    }
+
+    #[test]
+    fn boot_drives_keep_blocking_calls_inline() {
+        let context = Rc::new(RefCell::new(make_context()));
+        let lua = scheduling_lua(&context);
+        lua.load(
+            r#"
+steps = ""
+function child()
+  sleep_for(100)
+  coroutine.yield()
+  steps = steps .. "child,"
+end
+function parent(child_handle)
+  steps = steps .. "start,"
+  sleep_for(500)
+  steps = steps .. "slept,"
+  wait_for_script(child_handle)
+  steps = steps .. "waited,"
+end
+start_script("parent", start_script("child"))
+"#,
+        )
+        .exec()
+        .expect("boot chunk runs");
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("boot drive");
+        drive_active_scripts(&lua, context.clone(), 16, 64).expect("intro drive");
+
+        // Same order the host produced before scripts could park: the sleep
+        // is a no-op and the wait drives the child inline.
+        assert_eq!(script_steps(&lua), "start,slept,child,waited,");
+        assert_eq!(
+            script_events(&context),
+            vec![
+                "script.start child (#1)",
+                "script.start parent (#2)",
+                "script.complete child (#1)",
+                "script.complete parent (#2)",
+            ]
+        );
+    }
+
+    #[test]
+    fn sleeps_count_engine_ticks_not_drive_calls() {
+        let context = Rc::new(RefCell::new(make_context()));
+        let lua = scheduling_lua(&context);
+        context.borrow_mut().advance_script_clock();
+        lua.load(
+            r#"
+steps = ""
+function sleeper()
+  sleep_for(66)
+  steps = steps .. "woke,"
+end
+start_script("sleeper")
+"#,
+        )
+        .exec()
+        .expect("sleeper starts");
+
+        for _ in 0..5 {
+            drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        }
+        assert_eq!(script_steps(&lua), "");
+        context.borrow_mut().advance_script_clock();
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        assert_eq!(script_steps(&lua), "");
+        context.borrow_mut().advance_script_clock();
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        assert_eq!(script_steps(&lua), "woke,");
+        assert!(!context.borrow().is_script_running(1));
+    }
+
+    #[test]
+    fn started_scripts_park_on_sleeps_waits_and_movies() {
+        let context = Rc::new(RefCell::new(make_context()));
+        let lua = scheduling_lua(&context);
+        {
+            let mut ctx = context.borrow_mut();
+            ctx.advance_script_clock();
+            ctx.start_fullscreen_movie("intro".to_string(), Some(2));
+        }
+        lua.load(
+            r#"
+steps = ""
+function worker()
+  sleep_for(66)
+  steps = steps .. "worker,"
+end
+function waiter()
+  wait_for_script(start_script("worker"))
+  steps = steps .. "waited,"
+  wait_for_movie()
+  steps = steps .. "movie,"
+end
+start_script("waiter")
+"#,
+        )
+        .exec()
+        .expect("waiter starts");
+
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        assert_eq!(script_steps(&lua), "");
+        context.borrow_mut().advance_script_clock();
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        assert_eq!(script_steps(&lua), "");
+
+        // The worker wakes, completing it wakes the waiter, and the countdown
+        // movie ends on the waiter's second poll within the same drive.
+        context.borrow_mut().advance_script_clock();
+        drive_active_scripts(&lua, context.clone(), 8, 32).expect("drive");
+        assert_eq!(script_steps(&lua), "worker,waited,movie,");
+        assert!(script_events(&context)
+            .iter()
+            .all(|event| !event.starts_with("script.error")));
+    }
+
+    #[test]
+    fn blocking_calls_under_callbacks_and_pcall_do_not_yield() {
+        let context = Rc::new(RefCell::new(make_context()));
+        let lua = scheduling_lua(&context);
+        {
+            let mut ctx = context.borrow_mut();
+            ctx.advance_script_clock();
+            ctx.start_fullscreen_movie("intro".to_string(), Some(3));
+        }
+        lua.load(
+            r#"
+steps = ""
+function worker()
+  coroutine.yield()
+  steps = steps .. "worker,"
+end
+function caller()
+  wait_for_script(function()
+    sleep_for(1000)
+    wait_for_movie()
+    steps = steps .. "callback,"
+  end)
+  local ok, err = pcall(function()
+    sleep_for(1000)
+    wait_for_script(start_script("worker"))
+    wait_for_movie()
+  end)
+  steps = steps .. (ok and "pcall," or ("error: " .. tostring(err)))
+end
+start_script("caller")
+"#,
+        )
+        .exec()
+        .expect("caller runs");
+
+        assert_eq!(script_steps(&lua), "callback,worker,pcall,");
+        assert!(!context.borrow().is_script_running(1));
+        assert!(script_events(&context)
+            .iter()
+            .all(|event| !event.starts_with("script.error")));
+    }
+
+    #[test]
+    fn script_scheduler_resumes_only_runnable_scripts() {
+        let mut scheduler = ScriptScheduler::default();
+        for handle in 1..=4 {
+            scheduler.spawn(handle);
+        }
+        let previous = scheduler.enter(1);
+        assert_eq!(
+            scheduler.parkable(),
+            None,
+            "nothing parks before the first tick"
+        );
+        scheduler.begin_tick();
+        assert_eq!(scheduler.parkable(), Some(1));
+        scheduler.leave(previous);
+        assert_eq!(scheduler.take_runnable(), BTreeSet::from([1, 2, 3, 4]));
+
+        scheduler.sleep(1, 2);
+        scheduler.wait(2, WaitCondition::Script(3));
+        scheduler.wait(4, WaitCondition::Movie);
+        for handle in 1..=4 {
+            scheduler.requeue(handle);
+        }
+        assert_eq!(scheduler.take_runnable(), BTreeSet::from([3]));
+
+        scheduler.forget(3);
+        assert_eq!(scheduler.take_runnable(), BTreeSet::from([2]));
+
+        scheduler.begin_tick();
+        assert!(scheduler.take_runnable().is_empty());
+        scheduler.begin_tick();
+        assert_eq!(scheduler.take_runnable(), BTreeSet::from([1]));
+
+        assert!(scheduler.has_waiters(WaitCondition::Movie));
+        scheduler.wake(WaitCondition::Movie);
+        assert!(!scheduler.has_waiters(WaitCondition::Movie));
+        assert_eq!(scheduler.take_runnable(), BTreeSet::from([4]));
+    }
 }
@@ -2,6 +2,7 @@ use std::collections::{BTreeMap, BTreeSet};
 
 pub(super) mod runtime;
 
+use super::costumes::CostumeHandle;
 use super::geometry::SectorHit;
 use crate::lua_host::types::Vec3;
 
@@ -21,6 +22,8 @@ pub(crate) struct ActorSnapshot {
     pub(super) handle: u32,
     pub(super) sectors: BTreeMap<String, SectorHit>,
     pub(super) costume_stack: Vec<String>,
+    /// Assets resolved for `costume`, when LAB archives are available.
+    pub(super) costume_handle: Option<CostumeHandle>,
     pub(super) current_chore: Option<String>,
     pub(super) walk_chore: Option<String>,
     pub(super) talk_chore: Option<String>,
@@ -1157,24 +1157,7 @@ fn install_engine_bindings(lua: &Lua, context: Rc<RefCell<EngineContext>>) -> Re
         })?,
     )?;
 
-    let sleep_context = context.clone();
-    globals.set(
-        "sleep_for",
-        lua.create_function(move |_, args: Variadic<Value>| {
-            let desc = if args.is_empty() {
-                "<none>".to_string()
-            } else {
-                args.iter()
-                    .map(|value| describe_value(value))
-                    .collect::<Vec<_>>()
-                    .join(", ")
-            };
-            sleep_context
-                .borrow_mut()
-                .log_event(format!("sleep_for {}", desc));
-            Ok(())
-        })?,
-    )?;
+    install_sleep_for(lua, context.clone())?;
 
     let set_override_context = context.clone();
     globals.set(
@@ -3292,38 +3275,7 @@ pub(crate) fn override_boot_stubs(lua: &Lua, context: Rc<RefCell<EngineContext>>
     })?;
     globals.set("source_all_set_files", source_stub)?;
 
-    globals.set("start_script", create_start_script(lua, context.clone())?)?;
-    globals.set(
-        "single_start_script",
-        create_single_start_script(lua, context.clone())?,
-    )?;
-
-    let wait_context = context.clone();
-    globals.set(
-        "wait_for_script",
-        lua.create_function(move |lua_ctx, args: Variadic<Value>| {
-            for value in args.into_iter() {
-                match value {
-                    Value::Integer(handle) => {
-                        wait_for_handle(lua_ctx, wait_context.clone(), handle as u32)?;
-                    }
-                    Value::Number(handle) => {
-                        wait_for_handle(lua_ctx, wait_context.clone(), handle as u32)?;
-                    }
-                    Value::Function(func) => {
-                        func.call::<_, ()>(MultiValue::new())?;
-                    }
-                    Value::Table(table) => {
-                        if let Ok(func) = table.get::<_, Function>("run") {
-                            func.call::<_, ()>(MultiValue::new())?;
-                        }
-                    }
-                    _ => {}
-                }
-            }
-            Ok(())
-        })?,
-    )?;
+    install_script_waits(lua, context.clone())?;
 
     let find_context = context.clone();
     globals.set(
@@ -3398,6 +3350,168 @@ pub(crate) fn override_boot_stubs(lua: &Lua, context: Rc<RefCell<EngineContext>>
     Ok(())
 }
 
+/// Installs `sleep_for`. Inside a script that can yield it parks the script
+/// for the requested time; anywhere else it only logs, as it always did.
+pub(super) fn install_sleep_for(lua: &Lua, context: Rc<RefCell<EngineContext>>) -> Result<()> {
+    let sleep_context = context;
+    let park_sleep =
+        lua.create_function(move |lua_ctx, (caller, args): (Value, Variadic<Value>)| {
+            let desc = if args.is_empty() {
+                "<none>".to_string()
+            } else {
+                args.iter()
+                    .map(|value| describe_value(value))
+                    .collect::<Vec<_>>()
+                    .join(", ")
+            };
+            let millis = args.get(0).and_then(value_to_f32).unwrap_or(0.0);
+            let can_yield = caller_can_yield(lua_ctx, &sleep_context, &caller);
+            let mut ctx = sleep_context.borrow_mut();
+            ctx.log_event(format!("sleep_for {}", desc));
+            Ok(can_yield && ctx.sleep_running_script(millis as f64))
+        })?;
+    let sleep_for = lua
+        .load(
+            r##"
+local park = ...
+local running, yield = coroutine.running, coroutine.yield
+return function(...)
+  if park(running(), ...) then
+    yield()
+  end
+end
+"##,
+        )
+        .call::<_, Function>(park_sleep)?;
+    lua.globals().set("sleep_for", sleep_for)?;
+    Ok(())
+}
+
+/// Installs `start_script`, `single_start_script`, `wait_for_script` and
+/// `wait_for_movie`. The waits park the calling script when it can yield
+/// and fall back to driving the target inline (or returning) when it
+/// cannot.
+pub(super) fn install_script_waits(lua: &Lua, context: Rc<RefCell<EngineContext>>) -> Result<()> {
+    let globals = lua.globals();
+    globals.set("start_script", create_start_script(lua, context.clone())?)?;
+    globals.set(
+        "single_start_script",
+        create_single_start_script(lua, context.clone())?,
+    )?;
+
+    let wait_context = context.clone();
+    let wait_one = lua.create_function(
+        move |lua_ctx, (caller, value): (Value, Value)| -> LuaResult<bool> {
+            let handle = match value {
+                Value::Integer(handle) => handle as u32,
+                Value::Number(handle) => handle as u32,
+                Value::Function(func) => {
+                    func.call::<_, ()>(MultiValue::new())?;
+                    return Ok(false);
+                }
+                Value::Table(table) => {
+                    if let Ok(func) = table.get::<_, Function>("run") {
+                        func.call::<_, ()>(MultiValue::new())?;
+                    }
+                    return Ok(false);
+                }
+                _ => return Ok(false),
+            };
+            if caller_can_yield(lua_ctx, &wait_context, &caller)
+                && wait_context.borrow_mut().wait_for_script_completion(handle)
+            {
+                return Ok(true);
+            }
+            wait_for_handle(lua_ctx, wait_context.clone(), handle)?;
+            Ok(false)
+        },
+    )?;
+    let wait_for_script = lua
+        .load(
+            r##"
+local wait_one = ...
+local running, yield = coroutine.running, coroutine.yield
+return function(...)
+  for index = 1, select("#", ...) do
+    local value = select(index, ...)
+    while wait_one(running(), value) do
+      yield()
+    end
+  end
+end
+"##,
+        )
+        .call::<_, Function>(wait_one)?;
+    globals.set("wait_for_script", wait_for_script)?;
+
+    // Returns whether the movie is still playing and whether the caller
+    // should yield before polling again (parked or not).
+    let movie_wait_context = context;
+    let park_movie = lua.create_function(move |lua_ctx, caller: Value| {
+        let can_yield = caller_can_yield(lua_ctx, &movie_wait_context, &caller);
+        let mut ctx = movie_wait_context.borrow_mut();
+        if !ctx.poll_fullscreen_movie() {
+            return Ok((false, false));
+        }
+        ctx.log_event("cut_scene.fullscreen.poll".to_string());
+        if can_yield {
+            ctx.wait_for_fullscreen_movie();
+        }
+        Ok((true, can_yield))
+    })?;
+    let wait_for_movie = lua
+        .load(
+            r##"
+local park = ...
+local running, yield = coroutine.running, coroutine.yield
+return function()
+  while true do
+    local playing, wait = park(running())
+    if not (playing and wait) then
+      return
+    end
+    yield()
+  end
+end
+"##,
+        )
+        .call::<_, Function>(park_movie)?;
+    globals.set("wait_for_movie", wait_for_movie)?;
+    Ok(())
+}
+
+/// Whether the Lua wrapper that called a park function can
+/// `coroutine.yield` straight back to the scheduler's resume of the running
+/// script. Lua 5.1 cannot yield across a C boundary, so this is false when
+/// the wrapper runs on another coroutine, or when a C frame (`pcall`, a host
+/// binding that called back into Lua) sits between it and the script's
+/// entry point.
+fn caller_can_yield<'lua>(
+    lua: &'lua Lua,
+    context: &Rc<RefCell<EngineContext>>,
+    caller: &Value<'lua>,
+) -> bool {
+    if !matches!(caller, Value::Thread(_)) {
+        return false;
+    }
+    let script_thread = {
+        let state = context.borrow();
+        let Some(handle) = state.running_script() else {
+            return false;
+        };
+        state.with_script_thread_key(handle, |maybe_key| {
+            maybe_key.and_then(|key| lua.registry_value::<Thread>(key).ok())
+        })
+    };
+    if !script_thread.is_some_and(|thread| *caller == Value::Thread(thread)) {
+        return false;
+    }
+    // Level 0 is the park function itself and level 1 its Lua wrapper.
+    (2..)
+        .map_while(|level| lua.inspect_stack(level))
+        .all(|frame| frame.source().what != "C")
+}
+
 fn install_cutscene_helpers(lua: &Lua, context: Rc<RefCell<EngineContext>>) -> Result<()> {
     let globals = lua.globals();
 
@@ -4033,6 +4147,20 @@ pub(crate) fn dump_runtime_summary(state: &EngineContext) {
             .map(|id| id.as_str())
             .unwrap_or("<none>")
     );
+    if let Some(handle) = state
+        .actors
+        .selected_actor_snapshot()
+        .and_then(|actor| actor.costume_handle.as_ref())
+    {
+        let costume = handle.costume();
+        println!(
+            "  Selected actor costume: {} ({} components, {} models, {} missing)",
+            costume.name,
+            costume.components.len(),
+            costume.models().count(),
+            costume.failures.len()
+        );
+    }
     if let Some(effect) = &state.voice_effect {
         println!("  Voice effect: {}", effect);
     }
@@ -4437,38 +4565,41 @@ enum ScriptStep {
     Completed,
 }
 
+/// Resumes runnable scripts for up to `max_passes` passes. Scripts that
+/// yield plainly run again next pass; scripts parked on a timer or wait-list
+/// are left alone until their condition fires. This does not advance the
+/// scheduler clock; see `EngineContext::advance_script_clock`.
 pub(crate) fn drive_active_scripts(
     lua: &Lua,
     context: Rc<RefCell<EngineContext>>,
     max_passes: usize,
     max_yields_per_script: u32,
 ) -> LuaResult<()> {
+    context
+        .borrow_mut()
+        .restore_script_budget(max_yields_per_script);
     for _ in 0..max_passes {
-        let handles = {
-            let state = context.borrow();
-            state.active_script_handles()
-        };
-        if handles.is_empty() {
+        let runnable = context.borrow_mut().take_runnable_scripts();
+        if runnable.is_empty() {
             break;
         }
-        let mut progressed = false;
-        for handle in handles {
+        for handle in runnable {
             let yield_count = {
                 let state = context.borrow();
-                state.script_yield_count(handle).unwrap_or(0)
+                match state.script_yield_count(handle) {
+                    Some(count) => count,
+                    None => continue,
+                }
             };
             if yield_count >= max_yields_per_script {
+                context.borrow_mut().exhaust_script(handle);
                 continue;
             }
             match resume_script(lua, context.clone(), handle, None, None)? {
-                ScriptStep::Yielded | ScriptStep::Completed => {
-                    progressed = true;
-                }
+                ScriptStep::Yielded => context.borrow_mut().requeue_script(handle),
+                ScriptStep::Completed => {}
             }
         }
-        if !progressed {
-            break;
-        }
     }
     Ok(())
 }
@@ -4570,11 +4701,13 @@ fn resume_script(
         return Ok(ScriptStep::Completed);
     }
 
+    let previous = context.borrow_mut().enter_script(handle);
     let resume_result = if let Some(args) = initial_args {
         thread.resume::<_, MultiValue>(args)
     } else {
         thread.resume::<_, MultiValue>(MultiValue::new())
     };
+    context.borrow_mut().leave_script(handle, previous);
 
     match resume_result {
         Ok(_) => match thread.status() {
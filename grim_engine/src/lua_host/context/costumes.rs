@@ -0,0 +1,87 @@
+use std::collections::HashSet;
+use std::fmt;
+use std::sync::Arc;
+
+use crate::lab_collection::LabCollection;
+use grim_formats::{CostumeLoader, ResolvedCostume};
+
+/// Resolved costume attached to an actor. Cloning shares the loaded models,
+/// keyframes and materials.
+#[derive(Clone)]
+pub(crate) struct CostumeHandle(Arc<ResolvedCostume>);
+
+impl CostumeHandle {
+    pub(crate) fn costume(&self) -> &ResolvedCostume {
+        &self.0
+    }
+}
+
+impl fmt::Debug for CostumeHandle {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("CostumeHandle")
+            .field("name", &self.0.name)
+            .field("components", &self.0.components.len())
+            .field("failures", &self.0.failures.len())
+            .finish()
+    }
+}
+
+/// Resolves costume names against the LAB archives. Models and keyframes
+/// shared between costumes are loaded once, and swapping back to a costume
+/// reuses its handle.
+#[derive(Debug)]
+pub(crate) struct CostumeRuntime {
+    verbose: bool,
+    loader: CostumeLoader,
+    lab_collection: Option<Arc<LabCollection>>,
+    /// Lowercase names that failed to load, so repeated swaps to a missing
+    /// costume do not rescan the archives.
+    unresolved: HashSet<String>,
+}
+
+impl CostumeRuntime {
+    pub(crate) fn new(verbose: bool, lab_collection: Option<Arc<LabCollection>>) -> Self {
+        Self {
+            verbose,
+            loader: CostumeLoader::new(),
+            lab_collection,
+            unresolved: HashSet::new(),
+        }
+    }
+
+    /// `None` without LAB archives or when the costume itself is missing;
+    /// missing dependencies still yield a (partial) handle.
+    pub(crate) fn resolve(&mut self, name: &str) -> Option<CostumeHandle> {
+        let collection = self.lab_collection.as_deref()?;
+        if let Some(costume) = self.loader.cached_costume(name) {
+            return Some(CostumeHandle(costume));
+        }
+        let key = name.to_ascii_lowercase();
+        if self.unresolved.contains(&key) {
+            return None;
+        }
+        match self.loader.load(name, collection) {
+            Ok(costume) => {
+                if self.verbose {
+                    for failure in &costume.failures {
+                        eprintln!(
+                            "[grim_engine] warning: costume {} dependency {}: {}",
+                            name, failure.name, failure.reason
+                        );
+                    }
+                }
+                Some(CostumeHandle(costume))
+            }
+            Err(err) => {
+                if self.verbose {
+                    eprintln!(
+                        "[grim_engine] warning: failed to resolve costume {}: {:?}",
+                        name, err
+                    );
+                }
+                self.unresolved.insert(key);
+                None
+            }
+        }
+    }
+}
@@ -1,4 +1,8 @@
-use grim_formats::{SectorKind as SetSectorKind, SetFile as SetFileData, Vec3 as SetVec3};
+use grim_formats::sector_index::centroid;
+use grim_formats::{
+    polygon_contains, PointIndex, SectorIndex, SectorKind as SetSectorKind, SetView,
+    Vec3 as SetVec3,
+};
 
 #[derive(Debug, Clone)]
 pub(super) struct SetupInfo {
@@ -61,15 +65,7 @@ impl SectorPolygon {
         vertices: Vec<(f32, f32)>,
         default_active: bool,
     ) -> Self {
-        let centroid = if vertices.is_empty() {
-            (0.0, 0.0)
-        } else {
-            let (sum_x, sum_y) = vertices
-                .iter()
-                .fold((0.0, 0.0), |acc, (x, y)| (acc.0 + x, acc.1 + y));
-            let count = vertices.len() as f32;
-            (sum_x / count, sum_y / count)
-        };
+        let centroid = centroid(&vertices);
         Self {
             name,
             id,
@@ -81,19 +77,7 @@ impl SectorPolygon {
     }
 
     pub(super) fn contains(&self, point: (f32, f32)) -> bool {
-        if self.vertices.len() < 3 {
-            return false;
-        }
-        if point_on_polygon_edge(point, &self.vertices) {
-            return true;
-        }
-        ray_cast_contains(point, &self.vertices)
-    }
-
-    fn distance_squared(&self, point: (f32, f32)) -> f32 {
-        let dx = point.0 - self.centroid.0;
-        let dy = point.1 - self.centroid.1;
-        dx * dx + dy * dy
+        polygon_contains(point, &self.vertices)
     }
 }
 
@@ -114,48 +98,100 @@ impl ParsedSetup {
 pub(super) struct ParsedSetGeometry {
     pub(super) sectors: Vec<SectorPolygon>,
     pub(super) setups: Vec<ParsedSetup>,
+    /// Point location over `sectors`, built once when the set loads.
+    index: SectorIndex,
+    setup_map: SetupMap,
+}
+
+/// Camera setup selection compiled when the set loads. Geometry stays cached
+/// per set file, so re-entering a set reuses it.
+#[derive(Debug, Clone)]
+struct SetupMap {
+    /// Per entry in `sectors`: the setup a camera sector switches to, when a
+    /// setup shares its name.
+    sector_setups: Vec<Option<usize>>,
+    /// Targets of setups that have one, for points outside every mapped
+    /// camera sector.
+    targets: PointIndex,
+    target_setups: Vec<usize>,
+}
+
+impl SetupMap {
+    fn new(sectors: &[SectorPolygon], setups: &[ParsedSetup]) -> Self {
+        let sector_setups = sectors
+            .iter()
+            .map(|sector| {
+                if sector.kind != SetSectorKind::Camera {
+                    return None;
+                }
+                setups
+                    .iter()
+                    .position(|setup| setup.name.eq_ignore_ascii_case(&sector.name))
+            })
+            .collect();
+        let (target_setups, targets): (Vec<usize>, Vec<(f32, f32)>) = setups
+            .iter()
+            .enumerate()
+            .filter_map(|(index, setup)| Some((index, setup.target_point()?)))
+            .unzip();
+        SetupMap {
+            sector_setups,
+            targets: PointIndex::new(targets),
+            target_setups,
+        }
+    }
 }
 
 impl ParsedSetGeometry {
-    pub(super) fn from_set_file(file: SetFileData) -> Self {
-        let sectors = file
+    pub(super) fn from_set_view(set: &SetView<'_>) -> Self {
+        let sectors = set
             .sectors
-            .into_iter()
+            .iter()
             .map(|sector| {
-                let vertices = sector
-                    .vertices
-                    .into_iter()
-                    .map(|SetVec3 { x, y, .. }| (x, y))
+                let vertices = set
+                    .sector_vertices(sector)
+                    .chunks_exact(3)
+                    .map(|xyz| (xyz[0], xyz[1]))
                     .collect();
                 let default_active = sector
                     .default_visibility
-                    .as_ref()
                     .map(|value| match value.to_ascii_lowercase().as_str() {
                         "hidden" | "invisible" | "false" | "off" => false,
                         _ => true,
                     })
                     .unwrap_or(true);
                 SectorPolygon::new(
-                    sector.name,
+                    sector.name.to_string(),
                     sector.id,
                     sector.kind,
                     vertices,
                     default_active,
                 )
             })
-            .collect();
+            .collect::<Vec<_>>();
+        let index = SectorIndex::new(
+            sectors
+                .iter()
+                .map(|sector| (sector.kind, sector.vertices.as_slice())),
+        );
 
-        let setups = file
+        let setups = set
             .setups
-            .into_iter()
+            .iter()
             .map(|setup| ParsedSetup {
-                name: setup.name,
-                interest: setup.interest.map(|SetVec3 { x, y, .. }| (x, y)),
-                position: setup.position.map(|SetVec3 { x, y, .. }| (x, y)),
+                name: setup.name.to_string(),
+                interest: setup.interest.as_ref().map(|&SetVec3 { x, y, .. }| (x, y)),
+                position: setup.position.as_ref().map(|&SetVec3 { x, y, .. }| (x, y)),
             })
-            .collect();
-
-        ParsedSetGeometry { sectors, setups }
+            .collect::<Vec<_>>();
+        let setup_map = SetupMap::new(&sectors, &setups);
+
+        ParsedSetGeometry {
+            sectors,
+            setups,
+            index,
+            setup_map,
+        }
     }
 
     pub(super) fn has_geometry(&self) -> bool {
@@ -167,84 +203,29 @@ impl ParsedSetGeometry {
         kind: SetSectorKind,
         point: (f32, f32),
     ) -> Option<&SectorPolygon> {
-        let mut fallback = None;
-        let mut fallback_dist = f32::MAX;
-        for sector in self.sectors.iter().filter(|sector| sector.kind == kind) {
-            if sector.contains(point) {
-                return Some(sector);
-            }
-            let dist = sector.distance_squared(point);
-            if dist < fallback_dist {
-                fallback_dist = dist;
-                fallback = Some(sector);
-            }
-        }
-        fallback
+        self.index
+            .locate(kind, point)
+            .map(|index| &self.sectors[index])
     }
 
+    /// The setup named by the camera sector under `point`, else the setup
+    /// whose interest (or position) is nearest, else the first setup.
     pub(super) fn best_setup_for_point(&self, point: (f32, f32)) -> Option<&ParsedSetup> {
-        let mut best = None;
-        let mut best_dist = f32::MAX;
-        for setup in &self.setups {
-            if let Some(target) = setup.target_point() {
-                let dx = point.0 - target.0;
-                let dy = point.1 - target.1;
-                let dist = dx * dx + dy * dy;
-                if dist < best_dist {
-                    best_dist = dist;
-                    best = Some(setup);
-                }
-            }
-        }
-        best.or_else(|| self.setups.first())
-    }
-}
-
-fn point_on_polygon_edge(point: (f32, f32), vertices: &[(f32, f32)]) -> bool {
-    if vertices.len() < 2 {
-        return false;
-    }
-    let mut prev = vertices.last().copied().unwrap();
-    for &current in vertices {
-        if point_on_segment(point, prev, current) {
-            return true;
-        }
-        prev = current;
-    }
-    false
-}
-
-fn point_on_segment(point: (f32, f32), a: (f32, f32), b: (f32, f32)) -> bool {
-    let (px, py) = point;
-    let (ax, ay) = a;
-    let (bx, by) = b;
-    let cross = (py - ay) * (bx - ax) - (px - ax) * (by - ay);
-    if cross.abs() > 1e-4 {
-        return false;
-    }
-    let dot = (px - ax) * (px - bx) + (py - ay) * (py - by);
-    dot <= 0.0
-}
-
-fn ray_cast_contains(point: (f32, f32), vertices: &[(f32, f32)]) -> bool {
-    let (px, py) = point;
-    let mut inside = false;
-    let mut j = vertices.len() - 1;
-    for i in 0..vertices.len() {
-        let (xi, yi) = vertices[i];
-        let (xj, yj) = vertices[j];
-        if (yi > py) != (yj > py) {
-            let denom = yj - yi;
-            if denom.abs() > 1e-6 {
-                let xinters = (py - yi) * (xj - xi) / denom + xi;
-                if xinters > px {
-                    inside = !inside;
-                }
-            }
+        let map = &self.setup_map;
+        let mapped = self
+            .index
+            .containing(SetSectorKind::Camera, point)
+            .and_then(|sector| map.sector_setups[sector]);
+        let setup = mapped.or_else(|| {
+            map.targets
+                .nearest(point)
+                .map(|target| map.target_setups[target])
+        });
+        match setup {
+            Some(index) => self.setups.get(index),
+            None => self.setups.first(),
         }
-        j = i;
     }
-    inside
 }
 
 #[derive(Debug, Clone)]
@@ -0,0 +1,318 @@
+//! Background loading of set geometry.
+//!
+//! Parsing a `.set` on the Lua thread stalls whichever tick switches rooms,
+//! so the set runtime asks this module to parse the sets it expects next on a
+//! worker thread. Predictions come from the static resource graph: the boot
+//! timeline names the first set and its hooks, and every set method is
+//! simulated once to find the other sets it touches (doors, cutscene
+//! transitions, `switch_to_set` calls).
+
+use std::collections::{BTreeMap, BTreeSet, VecDeque};
+use std::sync::Arc;
+use std::thread;
+
+use crossbeam_channel::{unbounded, Receiver, Sender};
+use grim_analysis::boot::{run_boot_pipeline, BootRequest};
+use grim_analysis::registry::Registry;
+use grim_analysis::resources::ResourceGraph;
+use grim_analysis::runtime::build_runtime_model;
+use grim_analysis::simulation::{simulate_set_function, FunctionSimulation};
+use grim_analysis::timeline::build_boot_timeline;
+use grim_formats::SetView;
+
+use super::geometry::ParsedSetGeometry;
+use crate::lab_collection::LabCollection;
+
+/// Sets the runtime is likely to enter next, keyed by lowercase set file.
+#[derive(Debug, Default)]
+pub(super) struct SetForecast {
+    boot: Vec<String>,
+    neighbours: BTreeMap<String, Vec<String>>,
+}
+
+impl SetForecast {
+    pub(super) fn from_resources(resources: &ResourceGraph) -> Self {
+        let by_variable: BTreeMap<String, String> = resources
+            .sets
+            .iter()
+            .map(|meta| {
+                (
+                    meta.variable_name.to_ascii_lowercase(),
+                    meta.set_file.to_ascii_lowercase(),
+                )
+            })
+            .collect();
+
+        let mut neighbours = BTreeMap::new();
+        for meta in &resources.sets {
+            let own = meta.set_file.to_ascii_lowercase();
+            let mut reached = Vec::new();
+            for method in &meta.methods {
+                let simulation = simulate_set_function(method);
+                collect_set_targets(&simulation, &by_variable, &own, &mut reached);
+            }
+            neighbours.insert(own, reached);
+        }
+
+        let summary = run_boot_pipeline(
+            &mut Registry::default(),
+            BootRequest { resume_save: false },
+            resources,
+        );
+        let timeline = build_boot_timeline(&summary, &build_runtime_model(resources));
+        let mut boot = Vec::new();
+        if let Some(set) = timeline.default_set {
+            let own = set.set_file.to_ascii_lowercase();
+            boot.push(own.clone());
+            for hook in &set.hooks {
+                collect_set_targets(&hook.simulation, &by_variable, &own, &mut boot);
+            }
+        }
+
+        Self { boot, neighbours }
+    }
+
+    /// Sets needed as soon as boot finishes: the default set first.
+    pub(super) fn boot(&self) -> &[String] {
+        &self.boot
+    }
+
+    /// Sets reachable from `set_file` through its methods, in first-seen order.
+    pub(super) fn after(&self, set_file: &str) -> &[String] {
+        self.neighbours
+            .get(&set_file.to_ascii_lowercase())
+            .map(Vec::as_slice)
+            .unwrap_or(&[])
+    }
+}
+
+fn collect_set_targets(
+    simulation: &FunctionSimulation,
+    by_variable: &BTreeMap<String, String>,
+    own: &str,
+    out: &mut Vec<String>,
+) {
+    let targets = simulation.method_calls.keys().chain(
+        simulation
+            .stateful_call_events
+            .iter()
+            .map(|event| &event.target),
+    );
+    for target in targets {
+        let root = target_root(target).to_ascii_lowercase();
+        if let Some(set_file) = by_variable.get(&root) {
+            if set_file != own && !out.contains(set_file) {
+                out.push(set_file.clone());
+            }
+        }
+    }
+}
+
+/// Leading identifier of a call target such as `mo:switch_to_set` or `ly.door`.
+fn target_root(target: &str) -> &str {
+    let end = target
+        .find(|ch: char| matches!(ch, '.' | ':' | '[' | '('))
+        .unwrap_or(target.len());
+    target[..end].trim()
+}
+
+/// Sets parsed ahead of use that have not been taken yet. Anything older is
+/// dropped; the Lua thread loads it itself if it turns out to be needed.
+const MAX_READY: usize = 8;
+
+#[derive(Debug)]
+enum Prefetch {
+    Boot,
+    Around(String),
+}
+
+/// Worker thread that parses set geometry ahead of the Lua thread.
+///
+/// The worker also builds the [`SetForecast`]: that runs the boot pipeline
+/// and simulates every set method, which is too slow for engine start-up on
+/// the Lua thread. Requests sent before it is ready simply queue.
+#[derive(Debug)]
+pub(super) struct SetPreloader {
+    requests: Sender<Prefetch>,
+    results: Receiver<(String, ParsedSetGeometry)>,
+    /// Parsed sets waiting to be taken, oldest first.
+    ready: VecDeque<(String, ParsedSetGeometry)>,
+}
+
+impl SetPreloader {
+    pub(super) fn spawn(collection: Arc<LabCollection>, resources: ResourceGraph) -> Option<Self> {
+        Self::spawn_with(
+            move || SetForecast::from_resources(&resources),
+            move |set_file| load_geometry(&collection, set_file),
+        )
+    }
+
+    fn spawn_with(
+        forecast: impl FnOnce() -> SetForecast + Send + 'static,
+        load: impl Fn(&str) -> Option<ParsedSetGeometry> + Send + 'static,
+    ) -> Option<Self> {
+        let (request_tx, request_rx) = unbounded::<Prefetch>();
+        let (result_tx, result_rx) = unbounded();
+        let spawned = thread::Builder::new()
+            .name("set-preload".to_string())
+            .spawn(move || {
+                let forecast = forecast();
+                // Each set is parsed at most once; the Lua thread keeps what it takes.
+                let mut parsed = BTreeSet::new();
+                for request in request_rx {
+                    let upcoming = match &request {
+                        Prefetch::Boot => forecast.boot(),
+                        Prefetch::Around(set_file) => forecast.after(set_file),
+                    };
+                    for set_file in upcoming {
+                        if !parsed.insert(set_file.clone()) {
+                            continue;
+                        }
+                        let Some(geometry) = load(set_file) else {
+                            continue;
+                        };
+                        if result_tx.send((set_file.clone(), geometry)).is_err() {
+                            return;
+                        }
+                    }
+                }
+            });
+        if let Err(err) = spawned {
+            eprintln!("[grim_engine] warning: failed to start set preloader: {err:?}");
+            return None;
+        }
+
+        Some(Self {
+            requests: request_tx,
+            results: result_rx,
+            ready: VecDeque::new(),
+        })
+    }
+
+    /// Queues the boot set and whatever its hooks reach.
+    pub(super) fn prefetch_boot(&mut self) {
+        let _ = self.requests.send(Prefetch::Boot);
+    }
+
+    /// Queues the predicted neighbours of `set_file`, and drops parsed sets
+    /// the caller already holds. `set_file` itself is not queued: the caller
+    /// is about to load it.
+    pub(super) fn prefetch_around(&mut self, set_file: &str, cached: impl Fn(&str) -> bool) {
+        self.drain();
+        self.ready.retain(|(name, _)| !cached(name));
+        let _ = self
+            .requests
+            .send(Prefetch::Around(set_file.to_ascii_lowercase()));
+    }
+
+    /// Hands over preloaded geometry for `set_file` if the worker has
+    /// finished it. Never waits: returns `None` whenever the caller should
+    /// load (and report) the set itself.
+    pub(super) fn take(&mut self, set_file: &str) -> Option<ParsedSetGeometry> {
+        self.drain();
+        let key = set_file.to_ascii_lowercase();
+        let position = self.ready.iter().position(|(name, _)| *name == key)?;
+        self.ready.remove(position).map(|(_, geometry)| geometry)
+    }
+
+    fn drain(&mut self) {
+        while let Ok(result) = self.results.try_recv() {
+            if self.ready.len() == MAX_READY {
+                self.ready.pop_front();
+            }
+            self.ready.push_back(result);
+        }
+    }
+}
+
+fn load_geometry(collection: &LabCollection, set_file: &str) -> Option<ParsedSetGeometry> {
+    let (archive, entry) = collection.find_entry(set_file)?;
+    let set = SetView::parse(archive.read_entry_bytes(entry)).ok()?;
+    let geometry = ParsedSetGeometry::from_set_view(&set);
+    geometry.has_geometry().then_some(geometry)
+}
+
+#[cfg(test)]
+mod tests {
+    use std::time::{Duration, Instant};
+
+    use grim_formats::SetView;
+
+    use super::{target_root, ParsedSetGeometry, SetForecast, SetPreloader, MAX_READY};
+
+    fn sample_geometry() -> ParsedSetGeometry {
+        let raw = "section: setups\n\tnumsetups\t1\n\tsetup\tcam_a\n\tposition\t0.0\t0.0\t0.0\n\tinterest\t0.3\t0.3\t0.0\n\troll\t\t0.0\n\tfov\t\t45.0\n\tnclip\t\t0.1\n\tfclip\t\t100.0\n";
+        ParsedSetGeometry::from_set_view(&SetView::parse(raw.as_bytes()).expect("parse set"))
+    }
+
+    fn forecast(neighbours: &[(&str, &[&str])]) -> SetForecast {
+        SetForecast {
+            boot: Vec::new(),
+            neighbours: neighbours
+                .iter()
+                .map(|(set, next)| {
+                    (
+                        set.to_string(),
+                        next.iter().map(|name| name.to_string()).collect(),
+                    )
+                })
+                .collect(),
+        }
+    }
+
+    /// Polls `take` until the worker delivers `set_file`.
+    fn wait_for(preloader: &mut SetPreloader, set_file: &str) -> ParsedSetGeometry {
+        let deadline = Instant::now() + Duration::from_secs(5);
+        loop {
+            if let Some(geometry) = preloader.take(set_file) {
+                return geometry;
+            }
+            assert!(Instant::now() < deadline, "{set_file} was never preloaded");
+            std::thread::sleep(Duration::from_millis(1));
+        }
+    }
+
+    #[test]
+    fn preloaded_neighbours_are_taken_once() {
+        let forecast = forecast(&[("mo.set", &["ly.set", "missing.set"])]);
+        let mut preloader = SetPreloader::spawn_with(
+            move || forecast,
+            |set_file| (set_file == "ly.set").then(sample_geometry),
+        )
+        .expect("spawn preloader");
+
+        preloader.prefetch_around("mo.set", |_| false);
+        let geometry = wait_for(&mut preloader, "LY.SET");
+        assert_eq!(geometry.setups.len(), 1);
+        assert!(preloader.take("ly.set").is_none());
+        assert!(preloader.take("missing.set").is_none());
+        // The current set is left to the caller.
+        assert!(preloader.take("mo.set").is_none());
+    }
+
+    #[test]
+    fn ready_sets_are_capped_oldest_first() {
+        let many: Vec<String> = (0..MAX_READY + 3).map(|i| format!("s{i}.set")).collect();
+        let many: Vec<&str> = many.iter().map(String::as_str).collect();
+        let forecast = forecast(&[("a.set", &many), ("b.set", &["last.set"])]);
+        let mut preloader = SetPreloader::spawn_with(move || forecast, |_| Some(sample_geometry()))
+            .expect("spawn preloader");
+
+        preloader.prefetch_around("a.set", |_| false);
+        preloader.prefetch_around("b.set", |_| false);
+        // Requests are served in order, so every s*.set has arrived by now.
+        wait_for(&mut preloader, "last.set");
+        assert_eq!(preloader.ready.len(), MAX_READY - 1);
+        assert!(preloader.take("s0.set").is_none());
+        assert!(preloader.take(&format!("s{}.set", MAX_READY + 2)).is_some());
+    }
+
+    #[test]
+    fn target_root_strips_methods_and_fields() {
+        assert_eq!(target_root("mo:switch_to_set"), "mo");
+        assert_eq!(target_root("ly.door_to_mo"), "ly");
+        assert_eq!(target_root("system.currentSet"), "system");
+        assert_eq!(target_root("manny"), "manny");
+        assert_eq!(target_root("tb[1]"), "tb");
+    }
+}
@@ -0,0 +1,517 @@
+use std::collections::{BTreeMap, BTreeSet};
+use std::fmt::Write as _;
+use std::fs::{self, File};
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+use anyhow::{Context, Result};
+use serde_json::{json, Value as JsonValue};
+
+use crate::lua_host::TICK_DURATION;
+
+/// Frame budget the report measures ticks against: one engine tick.
+const FRAME_BUDGET: Duration = TICK_DURATION;
+
+/// Trace events written before the Chrome trace stops growing. Aggregates
+/// keep counting past the cap.
+const MAX_TRACE_EVENTS: usize = 1_000_000;
+
+const WORST_TICKS_KEPT: usize = 10;
+
+/// Times every coroutine resume and aggregates the results per script label.
+///
+/// Nested resumes (a script driving another through `wait_for_script` or
+/// `start_script`) are charged to the inner script; the outer script's self
+/// time excludes them so the report does not double count.
+///
+/// The Chrome trace is streamed to disk in the JSON array format, whose
+/// closing bracket is optional, so a run killed mid-tick still leaves a
+/// loadable trace. The text report is rewritten on every `flush`.
+#[derive(Debug)]
+pub(super) struct ScriptProfiler {
+    report_path: PathBuf,
+    trace_path: PathBuf,
+    origin: Instant,
+    stack: Vec<ResumeFrame>,
+    scripts: BTreeMap<String, ScriptStats>,
+    tick: u64,
+    tick_started: Option<Instant>,
+    tick_time: BTreeMap<String, Duration>,
+    tick_totals: DurationHistogram,
+    ticks_over_budget: u64,
+    worst_ticks: Vec<TickSample>,
+    trace: Option<BufWriter<File>>,
+    trace_events: usize,
+    trace_truncated: bool,
+}
+
+#[derive(Debug)]
+struct ResumeFrame {
+    handle: u32,
+    started: Instant,
+    children: Duration,
+}
+
+#[derive(Debug, Default)]
+struct ScriptStats {
+    handles: BTreeSet<u32>,
+    resumes: u64,
+    total: Duration,
+    self_time: Duration,
+    max_resume: Duration,
+    max_tick: Duration,
+    ticks_over_budget: u64,
+    per_resume: DurationHistogram,
+    per_tick: DurationHistogram,
+}
+
+#[derive(Debug, Clone)]
+struct TickSample {
+    tick: u64,
+    total: Duration,
+    heaviest: String,
+    heaviest_time: Duration,
+}
+
+impl ScriptProfiler {
+    /// Starts profiling into `path` (the report) and `path` with a
+    /// `.trace.json` extension (the Chrome trace).
+    pub(super) fn create(path: &Path) -> Result<Self> {
+        let trace_path = path.with_extension("trace.json");
+        let file = File::create(&trace_path)
+            .with_context(|| format!("creating script trace {}", trace_path.display()))?;
+        let mut trace = BufWriter::new(file);
+        trace
+            .write_all(b"[")
+            .with_context(|| format!("writing script trace {}", trace_path.display()))?;
+        Ok(Self {
+            report_path: path.to_path_buf(),
+            trace_path,
+            origin: Instant::now(),
+            stack: Vec::new(),
+            scripts: BTreeMap::new(),
+            tick: 0,
+            tick_started: None,
+            tick_time: BTreeMap::new(),
+            tick_totals: DurationHistogram::default(),
+            ticks_over_budget: 0,
+            worst_ticks: Vec::new(),
+            trace: Some(trace),
+            trace_events: 0,
+            trace_truncated: false,
+        })
+    }
+
+    pub(super) fn begin_resume(&mut self, handle: u32) {
+        if self.tick_started.is_none() {
+            self.tick_started = Some(Instant::now());
+        }
+        self.stack.push(ResumeFrame {
+            handle,
+            started: Instant::now(),
+            children: Duration::ZERO,
+        });
+    }
+
+    pub(super) fn end_resume(&mut self, label: &str) {
+        let Some(frame) = self.stack.pop() else {
+            return;
+        };
+        let total = frame.started.elapsed();
+        let self_time = total.saturating_sub(frame.children);
+        if let Some(parent) = self.stack.last_mut() {
+            parent.children += total;
+        }
+
+        let stats = self.scripts.entry(label.to_string()).or_default();
+        stats.handles.insert(frame.handle);
+        stats.resumes += 1;
+        stats.total += total;
+        stats.self_time += self_time;
+        stats.max_resume = stats.max_resume.max(self_time);
+        stats.per_resume.record(self_time);
+        *self.tick_time.entry(label.to_string()).or_default() += self_time;
+
+        let ts = micros(frame.started.duration_since(self.origin));
+        let args = json!({ "handle": frame.handle, "tick": self.tick });
+        self.push_trace(json!({
+            "name": label,
+            "cat": "script",
+            "ph": "X",
+            "ts": ts,
+            "dur": micros(total),
+            "pid": 1,
+            "tid": 1,
+            "args": args,
+        }));
+    }
+
+    /// Closes the current tick, folding its per-script totals into the
+    /// per-tick histograms.
+    pub(super) fn end_tick(&mut self) {
+        let tick = self.tick;
+        self.tick += 1;
+        let Some(started) = self.tick_started.take() else {
+            self.tick_totals.record(Duration::ZERO);
+            return;
+        };
+
+        let mut total = Duration::ZERO;
+        let mut heaviest = ("", Duration::ZERO);
+        for (label, time) in &self.tick_time {
+            total += *time;
+            if *time > heaviest.1 {
+                heaviest = (label.as_str(), *time);
+            }
+            if let Some(stats) = self.scripts.get_mut(label) {
+                stats.per_tick.record(*time);
+                stats.max_tick = stats.max_tick.max(*time);
+                if *time > FRAME_BUDGET {
+                    stats.ticks_over_budget += 1;
+                }
+            }
+        }
+        self.tick_totals.record(total);
+        if total > FRAME_BUDGET {
+            self.ticks_over_budget += 1;
+        }
+
+        let sample = TickSample {
+            tick,
+            total,
+            heaviest: heaviest.0.to_string(),
+            heaviest_time: heaviest.1,
+        };
+        let position = self
+            .worst_ticks
+            .iter()
+            .position(|existing| existing.total < sample.total)
+            .unwrap_or(self.worst_ticks.len());
+        if position < WORST_TICKS_KEPT {
+            self.worst_ticks.insert(position, sample);
+            self.worst_ticks.truncate(WORST_TICKS_KEPT);
+        }
+        self.tick_time.clear();
+
+        self.push_trace(json!({
+            "name": format!("tick {tick}"),
+            "cat": "tick",
+            "ph": "X",
+            "ts": micros(started.duration_since(self.origin)),
+            "dur": micros(started.elapsed()),
+            "pid": 1,
+            "tid": 0,
+            "args": { "script_us": micros(total) },
+        }));
+    }
+
+    /// Rewrites the report and pushes buffered trace events to disk.
+    pub(super) fn flush(&mut self) -> Result<()> {
+        fs::write(&self.report_path, self.report())
+            .with_context(|| format!("writing script profile to {}", self.report_path.display()))?;
+        if let Some(trace) = self.trace.as_mut() {
+            trace
+                .flush()
+                .with_context(|| format!("writing script trace {}", self.trace_path.display()))?;
+        }
+        Ok(())
+    }
+
+    /// Final flush; closes the trace array. Returns the report and trace paths.
+    pub(super) fn finish(&mut self) -> Result<(PathBuf, PathBuf)> {
+        if let Some(mut trace) = self.trace.take() {
+            trace
+                .write_all(b"]\n")
+                .and_then(|_| trace.flush())
+                .with_context(|| format!("writing script trace {}", self.trace_path.display()))?;
+        }
+        self.flush()?;
+        Ok((self.report_path.clone(), self.trace_path.clone()))
+    }
+
+    fn report(&self) -> String {
+        let mut rows: Vec<(&String, &ScriptStats)> = self.scripts.iter().collect();
+        rows.sort_by(|a, b| b.1.self_time.cmp(&a.1.self_time).then_with(|| a.0.cmp(b.0)));
+
+        let mut out = String::new();
+        let _ = writeln!(
+            out,
+            "script profile: {} ticks, {} over the {} ms budget, tick p50<={} p99<={} max {}",
+            self.tick,
+            self.ticks_over_budget,
+            FRAME_BUDGET.as_millis(),
+            format_duration(self.tick_totals.percentile(0.50)),
+            format_duration(self.tick_totals.percentile(0.99)),
+            format_duration(self.tick_totals.max),
+        );
+        if self.trace_truncated {
+            let _ = writeln!(
+                out,
+                "trace truncated after {MAX_TRACE_EVENTS} events; totals below are complete"
+            );
+        }
+        let _ = writeln!(out);
+        let _ = writeln!(
+            out,
+            "{:<40} {:>6} {:>8} {:>10} {:>10} {:>9} {:>9} {:>9} {:>9} {:>6}",
+            "script",
+            "runs",
+            "resumes",
+            "self",
+            "total",
+            "p50<=",
+            "p99<=",
+            "max",
+            "tick max",
+            format!(">{}ms", FRAME_BUDGET.as_millis()),
+        );
+        for (label, stats) in rows {
+            let _ = writeln!(
+                out,
+                "{:<40} {:>6} {:>8} {:>10} {:>10} {:>9} {:>9} {:>9} {:>9} {:>6}",
+                label,
+                stats.handles.len(),
+                stats.resumes,
+                format_duration(stats.self_time),
+                format_duration(stats.total),
+                format_duration(stats.per_resume.percentile(0.50)),
+                format_duration(stats.per_resume.percentile(0.99)),
+                format_duration(stats.max_resume),
+                format_duration(stats.max_tick),
+                stats.ticks_over_budget,
+            );
+        }
+
+        if !self.worst_ticks.is_empty() {
+            let _ = writeln!(out);
+            let _ = writeln!(out, "worst ticks:");
+            for sample in &self.worst_ticks {
+                let _ = writeln!(
+                    out,
+                    "  tick {:>6}: {:>9} (heaviest {} {})",
+                    sample.tick,
+                    format_duration(sample.total),
+                    sample.heaviest,
+                    format_duration(sample.heaviest_time),
+                );
+            }
+        }
+        out
+    }
+
+    fn push_trace(&mut self, event: JsonValue) {
+        let Some(trace) = self.trace.as_mut() else {
+            return;
+        };
+        if self.trace_events >= MAX_TRACE_EVENTS {
+            self.trace_truncated = true;
+            return;
+        }
+        let separator: &[u8] = if self.trace_events == 0 {
+            b"\n"
+        } else {
+            b",\n"
+        };
+        let written = trace
+            .write_all(separator)
+            .and_then(|_| serde_json::to_writer(&mut *trace, &event).map_err(Into::into));
+        match written {
+            Ok(()) => self.trace_events += 1,
+            Err(err) => {
+                eprintln!(
+                    "[grim_engine] warning: failed to write script trace {}: {err}; trace disabled",
+                    self.trace_path.display()
+                );
+                self.trace = None;
+            }
+        }
+    }
+}
+
+/// Log2 histogram over microseconds: bucket `i` holds samples below `2^i` µs.
+#[derive(Debug, Default)]
+struct DurationHistogram {
+    buckets: [u64; 32],
+    count: u64,
+    max: Duration,
+}
+
+impl DurationHistogram {
+    fn record(&mut self, sample: Duration) {
+        let micros = sample.as_micros().min(u64::MAX as u128) as u64;
+        let bucket = (u64::BITS - micros.leading_zeros()) as usize;
+        self.buckets[bucket.min(self.buckets.len() - 1)] += 1;
+        self.count += 1;
+        self.max = self.max.max(sample);
+    }
+
+    /// Upper bound of the bucket holding the `quantile` sample, capped at the
+    /// largest sample seen.
+    fn percentile(&self, quantile: f64) -> Duration {
+        if self.count == 0 {
+            return Duration::ZERO;
+        }
+        let rank = ((self.count as f64 * quantile).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (index, count) in self.buckets.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                let bound = Duration::from_micros(1u64 << index);
+                return bound.min(self.max);
+            }
+        }
+        self.max
+    }
+}
+
+fn micros(duration: Duration) -> f64 {
+    duration.as_secs_f64() * 1_000_000.0
+}
+
+fn format_duration(duration: Duration) -> String {
+    let micros = duration.as_secs_f64() * 1_000_000.0;
+    if micros >= 1_000_000.0 {
+        format!("{:.2}s", micros / 1_000_000.0)
+    } else if micros >= 1_000.0 {
+        format!("{:.2}ms", micros / 1_000.0)
+    } else {
+        format!("{:.0}us", micros)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn profile_path(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!(
+            "grim_engine_profiler_{}_{name}.txt",
+            std::process::id()
+        ))
+    }
+
+    #[test]
+    fn nested_resumes_charge_child_time_to_the_child() {
+        let path = profile_path("nested");
+        let mut profiler = ScriptProfiler::create(&path).expect("profiler created");
+        profiler.begin_resume(1);
+        profiler.begin_resume(2);
+        std::thread::sleep(Duration::from_millis(2));
+        profiler.end_resume("inner");
+        profiler.end_resume("outer");
+        profiler.end_tick();
+
+        let inner = &profiler.scripts["inner"];
+        let outer = &profiler.scripts["outer"];
+        assert_eq!(inner.self_time, inner.total);
+        assert!(inner.total >= Duration::from_millis(2));
+        assert_eq!(outer.self_time + inner.total, outer.total);
+        // The tick adds self times, so the nested resume is counted once.
+        assert_eq!(profiler.worst_ticks[0].total, outer.total);
+        assert_eq!(profiler.worst_ticks[0].heaviest, "inner");
+
+        let _ = fs::remove_file(&profiler.trace_path);
+    }
+
+    #[test]
+    fn percentile_reports_bucket_upper_bounds() {
+        let mut histogram = DurationHistogram::default();
+        assert_eq!(histogram.percentile(0.5), Duration::ZERO);
+
+        for micros in [1, 3, 3, 100] {
+            histogram.record(Duration::from_micros(micros));
+        }
+        assert_eq!(histogram.percentile(0.25), Duration::from_micros(2));
+        assert_eq!(histogram.percentile(0.50), Duration::from_micros(4));
+        assert_eq!(histogram.percentile(0.75), Duration::from_micros(4));
+        // 100 µs sits in the [64, 128) bucket; the bound is capped at the max.
+        assert_eq!(histogram.percentile(0.99), Duration::from_micros(100));
+
+        let mut zeros = DurationHistogram::default();
+        zeros.record(Duration::ZERO);
+        assert_eq!(zeros.percentile(0.5), Duration::ZERO);
+    }
+
+    #[test]
+    fn worst_ticks_stay_sorted_and_bounded() {
+        let path = profile_path("worst");
+        let mut profiler = ScriptProfiler::create(&path).expect("profiler created");
+        let totals = [5, 40, 1, 40, 12, 3, 9, 27, 8, 2, 30, 7];
+        for millis in totals {
+            profiler.tick_started = Some(Instant::now());
+            profiler
+                .tick_time
+                .insert("script".to_string(), Duration::from_millis(millis));
+            profiler.end_tick();
+        }
+
+        let kept: Vec<(u64, u64)> = profiler
+            .worst_ticks
+            .iter()
+            .map(|sample| (sample.tick, sample.total.as_millis() as u64))
+            .collect();
+        assert_eq!(
+            kept,
+            vec![
+                (1, 40),
+                (3, 40),
+                (10, 30),
+                (7, 27),
+                (4, 12),
+                (6, 9),
+                (8, 8),
+                (11, 7),
+                (0, 5),
+                (5, 3),
+            ]
+        );
+        assert_eq!(profiler.ticks_over_budget, 2);
+
+        let _ = fs::remove_file(&profiler.trace_path);
+    }
+
+    #[test]
+    fn trace_is_a_json_array_even_before_finish() {
+        let path = profile_path("trace");
+        let mut profiler = ScriptProfiler::create(&path).expect("profiler created");
+        profiler.begin_resume(1);
+        profiler.begin_resume(2);
+        profiler.end_resume("inner");
+        profiler.end_resume("outer");
+        profiler.end_tick();
+        profiler.flush().expect("flushed");
+
+        // A killed run leaves the array unterminated; viewers accept that.
+        let partial = fs::read_to_string(&profiler.trace_path).expect("trace readable");
+        assert!(partial.starts_with("[\n{"));
+        assert_eq!(partial.matches(",\n").count(), 2);
+        let closed: Vec<JsonValue> =
+            serde_json::from_str(&format!("{partial}]")).expect("partial trace parses");
+        assert_eq!(closed.len(), 3);
+
+        let (report, trace) = profiler.finish().expect("finished");
+        let text = fs::read_to_string(&trace).expect("trace readable");
+        assert!(text.ends_with("}]\n"));
+        let events: Vec<JsonValue> = serde_json::from_str(&text).expect("trace parses");
+        let names: Vec<&str> = events
+            .iter()
+            .map(|event| event["name"].as_str().expect("event name"))
+            .collect();
+        assert_eq!(names, vec!["inner", "outer", "tick 0"]);
+
+        let _ = fs::remove_file(&report);
+        let _ = fs::remove_file(&trace);
+    }
+
+    #[test]
+    fn empty_trace_closes_to_an_empty_array() {
+        let path = profile_path("empty");
+        let mut profiler = ScriptProfiler::create(&path).expect("profiler created");
+        let (report, trace) = profiler.finish().expect("finished");
+        assert_eq!(fs::read_to_string(&trace).expect("trace readable"), "[]\n");
+
+        let _ = fs::remove_file(&report);
+        let _ = fs::remove_file(&trace);
+    }
+}
@@ -0,0 +1,226 @@
+use std::collections::{BTreeMap, BTreeSet, HashMap};
+
+use crate::lua_host::TICK_DURATION;
+
+/// Length of one scheduler tick, in the milliseconds scripts sleep by.
+const TICK_MILLIS: f64 = TICK_DURATION.as_millis() as f64;
+
+const WHEEL_SLOTS: usize = 64;
+
+/// Condition a parked script is waiting on.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+pub(super) enum WaitCondition {
+    /// The fullscreen movie finishing.
+    Movie,
+    /// The script with this handle completing.
+    Script(u32),
+}
+
+#[derive(Debug, Clone, Copy)]
+enum Blocker {
+    Timer(u64),
+    Wait(WaitCondition),
+}
+
+/// Decides which script coroutines are worth resuming.
+///
+/// Scripts live in exactly one place: the run queue, the timer wheel, a
+/// wait-list, or the exhausted set (over the caller's yield budget). Only the
+/// run queue is walked each pass, so the cost of a tick follows the number of
+/// runnable scripts rather than the number of live ones. The run queue is
+/// ordered by handle so passes resume scripts in start order.
+#[derive(Debug, Default)]
+pub(super) struct ScriptScheduler {
+    tick: u64,
+    running: Option<u32>,
+    run_queue: BTreeSet<u32>,
+    exhausted: BTreeSet<u32>,
+    timers: TimerWheel,
+    waits: BTreeMap<WaitCondition, Vec<u32>>,
+    blocked: HashMap<u32, Blocker>,
+}
+
+impl ScriptScheduler {
+    pub(super) fn spawn(&mut self, handle: u32) {
+        self.run_queue.insert(handle);
+    }
+
+    /// Advances the clock by one tick and releases expired sleepers.
+    pub(super) fn begin_tick(&mut self) {
+        self.tick += 1;
+        for handle in self.timers.expire(self.tick) {
+            self.blocked.remove(&handle);
+            self.run_queue.insert(handle);
+        }
+    }
+
+    /// Takes the scripts runnable in this pass; yields during the pass queue
+    /// them for the next one.
+    pub(super) fn take_runnable(&mut self) -> BTreeSet<u32> {
+        std::mem::take(&mut self.run_queue)
+    }
+
+    pub(super) fn requeue(&mut self, handle: u32) {
+        if !self.blocked.contains_key(&handle) {
+            self.run_queue.insert(handle);
+        }
+    }
+
+    /// Parks a script that has used up its yield budget. Anything waiting on
+    /// it is woken so it can stop relying on the scheduler to finish it.
+    pub(super) fn exhaust(&mut self, handle: u32) {
+        self.run_queue.remove(&handle);
+        self.exhausted.insert(handle);
+        self.wake(WaitCondition::Script(handle));
+    }
+
+    pub(super) fn is_exhausted(&self, handle: u32) -> bool {
+        self.exhausted.contains(&handle)
+    }
+
+    /// Returns exhausted scripts to the run queue when `within_budget` says
+    /// a larger budget now covers them.
+    pub(super) fn restore_budget(&mut self, within_budget: impl Fn(u32) -> bool) {
+        let restored: Vec<u32> = self
+            .exhausted
+            .iter()
+            .copied()
+            .filter(|handle| within_budget(*handle))
+            .collect();
+        for handle in restored {
+            self.exhausted.remove(&handle);
+            self.run_queue.insert(handle);
+        }
+    }
+
+    pub(super) fn running(&self) -> Option<u32> {
+        self.running
+    }
+
+    /// The running script, if a blocking call may park it. Only the engine
+    /// loop's ticks wake sleepers and movie waiters, so until the first tick
+    /// (the boot drives) blocking calls keep their inline behaviour.
+    pub(super) fn parkable(&self) -> Option<u32> {
+        self.running.filter(|_| self.tick > 0)
+    }
+
+    /// Marks `handle` as the coroutine being resumed, returning the previous
+    /// one so nested resumes can restore it.
+    pub(super) fn enter(&mut self, handle: u32) -> Option<u32> {
+        self.running.replace(handle)
+    }
+
+    pub(super) fn leave(&mut self, previous: Option<u32>) {
+        self.running = previous;
+    }
+
+    pub(super) fn sleep(&mut self, handle: u32, ticks: u64) {
+        let deadline = self.tick + ticks.max(1);
+        self.unblock(handle);
+        self.run_queue.remove(&handle);
+        self.timers.insert(deadline, handle);
+        self.blocked.insert(handle, Blocker::Timer(deadline));
+    }
+
+    pub(super) fn wait(&mut self, handle: u32, condition: WaitCondition) {
+        self.unblock(handle);
+        self.run_queue.remove(&handle);
+        self.waits.entry(condition).or_default().push(handle);
+        self.blocked.insert(handle, Blocker::Wait(condition));
+    }
+
+    pub(super) fn has_waiters(&self, condition: WaitCondition) -> bool {
+        self.waits.contains_key(&condition)
+    }
+
+    pub(super) fn wake(&mut self, condition: WaitCondition) {
+        for handle in self.waits.remove(&condition).unwrap_or_default() {
+            self.blocked.remove(&handle);
+            self.run_queue.insert(handle);
+        }
+    }
+
+    /// Drops every trace of a completed script and wakes its waiters.
+    pub(super) fn forget(&mut self, handle: u32) {
+        self.run_queue.remove(&handle);
+        self.exhausted.remove(&handle);
+        self.unblock(handle);
+        self.wake(WaitCondition::Script(handle));
+    }
+
+    /// Removes `handle` from whichever timer or wait-list holds it. A script
+    /// resumed outside the scheduler (see `wait_for_script`) can park again
+    /// before its earlier blocker fires.
+    fn unblock(&mut self, handle: u32) {
+        match self.blocked.remove(&handle) {
+            Some(Blocker::Timer(deadline)) => self.timers.cancel(deadline, handle),
+            Some(Blocker::Wait(condition)) => {
+                if let Some(waiters) = self.waits.get_mut(&condition) {
+                    waiters.retain(|waiter| *waiter != handle);
+                    if waiters.is_empty() {
+                        self.waits.remove(&condition);
+                    }
+                }
+            }
+            None => {}
+        }
+    }
+}
+
+/// Ticks needed to sleep for `millis`, rounded up to at least one.
+pub(super) fn ticks_for_millis(millis: f64) -> u64 {
+    if millis.is_finite() && millis > 0.0 {
+        (millis / TICK_MILLIS).ceil() as u64
+    } else {
+        1
+    }
+}
+
+/// Hashed timer wheel: a deadline lands in slot `deadline % WHEEL_SLOTS`, and
+/// each tick only inspects its own slot. Deadlines further out than one
+/// revolution stay in their slot until their lap comes round.
+#[derive(Debug)]
+struct TimerWheel {
+    slots: Vec<Vec<(u64, u32)>>,
+}
+
+impl Default for TimerWheel {
+    fn default() -> Self {
+        Self {
+            slots: vec![Vec::new(); WHEEL_SLOTS],
+        }
+    }
+}
+
+impl TimerWheel {
+    fn insert(&mut self, deadline: u64, handle: u32) {
+        self.slot_mut(deadline).push((deadline, handle));
+    }
+
+    fn cancel(&mut self, deadline: u64, handle: u32) {
+        self.slot_mut(deadline)
+            .retain(|entry| *entry != (deadline, handle));
+    }
+
+    fn expire(&mut self, tick: u64) -> Vec<u32> {
+        let slot = self.slot_mut(tick);
+        if slot.is_empty() {
+            return Vec::new();
+        }
+        let mut expired = Vec::new();
+        slot.retain(|&(deadline, handle)| {
+            if deadline <= tick {
+                expired.push(handle);
+                false
+            } else {
+                true
+            }
+        });
+        expired.sort_unstable();
+        expired
+    }
+
+    fn slot_mut(&mut self, deadline: u64) -> &mut Vec<(u64, u32)> {
+        &mut self.slots[(deadline % WHEEL_SLOTS as u64) as usize]
+    }
+}
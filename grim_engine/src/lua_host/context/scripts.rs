@@ -2,6 +2,8 @@ use std::collections::BTreeMap;
 
 use mlua::RegistryKey;
 
+use super::scheduler::{ScriptScheduler, WaitCondition};
+
 #[derive(Debug)]
 pub(super) struct ScriptRecord {
     label: String,
@@ -20,6 +22,7 @@ pub(super) struct ScriptCleanup {
 pub(super) struct ScriptRuntime {
     next_handle: u32,
     records: BTreeMap<u32, ScriptRecord>,
+    scheduler: ScriptScheduler,
 }
 
 impl ScriptRuntime {
@@ -27,6 +30,7 @@ impl ScriptRuntime {
         ScriptRuntime {
             next_handle: 1,
             records: BTreeMap::new(),
+            scheduler: ScriptScheduler::default(),
         }
     }
 
@@ -46,6 +50,7 @@ impl ScriptRuntime {
                 callable,
             },
         );
+        self.scheduler.spawn(handle);
         (handle, format!("script.start {label} (#{handle})"))
     }
 
@@ -91,6 +96,7 @@ impl ScriptRuntime {
 
     pub(super) fn complete_script(&mut self, handle: u32) -> (ScriptCleanup, Option<String>) {
         if let Some(record) = self.records.remove(&handle) {
+            self.scheduler.forget(handle);
             let message = format!("script.complete {} (#{handle})", record.label);
             (
                 ScriptCleanup {
@@ -110,6 +116,60 @@ impl ScriptRuntime {
             .find_map(|(handle, record)| (record.label == label).then_some(*handle))
     }
 
+    /// Returns exhausted scripts to the run queue when `max_yields` gives
+    /// them budget again.
+    pub(super) fn restore_budget(&mut self, max_yields: u32) {
+        let records = &self.records;
+        self.scheduler.restore_budget(|handle| {
+            records
+                .get(&handle)
+                .is_some_and(|record| record.yields < max_yields)
+        });
+    }
+
+    pub(super) fn scheduler(&self) -> &ScriptScheduler {
+        &self.scheduler
+    }
+
+    pub(super) fn scheduler_mut(&mut self) -> &mut ScriptScheduler {
+        &mut self.scheduler
+    }
+
+    /// Parks the running script for `ticks`; false when nothing can be parked.
+    pub(super) fn sleep_running(&mut self, ticks: u64) -> bool {
+        let Some(handle) = self.scheduler.parkable() else {
+            return false;
+        };
+        self.scheduler.sleep(handle, ticks);
+        true
+    }
+
+    /// Parks the running script until `target` completes. Returns false when
+    /// the scheduler cannot finish `target` on its own (nothing parkable,
+    /// a self-wait, or `target` is out of yield budget).
+    pub(super) fn wait_for_script(&mut self, target: u32) -> bool {
+        let Some(handle) = self.scheduler.parkable() else {
+            return false;
+        };
+        if handle == target
+            || !self.records.contains_key(&target)
+            || self.scheduler.is_exhausted(target)
+        {
+            return false;
+        }
+        self.scheduler.wait(handle, WaitCondition::Script(target));
+        true
+    }
+
+    /// Parks the running script until the fullscreen movie ends.
+    pub(super) fn wait_for_movie(&mut self) -> bool {
+        let Some(handle) = self.scheduler.parkable() else {
+            return false;
+        };
+        self.scheduler.wait(handle, WaitCondition::Movie);
+        true
+    }
+
     pub(super) fn is_empty(&self) -> bool {
         self.records.is_empty()
     }
@@ -166,6 +226,26 @@ impl<'a> ScriptRuntimeAdapter<'a> {
         }
         cleanup
     }
+
+    pub(super) fn restore_budget(&mut self, max_yields: u32) {
+        self.runtime.restore_budget(max_yields);
+    }
+
+    pub(super) fn scheduler(&mut self) -> &mut ScriptScheduler {
+        self.runtime.scheduler_mut()
+    }
+
+    pub(super) fn sleep_running(&mut self, ticks: u64) -> bool {
+        self.runtime.sleep_running(ticks)
+    }
+
+    pub(super) fn wait_for_script(&mut self, target: u32) -> bool {
+        self.runtime.wait_for_script(target)
+    }
+
+    pub(super) fn wait_for_movie(&mut self) -> bool {
+        self.runtime.wait_for_movie()
+    }
 }
 
 impl<'a> ScriptRuntimeView<'a> {
@@ -200,4 +280,12 @@ impl<'a> ScriptRuntimeView<'a> {
     pub(super) fn label(&self, handle: u32) -> Option<String> {
         self.runtime.label(handle).map(|label| label.to_string())
     }
+
+    pub(super) fn has_waiters(&self, condition: WaitCondition) -> bool {
+        self.runtime.scheduler().has_waiters(condition)
+    }
+
+    pub(super) fn running(&self) -> Option<u32> {
+        self.runtime.scheduler().running()
+    }
 }
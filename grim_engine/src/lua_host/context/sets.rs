@@ -1,10 +1,12 @@
 use std::collections::{BTreeMap, BTreeSet};
 use std::rc::Rc;
+use std::sync::Arc;
 
 use super::geometry::{ParsedSetGeometry, SectorHit, SetDescriptor, SetSnapshot, SetupInfo};
+use super::preload::SetPreloader;
 use crate::lab_collection::LabCollection;
 use grim_analysis::resources::ResourceGraph;
-use grim_formats::{SectorKind as SetSectorKind, SetFile as SetFileData};
+use grim_formats::{SectorKind as SetSectorKind, SetView};
 
 #[derive(Debug)]
 pub(crate) struct SetRuntime {
@@ -15,7 +17,8 @@ pub(crate) struct SetRuntime {
     current_set: Option<SetSnapshot>,
     set_geometry: BTreeMap<String, ParsedSetGeometry>,
     sector_states: BTreeMap<String, BTreeMap<String, bool>>,
-    lab_collection: Option<Rc<LabCollection>>,
+    lab_collection: Option<Arc<LabCollection>>,
+    preloader: Option<SetPreloader>,
 }
 
 /// Couples set runtime mutations with the engine event log.
@@ -160,7 +163,7 @@ impl SetRuntime {
     pub(crate) fn new(
         resources: Rc<ResourceGraph>,
         verbose: bool,
-        lab_collection: Option<Rc<LabCollection>>,
+        lab_collection: Option<Arc<LabCollection>>,
     ) -> Self {
         let mut available_sets = BTreeMap::new();
         for meta in &resources.sets {
@@ -182,6 +185,13 @@ impl SetRuntime {
             );
         }
 
+        let mut preloader = lab_collection.as_ref().and_then(|collection| {
+            SetPreloader::spawn(collection.clone(), ResourceGraph::clone(&resources))
+        });
+        if let Some(preloader) = preloader.as_mut() {
+            preloader.prefetch_boot();
+        }
+
         Self {
             verbose,
             available_sets,
@@ -190,6 +200,7 @@ impl SetRuntime {
             current_set: None,
             set_geometry: BTreeMap::new(),
             sector_states: BTreeMap::new(),
+            preloader,
             lab_collection,
         }
     }
@@ -209,6 +220,10 @@ impl SetRuntime {
             display_name,
         });
         self.current_setups.entry(set_key).or_insert(0);
+        if let Some(preloader) = self.preloader.as_mut() {
+            let cached = &self.set_geometry;
+            preloader.prefetch_around(set_file, |name| cached.contains_key(name));
+        }
         self.current_set
             .as_ref()
             .expect("current set just assigned")
@@ -452,34 +467,24 @@ impl SetRuntime {
         if self.set_geometry.contains_key(set_file) {
             return None;
         }
+        if let Some(geometry) = self
+            .preloader
+            .as_mut()
+            .and_then(|preloader| preloader.take(set_file))
+        {
+            return self.cache_geometry(set_file, geometry);
+        }
         let Some(collection) = &self.lab_collection else {
             return None;
         };
         match collection.find_entry(set_file) {
             Some((archive, entry)) => {
                 let bytes = archive.read_entry_bytes(entry);
-                match SetFileData::parse(&bytes) {
-                    Ok(file) => {
-                        let geometry = ParsedSetGeometry::from_set_file(file);
+                match SetView::parse(bytes) {
+                    Ok(set) => {
+                        let geometry = ParsedSetGeometry::from_set_view(&set);
                         if geometry.has_geometry() {
-                            let sector_count = geometry.sectors.len();
-                            let setup_count = geometry.setups.len();
-                            self.sector_states
-                                .entry(set_file.to_string())
-                                .or_insert_with(|| {
-                                    let mut map = BTreeMap::new();
-                                    for sector in &geometry.sectors {
-                                        map.insert(sector.name.clone(), sector.default_active);
-                                    }
-                                    map
-                                });
-                            self.set_geometry.insert(set_file.to_string(), geometry);
-                            if self.verbose {
-                                return Some(format!(
-                                    "set.geometry {set_file} sectors={} setups={}",
-                                    sector_count, setup_count
-                                ));
-                            }
+                            return self.cache_geometry(set_file, geometry);
                         } else if self.verbose {
                             eprintln!(
                                 "[grim_engine] info: {} contained no geometry data",
@@ -508,4 +513,27 @@ impl SetRuntime {
         }
         None
     }
+
+    fn cache_geometry(&mut self, set_file: &str, geometry: ParsedSetGeometry) -> Option<String> {
+        let sector_count = geometry.sectors.len();
+        let setup_count = geometry.setups.len();
+        self.sector_states
+            .entry(set_file.to_string())
+            .or_insert_with(|| {
+                let mut map = BTreeMap::new();
+                for sector in &geometry.sectors {
+                    map.insert(sector.name.clone(), sector.default_active);
+                }
+                map
+            });
+        self.set_geometry.insert(set_file.to_string(), geometry);
+        if self.verbose {
+            Some(format!(
+                "set.geometry {set_file} sectors={} setups={}",
+                sector_count, setup_count
+            ))
+        } else {
+            None
+        }
+    }
 }
@@ -0,0 +1,227 @@
+//! Fixed-timestep pacing for the engine loop.
+//!
+//! Simulation advances in whole `step`s measured against the wall clock, so
+//! a slow frame is followed by catch-up ticks instead of silently stretching
+//! the timeline. Waiting sleeps for most of the gap and spins the last
+//! stretch, which keeps tick starts within a few microseconds of their
+//! deadline instead of inheriting the scheduler's sleep jitter.
+
+use std::collections::VecDeque;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use grim_stream::FrameStats;
+
+/// Portion of each wait spent spinning rather than sleeping.
+const SPIN_MARGIN: Duration = Duration::from_micros(2_000);
+
+/// Ticks covered by the rolling percentiles (~10 s at 30 Hz).
+const STATS_WINDOW: usize = 300;
+
+/// Accumulates wall time and hands it out in fixed steps.
+#[derive(Debug)]
+pub(super) struct FrameClock {
+    step: Duration,
+    max_catch_up: u32,
+    last: Instant,
+    accumulator: Duration,
+    catch_up_ticks: u64,
+    dropped_ticks: u64,
+}
+
+impl FrameClock {
+    /// Starts with one step banked so the first tick runs immediately.
+    pub(super) fn new(step: Duration, max_catch_up: u32) -> Self {
+        Self::starting_at(step, max_catch_up, Instant::now())
+    }
+
+    fn starting_at(step: Duration, max_catch_up: u32, now: Instant) -> Self {
+        Self {
+            step,
+            max_catch_up: max_catch_up.max(1),
+            last: now,
+            accumulator: step,
+            catch_up_ticks: 0,
+            dropped_ticks: 0,
+        }
+    }
+
+    pub(super) fn step(&self) -> Duration {
+        self.step
+    }
+
+    /// Number of ticks to simulate now, at most `max_catch_up`. A backlog
+    /// beyond that is dropped (and counted) so one long stall cannot turn
+    /// into a burst of ticks that stalls the next frame too.
+    pub(super) fn due_ticks(&mut self) -> u32 {
+        self.due_ticks_at(Instant::now())
+    }
+
+    fn due_ticks_at(&mut self, now: Instant) -> u32 {
+        self.accumulator += now.saturating_duration_since(self.last);
+        self.last = now;
+
+        let mut due = 0;
+        while self.accumulator >= self.step && due < self.max_catch_up {
+            self.accumulator -= self.step;
+            due += 1;
+        }
+        if self.accumulator >= self.step {
+            let step = self.step.as_nanos();
+            let backlog = self.accumulator.as_nanos();
+            self.dropped_ticks += (backlog / step) as u64;
+            self.accumulator = Duration::from_nanos((backlog % step) as u64);
+        }
+        if due > 1 {
+            self.catch_up_ticks += u64::from(due - 1);
+        }
+        due
+    }
+
+    /// Blocks until the next step is due.
+    pub(super) fn wait_for_next_tick(&self) {
+        let remaining = self.step.saturating_sub(self.accumulator);
+        wait_until(self.last + remaining);
+    }
+}
+
+/// Sleeps while the deadline is comfortably ahead, then spins.
+fn wait_until(deadline: Instant) {
+    loop {
+        let now = Instant::now();
+        if now >= deadline {
+            return;
+        }
+        let remaining = deadline - now;
+        if remaining > SPIN_MARGIN {
+            thread::sleep(remaining - SPIN_MARGIN);
+        } else {
+            std::hint::spin_loop();
+        }
+    }
+}
+
+/// Rolling record of how long each tick's work took.
+#[derive(Debug, Default)]
+pub(super) struct FrameTimes {
+    samples: VecDeque<Duration>,
+    overruns: u64,
+}
+
+impl FrameTimes {
+    /// Records one batch of ticks simulated back to back. Each tick is its
+    /// own sample, so a catch-up batch of cheap ticks does not read as one
+    /// overrun. `shared` is work done once per batch (publishing state) and
+    /// is charged to the last tick.
+    pub(super) fn record_batch(&mut self, ticks: &[Duration], shared: Duration, step: Duration) {
+        let Some((last, earlier)) = ticks.split_last() else {
+            return;
+        };
+        for work in earlier {
+            self.record(*work, step);
+        }
+        self.record(*last + shared, step);
+    }
+
+    fn record(&mut self, work: Duration, step: Duration) {
+        if self.samples.len() == STATS_WINDOW {
+            self.samples.pop_front();
+        }
+        self.samples.push_back(work);
+        if work > step {
+            self.overruns += 1;
+        }
+    }
+
+    pub(super) fn snapshot(&self, clock: &FrameClock) -> FrameStats {
+        let mut sorted: Vec<Duration> = self.samples.iter().copied().collect();
+        sorted.sort_unstable();
+        let at = |quantile: f64| -> f32 {
+            if sorted.is_empty() {
+                return 0.0;
+            }
+            let rank = ((sorted.len() as f64 * quantile).ceil() as usize).clamp(1, sorted.len());
+            millis(sorted[rank - 1])
+        };
+        FrameStats {
+            window: sorted.len() as u32,
+            p50_ms: at(0.50),
+            p99_ms: at(0.99),
+            max_ms: sorted.last().copied().map(millis).unwrap_or(0.0),
+            overruns: self.overruns,
+            catch_up_ticks: clock.catch_up_ticks,
+            dropped_ticks: clock.dropped_ticks,
+        }
+    }
+}
+
+fn millis(duration: Duration) -> f32 {
+    (duration.as_secs_f64() * 1_000.0) as f32
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const STEP: Duration = Duration::from_millis(33);
+
+    #[test]
+    fn clock_catches_up_then_drops_backlog() {
+        let start = Instant::now();
+        let mut clock = FrameClock::starting_at(STEP, 3, start);
+        assert_eq!(clock.due_ticks_at(start), 1);
+        assert_eq!(clock.due_ticks_at(start + STEP / 2), 0);
+        assert_eq!(clock.due_ticks_at(start + STEP), 1);
+
+        // Two and a half steps late: two ticks now, the half step carries over.
+        let late = start + STEP * 3 + STEP / 2;
+        assert_eq!(clock.due_ticks_at(late), 2);
+        assert_eq!(clock.catch_up_ticks, 1);
+        assert_eq!(clock.due_ticks_at(late + STEP / 2), 1);
+
+        // Ten steps late with a cap of three: the other seven are dropped.
+        let stalled = late + STEP / 2 + STEP * 10;
+        assert_eq!(clock.due_ticks_at(stalled), 3);
+        assert_eq!(clock.dropped_ticks, 7);
+        assert_eq!(clock.due_ticks_at(stalled), 0);
+    }
+
+    #[test]
+    fn frame_times_report_rolling_percentiles() {
+        let clock = FrameClock::starting_at(STEP, 3, Instant::now());
+        let mut times = FrameTimes::default();
+        for ms in 1..=100 {
+            times.record(Duration::from_millis(ms), STEP);
+        }
+        let stats = times.snapshot(&clock);
+        assert_eq!(stats.window, 100);
+        assert_eq!(stats.p50_ms, 50.0);
+        assert_eq!(stats.p99_ms, 99.0);
+        assert_eq!(stats.max_ms, 100.0);
+        assert_eq!(stats.overruns, 67);
+    }
+
+    #[test]
+    fn catch_up_batches_record_each_tick() {
+        let clock = FrameClock::starting_at(STEP, 3, Instant::now());
+        let mut times = FrameTimes::default();
+        let ms = Duration::from_millis;
+
+        // Three 20 ms ticks take 60 ms together, but none overran its step.
+        times.record_batch(&[ms(20), ms(20), ms(20)], ms(1), STEP);
+        let stats = times.snapshot(&clock);
+        assert_eq!(stats.window, 3);
+        assert_eq!(stats.max_ms, 21.0);
+        assert_eq!(stats.overruns, 0);
+
+        // The shared publish cost lands on the last tick only.
+        times.record_batch(&[ms(30), ms(40)], ms(5), STEP);
+        let stats = times.snapshot(&clock);
+        assert_eq!(stats.window, 5);
+        assert_eq!(stats.max_ms, 45.0);
+        assert_eq!(stats.overruns, 1);
+
+        times.record_batch(&[], ms(5), STEP);
+        assert_eq!(times.snapshot(&clock).window, 5);
+    }
+}
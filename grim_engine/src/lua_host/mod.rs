@@ -1,4 +1,5 @@
 mod context;
+mod frame_clock;
 mod state_update;
 mod types;
 
@@ -10,17 +11,20 @@ use std::fs::{self, File, OpenOptions};
 use std::io::Write;
 use std::path::{Path, PathBuf};
 use std::rc::Rc;
+use std::sync::Arc;
 use std::thread;
 use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
 
 use anyhow::{Context, Result};
 use grim_analysis::resources::ResourceGraph;
+use grim_stream::FrameStats;
 use mlua::{Lua, LuaOptions, StdLib};
 
 use crate::lab_collection::LabCollection;
 use crate::stream::{MovieControlEvents, StreamServer, StreamViewerGate};
 use context::EngineContextHandle;
 use crossbeam_channel::TryRecvError;
+use frame_clock::{FrameClock, FrameTimes};
 use state_update::StateUpdateBuilder;
 
 pub fn run_boot_sequence(
@@ -32,6 +36,7 @@ pub fn run_boot_sequence(
     audio_callback: Option<Rc<dyn AudioCallback>>,
     stream: Option<StreamServer>,
     stream_ready: Option<PathBuf>,
+    profile_scripts: Option<&Path>,
 ) -> Result<Option<EngineRuntime>> {
     let resources = Rc::new(
         ResourceGraph::from_data_root(data_root)
@@ -43,7 +48,7 @@ pub fn run_boot_sequence(
         .unwrap_or_else(|| PathBuf::from("dev-install"));
     let lab_collection = if lab_root_path.is_dir() {
         match LabCollection::load_from_dir(&lab_root_path) {
-            Ok(collection) => Some(Rc::new(collection)),
+            Ok(collection) => Some(Arc::new(collection)),
             Err(err) => {
                 eprintln!(
                     "[grim_engine] warning: failed to load LAB archives from {}: {:?}",
@@ -73,6 +78,9 @@ pub fn run_boot_sequence(
         lab_root_path.clone(),
     )));
     let context_handle = context::EngineContextHandle::new(context.clone());
+    if let Some(path) = profile_scripts {
+        context.borrow_mut().enable_script_profiler(path)?;
+    }
 
     context::install_package_path(&lua, data_root)?;
     context::install_globals(&lua, data_root, context.clone())?;
@@ -86,6 +94,7 @@ pub fn run_boot_sequence(
     {
         context::drive_active_scripts(&lua, context.clone(), 16, 64)?;
     }
+    context.borrow_mut().end_script_profile_tick();
 
     let snapshot = context.borrow();
     context::dump_runtime_summary(&snapshot);
@@ -121,12 +130,32 @@ pub fn run_boot_sequence(
             defer_intro_playback,
         ))
     } else {
+        finish_script_profile(&context)?;
         None
     };
 
     Ok(runtime)
 }
 
+/// Writes the `--profile-scripts` report and trace, if profiling is on.
+fn finish_script_profile(context: &Rc<RefCell<context::EngineContext>>) -> Result<()> {
+    if let Some((report, trace)) = context.borrow_mut().finish_script_profile()? {
+        eprintln!(
+            "[grim_engine] wrote script profile to {} (trace {})",
+            report.display(),
+            trace.display()
+        );
+    }
+    Ok(())
+}
+
+/// Length of one engine tick (~30 Hz). The frame clock paces the loop by it,
+/// the script scheduler converts sleeps into it, and the profiler budgets it.
+pub(crate) const TICK_DURATION: Duration = Duration::from_millis(33);
+
+/// Ticks `EngineRuntime` replays after a stall unless `--max-catch-up` says otherwise.
+pub const DEFAULT_MAX_CATCH_UP: u32 = 4;
+
 /// Drives the embedded Lua runtime and publishes live state over GrimStream.
 pub struct EngineRuntime {
     lua: Lua,
@@ -141,6 +170,8 @@ pub struct EngineRuntime {
     movie_controls: Option<MovieControlEvents>,
     log_file: Option<File>,
     defer_intro_cutscene: bool,
+    /// Most ticks simulated back to back when the loop falls behind.
+    max_catch_up: u32,
 }
 
 impl EngineRuntime {
@@ -182,11 +213,30 @@ impl EngineRuntime {
             movie_controls,
             log_file: open_live_preview_log(),
             defer_intro_cutscene,
+            max_catch_up: DEFAULT_MAX_CATCH_UP,
         }
     }
 
+    /// Caps how many ticks one wake-up may simulate; a longer backlog is
+    /// dropped rather than replayed.
+    pub fn with_max_catch_up(mut self, ticks: u32) -> Self {
+        self.max_catch_up = ticks.max(1);
+        self
+    }
+
     pub fn run(mut self) -> Result<()> {
-        const FRAME_DURATION: Duration = Duration::from_millis(33);
+        let result = self.run_loop();
+        if let Err(err) = finish_script_profile(&self.context) {
+            eprintln!("[grim_engine] warning: failed to write script profile: {err:?}");
+        }
+        result
+    }
+
+    fn run_loop(&mut self) -> Result<()> {
+        // Rewrite the script profile every ~10 s so a killed run still leaves one.
+        const PROFILE_FLUSH_FRAMES: u32 = 300;
+        // Attach frame pacing stats to a state update about once a second.
+        const STATS_PUBLISH_FRAMES: u32 = 30;
 
         self.await_live_preview_handshake()?;
 
@@ -197,36 +247,81 @@ impl EngineRuntime {
             self.defer_intro_cutscene = false;
         }
 
+        // Start the clock after the handshake so waiting for the viewer does
+        // not count as a backlog of missed ticks.
+        let mut clock = FrameClock::new(TICK_DURATION, self.max_catch_up);
+        let mut frame_times = FrameTimes::default();
+        let mut frames_since_stats = 0;
+        let mut tick_work = Vec::new();
+
         loop {
-            let tick_start = Instant::now();
-            context::drive_active_scripts(&self.lua, self.context.clone(), 8, 32)?;
-            self.frame = self.frame.wrapping_add(1);
-            self.poll_movie_controls();
-
-            if let Some(update) = self
-                .state_builder
-                .build(self.frame, &self.context)
-                .context("building state update")?
-            {
-                if self.headless && !update.events.is_empty() {
-                    for event in &update.events {
-                        println!("[grim_engine][headless] {event}");
-                    }
-                }
-                if let Some(stream) = self.stream.as_ref() {
-                    if let Err(err) = stream.send_state_update(update) {
-                        eprintln!(
-                            "[grim_engine] failed to publish state update: {err:?}; continuing"
-                        );
-                    }
+            let due = clock.due_ticks();
+            if due == 0 {
+                clock.wait_for_next_tick();
+                continue;
+            }
+
+            tick_work.clear();
+            for _ in 0..due {
+                let tick_start = Instant::now();
+                self.simulate_tick(PROFILE_FLUSH_FRAMES)?;
+                tick_work.push(tick_start.elapsed());
+            }
+
+            frames_since_stats += due;
+            let frame_stats = if frames_since_stats >= STATS_PUBLISH_FRAMES {
+                frames_since_stats = 0;
+                Some(frame_times.snapshot(&clock))
+            } else {
+                None
+            };
+            let publish_start = Instant::now();
+            self.publish_state(frame_stats)?;
+
+            frame_times.record_batch(&tick_work, publish_start.elapsed(), clock.step());
+            clock.wait_for_next_tick();
+        }
+    }
+
+    /// Advances the simulation by exactly one fixed step.
+    fn simulate_tick(&mut self, profile_flush_frames: u32) -> Result<()> {
+        self.context.borrow_mut().advance_script_clock();
+        context::drive_active_scripts(&self.lua, self.context.clone(), 8, 32)?;
+        {
+            let mut ctx = self.context.borrow_mut();
+            ctx.end_script_profile_tick();
+            if self.frame % profile_flush_frames == 0 {
+                if let Err(err) = ctx.flush_script_profile() {
+                    eprintln!(
+                        "[grim_engine] warning: failed to flush script profile: {err:?}; continuing"
+                    );
                 }
             }
+        }
+        self.frame = self.frame.wrapping_add(1);
+        self.poll_movie_controls();
+        Ok(())
+    }
 
-            let elapsed = tick_start.elapsed();
-            if elapsed < FRAME_DURATION {
-                thread::sleep(FRAME_DURATION - elapsed);
+    fn publish_state(&mut self, frame_stats: Option<FrameStats>) -> Result<()> {
+        let Some(update) = self
+            .state_builder
+            .build(self.frame, &self.context, frame_stats)
+            .context("building state update")?
+        else {
+            return Ok(());
+        };
+        if self.headless && !update.events.is_empty() {
+            for event in &update.events {
+                println!("[grim_engine][headless] {event}");
+            }
+        }
+        if let Some(stream) = self.stream.as_ref() {
+            if let Err(err) = stream.send_state_update(update) {
+                eprintln!("[grim_engine] failed to publish state update: {err:?}; continuing");
             }
         }
+        Ok(())
     }
 
     fn poll_movie_controls(&mut self) {
@@ -3,7 +3,7 @@ use std::collections::BTreeMap;
 use std::rc::Rc;
 
 use anyhow::Result;
-use grim_stream::{CoverageCounter, StateUpdate};
+use grim_stream::{CoverageCounter, FrameStats, StateUpdate};
 
 use super::context::{EngineContext, EngineContextHandle};
 
@@ -47,6 +47,7 @@ impl StateUpdateBuilder {
         &mut self,
         frame: u32,
         context: &Rc<RefCell<EngineContext>>,
+        frame_stats: Option<FrameStats>,
     ) -> Result<Option<StateUpdate>> {
         self.ensure_manny_handle();
 
@@ -179,6 +180,10 @@ impl StateUpdateBuilder {
             changed = true;
         }
 
+        if frame_stats.is_some() {
+            changed = true;
+        }
+
         if new_events.is_empty() && !changed {
             return Ok(None);
         }
@@ -197,6 +202,7 @@ impl StateUpdateBuilder {
             coverage: coverage_updates,
             events: new_events,
             active_movie: self.last_movie.clone(),
+            frame_stats,
         };
 
         Ok(Some(update))
@@ -12,6 +12,8 @@ pub fn execute(args: RunLuaArgs) -> Result<()> {
         lab_root,
         stream_bind,
         stream_ready_file,
+        profile_scripts,
+        max_catch_up,
     } = args;
 
     let stream = if headless {
@@ -40,10 +42,11 @@ pub fn execute(args: RunLuaArgs) -> Result<()> {
         None,
         stream,
         stream_ready_file,
+        profile_scripts.as_deref(),
     )?;
 
     if let Some(runtime) = runtime {
-        runtime.run()?;
+        runtime.with_max_catch_up(max_catch_up).run()?;
     }
 
     Ok(())
@@ -0,0 +1,558 @@
+//! Decoder throughput for Blocky16, BM codec 3 and SNM container parsing.
+//!
+//! Every Blocky16 benchmark decodes one frame per iteration, so criterion's
+//! time is ns/frame; throughput is reported against the decoded 1555 bytes.
+//! Synthetic streams cover each frame mode and each level1/2/3 opcode class.
+//! Set `GRIM_BENCH_CORPUS` to a directory (or a single file) to also bench
+//! every `.snm`, `.bm` and `.zbm` found there.
+
+use std::io::Cursor;
+use std::path::{Path, PathBuf};
+
+use criterion::{BenchmarkId, Criterion, Throughput, black_box, criterion_group, criterion_main};
+use grim_formats::{Blocky16Decoder, SnmFile, SnmFrameIndex, decode_bm};
+use walkdir::WalkDir;
+
+const WIDTH: u16 = 640;
+const HEIGHT: u16 = 480;
+const FRAME_LEN: usize = WIDTH as usize * HEIGHT as usize * 2;
+/// Frames per synthetic sequence; the first is the seq-0 keyframe.
+const SEQUENCE_LEN: u16 = 16;
+
+/// xorshift32 so the corpus is identical between runs.
+struct Rng(u32);
+
+impl Rng {
+    fn next(&mut self) -> u32 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 17;
+        self.0 ^= self.0 << 5;
+        self.0
+    }
+
+    fn byte(&mut self) -> u8 {
+        self.next() as u8
+    }
+
+    fn below(&mut self, bound: u32) -> u32 {
+        self.next() % bound
+    }
+}
+
+/// Blocky16 payload: 560-byte header (seq, mode, swap, param tables) + gfx.
+fn blocky16_frame(rng: &mut Rng, seq: u16, mode: u8, gfx: &[u8]) -> Vec<u8> {
+    let mut frame = vec![0u8; 560];
+    for byte in frame[24..560].iter_mut() {
+        *byte = rng.byte();
+    }
+    frame[16..18].copy_from_slice(&seq.to_le_bytes());
+    frame[18] = mode;
+    // Swap mode 0 keeps the surface layout fixed, so motion vectors chosen
+    // below stay inside the decoder's backing storage on every frame.
+    frame[19] = 0;
+    frame.extend_from_slice(gfx);
+    frame
+}
+
+#[derive(Clone, Copy, Debug)]
+enum Opcode {
+    /// 0x00..=0xF4: table motion vector into the previous frame.
+    Motion,
+    /// 0xF5: explicit 16-bit motion offset.
+    MotionFar,
+    /// 0xF6: copy from the frame before last.
+    Previous,
+    /// 0xF7/0xF8: two-colour pattern (level3: four param67 pixels).
+    Pattern,
+    /// 0xF9..=0xFE: solid fill from params, param67 or an inline colour.
+    Fill,
+    /// Level3 0xF8: raw 2x2 pixels.
+    Raw,
+}
+
+impl Opcode {
+    fn name(self) -> &'static str {
+        match self {
+            Opcode::Motion => "motion",
+            Opcode::MotionFar => "motion_far",
+            Opcode::Previous => "previous",
+            Opcode::Pattern => "pattern",
+            Opcode::Fill => "fill",
+            Opcode::Raw => "raw",
+        }
+    }
+}
+
+const LEAF_OPCODES: [Opcode; 6] = [
+    Opcode::Motion,
+    Opcode::MotionFar,
+    Opcode::Previous,
+    Opcode::Pattern,
+    Opcode::Fill,
+    Opcode::Raw,
+];
+
+/// Emit one block at `level`, subdividing with 0xFF down to `leaf_level`.
+/// `leaf` of `None` picks a random opcode per block (the "mixed" stream).
+fn emit_block(rng: &mut Rng, gfx: &mut Vec<u8>, level: u8, leaf_level: u8, leaf: Option<Opcode>) {
+    let leaf_level = if leaf.is_none() && level < 3 && rng.below(4) == 0 {
+        level + 1
+    } else {
+        leaf_level
+    };
+    if level < leaf_level {
+        gfx.push(0xFF);
+        for _ in 0..4 {
+            emit_block(rng, gfx, level + 1, leaf_level, leaf);
+        }
+        return;
+    }
+
+    let opcode = leaf.unwrap_or_else(|| match rng.below(if level == 3 { 6 } else { 5 }) {
+        0 => Opcode::Motion,
+        1 => Opcode::MotionFar,
+        2 => Opcode::Previous,
+        3 => Opcode::Pattern,
+        4 => Opcode::Fill,
+        _ => Opcode::Raw,
+    });
+    match opcode {
+        Opcode::Motion => gfx.push(rng.below(0xF5) as u8),
+        Opcode::MotionFar => {
+            gfx.push(0xF5);
+            let offset = rng.below(2 * u32::from(WIDTH)) as i16 - WIDTH as i16;
+            gfx.extend_from_slice(&offset.to_le_bytes());
+        }
+        Opcode::Previous => gfx.push(0xF6),
+        Opcode::Pattern if level == 3 => {
+            gfx.push(0xF7);
+            gfx.extend_from_slice(&rng.next().to_le_bytes());
+        }
+        Opcode::Pattern => {
+            if rng.below(2) == 0 {
+                gfx.extend_from_slice(&[0xF7, rng.byte(), rng.byte(), rng.byte()]);
+            } else {
+                gfx.extend_from_slice(&[0xF8, rng.byte()]);
+                gfx.extend_from_slice(&rng.next().to_le_bytes());
+            }
+        }
+        Opcode::Fill => {
+            let code = 0xF9 + rng.below(6) as u8;
+            gfx.push(code);
+            match code {
+                0xFD => gfx.push(rng.byte()),
+                0xFE => gfx.extend_from_slice(&[rng.byte(), rng.byte()]),
+                _ => {}
+            }
+        }
+        Opcode::Raw => {
+            gfx.push(0xF8);
+            for _ in 0..8 {
+                gfx.push(rng.byte());
+            }
+        }
+    }
+}
+
+fn mode2_gfx(rng: &mut Rng, leaf_level: u8, leaf: Option<Opcode>) -> Vec<u8> {
+    let blocks = usize::from(WIDTH).div_ceil(8) * usize::from(HEIGHT).div_ceil(8);
+    let mut gfx = Vec::new();
+    for _ in 0..blocks {
+        emit_block(rng, &mut gfx, 1, leaf_level, leaf);
+    }
+    gfx
+}
+
+/// Bomp RLE stream decoding to exactly `len` bytes, mixing runs and literals.
+fn bomp_stream(rng: &mut Rng, len: usize) -> Vec<u8> {
+    let mut out = Vec::new();
+    let mut produced = 0usize;
+    while produced < len {
+        let count = (1 + rng.below(64) as usize).min(len - produced);
+        let code = ((count - 1) as u8) << 1;
+        if rng.below(2) == 0 {
+            out.extend_from_slice(&[code | 1, rng.byte()]);
+        } else {
+            out.push(code);
+            out.extend((0..count).map(|_| rng.byte()));
+        }
+        produced += count;
+    }
+    out
+}
+
+/// One synthetic sequence per Blocky16 mode / opcode class.
+fn synthetic_sequences() -> Vec<(String, Vec<Vec<u8>>)> {
+    let mut sequences = Vec::new();
+    let mut rng = Rng(0x5EED_B16A);
+    let sequence = |rng: &mut Rng, mode: u8, gfx: &mut dyn FnMut(&mut Rng) -> Vec<u8>| {
+        (0..SEQUENCE_LEN)
+            .map(|seq| {
+                let gfx = gfx(rng);
+                blocky16_frame(rng, seq, mode, &gfx)
+            })
+            .collect::<Vec<_>>()
+    };
+
+    sequences.push((
+        "mode0_raw".to_string(),
+        sequence(&mut rng, 0, &mut |rng| {
+            (0..FRAME_LEN).map(|_| rng.byte()).collect()
+        }),
+    ));
+    sequences.push((
+        "mode2_mixed".to_string(),
+        sequence(&mut rng, 2, &mut |rng| mode2_gfx(rng, 1, None)),
+    ));
+    for level in 1..=3u8 {
+        // Raw 2x2 blocks only exist at level 3.
+        let opcodes = if level == 3 {
+            &LEAF_OPCODES[..]
+        } else {
+            &LEAF_OPCODES[..5]
+        };
+        for &opcode in opcodes {
+            sequences.push((
+                format!("mode2_level{level}_{}", opcode.name()),
+                sequence(&mut rng, 2, &mut |rng| mode2_gfx(rng, level, Some(opcode))),
+            ));
+        }
+    }
+    sequences.push((
+        "mode3_copy_delta1".to_string(),
+        sequence(&mut rng, 3, &mut |_| Vec::new()),
+    ));
+    sequences.push((
+        "mode4_copy_delta0".to_string(),
+        sequence(&mut rng, 4, &mut |_| Vec::new()),
+    ));
+    let mut mode5 = sequence(&mut rng, 5, &mut |rng| bomp_stream(rng, FRAME_LEN));
+    for frame in &mut mode5 {
+        frame[36..40].copy_from_slice(&(FRAME_LEN as u32).to_le_bytes());
+    }
+    sequences.push(("mode5_bomp".to_string(), mode5));
+    sequences.push((
+        "mode6_palette".to_string(),
+        sequence(&mut rng, 6, &mut |rng| {
+            (0..FRAME_LEN / 2).map(|_| rng.byte()).collect()
+        }),
+    ));
+    sequences.push((
+        "mode8_bomp".to_string(),
+        sequence(&mut rng, 8, &mut |rng| bomp_stream(rng, FRAME_LEN)),
+    ));
+    sequences
+}
+
+/// Decode a frame sequence one frame per iteration, cycling so keyframes
+/// recur at their natural rate.
+fn bench_sequence(
+    group: &mut criterion::BenchmarkGroup<'_>,
+    name: &str,
+    width: u16,
+    height: u16,
+    frames: &[Vec<u8>],
+) {
+    let mut decoder = Blocky16Decoder::new(width, height).expect("decoder");
+    let mut out = vec![0u8; decoder.frame_len()];
+    for (index, frame) in frames.iter().enumerate() {
+        decoder
+            .decode(&mut out, frame)
+            .unwrap_or_else(|err| panic!("{name} frame {index} does not decode: {err:#}"));
+    }
+
+    group.throughput(Throughput::Bytes(decoder.frame_len() as u64));
+    let mut next = 0usize;
+    group.bench_function(BenchmarkId::from_parameter(name), |b| {
+        b.iter(|| {
+            let frame = &frames[next % frames.len()];
+            next += 1;
+            decoder
+                .decode(black_box(&mut out), black_box(frame))
+                .unwrap();
+        })
+    });
+}
+
+fn bench_blocky16_synthetic(c: &mut Criterion) {
+    let mut group = c.benchmark_group("blocky16_640x480");
+    for (name, frames) in synthetic_sequences() {
+        bench_sequence(&mut group, &name, WIDTH, HEIGHT, &frames);
+    }
+    group.finish();
+}
+
+/// Minimal LZSS encoder for BM codec 3: LSB-first flag words interleaved with
+/// literal and match bytes, exactly where the decoder will read them.
+struct Codec3Writer {
+    out: Vec<u8>,
+    flag_slot: usize,
+    flags: u16,
+    flag_count: u32,
+}
+
+impl Codec3Writer {
+    fn new() -> Self {
+        Self {
+            out: vec![0, 0],
+            flag_slot: 0,
+            flags: 0,
+            flag_count: 0,
+        }
+    }
+
+    fn bit(&mut self, bit: u16) {
+        self.flags |= bit << self.flag_count;
+        self.flag_count += 1;
+        if self.flag_count == 16 {
+            self.out[self.flag_slot..self.flag_slot + 2].copy_from_slice(&self.flags.to_le_bytes());
+            self.flag_slot = self.out.len();
+            self.out.extend_from_slice(&[0, 0]);
+            self.flags = 0;
+            self.flag_count = 0;
+        }
+    }
+
+    fn literal(&mut self, value: u8) {
+        self.bit(1);
+        self.out.push(value);
+    }
+
+    /// Long match: 12-bit back distance (1..=4096), length 4..=18 (a stored
+    /// length of 3 selects the extended form instead).
+    fn long_match(&mut self, distance: usize, len: usize) {
+        self.bit(0);
+        self.bit(1);
+        let offset = 0x1000 - distance;
+        self.out.push(offset as u8);
+        self.out
+            .push((((offset >> 8) & 0x0F) << 4) as u8 | (len - 3) as u8);
+    }
+
+    fn finish(mut self) -> Vec<u8> {
+        self.out[self.flag_slot..self.flag_slot + 2].copy_from_slice(&self.flags.to_le_bytes());
+        self.out
+    }
+}
+
+/// Codec-3 BM with dithered noise and repeated spans, roughly the literal/match
+/// mix of retail backgrounds.
+fn synthetic_codec3_bm(width: u32, height: u32) -> Vec<u8> {
+    let len = (width * height * 2) as usize;
+    let mut rng = Rng(0xC0DE_C3C3);
+    let mut writer = Codec3Writer::new();
+    let mut produced = 0usize;
+    while produced < len {
+        if produced >= 64 && rng.below(3) != 0 {
+            let run = (4 + rng.below(15) as usize).min(len - produced);
+            if run >= 4 {
+                let distance = 1 + rng.below(produced.min(4096) as u32) as usize;
+                writer.long_match(distance, run);
+                produced += run;
+                continue;
+            }
+        }
+        writer.literal(rng.byte());
+        produced += 1;
+    }
+    let stream = writer.finish();
+
+    let mut bm = vec![0u8; 0x80];
+    bm[0..4].copy_from_slice(b"BM  ");
+    bm[4..8].copy_from_slice(b"F\0\0\0");
+    bm[8..12].copy_from_slice(&3u32.to_le_bytes());
+    bm[16..20].copy_from_slice(&1u32.to_le_bytes());
+    bm[32..36].copy_from_slice(&1u32.to_le_bytes());
+    bm[36..40].copy_from_slice(&16u32.to_le_bytes());
+    bm.extend_from_slice(&width.to_le_bytes());
+    bm.extend_from_slice(&height.to_le_bytes());
+    bm.extend_from_slice(&(stream.len() as u32).to_le_bytes());
+    bm.extend_from_slice(&stream);
+    bm
+}
+
+fn bench_codec3(c: &mut Criterion) {
+    let bm = synthetic_codec3_bm(u32::from(WIDTH), u32::from(HEIGHT));
+    decode_bm(&bm).expect("synthetic codec3 bitmap decodes");
+
+    let mut group = c.benchmark_group("bm_codec3");
+    group.throughput(Throughput::Bytes(FRAME_LEN as u64));
+    group.bench_function("synthetic_640x480", |b| {
+        b.iter(|| decode_bm(black_box(&bm)).unwrap())
+    });
+    group.finish();
+}
+
+fn chunk(tag: &[u8; 4], payload: &[u8]) -> Vec<u8> {
+    let mut out = tag.to_vec();
+    out.extend_from_slice(&(payload.len() as u32).to_be_bytes());
+    out.extend_from_slice(payload);
+    if payload.len() % 2 == 1 {
+        out.push(0);
+    }
+    out
+}
+
+/// SANM container around the mixed mode-2 sequence, with an audio chunk per frame.
+fn synthetic_snm(frames: &[Vec<u8>]) -> Vec<u8> {
+    let mut shdr = Vec::new();
+    shdr.extend_from_slice(&2u16.to_le_bytes()); // version
+    shdr.extend_from_slice(&(frames.len() as u32).to_le_bytes());
+    shdr.extend_from_slice(&0u16.to_le_bytes());
+    shdr.extend_from_slice(&WIDTH.to_le_bytes());
+    shdr.extend_from_slice(&HEIGHT.to_le_bytes());
+    shdr.extend_from_slice(&0u16.to_le_bytes());
+    shdr.extend_from_slice(&15u32.to_le_bytes()); // frame rate
+    shdr.extend_from_slice(&0u16.to_le_bytes()); // flags
+    let mut wave = Vec::new();
+    wave.extend_from_slice(&22_050u32.to_le_bytes());
+    wave.extend_from_slice(&2u32.to_le_bytes());
+
+    let mut body = chunk(b"SHDR", &shdr);
+    body.extend(chunk(b"FLHD", &chunk(b"Wave", &wave)));
+    for frame in frames {
+        let mut frme = chunk(b"Bl16", frame);
+        frme.extend(chunk(b"Wave", &[0u8; 1470]));
+        body.extend(chunk(b"FRME", &frme));
+    }
+    chunk(b"SANM", &body)
+}
+
+fn bench_snm_parse(c: &mut Criterion) {
+    let frames: Vec<Vec<u8>> = synthetic_sequences()
+        .into_iter()
+        .find(|(name, _)| name == "mode2_mixed")
+        .map(|(_, frames)| frames)
+        .expect("mixed sequence");
+    let bytes = synthetic_snm(&frames);
+
+    let mut group = c.benchmark_group("snm_parse");
+    group.throughput(Throughput::Bytes(bytes.len() as u64));
+    group.bench_function("read_from", |b| {
+        b.iter(|| SnmFile::read_from(Cursor::new(black_box(&bytes[..]))).unwrap())
+    });
+    group.bench_function("index_scan", |b| {
+        b.iter(|| SnmFrameIndex::scan(black_box(&bytes)).unwrap())
+    });
+    group.finish();
+}
+
+fn corpus_paths() -> Vec<PathBuf> {
+    let Some(root) = std::env::var_os("GRIM_BENCH_CORPUS").map(PathBuf::from) else {
+        return Vec::new();
+    };
+    let mut paths: Vec<PathBuf> = WalkDir::new(&root)
+        .into_iter()
+        .filter_map(|entry| entry.ok())
+        .filter(|entry| entry.file_type().is_file())
+        .map(|entry| entry.into_path())
+        .filter(|path| corpus_kind(path).is_some())
+        .collect();
+    paths.sort();
+    if paths.is_empty() {
+        eprintln!(
+            "GRIM_BENCH_CORPUS={} contains no .snm/.bm/.zbm files",
+            root.display()
+        );
+    }
+    paths
+}
+
+fn corpus_kind(path: &Path) -> Option<&'static str> {
+    let ext = path.extension()?.to_str()?.to_ascii_lowercase();
+    match ext.as_str() {
+        "snm" => Some("snm"),
+        "bm" | "zbm" => Some("bm"),
+        _ => None,
+    }
+}
+
+fn corpus_name(path: &Path) -> String {
+    path.file_name()
+        .and_then(|name| name.to_str())
+        .unwrap_or("corpus")
+        .to_string()
+}
+
+fn bench_corpus(c: &mut Criterion) {
+    let paths = corpus_paths();
+    if paths.is_empty() {
+        return;
+    }
+
+    let mut blocky16 = c.benchmark_group("corpus_blocky16");
+    for path in paths.iter().filter(|path| corpus_kind(path) == Some("snm")) {
+        let movie = match SnmFile::open_mmap(path) {
+            Ok(movie) => movie,
+            Err(err) => {
+                eprintln!("skipping {}: {err:#}", path.display());
+                continue;
+            }
+        };
+        let header = movie.header();
+        let frames: Vec<Vec<u8>> = movie
+            .frames()
+            .filter_map(|frame| frame.blocky16.map(<[u8]>::to_vec))
+            .collect();
+        if frames.is_empty() {
+            continue;
+        }
+
+        // Per-mode breakdown of what the movie actually exercises.
+        let mut modes = [0usize; 256];
+        for frame in &frames {
+            if let Some(&mode) = frame.get(18) {
+                modes[usize::from(mode)] += 1;
+            }
+        }
+        let summary: Vec<String> = modes
+            .iter()
+            .enumerate()
+            .filter(|(_, count)| **count > 0)
+            .map(|(mode, count)| format!("mode{mode}={count}"))
+            .collect();
+        eprintln!("{}: {}", corpus_name(path), summary.join(" "));
+
+        let name = corpus_name(path);
+        bench_sequence(&mut blocky16, &name, header.width, header.height, &frames);
+    }
+    blocky16.finish();
+
+    let mut parse = c.benchmark_group("corpus_snm_parse");
+    for path in paths.iter().filter(|path| corpus_kind(path) == Some("snm")) {
+        let Ok(bytes) = std::fs::read(path) else {
+            continue;
+        };
+        parse.throughput(Throughput::Bytes(bytes.len() as u64));
+        parse.bench_function(BenchmarkId::from_parameter(corpus_name(path)), |b| {
+            b.iter(|| SnmFrameIndex::scan(black_box(&bytes)))
+        });
+    }
+    parse.finish();
+
+    let mut bitmaps = c.benchmark_group("corpus_bm");
+    for path in paths.iter().filter(|path| corpus_kind(path) == Some("bm")) {
+        let Ok(bytes) = std::fs::read(path) else {
+            continue;
+        };
+        // Delta frames may need an external seed; only bench self-contained files.
+        let Ok(decoded) = decode_bm(&bytes) else {
+            continue;
+        };
+        let output: usize = decoded.frames.iter().map(|frame| frame.data.len()).sum();
+        bitmaps.throughput(Throughput::Bytes(output as u64));
+        bitmaps.bench_function(BenchmarkId::from_parameter(corpus_name(path)), |b| {
+            b.iter(|| decode_bm(black_box(&bytes)).unwrap())
+        });
+    }
+    bitmaps.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_blocky16_synthetic,
+    bench_codec3,
+    bench_snm_parse,
+    bench_corpus
+);
+criterion_main!(benches);
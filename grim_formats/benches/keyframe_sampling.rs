@@ -0,0 +1,158 @@
+//! Pose sampling throughput for `.key` animations.
+//!
+//! Each iteration samples every joint of one animation at the next time
+//! step, so criterion's element throughput is poses/sec. A synthetic walk
+//! cycle always runs; set `GRIM_BENCH_CORPUS` to a directory (or a single
+//! file) to also bench Manny's walk keyframes (`ma_*walk*.key`) found there.
+
+use std::path::{Path, PathBuf};
+
+use criterion::{BenchmarkId, Criterion, Throughput, black_box, criterion_group, criterion_main};
+use grim_formats::{KeyframeAnimation, Pose, PoseSampler};
+use walkdir::WalkDir;
+
+const JOINTS: u32 = 40;
+const FRAMES: u32 = 24;
+/// Sub-frame step so samples land between keys and extrapolate along deltas.
+const TIME_STEP: f32 = 1.0 / 60.0;
+
+/// A walk-cycle shaped animation: every joint keyed on every frame.
+fn synthetic_walk() -> Vec<u8> {
+    let mut bytes = vec![0u8; 180];
+    bytes[..4].copy_from_slice(b"FYEK");
+    bytes[4..19].copy_from_slice(b"synthetic_walk\0");
+    bytes[48..52].copy_from_slice(&u32::MAX.to_le_bytes());
+    bytes[52..56].copy_from_slice(&15.0f32.to_le_bytes());
+    bytes[56..60].copy_from_slice(&FRAMES.to_le_bytes());
+    bytes[60..64].copy_from_slice(&JOINTS.to_le_bytes());
+    for joint in 0..JOINTS {
+        let mut header = [0u8; 44];
+        header[..5].copy_from_slice(b"joint");
+        header[32..36].copy_from_slice(&joint.to_le_bytes());
+        header[36..40].copy_from_slice(&(FRAMES + 1).to_le_bytes());
+        bytes.extend_from_slice(&header);
+        for frame in 0..=FRAMES {
+            let phase =
+                (frame as f32 / FRAMES as f32 + joint as f32 * 0.05) * std::f32::consts::TAU;
+            let values = [
+                phase.sin() * 0.1,
+                phase.cos() * 0.05,
+                0.0,
+                phase.sin() * 30.0,
+                phase.cos() * 10.0,
+                0.0,
+            ];
+            bytes.extend_from_slice(&(frame as f32).to_le_bytes());
+            bytes.extend_from_slice(&0u32.to_le_bytes());
+            for value in values {
+                bytes.extend_from_slice(&value.to_le_bytes());
+            }
+            for value in values {
+                bytes.extend_from_slice(&(value * 0.2).to_le_bytes());
+            }
+        }
+    }
+    bytes
+}
+
+fn bench_animation(
+    group: &mut criterion::BenchmarkGroup<'_>,
+    name: &str,
+    animation: &KeyframeAnimation,
+) {
+    let mut sampler = PoseSampler::new();
+    let mut pose = Pose::default();
+    let duration = animation.duration().max(TIME_STEP);
+
+    group.throughput(Throughput::Elements(1));
+    let mut time = 0.0f32;
+    group.bench_function(BenchmarkId::new("scalar", name), |b| {
+        b.iter(|| {
+            time = (time + TIME_STEP) % duration;
+            let frame = animation.frame_at(time);
+            sampler.sample_frame_scalar(black_box(animation), frame, black_box(&mut pose));
+        })
+    });
+    group.bench_function(BenchmarkId::new("dispatch", name), |b| {
+        b.iter(|| {
+            time = (time + TIME_STEP) % duration;
+            sampler.sample(black_box(animation), time, black_box(&mut pose));
+        })
+    });
+}
+
+fn bench_synthetic(c: &mut Criterion) {
+    let animation =
+        KeyframeAnimation::from_bytes(&synthetic_walk()).expect("synthetic walk parses");
+    let mut group = c.benchmark_group("key_pose_sampling");
+    bench_animation(
+        &mut group,
+        &format!("synthetic_{JOINTS}_joints"),
+        &animation,
+    );
+    group.finish();
+}
+
+fn corpus_walk_keys() -> Vec<PathBuf> {
+    let Some(root) = std::env::var_os("GRIM_BENCH_CORPUS").map(PathBuf::from) else {
+        return Vec::new();
+    };
+    let mut paths: Vec<PathBuf> = WalkDir::new(&root)
+        .into_iter()
+        .filter_map(|entry| entry.ok())
+        .filter(|entry| entry.file_type().is_file())
+        .map(|entry| entry.into_path())
+        .filter(|path| is_manny_walk(path))
+        .collect();
+    paths.sort();
+    if paths.is_empty() {
+        eprintln!(
+            "GRIM_BENCH_CORPUS={} contains no ma_*walk*.key files",
+            root.display()
+        );
+    }
+    paths
+}
+
+fn is_manny_walk(path: &Path) -> bool {
+    let Some(name) = path.file_name().and_then(|name| name.to_str()) else {
+        return false;
+    };
+    let name = name.to_ascii_lowercase();
+    name.starts_with("ma_") && name.contains("walk") && name.ends_with(".key")
+}
+
+fn bench_corpus(c: &mut Criterion) {
+    let paths = corpus_walk_keys();
+    if paths.is_empty() {
+        return;
+    }
+    let mut group = c.benchmark_group("corpus_key_pose_sampling");
+    for path in &paths {
+        let animation = match std::fs::read(path)
+            .map_err(anyhow::Error::from)
+            .and_then(|bytes| KeyframeAnimation::from_bytes(&bytes))
+        {
+            Ok(animation) => animation,
+            Err(err) => {
+                eprintln!("skipping {}: {err:#}", path.display());
+                continue;
+            }
+        };
+        let name = path
+            .file_name()
+            .and_then(|name| name.to_str())
+            .unwrap_or("corpus");
+        eprintln!(
+            "{name}: {} joints, {} keys, {} frames",
+            animation.joint_count(),
+            animation.key_count(),
+            animation.num_frames
+        );
+        bench_animation(&mut group, name, &animation);
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_synthetic, bench_corpus);
+criterion_main!(benches);
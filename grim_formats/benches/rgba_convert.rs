@@ -0,0 +1,74 @@
+use criterion::{Criterion, Throughput, black_box, criterion_group, criterion_main};
+use grim_formats::{DepthHistogram, convert};
+
+const WIDTH: usize = 640;
+const HEIGHT: usize = 480;
+
+/// Deterministic 640x480 1555 frame with a mix of gradients and noise.
+fn synthetic_1555_frame() -> Vec<u8> {
+    let mut state = 0x2545_F491u32;
+    let mut frame = Vec::with_capacity(WIDTH * HEIGHT * 2);
+    for y in 0..HEIGHT {
+        for x in 0..WIDTH {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            let pixel =
+                ((x * 31 / WIDTH) << 10 | (y * 31 / HEIGHT) << 5) as u16 | (state & 0x1F) as u16;
+            frame.extend_from_slice(&pixel.to_le_bytes());
+        }
+    }
+    frame
+}
+
+fn bench_rgba_from_1555(c: &mut Criterion) {
+    let src = synthetic_1555_frame();
+    let mut dst = vec![0u8; WIDTH * HEIGHT * 4];
+
+    let mut group = c.benchmark_group("rgba_from_1555_640x480");
+    group.throughput(Throughput::Elements((WIDTH * HEIGHT) as u64));
+    group.bench_function("scalar", |b| {
+        b.iter(|| convert::rgba_from_1555_scalar(black_box(&src), black_box(&mut dst)))
+    });
+    group.bench_function("dispatch", |b| {
+        b.iter(|| convert::rgba_from_1555(black_box(&src), black_box(&mut dst)))
+    });
+    group.finish();
+}
+
+fn bench_bm_planes(c: &mut Criterion) {
+    // The 1555 frame doubles as arbitrary 565 colour and 16-bit depth data.
+    let src = synthetic_1555_frame();
+    let mut dst = vec![0u8; WIDTH * HEIGHT * 4];
+    let (min, max) = convert::depth_range(&src).unwrap();
+
+    let mut group = c.benchmark_group("bm_planes_640x480");
+    group.throughput(Throughput::Elements((WIDTH * HEIGHT) as u64));
+    group.bench_function("565_scalar", |b| {
+        b.iter(|| convert::rgba_from_565_scalar(black_box(&src), black_box(&mut dst)))
+    });
+    group.bench_function("565_dispatch", |b| {
+        b.iter(|| convert::rgba_from_565(black_box(&src), black_box(&mut dst)))
+    });
+    group.bench_function("depth_scalar", |b| {
+        b.iter(|| {
+            convert::gray_from_depth16_scalar(black_box(&src), black_box(&mut dst), min, max - min)
+        })
+    });
+    group.bench_function("depth_dispatch", |b| {
+        b.iter(|| convert::gray_from_depth16(black_box(&src), black_box(&mut dst), min, max - min))
+    });
+    group.bench_function("depth_range_scalar", |b| {
+        b.iter(|| convert::depth_range_scalar(black_box(&src)))
+    });
+    group.bench_function("depth_range_dispatch", |b| {
+        b.iter(|| convert::depth_range(black_box(&src)))
+    });
+    group.bench_function("depth_histogram", |b| {
+        b.iter(|| DepthHistogram::from_depth16(black_box(&src)))
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_rgba_from_1555, bench_bm_planes);
+criterion_main!(benches);
@@ -0,0 +1,175 @@
+//! Sector point location: the linear scan the engine used against
+//! [`SectorIndex`].
+//!
+//! Each iteration locates one walk-sector query from a fixed walk of points
+//! across the set. Synthetic sets with hundreds of sectors always run; set
+//! `GRIM_BENCH_CORPUS` to a directory (or a single file) to also bench every
+//! `.set` file found there.
+
+use std::path::PathBuf;
+
+use criterion::{BenchmarkId, Criterion, Throughput, black_box, criterion_group, criterion_main};
+use grim_formats::{SectorIndex, SectorKind, SetFile};
+use walkdir::WalkDir;
+
+const QUERIES: usize = 4096;
+
+/// `count` irregular hexagons on a jittered grid; every fifth is a camera
+/// sector and every seventh a special one, like a set's mixed sector list.
+fn synthetic_set(count: usize) -> Vec<(SectorKind, Vec<(f32, f32)>)> {
+    let columns = (count as f32).sqrt().ceil() as usize;
+    let mut seed = 0x9e37_79b9u32;
+    let mut jitter = move || {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        (seed as f32 / u32::MAX as f32) - 0.5
+    };
+    (0..count)
+        .map(|sector| {
+            let cx = (sector % columns) as f32 + jitter() * 0.3;
+            let cy = (sector / columns) as f32 + jitter() * 0.3;
+            let vertices = (0..6)
+                .map(|corner| {
+                    let angle = corner as f32 * std::f32::consts::TAU / 6.0;
+                    let radius = 0.55 + jitter() * 0.2;
+                    (cx + angle.cos() * radius, cy + angle.sin() * radius)
+                })
+                .collect();
+            let kind = if sector % 7 == 0 {
+                SectorKind::Special
+            } else if sector % 5 == 0 {
+                SectorKind::Camera
+            } else {
+                SectorKind::Walk
+            };
+            (kind, vertices)
+        })
+        .collect()
+}
+
+/// Points spread over the set's bounds, plus a margin outside them.
+fn query_points(polygons: &[(SectorKind, Vec<(f32, f32)>)]) -> Vec<(f32, f32)> {
+    let (mut min, mut max) = ((f32::MAX, f32::MAX), (f32::MIN, f32::MIN));
+    for &(x, y) in polygons.iter().flat_map(|(_, vertices)| vertices) {
+        min = (min.0.min(x), min.1.min(y));
+        max = (max.0.max(x), max.1.max(y));
+    }
+    if min.0 > max.0 {
+        return vec![(0.0, 0.0)];
+    }
+    let margin = ((max.0 - min.0) * 0.05, (max.1 - min.1) * 0.05);
+    (0..QUERIES)
+        .map(|query| {
+            // Golden-ratio sequence: even coverage without clustering.
+            let u = (query as f32 * 0.618_034).fract();
+            let v = (query as f32 * 0.754_878).fract();
+            (
+                min.0 - margin.0 + u * (max.0 - min.0 + 2.0 * margin.0),
+                min.1 - margin.1 + v * (max.1 - min.1 + 2.0 * margin.1),
+            )
+        })
+        .collect()
+}
+
+fn bench_set(
+    group: &mut criterion::BenchmarkGroup<'_>,
+    name: &str,
+    polygons: &[(SectorKind, Vec<(f32, f32)>)],
+) {
+    let index = SectorIndex::new(
+        polygons
+            .iter()
+            .map(|(kind, vertices)| (*kind, vertices.as_slice())),
+    );
+    let points = query_points(polygons);
+
+    group.throughput(Throughput::Elements(1));
+    let mut query = 0usize;
+    group.bench_function(BenchmarkId::new("linear", name), |b| {
+        b.iter(|| {
+            query = (query + 1) % points.len();
+            index.locate_linear(SectorKind::Walk, black_box(points[query]))
+        })
+    });
+    group.bench_function(BenchmarkId::new("indexed", name), |b| {
+        b.iter(|| {
+            query = (query + 1) % points.len();
+            index.locate(SectorKind::Walk, black_box(points[query]))
+        })
+    });
+}
+
+fn bench_synthetic(c: &mut Criterion) {
+    let mut group = c.benchmark_group("sector_lookup");
+    for count in [100, 400, 1000] {
+        bench_set(
+            &mut group,
+            &format!("synthetic_{count}_sectors"),
+            &synthetic_set(count),
+        );
+    }
+    group.finish();
+}
+
+fn corpus_sets() -> Vec<PathBuf> {
+    let Some(root) = std::env::var_os("GRIM_BENCH_CORPUS").map(PathBuf::from) else {
+        return Vec::new();
+    };
+    let mut paths: Vec<PathBuf> = WalkDir::new(&root)
+        .into_iter()
+        .filter_map(|entry| entry.ok())
+        .filter(|entry| entry.file_type().is_file())
+        .map(|entry| entry.into_path())
+        .filter(|path| {
+            path.extension()
+                .and_then(|ext| ext.to_str())
+                .is_some_and(|ext| ext.eq_ignore_ascii_case("set"))
+        })
+        .collect();
+    paths.sort();
+    if paths.is_empty() {
+        eprintln!(
+            "GRIM_BENCH_CORPUS={} contains no .set files",
+            root.display()
+        );
+    }
+    paths
+}
+
+fn bench_corpus(c: &mut Criterion) {
+    let paths = corpus_sets();
+    if paths.is_empty() {
+        return;
+    }
+    let mut group = c.benchmark_group("corpus_sector_lookup");
+    for path in &paths {
+        let set = match std::fs::read(path)
+            .map_err(anyhow::Error::from)
+            .and_then(|bytes| SetFile::parse(&bytes))
+        {
+            Ok(set) => set,
+            Err(err) => {
+                eprintln!("skipping {}: {err:#}", path.display());
+                continue;
+            }
+        };
+        let polygons: Vec<(SectorKind, Vec<(f32, f32)>)> = set
+            .sectors
+            .iter()
+            .map(|sector| {
+                let vertices = sector.vertices.iter().map(|v| (v.x, v.y)).collect();
+                (sector.kind, vertices)
+            })
+            .collect();
+        let name = path
+            .file_name()
+            .and_then(|name| name.to_str())
+            .unwrap_or("corpus");
+        bench_set(&mut group, name, &polygons);
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_synthetic, bench_corpus);
+criterion_main!(benches);
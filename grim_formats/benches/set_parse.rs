@@ -0,0 +1,151 @@
+//! `.set` parsing throughput: the borrowed [`SetView`] against the owned
+//! [`SetFile`] built from it.
+//!
+//! Each iteration parses one whole set, so criterion's byte throughput is
+//! text parsed per second. A synthetic CRLF set with a few hundred sectors
+//! always runs; set `GRIM_BENCH_CORPUS` to a directory (or a single file) to
+//! also bench every `.set` inside the `.lab` archives found there, straight
+//! from the mapped archive, plus any loose `.set` files.
+
+use std::path::PathBuf;
+
+use criterion::{BenchmarkId, Criterion, Throughput, black_box, criterion_group, criterion_main};
+use grim_formats::{LabArchive, SetFile, SetView};
+use walkdir::WalkDir;
+
+const SECTORS: usize = 300;
+
+/// Retail-shaped set text: colormaps, a few setups, then `SECTORS` sectors
+/// of five vertices and three triangles each, with DOS line endings.
+fn synthetic_set() -> String {
+    let mut text = String::from(
+        "section: colormaps\r\n\tnumcolormaps\t1\r\n\tcolormap\tsynthetic.cmp\r\n\r\n",
+    );
+    text.push_str("section: setups\r\n\tnumsetups\t4\r\n");
+    for setup in 0..4 {
+        text.push_str(&format!(
+            "\tsetup\tsyn_cam{setup}\r\n\tbackground\tsyn_cam{setup}.bm\r\n\
+             \tzbuffer\tsyn_cam{setup}.zbm\r\n\tposition\t{setup}.25\t-1.5\t0.6\r\n\
+             \tinterest\t0.0\t1.0\t0.5\r\n\troll\t\t0.0\r\n\tfov\t\t52.5\r\n\
+             \tnclip\t\t0.01\r\n\tfclip\t\t3276.8\r\n"
+        ));
+    }
+    text.push_str("\r\nsection: sectors\r\n");
+    for sector in 0..SECTORS {
+        let kind = ["walk", "camera", "special"][sector % 3];
+        let x = (sector % 20) as f32 * 0.5;
+        let y = (sector / 20) as f32 * 0.5;
+        text.push_str(&format!(
+            "\tsector\t\tsyn_sector{sector}\r\n\tID\t\t{}\r\n\ttype\t\t{kind}\r\n\
+             \tdefault visibility\t\tvisible\r\n\theight\t\t0.000000\r\n\
+             \tnumvertices\t5\r\n\tvertices:\t\t{x:.6}\t{y:.6}\t0.000000\r\n",
+            1000 + sector
+        ));
+        for (dx, dy) in [(0.5, 0.0), (0.5, 0.25), (0.25, 0.5), (0.0, 0.5)] {
+            text.push_str(&format!(
+                "\t         \t\t{:.6}\t{:.6}\t0.000000\r\n",
+                x + dx,
+                y + dy
+            ));
+        }
+        text.push_str("\tnumtris 3\r\n\ttriangles:\t\t0 1 2\r\n\t\t\t\t0 2 3\r\n\t\t\t\t0 3 4\r\n");
+    }
+    text
+}
+
+fn bench_set(group: &mut criterion::BenchmarkGroup<'_>, name: &str, bytes: &[u8]) {
+    group.throughput(Throughput::Bytes(bytes.len() as u64));
+    group.bench_function(BenchmarkId::new("view", name), |b| {
+        b.iter(|| SetView::parse(black_box(bytes)).expect("set parses"))
+    });
+    group.bench_function(BenchmarkId::new("owned", name), |b| {
+        b.iter(|| SetFile::parse(black_box(bytes)).expect("set parses"))
+    });
+}
+
+fn bench_synthetic(c: &mut Criterion) {
+    let text = synthetic_set();
+    let mut group = c.benchmark_group("set_parse");
+    bench_set(
+        &mut group,
+        &format!("synthetic_{SECTORS}_sectors"),
+        text.as_bytes(),
+    );
+    group.finish();
+}
+
+fn corpus_paths() -> Vec<PathBuf> {
+    let Some(root) = std::env::var_os("GRIM_BENCH_CORPUS").map(PathBuf::from) else {
+        return Vec::new();
+    };
+    let mut paths: Vec<PathBuf> = WalkDir::new(&root)
+        .into_iter()
+        .filter_map(|entry| entry.ok())
+        .filter(|entry| entry.file_type().is_file())
+        .map(|entry| entry.into_path())
+        .filter(|path| {
+            path.extension()
+                .and_then(|ext| ext.to_str())
+                .is_some_and(|ext| {
+                    ext.eq_ignore_ascii_case("lab") || ext.eq_ignore_ascii_case("set")
+                })
+        })
+        .collect();
+    paths.sort();
+    if paths.is_empty() {
+        eprintln!(
+            "GRIM_BENCH_CORPUS={} contains no .lab or .set files",
+            root.display()
+        );
+    }
+    paths
+}
+
+fn bench_corpus(c: &mut Criterion) {
+    let paths = corpus_paths();
+    if paths.is_empty() {
+        return;
+    }
+    let mut group = c.benchmark_group("corpus_set_parse");
+    for path in &paths {
+        let is_lab = path
+            .extension()
+            .and_then(|ext| ext.to_str())
+            .is_some_and(|ext| ext.eq_ignore_ascii_case("lab"));
+        if !is_lab {
+            match std::fs::read(path) {
+                Ok(bytes) => {
+                    let name = path
+                        .file_name()
+                        .and_then(|name| name.to_str())
+                        .unwrap_or("corpus");
+                    bench_set(&mut group, name, &bytes);
+                }
+                Err(err) => eprintln!("skipping {}: {err}", path.display()),
+            }
+            continue;
+        }
+        let archive = match LabArchive::open(path) {
+            Ok(archive) => archive,
+            Err(err) => {
+                eprintln!("skipping {}: {err:#}", path.display());
+                continue;
+            }
+        };
+        for entry in archive.entries() {
+            if !entry.name.to_ascii_lowercase().ends_with(".set") {
+                continue;
+            }
+            let bytes = archive.read_entry_bytes(entry);
+            if let Err(err) = SetView::parse(bytes) {
+                eprintln!("skipping {}: {err:#}", entry.name);
+                continue;
+            }
+            bench_set(&mut group, &entry.name, bytes);
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_synthetic, bench_corpus);
+criterion_main!(benches);
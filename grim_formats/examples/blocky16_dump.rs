@@ -1,10 +1,10 @@
 use std::fs::File;
-use std::io::Write;
+use std::io::{BufReader, Write};
 use std::path::PathBuf;
 
 use anyhow::{Context, Result};
 use clap::{Parser, ValueEnum};
-use grim_formats::SnmFile;
+use grim_formats::{SnmHeader, SnmStream};
 
 #[derive(Parser)]
 #[command(
@@ -43,10 +43,11 @@ impl OutputFormat {
         }
     }
 
-    fn buffer_len(self, snm: &SnmFile) -> usize {
+    fn buffer_len(self, header: &SnmHeader) -> usize {
+        let pixels = header.width as usize * header.height as usize;
         match self {
-            OutputFormat::Rgba => snm.blocky16_rgba_len(),
-            OutputFormat::Packed1555 => snm.blocky16_frame_len(),
+            OutputFormat::Rgba => pixels * 4,
+            OutputFormat::Packed1555 => pixels * 2,
         }
     }
 }
@@ -56,14 +57,18 @@ fn main() -> Result<()> {
     std::fs::create_dir_all(&args.output)
         .with_context(|| format!("failed to create {}", args.output.display()))?;
 
-    let snm = SnmFile::open(&args.input)?;
+    // Stream frames straight off disk so decoding starts after the first FRME.
+    let file = File::open(&args.input)
+        .with_context(|| format!("failed to open {}", args.input.display()))?;
+    let mut snm = SnmStream::new(BufReader::new(file))
+        .with_context(|| format!("failed to read SNM header from {}", args.input.display()))?;
     let mut decoder = snm
         .blocky16_decoder()
         .with_context(|| format!("failed to create decoder for {}", args.input.display()))?;
-    let mut scratch = vec![0u8; args.format.buffer_len(&snm)];
+    let mut scratch = vec![0u8; args.format.buffer_len(snm.header())];
 
     let mut written = 0usize;
-    for frame in &snm.frames {
+    while let Some(frame) = snm.next_frame()? {
         if let Some(limit) = args.limit {
             if written >= limit {
                 break;
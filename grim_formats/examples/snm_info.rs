@@ -12,17 +12,19 @@ struct Args {
 
 fn main() -> Result<()> {
     let args = Args::parse();
-    let snm = SnmFile::open(&args.input)?;
+    // Only headers are needed here, so index the mapping instead of copying payloads.
+    let snm = SnmFile::open_mmap(&args.input)?;
+    let header = snm.header();
     println!(
         "SNM {}: {} frames, {}x{}, frame_rate={} flags=0x{:04x}",
         args.input.display(),
-        snm.header.frame_count,
-        snm.header.width,
-        snm.header.height,
-        snm.header.frame_rate,
-        snm.header.flags
+        header.frame_count,
+        header.width,
+        header.height,
+        header.frame_rate,
+        header.flags
     );
-    if let Some(audio) = snm.audio {
+    if let Some(audio) = snm.audio() {
         println!(
             "Audio: {} Hz, {} channel(s)",
             audio.sample_rate, audio.channels
@@ -30,6 +32,6 @@ fn main() -> Result<()> {
     } else {
         println!("Audio: not present");
     }
-    println!("Frames parsed: {}", snm.frames.len());
+    println!("Frames indexed: {}", snm.frame_count());
     Ok(())
 }
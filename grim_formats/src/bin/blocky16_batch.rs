@@ -0,0 +1,320 @@
+use std::fs::{self, File};
+use std::io::{BufWriter, Seek, Write};
+use std::ops::Range;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+use anyhow::{Context, Result, bail};
+use clap::{Parser, ValueEnum};
+use grim_formats::{MappedSnm, SnmFile};
+use image::codecs::png::PngEncoder;
+use image::{ColorType, ImageEncoder};
+use rayon::prelude::*;
+use walkdir::WalkDir;
+
+#[derive(Parser, Debug)]
+#[command(
+    about = "Decode every SNM under a directory into frame dumps, in parallel",
+    version
+)]
+struct Args {
+    /// Directory scanned recursively for .snm movies (or a single .snm file)
+    input: PathBuf,
+
+    /// Output directory; each movie is written to a sub-directory named after it
+    output: PathBuf,
+
+    /// Output format for decoded frames
+    #[arg(long, value_enum, default_value_t = OutputFormat::Png)]
+    format: OutputFormat,
+
+    /// Worker threads (defaults to one per logical CPU)
+    #[arg(long)]
+    threads: Option<usize>,
+
+    /// Decode each movie on one worker instead of splitting at keyframes.
+    /// Splitting resets the decoder on every keyframe, which the retail decoder
+    /// does not; use this for output that matches it byte-for-byte.
+    #[arg(long)]
+    no_gop_split: bool,
+}
+
+#[derive(Clone, Copy, Debug, Eq, PartialEq, ValueEnum)]
+enum OutputFormat {
+    Png,
+    Rgba,
+    #[value(name = "1555", alias = "packed1555")]
+    Packed1555,
+}
+
+impl OutputFormat {
+    fn extension(self) -> &'static str {
+        match self {
+            OutputFormat::Png => "png",
+            OutputFormat::Rgba => "rgba",
+            OutputFormat::Packed1555 => "1555",
+        }
+    }
+}
+
+struct Movie {
+    name: String,
+    dest: PathBuf,
+    snm: MappedSnm,
+}
+
+/// Contiguous run of frames starting at a Blocky16 keyframe (seq 0). When
+/// movies are split, runs are decoded with keyframe resets enabled so a fresh
+/// decoder needs no state from earlier frames.
+struct GopJob {
+    movie: usize,
+    frames: Range<usize>,
+    keyframe_reset: bool,
+}
+
+#[derive(Default)]
+struct GopStats {
+    frames: usize,
+    bytes_written: u64,
+    busy: Duration,
+    /// Set when the run stopped early; frames before the error were written.
+    error: Option<anyhow::Error>,
+}
+
+fn main() -> Result<()> {
+    let args = Args::parse();
+
+    if let Some(threads) = args.threads {
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .build_global()
+            .context("configuring worker pool")?;
+    }
+
+    let paths = collect_snm_paths(&args.input)?;
+    if paths.is_empty() {
+        bail!("no .snm files found under {}", args.input.display());
+    }
+
+    let started = Instant::now();
+    let opened: Vec<(&PathBuf, Result<Movie>)> = paths
+        .par_iter()
+        .map(|path| (path, open_movie(path, &args.output)))
+        .collect();
+    let mut failed = 0usize;
+    let mut movies = Vec::new();
+    for (path, result) in opened {
+        match result {
+            Ok(movie) => movies.push(movie),
+            Err(err) => {
+                failed += 1;
+                eprintln!("{}: {err:#}", path.display());
+            }
+        }
+    }
+
+    let jobs = plan_jobs(&movies, !args.no_gop_split);
+    let results: Vec<GopStats> = jobs
+        .par_iter()
+        .map(|job| transcode_gop(&movies[job.movie], job, args.format))
+        .collect();
+    let wall = started.elapsed();
+
+    // A movie with a failed run is reported once, with its first error.
+    let mut broken = vec![false; movies.len()];
+    for (job, stats) in jobs.iter().zip(&results) {
+        if let Some(err) = &stats.error {
+            if !std::mem::replace(&mut broken[job.movie], true) {
+                failed += 1;
+                eprintln!("{}: {err:#}", movies[job.movie].name);
+            }
+        }
+    }
+
+    report(&movies, &jobs, &results, wall);
+    if failed > 0 {
+        bail!("{failed} movie(s) failed to transcode");
+    }
+    Ok(())
+}
+
+fn collect_snm_paths(input: &Path) -> Result<Vec<PathBuf>> {
+    if input.is_file() {
+        return Ok(vec![input.to_path_buf()]);
+    }
+
+    let mut paths = Vec::new();
+    for entry in WalkDir::new(input).into_iter().filter_map(|res| res.ok()) {
+        if entry.file_type().is_file()
+            && entry
+                .path()
+                .extension()
+                .and_then(|ext| ext.to_str())
+                .map(|ext| ext.eq_ignore_ascii_case("snm"))
+                .unwrap_or(false)
+        {
+            paths.push(entry.into_path());
+        }
+    }
+    paths.sort();
+    Ok(paths)
+}
+
+fn open_movie(path: &Path, output_root: &Path) -> Result<Movie> {
+    let snm = SnmFile::open_mmap(path)?;
+    let name = path
+        .file_stem()
+        .and_then(|stem| stem.to_str())
+        .unwrap_or("movie")
+        .to_string();
+    let dest = output_root.join(&name);
+    fs::create_dir_all(&dest).with_context(|| format!("creating {}", dest.display()))?;
+    Ok(Movie { name, dest, snm })
+}
+
+fn plan_jobs(movies: &[Movie], split_gops: bool) -> Vec<GopJob> {
+    let mut jobs = Vec::new();
+    for (movie_index, movie) in movies.iter().enumerate() {
+        let frame_count = movie.snm.frame_count();
+        let mut start = 0usize;
+        if split_gops {
+            for index in 1..frame_count {
+                let keyframe = movie
+                    .snm
+                    .frame(index)
+                    .and_then(|frame| frame.blocky16_seq())
+                    == Some(0);
+                if keyframe {
+                    jobs.push(GopJob {
+                        movie: movie_index,
+                        frames: start..index,
+                        keyframe_reset: true,
+                    });
+                    start = index;
+                }
+            }
+        }
+        if start < frame_count {
+            jobs.push(GopJob {
+                movie: movie_index,
+                frames: start..frame_count,
+                keyframe_reset: split_gops,
+            });
+        }
+    }
+
+    // Longest runs first so a single long GOP does not end up last in the queue.
+    jobs.sort_by_key(|job| std::cmp::Reverse(job.frames.len()));
+    jobs
+}
+
+fn transcode_gop(movie: &Movie, job: &GopJob, format: OutputFormat) -> GopStats {
+    let started = Instant::now();
+    let mut stats = GopStats::default();
+    if let Err(err) = transcode_frames(movie, job, format, &mut stats) {
+        stats.error = Some(err);
+    }
+    stats.busy = started.elapsed();
+    stats
+}
+
+fn transcode_frames(
+    movie: &Movie,
+    job: &GopJob,
+    format: OutputFormat,
+    stats: &mut GopStats,
+) -> Result<()> {
+    let header = movie.snm.header();
+    let mut decoder = movie
+        .snm
+        .blocky16_decoder()
+        .with_context(|| format!("creating decoder for {}", movie.name))?;
+    decoder.set_keyframe_reset(job.keyframe_reset);
+    let mut scratch = vec![
+        0u8;
+        match format {
+            OutputFormat::Packed1555 => movie.snm.blocky16_frame_len(),
+            _ => movie.snm.blocky16_rgba_len(),
+        }
+    ];
+
+    for index in job.frames.clone() {
+        let Some(frame) = movie.snm.frame(index) else {
+            continue;
+        };
+        let decoded = match format {
+            OutputFormat::Packed1555 => frame.decode_blocky16(&mut decoder, &mut scratch),
+            _ => frame.decode_blocky16_rgba(&mut decoder, &mut scratch),
+        }
+        .with_context(|| format!("decoding {} frame {index}", movie.name))?;
+        if !decoded {
+            continue;
+        }
+
+        let path = movie
+            .dest
+            .join(format!("frame_{index:05}.{}", format.extension()));
+        let file = File::create(&path).with_context(|| format!("creating {}", path.display()))?;
+        let mut writer = BufWriter::new(file);
+        match format {
+            OutputFormat::Png => PngEncoder::new(&mut writer)
+                .write_image(
+                    &scratch,
+                    u32::from(header.width),
+                    u32::from(header.height),
+                    ColorType::Rgba8.into(),
+                )
+                .with_context(|| format!("encoding {}", path.display()))?,
+            _ => writer
+                .write_all(&scratch)
+                .with_context(|| format!("writing {}", path.display()))?,
+        }
+        let written = writer
+            .flush()
+            .and_then(|_| writer.get_mut().stream_position())
+            .with_context(|| format!("writing {}", path.display()))?;
+
+        stats.frames += 1;
+        stats.bytes_written += written;
+    }
+    Ok(())
+}
+
+fn report(movies: &[Movie], jobs: &[GopJob], results: &[GopStats], wall: Duration) {
+    let mut per_movie: Vec<(usize, GopStats)> =
+        movies.iter().map(|_| (0, GopStats::default())).collect();
+    for (job, stats) in jobs.iter().zip(results) {
+        let (gops, total) = &mut per_movie[job.movie];
+        *gops += 1;
+        total.frames += stats.frames;
+        total.bytes_written += stats.bytes_written;
+        total.busy += stats.busy;
+    }
+
+    for (movie, (gops, stats)) in movies.iter().zip(&per_movie) {
+        println!(
+            "{:<24} {:>6} frames {:>4} gop(s) {:>8.1} frames/s busy",
+            movie.name,
+            stats.frames,
+            gops,
+            rate(stats.frames, stats.busy)
+        );
+    }
+
+    let threads = rayon::current_num_threads();
+    let frames: usize = results.iter().map(|stats| stats.frames).sum();
+    let bytes: u64 = results.iter().map(|stats| stats.bytes_written).sum();
+    let fps = rate(frames, wall);
+    println!(
+        "Decoded {frames} frame(s) from {} movie(s) in {:.2}s on {threads} thread(s): \
+         {fps:.1} frames/s, {:.1} frames/s per core, {:.1} MB/s written",
+        movies.len(),
+        wall.as_secs_f64(),
+        fps / threads as f64,
+        bytes as f64 / 1_000_000.0 / wall.as_secs_f64().max(f64::EPSILON)
+    );
+}
+
+fn rate(frames: usize, elapsed: Duration) -> f64 {
+    frames as f64 / elapsed.as_secs_f64().max(f64::EPSILON)
+}
@@ -1,16 +1,25 @@
 //! Convert LucasArts 3DO meshes into a JSON description that the viewer can load.
 //! The schema mirrors the decoded `three_do` structs (materials, meshes, faces, triangles).
+//!
+//! `--batch` instead exports every `.3do` in a LAB archive or directory into a
+//! binary mesh cache (see `grim_formats::mesh_cache`) keyed by content hash.
 
-use std::fs::{self, File};
-use std::io::{BufWriter, Write};
-use std::path::PathBuf;
+use std::borrow::Cow;
+use std::collections::{BTreeMap, HashSet};
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::time::Instant;
 
-use anyhow::Result;
+use anyhow::{Context, Result, bail};
 use clap::Parser;
+use grim_formats::mesh_cache::{self, MESH_CACHE_VERSION};
 use grim_formats::{
-    ThreeDoFace, ThreeDoGeoset, ThreeDoMesh, ThreeDoModel, ThreeDoNode, ThreeDoTriangle,
+    LabArchive, MeshCacheFile, ThreeDoFace, ThreeDoFlatModel, ThreeDoGeoset, ThreeDoMesh,
+    ThreeDoModel, ThreeDoNode, ThreeDoTriangle,
 };
-use serde::Serialize;
+use rayon::prelude::*;
+use serde::{Deserialize, Serialize};
+use walkdir::WalkDir;
 
 /// Softimage assets are authored roughly ten times smaller than the in-game
 /// coordinate system. The original engine applies this scale when staging
@@ -21,42 +30,301 @@ const SOFTIMAGE_TO_WORLD_SCALE: f32 = 10.0;
 #[command(author, version, about)]
 struct Args {
     /// Input 3DO file to convert
-    #[arg(long)]
-    input: PathBuf,
+    #[arg(long, required_unless_present = "batch", conflicts_with = "batch")]
+    input: Option<PathBuf>,
 
     /// Output JSON file path
-    #[arg(long)]
-    output: PathBuf,
+    #[arg(long, required_unless_present = "batch", conflicts_with = "batch")]
+    output: Option<PathBuf>,
 
     /// Pretty-print the JSON output
     #[arg(long, default_value_t = false)]
     pretty: bool,
+
+    /// Export every .3do in a LAB archive, or in a directory of LABs and loose files
+    #[arg(long, requires = "cache_dir")]
+    batch: Option<PathBuf>,
+
+    /// Mesh cache directory for --batch; entries are listed in index.json
+    #[arg(long)]
+    cache_dir: Option<PathBuf>,
+
+    /// With --batch, also write JSON exports to <cache-dir>/json for debugging
+    #[arg(long, default_value_t = false)]
+    json: bool,
+
+    /// Rebuild cache entries even when one for the same content already exists
+    #[arg(long, default_value_t = false)]
+    force: bool,
+
+    /// Worker threads for --batch (defaults to one per logical CPU)
+    #[arg(long)]
+    threads: Option<usize>,
 }
 
 fn main() -> Result<()> {
     let args = Args::parse();
-    let bytes = fs::read(&args.input)?;
+    if let Some(batch) = &args.batch {
+        let cache_dir = args
+            .cache_dir
+            .as_deref()
+            .expect("clap requires --cache-dir");
+        return run_batch(&args, batch, cache_dir);
+    }
+
+    let input = args.input.as_ref().expect("clap requires --input");
+    let output = args.output.as_ref().expect("clap requires --output");
+    let bytes = fs::read(input)?;
     let model = ThreeDoModel::from_bytes(&bytes)?;
-    let export = ExportModel::from(&model);
+    write_json(&ExportModel::from(&model), output, args.pretty)
+}
 
-    if let Some(parent) = args.output.parent() {
+fn write_json(export: &ExportModel, output: &Path, pretty: bool) -> Result<()> {
+    if let Some(parent) = output.parent() {
         if !parent.as_os_str().is_empty() {
             fs::create_dir_all(parent)?;
         }
     }
 
-    let file = File::create(&args.output)?;
-    let mut writer = BufWriter::new(file);
-    if args.pretty {
-        serde_json::to_writer_pretty(&mut writer, &export)?;
+    let json = if pretty {
+        serde_json::to_vec_pretty(export)?
     } else {
-        serde_json::to_writer(&mut writer, &export)?;
+        serde_json::to_vec(export)?
+    };
+    mesh_cache::write_atomic(output, &json)
+}
+
+/// Where a model's bytes live.
+enum Source {
+    File(PathBuf),
+    Lab { archive: usize, entry: usize },
+}
+
+struct ModelSource {
+    name: String,
+    source: Source,
+}
+
+enum Outcome {
+    Exported,
+    Cached,
+}
+
+#[derive(Serialize, Deserialize)]
+struct CacheIndex {
+    version: u32,
+    /// Lowercase model name to cache file name, relative to the index.
+    models: BTreeMap<String, String>,
+}
+
+fn run_batch(args: &Args, input: &Path, cache_dir: &Path) -> Result<()> {
+    if let Some(threads) = args.threads {
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .build_global()
+            .context("configuring worker pool")?;
     }
-    writer.flush()?;
 
+    let (archives, models) = collect_models(input)?;
+    if models.is_empty() {
+        bail!("no .3do models found under {}", input.display());
+    }
+    fs::create_dir_all(cache_dir).with_context(|| format!("creating {}", cache_dir.display()))?;
+
+    // Models are sorted, so the first archive holding a name owns its JSON
+    // export; later ones would race it for the same file.
+    let mut names = HashSet::new();
+    let owns_json: Vec<bool> = models
+        .iter()
+        .map(|model| names.insert(model.name.to_ascii_lowercase()))
+        .collect();
+
+    let started = Instant::now();
+    let results: Vec<(&ModelSource, Result<(u64, Outcome)>)> = models
+        .par_iter()
+        .zip(owns_json)
+        .map(|(model, owns_json)| {
+            let json = args.json && owns_json;
+            (model, export_model(model, &archives, cache_dir, json, args))
+        })
+        .collect();
+    let wall = started.elapsed();
+
+    // Entries from earlier runs over other archives stay listed; a model
+    // exported again in this run points at its current content.
+    let index_path = cache_dir.join("index.json");
+    let mut index = fs::read(&index_path)
+        .ok()
+        .and_then(|bytes| serde_json::from_slice::<CacheIndex>(&bytes).ok())
+        .filter(|index| index.version == MESH_CACHE_VERSION)
+        .unwrap_or(CacheIndex {
+            version: MESH_CACHE_VERSION,
+            models: BTreeMap::new(),
+        });
+    let mut listed = HashSet::new();
+    let (mut exported, mut cached, mut failed) = (0usize, 0usize, 0usize);
+    for (model, result) in results {
+        match result {
+            Ok((hash, outcome)) => {
+                match outcome {
+                    Outcome::Exported => exported += 1,
+                    Outcome::Cached => cached += 1,
+                }
+                // Models are sorted, so the first archive holding a name wins.
+                let name = model.name.to_ascii_lowercase();
+                if listed.insert(name.clone()) {
+                    let file = mesh_cache::cache_path(Path::new(""), hash);
+                    index.models.insert(name, file.display().to_string());
+                }
+            }
+            Err(err) => {
+                failed += 1;
+                eprintln!("{}: {err:#}", describe(&model.source, &archives));
+            }
+        }
+    }
+
+    mesh_cache::write_atomic(&index_path, &serde_json::to_vec_pretty(&index)?)?;
+
+    println!(
+        "Exported {exported} model(s), reused {cached} cached, {failed} failed in {:.2}s on {} thread(s)",
+        wall.as_secs_f64(),
+        rayon::current_num_threads()
+    );
+    if failed > 0 {
+        bail!("{failed} model(s) failed to export");
+    }
     Ok(())
 }
 
+fn export_model(
+    model: &ModelSource,
+    archives: &[LabArchive],
+    cache_dir: &Path,
+    json: bool,
+    args: &Args,
+) -> Result<(u64, Outcome)> {
+    let bytes = load(&model.source, archives)?;
+    let hash = mesh_cache::content_hash(&bytes);
+    let path = mesh_cache::cache_path(cache_dir, hash);
+
+    if json {
+        let nested = ThreeDoModel::from_bytes(&bytes)?;
+        let json_path = cache_dir
+            .join("json")
+            .join(format!("{}.json", model.name.to_ascii_lowercase()));
+        write_json(&ExportModel::from(&nested), &json_path, args.pretty)?;
+    }
+
+    let up_to_date = !args.force
+        && MeshCacheFile::open(&path).is_ok_and(|cache| cache.model().content_hash == hash);
+    if up_to_date {
+        return Ok((hash, Outcome::Cached));
+    }
+
+    let flat = ThreeDoFlatModel::from_bytes(&bytes)?;
+    let encoded = mesh_cache::encode_flat_model(&flat, hash)?;
+    // Models with identical content share a hash and may write the same
+    // entry concurrently; whichever rename lands last wins with the same bytes.
+    mesh_cache::write_atomic(&path, &encoded)?;
+    Ok((hash, Outcome::Exported))
+}
+
+/// Gathers `.3do` models from a LAB archive, a single file, or a directory
+/// tree holding loose files and/or LAB archives, sorted by name.
+fn collect_models(input: &Path) -> Result<(Vec<LabArchive>, Vec<ModelSource>)> {
+    let mut archives = Vec::new();
+    let mut models = Vec::new();
+
+    if input.is_file() {
+        if has_extension(input, "lab") {
+            archives.push(LabArchive::open(input)?);
+        } else {
+            models.push(file_source(input.to_path_buf()));
+        }
+    } else {
+        for entry in WalkDir::new(input).into_iter().filter_map(|res| res.ok()) {
+            if !entry.file_type().is_file() {
+                continue;
+            }
+            let path = entry.into_path();
+            if has_extension(&path, "3do") {
+                models.push(file_source(path));
+            } else if has_extension(&path, "lab") {
+                archives.push(LabArchive::open(&path)?);
+            }
+        }
+    }
+
+    for (archive_index, archive) in archives.iter().enumerate() {
+        for (entry_index, entry) in archive.entries().iter().enumerate() {
+            if has_extension(Path::new(&entry.name), "3do") {
+                models.push(ModelSource {
+                    name: entry.name.clone(),
+                    source: Source::Lab {
+                        archive: archive_index,
+                        entry: entry_index,
+                    },
+                });
+            }
+        }
+    }
+
+    models.sort_by(|a, b| {
+        a.name
+            .to_ascii_lowercase()
+            .cmp(&b.name.to_ascii_lowercase())
+            .then_with(|| describe(&a.source, &archives).cmp(&describe(&b.source, &archives)))
+    });
+    Ok((archives, models))
+}
+
+fn file_source(path: PathBuf) -> ModelSource {
+    ModelSource {
+        name: path
+            .file_name()
+            .map(|name| name.to_string_lossy().into_owned())
+            .unwrap_or_default(),
+        source: Source::File(path),
+    }
+}
+
+fn load<'a>(source: &Source, archives: &'a [LabArchive]) -> Result<Cow<'a, [u8]>> {
+    match source {
+        Source::File(path) => {
+            let bytes = fs::read(path).with_context(|| format!("reading {}", path.display()))?;
+            Ok(Cow::Owned(bytes))
+        }
+        Source::Lab { archive, entry } => {
+            let archive = &archives[*archive];
+            Ok(Cow::Borrowed(
+                archive.read_entry_bytes(&archive.entries()[*entry]),
+            ))
+        }
+    }
+}
+
+fn describe(source: &Source, archives: &[LabArchive]) -> String {
+    match source {
+        Source::File(path) => path.display().to_string(),
+        Source::Lab { archive, entry } => {
+            let archive = &archives[*archive];
+            format!(
+                "{}:{}",
+                archive.path().display(),
+                archive.entries()[*entry].name
+            )
+        }
+    }
+}
+
+fn has_extension(path: &Path, extension: &str) -> bool {
+    path.extension()
+        .and_then(|ext| ext.to_str())
+        .map(|ext| ext.eq_ignore_ascii_case(extension))
+        .unwrap_or(false)
+}
+
 #[derive(Debug, Serialize)]
 struct ExportModel {
     name: Option<String>,
@@ -0,0 +1,398 @@
+//! Depth statistics for every `.zbm` in a LAB archive or directory tree. Each
+//! frame becomes one record in the shape of
+//! `tools/tests/manny_office_depth_stats.json`, extended with percentiles and a
+//! bucketed histogram, so set fixtures can be regenerated in one pass.
+
+use std::borrow::Cow;
+use std::collections::HashMap;
+use std::fs::{self, File};
+use std::io::{self, BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::time::Instant;
+
+use anyhow::{Context, Result, bail};
+use clap::Parser;
+use grim_formats::{LabArchive, decode_bm, decode_bm_with_seed};
+use rayon::prelude::*;
+use serde::Serialize;
+use walkdir::WalkDir;
+
+#[derive(Parser, Debug)]
+#[command(
+    about = "Report per-frame depth statistics for every ZBM in a LAB or directory, in parallel",
+    version
+)]
+struct Args {
+    /// LAB archive, single .zbm, or directory scanned recursively for .zbm and .lab files
+    input: PathBuf,
+
+    /// Write the JSON report here instead of stdout
+    #[arg(long, short)]
+    output: Option<PathBuf>,
+
+    /// Only report assets with this file name (case-insensitive; repeatable)
+    #[arg(long)]
+    asset: Vec<String>,
+
+    /// Percentiles reported for each frame
+    #[arg(long, value_delimiter = ',', default_values_t = [1.0, 5.0, 50.0, 95.0, 99.0])]
+    percentiles: Vec<f64>,
+
+    /// Histogram buckets per frame, spread over the frame's min..=max (0 disables)
+    #[arg(long, default_value_t = 64)]
+    bins: usize,
+
+    /// Decode without priming frame 0 from the paired .bm plate
+    #[arg(long)]
+    no_seed: bool,
+
+    /// Worker threads (defaults to one per logical CPU)
+    #[arg(long)]
+    threads: Option<usize>,
+
+    /// Pretty-print the JSON output
+    #[arg(long)]
+    pretty: bool,
+}
+
+/// Where an asset's bytes live.
+#[derive(Clone)]
+enum Source {
+    File(PathBuf),
+    Lab { archive: usize, entry: usize },
+}
+
+struct Asset {
+    name: String,
+    source: Source,
+    /// Paired `.bm` colour plate used as the codec3 seed for frame 0.
+    seed: Option<Source>,
+}
+
+#[derive(Serialize)]
+struct FrameReport {
+    asset: String,
+    source: String,
+    frame: usize,
+    dimensions: [u32; 2],
+    checksum_fnv1a: u64,
+    seeded: bool,
+    depth: DepthReport,
+}
+
+#[derive(Serialize)]
+struct DepthReport {
+    min: u16,
+    max: u16,
+    min_hex: String,
+    max_hex: String,
+    zero_pixels: usize,
+    nonzero_pixels: usize,
+    percentiles: Vec<PercentileReport>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    histogram: Option<HistogramReport>,
+}
+
+#[derive(Serialize)]
+struct PercentileReport {
+    percent: f64,
+    value: u16,
+}
+
+#[derive(Serialize)]
+struct HistogramReport {
+    /// Depth value at the start of the first bucket.
+    start: u16,
+    bucket_width: usize,
+    counts: Vec<u64>,
+}
+
+fn main() -> Result<()> {
+    let args = Args::parse();
+
+    if let Some(threads) = args.threads {
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .build_global()
+            .context("configuring worker pool")?;
+    }
+    if let Some(percent) = args
+        .percentiles
+        .iter()
+        .find(|percent| !(0.0..=100.0).contains(*percent))
+    {
+        bail!("percentile {percent} is outside 0..=100");
+    }
+
+    let (archives, mut assets) = collect_assets(&args.input, !args.no_seed)?;
+    if !args.asset.is_empty() {
+        assets.retain(|asset| {
+            args.asset
+                .iter()
+                .any(|name| name.eq_ignore_ascii_case(&asset.name))
+        });
+    }
+    if assets.is_empty() {
+        bail!("no .zbm assets found under {}", args.input.display());
+    }
+
+    let started = Instant::now();
+    let results: Vec<(&Asset, Result<Vec<FrameReport>>)> = assets
+        .par_iter()
+        .map(|asset| (asset, analyze(asset, &archives, &args)))
+        .collect();
+    let wall = started.elapsed();
+
+    let mut reports = Vec::new();
+    let mut failed = 0usize;
+    for (asset, result) in results {
+        match result {
+            Ok(frames) => reports.extend(frames),
+            Err(err) => {
+                failed += 1;
+                eprintln!("{}: {err:#}", describe(&asset.source, &archives));
+            }
+        }
+    }
+
+    match &args.output {
+        Some(path) => {
+            if let Some(parent) = path.parent() {
+                if !parent.as_os_str().is_empty() {
+                    fs::create_dir_all(parent)
+                        .with_context(|| format!("creating {}", parent.display()))?;
+                }
+            }
+            let file =
+                File::create(path).with_context(|| format!("creating {}", path.display()))?;
+            write_report(BufWriter::new(file), &reports, args.pretty)
+                .with_context(|| format!("writing {}", path.display()))?;
+        }
+        None => write_report(io::stdout().lock(), &reports, args.pretty)?,
+    }
+
+    eprintln!(
+        "Analysed {} frame(s) from {} asset(s), {failed} failed, in {:.2}s on {} thread(s)",
+        reports.len(),
+        assets.len() - failed,
+        wall.as_secs_f64(),
+        rayon::current_num_threads()
+    );
+    if failed > 0 {
+        bail!("{failed} asset(s) failed to analyse");
+    }
+    Ok(())
+}
+
+/// Gathers `.zbm` assets from a single file, a LAB archive, or a directory
+/// tree holding loose files and/or LAB archives, sorted by name.
+fn collect_assets(input: &Path, seeded: bool) -> Result<(Vec<LabArchive>, Vec<Asset>)> {
+    let mut archives = Vec::new();
+    let mut assets = Vec::new();
+
+    if input.is_file() {
+        if has_extension(input, "lab") {
+            archives.push(LabArchive::open(input)?);
+        } else {
+            let seed = input.with_extension("bm");
+            assets.push(Asset {
+                name: file_name(input),
+                source: Source::File(input.to_path_buf()),
+                seed: (seeded && seed.is_file()).then_some(Source::File(seed)),
+            });
+        }
+    } else {
+        // Keyed by lowercase path without extension, so `MO_0_DDTWS.BM`
+        // pairs with `mo_0_ddtws.zbm`.
+        let mut plates = HashMap::new();
+        let mut depth_maps = Vec::new();
+        for entry in WalkDir::new(input).into_iter().filter_map(|res| res.ok()) {
+            if !entry.file_type().is_file() {
+                continue;
+            }
+            let path = entry.into_path();
+            if has_extension(&path, "zbm") {
+                depth_maps.push(path);
+            } else if has_extension(&path, "bm") {
+                plates.insert(stem_key(&path), path);
+            } else if has_extension(&path, "lab") {
+                archives.push(LabArchive::open(&path)?);
+            }
+        }
+        for path in depth_maps {
+            let seed = plates.get(&stem_key(&path)).cloned();
+            assets.push(Asset {
+                name: file_name(&path),
+                source: Source::File(path),
+                seed: seed.filter(|_| seeded).map(Source::File),
+            });
+        }
+    }
+
+    for (archive_index, archive) in archives.iter().enumerate() {
+        for (entry_index, entry) in archive.entries().iter().enumerate() {
+            let Some(stem) = strip_extension(&entry.name, ".zbm") else {
+                continue;
+            };
+            let seed = archive
+                .entries()
+                .iter()
+                .position(|other| {
+                    strip_extension(&other.name, ".bm")
+                        .is_some_and(|plate| plate.eq_ignore_ascii_case(stem))
+                })
+                .filter(|_| seeded)
+                .map(|entry| Source::Lab {
+                    archive: archive_index,
+                    entry,
+                });
+            assets.push(Asset {
+                name: entry.name.clone(),
+                source: Source::Lab {
+                    archive: archive_index,
+                    entry: entry_index,
+                },
+                seed,
+            });
+        }
+    }
+
+    assets.sort_by(|a, b| {
+        a.name
+            .to_ascii_lowercase()
+            .cmp(&b.name.to_ascii_lowercase())
+            .then_with(|| describe(&a.source, &archives).cmp(&describe(&b.source, &archives)))
+    });
+    Ok((archives, assets))
+}
+
+fn analyze(asset: &Asset, archives: &[LabArchive], args: &Args) -> Result<Vec<FrameReport>> {
+    let source = describe(&asset.source, archives);
+    let bytes = load(&asset.source, archives)?;
+
+    let seed = match &asset.seed {
+        Some(seed) => {
+            let plate = decode_bm(&load(seed, archives)?)
+                .with_context(|| format!("decoding seed plate for {source}"))?;
+            plate.frames.into_iter().next().map(|frame| frame.data)
+        }
+        None => None,
+    };
+    let bm = decode_bm_with_seed(&bytes, seed.as_deref())
+        .with_context(|| format!("decoding {source}"))?;
+    let metadata = bm.metadata();
+
+    let mut reports = Vec::with_capacity(bm.frames.len());
+    for (index, frame) in bm.frames.iter().enumerate() {
+        let histogram = frame
+            .depth_histogram(&metadata)
+            .with_context(|| format!("{source} frame {index}"))?;
+        let stats = histogram.stats();
+        let percentiles = args
+            .percentiles
+            .iter()
+            .filter_map(|&percent| {
+                histogram
+                    .percentile(percent)
+                    .map(|value| PercentileReport { percent, value })
+            })
+            .collect();
+        let histogram = (args.bins > 0).then(|| HistogramReport {
+            start: stats.min,
+            bucket_width: histogram.bucket_width(args.bins),
+            counts: histogram.buckets(args.bins),
+        });
+
+        reports.push(FrameReport {
+            asset: asset.name.clone(),
+            source: source.clone(),
+            frame: index,
+            dimensions: [frame.width, frame.height],
+            checksum_fnv1a: fnv1a(&frame.data),
+            seeded: seed.is_some(),
+            depth: DepthReport {
+                min: stats.min,
+                max: stats.max,
+                min_hex: format!("0x{:04X}", stats.min),
+                max_hex: format!("0x{:04X}", stats.max),
+                zero_pixels: stats.zero_pixels,
+                nonzero_pixels: stats.nonzero_pixels,
+                percentiles,
+                histogram,
+            },
+        });
+    }
+    Ok(reports)
+}
+
+fn write_report(mut writer: impl Write, reports: &[FrameReport], pretty: bool) -> Result<()> {
+    if pretty {
+        serde_json::to_writer_pretty(&mut writer, reports)?;
+    } else {
+        serde_json::to_writer(&mut writer, reports)?;
+    }
+    writeln!(writer)?;
+    writer.flush()?;
+    Ok(())
+}
+
+fn load<'a>(source: &Source, archives: &'a [LabArchive]) -> Result<Cow<'a, [u8]>> {
+    match source {
+        Source::File(path) => {
+            let bytes = fs::read(path).with_context(|| format!("reading {}", path.display()))?;
+            Ok(Cow::Owned(bytes))
+        }
+        Source::Lab { archive, entry } => {
+            let archive = &archives[*archive];
+            Ok(Cow::Borrowed(
+                archive.read_entry_bytes(&archive.entries()[*entry]),
+            ))
+        }
+    }
+}
+
+fn describe(source: &Source, archives: &[LabArchive]) -> String {
+    match source {
+        Source::File(path) => path.display().to_string(),
+        Source::Lab { archive, entry } => {
+            let archive = &archives[*archive];
+            format!(
+                "{}:{}",
+                archive.path().display(),
+                archive.entries()[*entry].name
+            )
+        }
+    }
+}
+
+/// 64-bit FNV-1a over the decoded frame bytes.
+fn fnv1a(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf2_9ce4_8422_2325, |hash, &byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+fn has_extension(path: &Path, extension: &str) -> bool {
+    path.extension()
+        .and_then(|ext| ext.to_str())
+        .map(|ext| ext.eq_ignore_ascii_case(extension))
+        .unwrap_or(false)
+}
+
+fn strip_extension<'a>(name: &'a str, extension: &str) -> Option<&'a str> {
+    let split = name.len().checked_sub(extension.len())?;
+    (name.is_char_boundary(split) && name[split..].eq_ignore_ascii_case(extension))
+        .then(|| &name[..split])
+}
+
+fn stem_key(path: &Path) -> String {
+    path.with_extension("")
+        .to_string_lossy()
+        .to_ascii_lowercase()
+}
+
+fn file_name(path: &Path) -> String {
+    path.file_name()
+        .map(|name| name.to_string_lossy().into_owned())
+        .unwrap_or_default()
+}
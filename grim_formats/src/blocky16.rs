@@ -5,11 +5,18 @@
 //
 // The codec stores Blocky16-compressed 16-bit (1555) frames inside Retail SNM
 // containers. The logic below mirrors the original implementation so that
-// decoded frames match the retail engine byte-for-byte.
+// decoded frames match the retail engine byte-for-byte. The one deliberate
+// departure, resetting the surfaces on keyframes, is off unless a caller opts
+// in with `Blocky16Decoder::set_keyframe_reset`.
+
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock};
 
 use anyhow::{Context, Result, bail, ensure};
 use byteorder::{ByteOrder, LittleEndian};
 
+use crate::convert;
+
 const BLOCKY16_TABLE_SMALL1: [i8; 16] = [0, 1, 2, 3, 3, 3, 3, 2, 1, 0, 0, 0, 1, 2, 2, 1];
 const BLOCKY16_TABLE_SMALL2: [i8; 16] = [0, 0, 0, 0, 1, 2, 3, 3, 3, 3, 2, 1, 1, 1, 2, 2];
 const BLOCKY16_TABLE_BIG1: [i8; 16] = [0, 2, 5, 7, 7, 7, 7, 7, 7, 5, 2, 0, 0, 0, 0, 0];
@@ -41,17 +48,10 @@ const BLOCKY16_TABLE: [i16; 513] = [
     0, 0, 0,
 ];
 
-/// Helper for translating Blocky16 output from 1555 to RGBA.
-fn rgb_from_1555(pixel: u16) -> [u8; 4] {
-    let r = ((pixel >> 10) & 0x1F) as u8;
-    let g = ((pixel >> 5) & 0x1F) as u8;
-    let b = (pixel & 0x1F) as u8;
-    [
-        (r << 3) | (r >> 2),
-        (g << 3) | (g >> 2),
-        (b << 3) | (b >> 2),
-        255,
-    ]
+/// Sequence number stored in a Blocky16 frame header; `0` marks a keyframe
+/// that resets all decoder surfaces.
+pub fn frame_seq(payload: &[u8]) -> Option<u16> {
+    payload.get(16..18).map(LittleEndian::read_u16)
 }
 
 pub struct Blocky16Decoder {
@@ -64,15 +64,16 @@ pub struct Blocky16Decoder {
     offset1: isize,
     offset2: isize,
     prev_seq: i32,
-    last_table_width: usize,
-    table_big: Vec<u8>,
-    table_small: Vec<u8>,
-    table: [i16; 256],
+    tables: Arc<Blocky16Tables>,
     delta_storage: Vec<u8>,
     delta0_start: usize,
     delta1_start: usize,
     cur_start: usize,
     d_pitch: usize,
+    /// Use the block-validated copy/fill paths; cleared by the differential tests.
+    fast_paths: bool,
+    /// Restore the initial surfaces on every seq-0 frame; see `set_keyframe_reset`.
+    keyframe_reset: bool,
 }
 
 impl Blocky16Decoder {
@@ -87,20 +88,29 @@ impl Blocky16Decoder {
             offset1: 0,
             offset2: 0,
             prev_seq: 0,
-            last_table_width: usize::MAX,
-            table_big: vec![0u8; 256 * 388],
-            table_small: vec![0u8; 256 * 128],
-            table: [0; 256],
+            tables: Blocky16Tables::for_width(width as usize),
             delta_storage: Vec::new(),
             delta0_start: 0,
             delta1_start: 0,
             cur_start: 0,
             d_pitch: 0,
+            fast_paths: true,
+            keyframe_reset: false,
         };
         decoder.init(width as usize, height as usize)?;
         Ok(decoder)
     }
 
+    /// Restore the initial surface layout and zero the storage on every
+    /// keyframe (seq 0), so a run starting at a keyframe decodes the same with
+    /// a fresh decoder as after earlier frames. The retail decoder does not do
+    /// this, and a keyframe's output can depend on what came before it, so
+    /// enabling it gives up byte-for-byte parity. `blocky16_batch` enables it
+    /// to decode keyframe runs in parallel.
+    pub fn set_keyframe_reset(&mut self, enabled: bool) {
+        self.keyframe_reset = enabled;
+    }
+
     /// Reconfigure the decoder for a different surface size.
     pub fn reconfigure(&mut self, width: u16, height: u16) -> Result<()> {
         self.init(width as usize, height as usize)
@@ -159,9 +169,9 @@ impl Blocky16Decoder {
         self.prev_seq = 0;
         self.d_pitch = self.width * 2;
 
-        self.make_tables_interpolation(4)?;
-        self.make_tables_interpolation(8)?;
-        self.make_tables_47(width);
+        if self.tables.width != width {
+            self.tables = Blocky16Tables::for_width(width);
+        }
         Ok(())
     }
 
@@ -173,16 +183,34 @@ impl Blocky16Decoder {
             dst.len(),
             self.frame_size
         );
+        let frame = self.decode_surface(src)?;
+        dst[..self.frame_size].copy_from_slice(self.current_buffer());
+        self.finish_frame(frame);
+        Ok(())
+    }
+
+    /// Decode Blocky16 payload directly to RGBA8.
+    ///
+    /// Pixels are converted straight from the decoder's current surface into
+    /// `dst`, without an intermediate 1555 copy.
+    pub fn decode_rgba(&mut self, dst: &mut [u8], src: &[u8]) -> Result<()> {
+        let rgba_len = self.rgba_len();
+        ensure!(dst.len() >= rgba_len, "blocky16 RGBA destination too small");
+        let frame = self.decode_surface(src)?;
+        convert::rgba_from_1555(self.current_buffer(), &mut dst[..rgba_len]);
+        self.finish_frame(frame);
+        Ok(())
+    }
+
+    /// Run the codec for one payload, leaving the result in the current surface.
+    /// Returns the frame's `(seq, swap_mode)` for [`Self::finish_frame`].
+    fn decode_surface(&mut self, src: &[u8]) -> Result<(i32, u8)> {
         ensure!(
             src.len() >= 560,
             "blocky16 frame payload too short: {}",
             src.len()
         );
 
-        self.offset1 = self.pointer_delta(self.delta1_start, self.cur_start);
-        self.offset2 = self.pointer_delta(self.delta0_start, self.cur_start);
-        self.d_pitch = self.width * 2;
-
         let seq = LittleEndian::read_u16(&src[16..18]) as i32;
         let mode = src[18];
         let swap_mode = src[19];
@@ -190,8 +218,14 @@ impl Blocky16Decoder {
         let param67_block = &src[40..560];
         let gfx = &src[560..];
 
+        if seq == 0 && self.keyframe_reset {
+            self.reset_surfaces();
+        }
+        self.offset1 = self.pointer_delta(self.delta1_start, self.cur_start);
+        self.offset2 = self.pointer_delta(self.delta0_start, self.cur_start);
+        self.d_pitch = self.width * 2;
+
         if seq == 0 {
-            self.make_tables_47(self.width);
             if src[32] == src[33] {
                 let value = src[32];
                 self.fill_surface_u8(self.cur_start, value);
@@ -267,8 +301,11 @@ impl Blocky16Decoder {
             _ => bail!("blocky16 unknown mode {}", mode),
         }
 
-        dst[..self.frame_size].copy_from_slice(self.current_buffer());
+        Ok((seq, swap_mode))
+    }
 
+    /// Rotate the current/delta surfaces once the frame has been emitted.
+    fn finish_frame(&mut self, (seq, swap_mode): (i32, u8)) {
         if seq == self.prev_seq + 1 {
             match swap_mode {
                 1 => {
@@ -288,22 +325,18 @@ impl Blocky16Decoder {
         }
 
         self.prev_seq = seq;
-        Ok(())
     }
 
-    /// Decode Blocky16 payload directly to RGBA8.
-    pub fn decode_rgba(&mut self, dst: &mut [u8], src: &[u8]) -> Result<()> {
-        ensure!(
-            dst.len() >= self.frame_size * 2,
-            "blocky16 RGBA destination too small"
-        );
-        let mut raw = vec![0u8; self.frame_size];
-        self.decode(&mut raw, src)?;
-        for (rgba, pixel) in dst.chunks_exact_mut(4).zip(raw.chunks_exact(2)) {
-            let value = LittleEndian::read_u16(pixel);
-            rgba.copy_from_slice(&rgb_from_1555(value));
-        }
-        Ok(())
+    /// Put the surfaces back in their initial layout with zeroed storage.
+    ///
+    /// Swaps rotate the three surfaces through the backing buffer, and motion
+    /// vectors may read past a surface into its neighbours, so without this a
+    /// keyframe's output depends on the frames decoded before it.
+    fn reset_surfaces(&mut self) {
+        self.delta_storage.fill(0);
+        self.delta0_start = 0;
+        self.delta1_start = self.frame_size;
+        self.cur_start = self.frame_size * 2;
     }
 
     fn pointer_delta(&self, first: usize, second: usize) -> isize {
@@ -355,14 +388,10 @@ impl Blocky16Decoder {
                 let tmp = self.read_i16(cursor, gfx)?;
                 (tmp as isize) * 2
             } else {
-                (self.table[code as usize] as isize) * 2
+                (self.tables.motion[code as usize] as isize) * 2
             };
             value += self.offset1;
-            for row in 0..8 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, value)?;
-                self.copy_line(src, dest, 16)?;
-            }
+            self.copy_block(dst_index, value, 8, 16)?;
         } else if code == 0xFF {
             self.level2(dst_index, cursor, gfx, param_ptr, param67_ptr)?;
             self.level2(dst_index + 8, cursor, gfx, param_ptr, param67_ptr)?;
@@ -381,11 +410,7 @@ impl Blocky16Decoder {
                 param67_ptr,
             )?;
         } else if code == 0xF6 {
-            for row in 0..8 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, self.offset2)?;
-                self.copy_line(src, dest, 16)?;
-            }
+            self.copy_block(dst_index, self.offset2, 8, 16)?;
         } else if code == 0xF7 || code == 0xF8 {
             let selector = self.read_byte(cursor, gfx)?;
             let value = if code == 0xF8 {
@@ -397,35 +422,18 @@ impl Blocky16Decoder {
                 ((hi as u32) << 16) | (lo as u32)
             };
 
-            let base = selector as usize * 388;
-            let count_true = self.table_big[base + 384] as usize;
-            let count_false = self.table_big[base + 385] as usize;
-            let low = value as u16;
-            let high = (value >> 16) as u16;
-
-            for idx in 0..count_true {
-                let offset =
-                    LittleEndian::read_u16(&self.table_big[base + idx * 2..base + idx * 2 + 2])
-                        as usize;
-                let dest = dst_index + offset * 2;
-                self.write_u16(dest, low)?;
-            }
-            for idx in 0..count_false {
-                let offset = LittleEndian::read_u16(
-                    &self.table_big[base + 128 + idx * 2..base + 128 + idx * 2 + 2],
-                ) as usize;
-                let dest = dst_index + offset * 2;
-                self.write_u16(dest, high)?;
-            }
+            let glyph = &self.tables.big[selector as usize];
+            fill_glyph(
+                &mut self.delta_storage,
+                dst_index,
+                glyph,
+                self.tables.big_extent,
+                value,
+                self.fast_paths,
+            )?;
         } else if code >= 0xF9 {
             let value = self.read_literal(code, cursor, gfx, param_ptr, param67_ptr)?;
-            for row in 0..8 {
-                let dest = dst_index + row * self.d_pitch;
-                self.write_u32(dest, value)?;
-                self.write_u32(dest + 4, value)?;
-                self.write_u32(dest + 8, value)?;
-                self.write_u32(dest + 12, value)?;
-            }
+            self.fill_block(dst_index, value, 8, 16)?;
         }
         Ok(())
     }
@@ -444,14 +452,10 @@ impl Blocky16Decoder {
                 let tmp = self.read_i16(cursor, gfx)?;
                 (tmp as isize) * 2
             } else {
-                (self.table[code as usize] as isize) * 2
+                (self.tables.motion[code as usize] as isize) * 2
             };
             value += self.offset1;
-            for row in 0..4 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, value)?;
-                self.copy_line(src, dest, 8)?;
-            }
+            self.copy_block(dst_index, value, 4, 8)?;
         } else if code == 0xFF {
             self.level3(dst_index, cursor, gfx, param_ptr, param67_ptr)?;
             self.level3(dst_index + 4, cursor, gfx, param_ptr, param67_ptr)?;
@@ -470,11 +474,7 @@ impl Blocky16Decoder {
                 param67_ptr,
             )?;
         } else if code == 0xF6 {
-            for row in 0..4 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, self.offset2)?;
-                self.copy_line(src, dest, 8)?;
-            }
+            self.copy_block(dst_index, self.offset2, 4, 8)?;
         } else if code == 0xF7 || code == 0xF8 {
             let selector = self.read_byte(cursor, gfx)?;
             let value = if code == 0xF8 {
@@ -486,33 +486,18 @@ impl Blocky16Decoder {
                 ((hi as u32) << 16) | (lo as u32)
             };
 
-            let base = selector as usize * 128;
-            let count_true = self.table_small[base + 96] as usize;
-            let count_false = self.table_small[base + 97] as usize;
-            let low = value as u16;
-            let high = (value >> 16) as u16;
-
-            for idx in 0..count_true {
-                let offset =
-                    LittleEndian::read_u16(&self.table_small[base + idx * 2..base + idx * 2 + 2])
-                        as usize;
-                let dest = dst_index + offset * 2;
-                self.write_u16(dest, low)?;
-            }
-            for idx in 0..count_false {
-                let offset = LittleEndian::read_u16(
-                    &self.table_small[base + 32 + idx * 2..base + 32 + idx * 2 + 2],
-                ) as usize;
-                let dest = dst_index + offset * 2;
-                self.write_u16(dest, high)?;
-            }
+            let glyph = &self.tables.small[selector as usize];
+            fill_glyph(
+                &mut self.delta_storage,
+                dst_index,
+                glyph,
+                self.tables.small_extent,
+                value,
+                self.fast_paths,
+            )?;
         } else if code >= 0xF9 {
             let value = self.read_literal(code, cursor, gfx, param_ptr, param67_ptr)?;
-            for row in 0..4 {
-                let dest = dst_index + row * self.d_pitch;
-                self.write_u32(dest, value)?;
-                self.write_u32(dest + 4, value)?;
-            }
+            self.fill_block(dst_index, value, 4, 8)?;
         }
         Ok(())
     }
@@ -531,14 +516,10 @@ impl Blocky16Decoder {
                 let tmp = self.read_i16(cursor, gfx)?;
                 (tmp as isize) * 2
             } else {
-                (self.table[code as usize] as isize) * 2
+                (self.tables.motion[code as usize] as isize) * 2
             };
             value += self.offset1;
-            for row in 0..2 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, value)?;
-                self.copy_line(src, dest, 4)?;
-            }
+            self.copy_block(dst_index, value, 2, 4)?;
         } else if code == 0xFF || code == 0xF8 {
             let values = self.read_exact(cursor, gfx, 8)?;
             self.current_write(dst_index, values)?;
@@ -548,23 +529,13 @@ impl Blocky16Decoder {
             let index = self.read_byte(cursor, gfx)?;
             let value = self.read_param67(param67_ptr, index)?;
             let packed = ((value as u32) << 16) | value as u32;
-            for row in 0..2 {
-                let dest = dst_index + row * self.d_pitch;
-                self.write_u32(dest, packed)?;
-            }
+            self.fill_block(dst_index, packed, 2, 4)?;
         } else if code == 0xFE {
             let value = self.read_u16(cursor, gfx)?;
             let packed = ((value as u32) << 16) | value as u32;
-            for row in 0..2 {
-                let dest = dst_index + row * self.d_pitch;
-                self.write_u32(dest, packed)?;
-            }
+            self.fill_block(dst_index, packed, 2, 4)?;
         } else if code == 0xF6 {
-            for row in 0..2 {
-                let dest = dst_index + row * self.d_pitch;
-                let src = self.index_with_offset(dest, self.offset2)?;
-                self.copy_line(src, dest, 4)?;
-            }
+            self.copy_block(dst_index, self.offset2, 2, 4)?;
         } else if code == 0xF7 {
             let value = self.read_u32(cursor, gfx)?;
             let mut tmp = value;
@@ -583,10 +554,7 @@ impl Blocky16Decoder {
         } else if (0xF9..=0xFC).contains(&code) {
             let value = self.read_param(param_ptr, code)?;
             let packed = ((value as u32) << 16) | value as u32;
-            for row in 0..2 {
-                let dest = dst_index + row * self.d_pitch;
-                self.write_u32(dest, packed)?;
-            }
+            self.fill_block(dst_index, packed, 2, 4)?;
         }
         Ok(())
     }
@@ -670,6 +638,70 @@ impl Blocky16Decoder {
         Ok(LittleEndian::read_u32(slice))
     }
 
+    /// Copy a `rows`×`len` byte block from `dst_index + offset` to `dst_index`.
+    ///
+    /// Motion vectors are validated once for the whole block so the per-row
+    /// copies run without bounds checks; anything that fails validation goes
+    /// through the row-by-row checked path, which reports the error.
+    fn copy_block(
+        &mut self,
+        dst_index: usize,
+        offset: isize,
+        rows: usize,
+        len: usize,
+    ) -> Result<()> {
+        let storage_len = self.delta_storage.len();
+        let last_row = dst_index + (rows - 1) * self.d_pitch;
+        let first_src = dst_index as isize + offset;
+        let last_src = last_row as isize + offset;
+        // Mirror `index_with_offset`, which reserves a full 16-byte line per source row.
+        if self.fast_paths
+            && first_src >= 0
+            && last_src as usize + 16 <= storage_len
+            && last_row + len <= storage_len
+        {
+            let base = self.delta_storage.as_mut_ptr();
+            for row in 0..rows {
+                let dest = dst_index + row * self.d_pitch;
+                let src = (dest as isize + offset) as usize;
+                // SAFETY: every source and destination row lies within
+                // `delta_storage` (checked above); `ptr::copy` tolerates overlap.
+                unsafe { std::ptr::copy(base.add(src), base.add(dest), len) };
+            }
+            return Ok(());
+        }
+
+        for row in 0..rows {
+            let dest = dst_index + row * self.d_pitch;
+            let src = self.index_with_offset(dest, offset)?;
+            self.copy_line(src, dest, len)?;
+        }
+        Ok(())
+    }
+
+    /// Fill a `rows`×`len` byte block with a repeated 32-bit pattern.
+    fn fill_block(&mut self, dst_index: usize, value: u32, rows: usize, len: usize) -> Result<()> {
+        let last_row = dst_index + (rows - 1) * self.d_pitch;
+        if self.fast_paths && last_row + len <= self.delta_storage.len() {
+            let pattern = value.to_le_bytes();
+            for row in 0..rows {
+                let dest = dst_index + row * self.d_pitch;
+                for word in self.delta_storage[dest..dest + len].chunks_exact_mut(4) {
+                    word.copy_from_slice(&pattern);
+                }
+            }
+            return Ok(());
+        }
+
+        for row in 0..rows {
+            let dest = dst_index + row * self.d_pitch;
+            for word in (0..len).step_by(4) {
+                self.write_u32(dest + word, value)?;
+            }
+        }
+        Ok(())
+    }
+
     fn index_with_offset(&self, base: usize, offset: isize) -> Result<usize> {
         let value = base as isize + offset;
         if value < 0 || (value as usize) + 16 > self.delta_storage.len() {
@@ -739,160 +771,196 @@ impl Blocky16Decoder {
         }
         Ok(())
     }
+}
 
-    fn make_tables_47(&mut self, width: usize) {
-        if self.last_table_width == width {
-            return;
-        }
-        self.last_table_width = width;
+/// Two-colour glyph for an `N`-pixel block: offsets of the low-colour pixels
+/// followed by the high-colour ones, in the order the fill loop writes them.
+#[derive(Clone, Copy)]
+struct Glyph<const N: usize> {
+    offsets: [u16; N],
+    split: u8,
+}
 
-        for (i, chunk) in BLOCKY16_TABLE.chunks_exact(2).enumerate() {
-            let value = chunk[1] * width as i16 + chunk[0];
-            self.table[i] = value;
+impl<const N: usize> Glyph<N> {
+    /// Turn mask indices (`row * size + col`) into pixel offsets for `width`.
+    fn linearize(&self, size: usize, width: usize) -> Self {
+        let mut offsets = [0u16; N];
+        for (dst, &index) in offsets.iter_mut().zip(self.offsets.iter()) {
+            let index = usize::from(index);
+            // Truncated to 16 bits like the original's packed table entries.
+            *dst = ((index / size) * width + index % size) as u16;
         }
-
-        let mut a = 0usize;
-        let mut c = 0usize;
-        while c < 32768 {
-            let count_true = self.table_small[96 + c] as usize;
-            for d in 0..count_true {
-                let idx = 64 + c + d;
-                let tmp = self.table_small[idx] as i16;
-                let linear = ((tmp >> 2) as i16 * width as i16) + (tmp & 3) as i16;
-                let dest = c + d * 2;
-                self.table_small[dest] = linear as u8;
-                self.table_small[dest + 1] = (linear >> 8) as u8;
-            }
-
-            let count_false = self.table_small[97 + c] as usize;
-            for d in 0..count_false {
-                let idx = 80 + c + d;
-                let tmp = self.table_small[idx] as i16;
-                let linear = ((tmp >> 2) as i16 * width as i16) + (tmp & 3) as i16;
-                let dest = 32 + c + d * 2;
-                self.table_small[dest] = linear as u8;
-                self.table_small[dest + 1] = (linear >> 8) as u8;
-            }
-
-            let count_big_true = self.table_big[384 + a] as usize;
-            for d in 0..count_big_true {
-                let idx = 256 + a + d;
-                let tmp = self.table_big[idx] as i16;
-                let linear = ((tmp >> 3) as i16 * width as i16) + (tmp & 7) as i16;
-                let dest = a + d * 2;
-                self.table_big[dest] = linear as u8;
-                self.table_big[dest + 1] = (linear >> 8) as u8;
-            }
-
-            let count_big_false = self.table_big[385 + a] as usize;
-            for d in 0..count_big_false {
-                let idx = 320 + a + d;
-                let tmp = self.table_big[idx] as i16;
-                let linear = ((tmp >> 3) as i16 * width as i16) + (tmp & 7) as i16;
-                let dest = 128 + a + d * 2;
-                self.table_big[dest] = linear as u8;
-                self.table_big[dest + 1] = (linear >> 8) as u8;
-            }
-
-            a += 388;
-            c += 128;
+        Self {
+            offsets,
+            split: self.split,
         }
     }
+}
 
-    fn make_tables_interpolation(&mut self, param: usize) -> Result<()> {
-        let (table1, table2, storage, stride) = match param {
-            8 => (
-                &BLOCKY16_TABLE_BIG1,
-                &BLOCKY16_TABLE_BIG2,
-                &mut self.table_big,
-                388usize,
-            ),
-            4 => (
-                &BLOCKY16_TABLE_SMALL1,
-                &BLOCKY16_TABLE_SMALL2,
-                &mut self.table_small,
-                128usize,
-            ),
-            other => bail!("blocky16 interpolation unsupported size {}", other),
-        };
+/// Write `value`'s low half to the glyph's first `split` pixels and its high
+/// half to the rest. The whole block is validated once when `fast` is set;
+/// otherwise (or if that fails) each write is checked and reports the error.
+fn fill_glyph<const N: usize>(
+    storage: &mut [u8],
+    dst_index: usize,
+    glyph: &Glyph<N>,
+    extent: usize,
+    value: u32,
+    fast: bool,
+) -> Result<()> {
+    let (low_set, high_set) = glyph.offsets.split_at(usize::from(glyph.split));
+    let low = (value as u16).to_le_bytes();
+    let high = ((value >> 16) as u16).to_le_bytes();
+
+    if fast && dst_index + extent <= storage.len() {
+        let block = &mut storage[dst_index..dst_index + extent];
+        for &offset in low_set {
+            let at = usize::from(offset) * 2;
+            block[at..at + 2].copy_from_slice(&low);
+        }
+        for &offset in high_set {
+            let at = usize::from(offset) * 2;
+            block[at..at + 2].copy_from_slice(&high);
+        }
+        return Ok(());
+    }
 
-        for entry in storage.chunks_mut(stride) {
-            entry.fill(0);
+    for (set, bytes) in [(low_set, low), (high_set, high)] {
+        for &offset in set {
+            let at = dst_index + usize::from(offset) * 2;
+            ensure!(at + 2 <= storage.len());
+            storage[at..at + 2].copy_from_slice(&bytes);
         }
+    }
+    Ok(())
+}
 
-        let mut s = 0usize;
-        for &x_val in table1 {
-            for &y_val in table1 {
-                let mut grid = [0u8; 64];
+/// Width-specific lookup tables (ScummVM's `makeTables47`). They depend only
+/// on the surface width, so decoders of the same width share one copy.
+struct Blocky16Tables {
+    width: usize,
+    /// `BLOCKY16_TABLE` motion vectors as linear pixel offsets.
+    motion: [i16; 256],
+    /// 8x8 glyphs, pixel offsets from the block origin.
+    big: Vec<Glyph<64>>,
+    /// 4x4 glyphs.
+    small: Vec<Glyph<16>>,
+    /// Bytes from a block origin to the end of its furthest glyph pixel.
+    big_extent: usize,
+    small_extent: usize,
+}
 
-                let x1 = x_val as i32;
-                let x2 = y_val as i32;
-                let y1 = table2[(s / stride) % 16] as i32;
-                let y2 = table2[((s / stride) / 16) % 16] as i32;
+impl Blocky16Tables {
+    fn for_width(width: usize) -> Arc<Self> {
+        static CACHE: OnceLock<Mutex<HashMap<usize, Arc<Blocky16Tables>>>> = OnceLock::new();
+        let mut cache = CACHE
+            .get_or_init(Default::default)
+            .lock()
+            .unwrap_or_else(|poisoned| poisoned.into_inner());
+        cache
+            .entry(width)
+            .or_insert_with(|| Arc::new(Self::build(width)))
+            .clone()
+    }
 
-                let b1 = classify_boundary(x1, y1, param as i32);
-                let b2 = classify_boundary(x2, y2, param as i32);
+    fn build(width: usize) -> Self {
+        let masks = glyph_masks();
+        let mut motion = [0i16; 256];
+        for (entry, pair) in motion.iter_mut().zip(BLOCKY16_TABLE.chunks_exact(2)) {
+            *entry = pair[1].wrapping_mul(width as i16).wrapping_add(pair[0]);
+        }
+        Self {
+            width,
+            motion,
+            big: masks
+                .big
+                .iter()
+                .map(|glyph| glyph.linearize(8, width))
+                .collect(),
+            small: masks
+                .small
+                .iter()
+                .map(|glyph| glyph.linearize(4, width))
+                .collect(),
+            big_extent: (7 * width + 8) * 2,
+            small_extent: (3 * width + 4) * 2,
+        }
+    }
+}
 
-                let mut delta = (y2 - y1).abs();
-                delta = delta.max((x2 - x1).abs());
+/// Width-independent glyph masks (ScummVM's `makeTablesInterpolation`).
+struct GlyphMasks {
+    big: Vec<Glyph<64>>,
+    small: Vec<Glyph<16>>,
+}
 
-                for variable1 in 0..=delta {
-                    let (interp_x, interp_y) = if delta > 0 {
-                        (
-                            (x1 * variable1 + x2 * (delta - variable1) + delta / 2) / delta,
-                            (y1 * variable1 + y2 * (delta - variable1) + delta / 2) / delta,
-                        )
-                    } else {
-                        (x1, y1)
-                    };
+fn glyph_masks() -> &'static GlyphMasks {
+    static MASKS: OnceLock<GlyphMasks> = OnceLock::new();
+    MASKS.get_or_init(|| GlyphMasks {
+        big: make_glyph_masks(8, &BLOCKY16_TABLE_BIG1, &BLOCKY16_TABLE_BIG2),
+        small: make_glyph_masks(4, &BLOCKY16_TABLE_SMALL1, &BLOCKY16_TABLE_SMALL2),
+    })
+}
 
-                    if interp_x >= 0
-                        && interp_x < param as i32
-                        && interp_y >= 0
-                        && interp_y < param as i32
-                    {
-                        set_grid(&mut grid, param, interp_x as usize, interp_y as usize);
-                        fill_edges(&mut grid, param, interp_x, interp_y, b1, b2);
-                    }
+/// Rasterise the edge between two border points for each of the 256
+/// selectors and split the block into the pixels on either side of it.
+fn make_glyph_masks<const N: usize>(
+    param: usize,
+    table1: &[i8; 16],
+    table2: &[i8; 16],
+) -> Vec<Glyph<N>> {
+    debug_assert_eq!(param * param, N);
+    (0..256usize)
+        .map(|selector| {
+            let mut grid = [0u8; 64];
+
+            let x1 = table1[selector / 16] as i32;
+            let x2 = table1[selector % 16] as i32;
+            let y1 = table2[selector % 16] as i32;
+            let y2 = table2[selector / 16] as i32;
+
+            let b1 = classify_boundary(x1, y1, param as i32);
+            let b2 = classify_boundary(x2, y2, param as i32);
+
+            let delta = (y2 - y1).abs().max((x2 - x1).abs());
+            for variable1 in 0..=delta {
+                let (interp_x, interp_y) = if delta > 0 {
+                    (
+                        (x1 * variable1 + x2 * (delta - variable1) + delta / 2) / delta,
+                        (y1 * variable1 + y2 * (delta - variable1) + delta / 2) / delta,
+                    )
+                } else {
+                    (x1, y1)
+                };
+
+                if interp_x >= 0
+                    && interp_x < param as i32
+                    && interp_y >= 0
+                    && interp_y < param as i32
+                {
+                    set_grid(&mut grid, param, interp_x as usize, interp_y as usize);
+                    fill_edges(&mut grid, param, interp_x, interp_y, b1, b2);
                 }
+            }
 
-                if param == 8 {
-                    let base = s;
-                    let mut true_count = 0usize;
-                    let mut false_count = 0usize;
-                    for idx in (0..64).rev() {
-                        if grid[idx] != 0 {
-                            storage[256 + base + true_count] = idx as u8;
-                            true_count += 1;
-                        } else {
-                            storage[320 + base + false_count] = idx as u8;
-                            false_count += 1;
-                        }
-                    }
-                    storage[384 + base] = true_count as u8;
-                    storage[385 + base] = false_count as u8;
-                    s += 388;
-                } else {
-                    let base = s;
-                    let mut true_count = 0usize;
-                    let mut false_count = 0usize;
-                    for idx in (0..16).rev() {
-                        if grid[idx] != 0 {
-                            storage[64 + base + true_count] = idx as u8;
-                            true_count += 1;
-                        } else {
-                            storage[80 + base + false_count] = idx as u8;
-                            false_count += 1;
-                        }
+            // Both sets are listed from the last pixel down, as in the original.
+            let mut offsets = [0u16; N];
+            let mut count = 0usize;
+            let mut split = 0u8;
+            for set in [true, false] {
+                for idx in (0..N).rev() {
+                    if (grid[idx] != 0) == set {
+                        offsets[count] = idx as u16;
+                        count += 1;
                     }
-                    storage[96 + base] = true_count as u8;
-                    storage[97 + base] = false_count as u8;
-                    s += 128;
+                }
+                if set {
+                    split = count as u8;
                 }
             }
-        }
-        Ok(())
-    }
+            Glyph { offsets, split }
+        })
+        .collect()
 }
 
 fn classify_boundary(value1: i32, value2: i32, param: i32) -> i32 {
@@ -1004,3 +1072,333 @@ impl<'a> Bomp<'a> {
         result
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// xorshift32; keeps the fuzz corpus deterministic without extra deps.
+    struct Rng(u32);
+
+    impl Rng {
+        fn next(&mut self) -> u32 {
+            self.0 ^= self.0 << 13;
+            self.0 ^= self.0 >> 17;
+            self.0 ^= self.0 << 5;
+            self.0
+        }
+
+        fn byte(&mut self) -> u8 {
+            self.next() as u8
+        }
+    }
+
+    /// Random mode-2 payload; half the opcode-position bytes are drawn from
+    /// the 0xF5..=0xFF range so level2/level3 and the fill codes get exercised.
+    fn random_mode2_frame(rng: &mut Rng, seq: u16, gfx_len: usize) -> Vec<u8> {
+        let mut frame = vec![0u8; 560 + gfx_len];
+        for byte in frame.iter_mut() {
+            *byte = rng.byte();
+        }
+        frame[16..18].copy_from_slice(&seq.to_le_bytes());
+        frame[18] = 2;
+        frame[19] = (rng.next() % 3) as u8;
+        for byte in frame[560..].iter_mut() {
+            if rng.next() & 1 == 0 {
+                *byte = 0xF5 + (rng.next() % 11) as u8;
+            }
+        }
+        frame
+    }
+
+    /// Header-only keyframe (seq 0) in the given mode.
+    fn keyframe(mode: u8) -> Vec<u8> {
+        let mut frame = vec![0u8; 560];
+        frame[18] = mode;
+        frame
+    }
+
+    #[test]
+    fn unverified_modes_are_rejected() {
+        let mut decoder = Blocky16Decoder::new(16, 16).unwrap();
+        let mut out = vec![0u8; decoder.frame_len()];
+        for mode in [1u8, 7] {
+            let mut frame = keyframe(mode);
+            frame.resize(560 + 256, 0);
+            let err = decoder.decode(&mut out, &frame).unwrap_err();
+            assert!(err.to_string().contains("not implemented"), "mode {mode}");
+        }
+    }
+
+    #[test]
+    fn decoders_of_equal_width_share_tables() {
+        let a = Blocky16Decoder::new(64, 48).unwrap();
+        let mut b = Blocky16Decoder::new(64, 16).unwrap();
+        assert!(Arc::ptr_eq(&a.tables, &b.tables));
+        b.reconfigure(32, 16).unwrap();
+        assert!(!Arc::ptr_eq(&a.tables, &b.tables));
+        assert_eq!(b.tables.width, 32);
+    }
+
+    #[test]
+    fn glyphs_cover_every_block_pixel_once() {
+        let tables = Blocky16Tables::for_width(640);
+        assert_eq!(
+            tables.motion[0],
+            BLOCKY16_TABLE[1] * 640 + BLOCKY16_TABLE[0]
+        );
+        for glyph in &tables.big {
+            let mut offsets = glyph.offsets;
+            offsets.sort_unstable();
+            let expected: Vec<u16> = (0..64).map(|i| (i / 8) * 640 + i % 8).collect();
+            assert_eq!(offsets.as_slice(), expected.as_slice());
+        }
+        for glyph in &tables.small {
+            let mut offsets = glyph.offsets;
+            offsets.sort_unstable();
+            let expected: Vec<u16> = (0..16).map(|i| (i / 4) * 640 + i % 4).collect();
+            assert_eq!(offsets.as_slice(), expected.as_slice());
+        }
+    }
+
+    /// The interleaved 388/128-byte glyph records the decoder used before
+    /// `Blocky16Tables`, built exactly as the old `make_tables_interpolation`
+    /// and `make_tables_47` did. Returns `(motion, big, small)`.
+    fn legacy_tables(width: usize) -> (Vec<i16>, Vec<u8>, Vec<u8>) {
+        let mut big = vec![0u8; 256 * 388];
+        let mut small = vec![0u8; 256 * 128];
+        for (param, table1, table2, storage, stride) in [
+            (
+                8usize,
+                &BLOCKY16_TABLE_BIG1,
+                &BLOCKY16_TABLE_BIG2,
+                &mut big,
+                388usize,
+            ),
+            (
+                4,
+                &BLOCKY16_TABLE_SMALL1,
+                &BLOCKY16_TABLE_SMALL2,
+                &mut small,
+                128,
+            ),
+        ] {
+            let mut s = 0usize;
+            for &x_val in table1 {
+                for &y_val in table1 {
+                    let mut grid = [0u8; 64];
+                    let x1 = x_val as i32;
+                    let x2 = y_val as i32;
+                    let y1 = table2[(s / stride) % 16] as i32;
+                    let y2 = table2[((s / stride) / 16) % 16] as i32;
+                    let b1 = classify_boundary(x1, y1, param as i32);
+                    let b2 = classify_boundary(x2, y2, param as i32);
+                    let delta = (y2 - y1).abs().max((x2 - x1).abs());
+                    for variable1 in 0..=delta {
+                        let (interp_x, interp_y) = if delta > 0 {
+                            (
+                                (x1 * variable1 + x2 * (delta - variable1) + delta / 2) / delta,
+                                (y1 * variable1 + y2 * (delta - variable1) + delta / 2) / delta,
+                            )
+                        } else {
+                            (x1, y1)
+                        };
+                        if interp_x >= 0
+                            && interp_x < param as i32
+                            && interp_y >= 0
+                            && interp_y < param as i32
+                        {
+                            set_grid(&mut grid, param, interp_x as usize, interp_y as usize);
+                            fill_edges(&mut grid, param, interp_x, interp_y, b1, b2);
+                        }
+                    }
+
+                    // Raw indices and counts sit after the linear offsets.
+                    let (true_at, false_at, counts_at) = if param == 8 {
+                        (256, 320, 384)
+                    } else {
+                        (64, 80, 96)
+                    };
+                    let (mut true_count, mut false_count) = (0usize, 0usize);
+                    for idx in (0..param * param).rev() {
+                        if grid[idx] != 0 {
+                            storage[true_at + s + true_count] = idx as u8;
+                            true_count += 1;
+                        } else {
+                            storage[false_at + s + false_count] = idx as u8;
+                            false_count += 1;
+                        }
+                    }
+                    storage[counts_at + s] = true_count as u8;
+                    storage[counts_at + 1 + s] = false_count as u8;
+                    s += stride;
+                }
+            }
+        }
+
+        let motion = BLOCKY16_TABLE
+            .chunks_exact(2)
+            .map(|chunk| chunk[1] * width as i16 + chunk[0])
+            .collect();
+
+        let (mut a, mut c) = (0usize, 0usize);
+        while c < 32768 {
+            for (record, base, shift, mask, lists) in [
+                (&mut small, c, 2, 3, [(64, 0, 96), (80, 32, 97)]),
+                (&mut big, a, 3, 7, [(256, 0, 384), (320, 128, 385)]),
+            ] {
+                for (raw, dest, counts) in lists {
+                    for d in 0..record[base + counts] as usize {
+                        let tmp = record[raw + base + d] as i16;
+                        let linear = ((tmp >> shift) * width as i16) + (tmp & mask);
+                        let at = dest + base + d * 2;
+                        record[at] = linear as u8;
+                        record[at + 1] = (linear >> 8) as u8;
+                    }
+                }
+            }
+            a += 388;
+            c += 128;
+        }
+        (motion, big, small)
+    }
+
+    /// `(low-colour, high-colour)` offsets of one legacy record.
+    fn legacy_glyph(record: &[u8], false_at: usize, counts_at: usize) -> (Vec<u16>, Vec<u16>) {
+        let read = |at: usize, count: u8| -> Vec<u16> {
+            (0..usize::from(count))
+                .map(|idx| LittleEndian::read_u16(&record[at + idx * 2..at + idx * 2 + 2]))
+                .collect()
+        };
+        (
+            read(0, record[counts_at]),
+            read(false_at, record[counts_at + 1]),
+        )
+    }
+
+    #[test]
+    fn tables_match_legacy_records_entry_by_entry() {
+        for width in [8usize, 13, 320, 640] {
+            let tables = Blocky16Tables::build(width);
+            let (motion, big, small) = legacy_tables(width);
+            assert_eq!(
+                tables.motion.as_slice(),
+                motion.as_slice(),
+                "width {width} motion"
+            );
+            for (selector, glyph) in tables.big.iter().enumerate() {
+                let (low, high) = legacy_glyph(&big[selector * 388..][..388], 128, 384);
+                let split = usize::from(glyph.split);
+                assert_eq!(
+                    &glyph.offsets[..split],
+                    low.as_slice(),
+                    "width {width} big {selector}"
+                );
+                assert_eq!(
+                    &glyph.offsets[split..],
+                    high.as_slice(),
+                    "width {width} big {selector}"
+                );
+            }
+            for (selector, glyph) in tables.small.iter().enumerate() {
+                let (low, high) = legacy_glyph(&small[selector * 128..][..128], 32, 96);
+                let split = usize::from(glyph.split);
+                assert_eq!(
+                    &glyph.offsets[..split],
+                    low.as_slice(),
+                    "width {width} small {selector}"
+                );
+                assert_eq!(
+                    &glyph.offsets[split..],
+                    high.as_slice(),
+                    "width {width} small {selector}"
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn block_fast_paths_match_checked_decoder() {
+        for (case, &(width, height)) in [(16u16, 16u16), (24, 8), (40, 24), (13, 11)]
+            .iter()
+            .enumerate()
+        {
+            let mut rng = Rng(0x9E37_79B9 ^ case as u32);
+            let mut fast = Blocky16Decoder::new(width, height).unwrap();
+            let mut checked = Blocky16Decoder::new(width, height).unwrap();
+            checked.fast_paths = false;
+
+            let mut fast_out = vec![0u8; fast.frame_len()];
+            let mut checked_out = vec![0u8; checked.frame_len()];
+            for seq in 0..200u16 {
+                let frame = random_mode2_frame(&mut rng, seq % 25, 64 + (seq as usize * 7) % 900);
+                let fast_result = fast.decode(&mut fast_out, &frame);
+                let checked_result = checked.decode(&mut checked_out, &frame);
+                assert_eq!(
+                    fast_result.is_ok(),
+                    checked_result.is_ok(),
+                    "{width}x{height} frame {seq}: {fast_result:?} vs {checked_result:?}"
+                );
+                assert_eq!(fast_out, checked_out, "{width}x{height} frame {seq} output");
+                assert_eq!(
+                    fast.delta_storage, checked.delta_storage,
+                    "{width}x{height} frame {seq} surfaces"
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn keyframes_keep_the_surface_layout_by_default() {
+        let mut decoder = Blocky16Decoder::new(16, 16).unwrap();
+        let mut out = vec![0u8; decoder.frame_len()];
+        let mut frame = keyframe(3);
+        frame[19] = 1;
+        decoder.decode(&mut out, &frame).unwrap();
+        let swapped = (decoder.cur_start, decoder.delta1_start);
+        assert_ne!(swapped.0, decoder.frame_size * 2);
+
+        frame[19] = 0;
+        decoder.decode(&mut out, &frame).unwrap();
+        assert_eq!((decoder.cur_start, decoder.delta1_start), swapped);
+
+        decoder.set_keyframe_reset(true);
+        decoder.decode(&mut out, &frame).unwrap();
+        assert_eq!(decoder.cur_start, decoder.frame_size * 2);
+    }
+
+    #[test]
+    fn keyframe_decodes_match_a_fresh_decoder() {
+        for (case, &(width, height)) in [(16u16, 16u16), (40, 24), (13, 11)].iter().enumerate() {
+            let mut rng = Rng(0x85EB_CA6B ^ case as u32);
+            let frames: Vec<Vec<u8>> = (0..150u16)
+                .map(|index| {
+                    random_mode2_frame(&mut rng, index % 25, 64 + (index as usize * 11) % 700)
+                })
+                .collect();
+
+            let mut sequential = Blocky16Decoder::new(width, height).unwrap();
+            sequential.set_keyframe_reset(true);
+            let mut split = Blocky16Decoder::new(width, height).unwrap();
+            let mut sequential_out = vec![0u8; sequential.frame_len()];
+            let mut split_out = vec![0u8; split.frame_len()];
+            for (index, frame) in frames.iter().enumerate() {
+                if index % 25 == 0 {
+                    split = Blocky16Decoder::new(width, height).unwrap();
+                    split.set_keyframe_reset(true);
+                }
+                let sequential_result = sequential.decode(&mut sequential_out, frame);
+                let split_result = split.decode(&mut split_out, frame);
+                assert_eq!(
+                    sequential_result.is_ok(),
+                    split_result.is_ok(),
+                    "{width}x{height} frame {index}"
+                );
+                assert_eq!(
+                    sequential_out, split_out,
+                    "{width}x{height} frame {index} output"
+                );
+            }
+        }
+    }
+}
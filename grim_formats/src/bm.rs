@@ -1,5 +1,11 @@
 use anyhow::{Context, Result, bail, ensure};
+use std::collections::{BTreeMap, HashMap};
 use std::convert::TryInto;
+use std::ops::Range;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+use crate::convert;
 
 const MAGIC_PRIMARY: &[u8; 4] = b"BM  ";
 const MAGIC_SECONDARY: &[u8; 4] = b"F\0\0\0";
@@ -37,76 +43,123 @@ pub struct BmFrame {
 }
 
 impl BmFrame {
+    /// Bytes [`Self::write_rgba8888`] needs with tightly packed rows.
+    pub fn rgba8888_len(&self) -> usize {
+        self.width as usize * self.height as usize * 4
+    }
+
     pub fn as_rgba8888(&self, metadata: &BmMetadata) -> Result<Vec<u8>> {
-        match metadata.format {
-            1 => match metadata.bits_per_pixel {
-                16 => convert_rgb565_to_rgba8888(&self.data),
-                32 => convert_rgba8888_le(&self.data),
-                other => bail!("unsupported bits-per-pixel value {other} for BM preview"),
-            },
-            5 => match metadata.bits_per_pixel {
-                16 => convert_zbuffer16_to_rgba8888(&self.data),
-                other => bail!("unsupported bits-per-pixel value {other} for BM zbuffer preview"),
-            },
-            other => bail!("unsupported BM format {other} for preview"),
-        }
+        let mut rgba = vec![0u8; self.rgba8888_len()];
+        self.write_rgba8888(metadata, &mut rgba, self.width as usize * 4)?;
+        Ok(rgba)
     }
 
-    pub fn depth_stats(&self, metadata: &BmMetadata) -> Result<DepthStats> {
+    /// Convert into `dst` with rows `pitch` bytes apart (at least `width * 4`),
+    /// so a texture staging buffer padded to the GPU row alignment can be
+    /// filled directly. Row padding is left untouched.
+    pub fn write_rgba8888(
+        &self,
+        metadata: &BmMetadata,
+        dst: &mut [u8],
+        pitch: usize,
+    ) -> Result<()> {
+        let width = self.width as usize;
+        let height = self.height as usize;
+        let row_bytes = width * 4;
         ensure!(
-            metadata.format == 5,
-            "depth stats requested for non-depth format {}",
-            metadata.format
+            pitch >= row_bytes,
+            "RGBA pitch {pitch} shorter than a {width}-pixel row"
         );
+        if width == 0 || height == 0 {
+            return Ok(());
+        }
+        let needed = (height - 1) * pitch + row_bytes;
         ensure!(
-            metadata.bits_per_pixel == 16,
-            "depth stats only supported for 16bpp surfaces (got {}bpp)",
-            metadata.bits_per_pixel
+            dst.len() >= needed,
+            "RGBA buffer ({}) smaller than {width}x{height} at pitch {pitch} ({needed})",
+            dst.len()
         );
+
+        let source_bpp = match (metadata.format, metadata.bits_per_pixel) {
+            (1, 16) | (5, 16) => 2,
+            (1, 32) => 4,
+            (1, other) => bail!("unsupported bits-per-pixel value {other} for BM preview"),
+            (5, other) => bail!("unsupported bits-per-pixel value {other} for BM zbuffer preview"),
+            (other, _) => bail!("unsupported BM format {other} for preview"),
+        };
+        let source_len = width * height * source_bpp;
         ensure!(
-            self.data.len() % 2 == 0,
-            "depth buffer payload must be a multiple of 2 bytes"
+            self.data.len() >= source_len,
+            "BM frame data ({}) shorter than {width}x{height} at {source_bpp} bytes per pixel",
+            self.data.len()
         );
+        let source = &self.data[..source_len];
+        let rows = RowLayout {
+            source_row: width * source_bpp,
+            row_bytes,
+            pitch,
+        };
 
-        const DEPTH_SENTINEL: u16 = 0xF81F;
-
-        let mut min_value = u16::MAX;
-        let mut max_value = u16::MIN;
-        let mut zero_pixels = 0usize;
-        let mut nonzero_pixels = 0usize;
-
-        for chunk in self.data.chunks_exact(2) {
-            let mut value = u16::from_le_bytes([chunk[0], chunk[1]]);
-            if value == DEPTH_SENTINEL {
-                value = 0;
-            }
-            if value == 0 {
-                zero_pixels += 1;
-            } else {
-                nonzero_pixels += 1;
-            }
-            if value < min_value {
-                min_value = value;
-            }
-            if value > max_value {
-                max_value = value;
+        match (metadata.format, source_bpp) {
+            (1, 2) => rows.convert(source, dst, convert::rgba_from_565),
+            (1, _) => rows.convert(source, dst, convert::rgba_from_bgra),
+            _ => {
+                let (min, max) = convert::depth_range(source).unwrap_or((0, 0));
+                rows.convert(source, dst, |src, out| {
+                    convert::gray_from_depth16(src, out, min, max - min)
+                });
             }
         }
+        Ok(())
+    }
 
-        if zero_pixels + nonzero_pixels == 0 {
-            min_value = 0;
-            max_value = 0;
-        } else if min_value == u16::MAX {
-            min_value = 0;
-        }
+    pub fn depth_stats(&self, metadata: &BmMetadata) -> Result<DepthStats> {
+        self.ensure_depth_plane(metadata, "depth stats")?;
+
+        let (min, max) = convert::depth_range(&self.data).unwrap_or((0, 0));
+        let zero_pixels = self
+            .data
+            .chunks_exact(2)
+            .filter(|chunk| {
+                matches!(
+                    u16::from_le_bytes([chunk[0], chunk[1]]),
+                    0 | convert::DEPTH_SENTINEL
+                )
+            })
+            .count();
 
         Ok(DepthStats {
-            min: min_value,
-            max: max_value,
+            min,
+            max,
             zero_pixels,
-            nonzero_pixels,
+            nonzero_pixels: self.data.len() / 2 - zero_pixels,
         })
     }
+
+    /// Full value distribution of a depth frame, for percentiles and
+    /// histograms on top of what [`BmFrame::depth_stats`] reports.
+    pub fn depth_histogram(&self, metadata: &BmMetadata) -> Result<DepthHistogram> {
+        self.ensure_depth_plane(metadata, "depth histogram")?;
+        Ok(DepthHistogram::from_depth16(&self.data))
+    }
+
+    fn ensure_depth_plane(&self, metadata: &BmMetadata, what: &str) -> Result<()> {
+        ensure!(
+            metadata.format == 5,
+            "{what} requested for non-depth format {}",
+            metadata.format
+        );
+        ensure!(
+            metadata.bits_per_pixel == 16,
+            "{what} only supported for 16bpp surfaces (got {}bpp)",
+            metadata.bits_per_pixel
+        );
+        ensure!(
+            self.data.len() % 2 == 0,
+            "depth buffer payload must be a multiple of 2 bytes"
+        );
+        Ok(())
+    }
 }
 
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -133,6 +186,130 @@ impl DepthStats {
     }
 }
 
+/// Per-value pixel counts of a 16-bit Z-buffer, sentinel counted as 0.
+///
+/// Counters only cover the frame's own `min..=max`, found first with the
+/// SIMD [`convert::depth_range`] pass.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct DepthHistogram {
+    min: u16,
+    counts: Vec<u32>,
+    total: usize,
+}
+
+impl DepthHistogram {
+    /// Count every little-endian depth value in `src`.
+    pub fn from_depth16(src: &[u8]) -> Self {
+        let Some((min, max)) = convert::depth_range(src) else {
+            return Self {
+                min: 0,
+                counts: Vec::new(),
+                total: 0,
+            };
+        };
+        let span = usize::from(max - min) + 1;
+        let slot = |pixel: &[u8]| {
+            let value = u16::from_le_bytes([pixel[0], pixel[1]]);
+            let value = if value == convert::DEPTH_SENTINEL {
+                0
+            } else {
+                value
+            };
+            usize::from(value - min)
+        };
+
+        // Depth maps are mostly flat walls and floors. With a single table,
+        // runs of one value serialise on the same counter's load and store;
+        // four interleaved tables let consecutive pixels update independently.
+        let mut tables = vec![0u32; span * 4];
+        let mut quads = src.chunks_exact(8);
+        for quad in &mut quads {
+            tables[slot(&quad[0..2])] += 1;
+            tables[span + slot(&quad[2..4])] += 1;
+            tables[2 * span + slot(&quad[4..6])] += 1;
+            tables[3 * span + slot(&quad[6..8])] += 1;
+        }
+        for pixel in quads.remainder().chunks_exact(2) {
+            tables[slot(pixel)] += 1;
+        }
+
+        let (counts, rest) = tables.split_at_mut(span);
+        for table in rest.chunks_exact(span) {
+            for (count, extra) in counts.iter_mut().zip(table) {
+                *count += extra;
+            }
+        }
+        tables.truncate(span);
+
+        Self {
+            min,
+            counts: tables,
+            total: src.len() / 2,
+        }
+    }
+
+    pub fn total_pixels(&self) -> usize {
+        self.total
+    }
+
+    /// Smallest and largest depth present, or `None` for an empty frame.
+    pub fn range(&self) -> Option<(u16, u16)> {
+        (!self.counts.is_empty()).then(|| (self.min, self.min + (self.counts.len() - 1) as u16))
+    }
+
+    pub fn count(&self, value: u16) -> u32 {
+        value
+            .checked_sub(self.min)
+            .and_then(|slot| self.counts.get(usize::from(slot)))
+            .copied()
+            .unwrap_or(0)
+    }
+
+    pub fn stats(&self) -> DepthStats {
+        let (min, max) = self.range().unwrap_or((0, 0));
+        let zero_pixels = self.count(0) as usize;
+        DepthStats {
+            min,
+            max,
+            zero_pixels,
+            nonzero_pixels: self.total - zero_pixels,
+        }
+    }
+
+    /// Nearest-rank percentile: the smallest depth with at least `percent`%
+    /// of the pixels at or below it. `percent` is clamped to 0..=100.
+    pub fn percentile(&self, percent: f64) -> Option<u16> {
+        if self.total == 0 {
+            return None;
+        }
+        let rank = ((percent.clamp(0.0, 100.0) / 100.0) * self.total as f64).ceil() as usize;
+        let rank = rank.max(1);
+        let mut seen = 0usize;
+        for (slot, &count) in self.counts.iter().enumerate() {
+            seen += count as usize;
+            if seen >= rank {
+                return Some(self.min + slot as u16);
+            }
+        }
+        self.range().map(|(_, max)| max)
+    }
+
+    /// Width of each bucket when `min..=max` is split into `bins` buckets.
+    pub fn bucket_width(&self, bins: usize) -> usize {
+        self.counts.len().div_ceil(bins.max(1)).max(1)
+    }
+
+    /// Pixel counts for `bins` equal-width buckets starting at the minimum
+    /// depth; bucket `i` covers [`min + i * width`, `min + (i + 1) * width`).
+    /// Trailing buckets past the maximum are dropped.
+    pub fn buckets(&self, bins: usize) -> Vec<u64> {
+        self.counts
+            .chunks(self.bucket_width(bins))
+            .map(|bucket| bucket.iter().map(|&count| u64::from(count)).sum())
+            .collect()
+    }
+}
+
 fn parse_bm_header(bytes: &[u8]) -> Result<(BmMetadata, usize)> {
     ensure!(
         bytes.len() >= HEADER_SIZE + 8,
@@ -197,7 +374,51 @@ pub fn decode_bm(bytes: &[u8]) -> Result<BmFile> {
 
 pub fn decode_bm_with_seed(bytes: &[u8], initial_seed: Option<&[u8]>) -> Result<BmFile> {
     let (metadata, bytes_per_pixel) = parse_bm_header(bytes)?;
-    let mut frames: Vec<BmFrame> = Vec::with_capacity(metadata.image_count as usize);
+    let entries = scan_frames(bytes, &metadata, bytes_per_pixel)?;
+    let mut frames: Vec<BmFrame> = Vec::with_capacity(entries.len());
+
+    for (frame_index, entry) in entries.iter().enumerate() {
+        let seed = match frames.last() {
+            Some(previous) => Some(&previous.data[..]),
+            None => initial_seed,
+        };
+        frames.push(decode_frame(
+            bytes,
+            metadata.codec,
+            frame_index,
+            entry,
+            seed,
+        )?);
+    }
+
+    Ok(BmFile {
+        codec: metadata.codec,
+        bits_per_pixel: metadata.bits_per_pixel,
+        image_count: metadata.image_count,
+        width: metadata.width,
+        height: metadata.height,
+        format: metadata.format,
+        frames,
+    })
+}
+
+/// Location of one frame's pixel payload inside a BM container.
+#[derive(Debug, Clone)]
+struct BmFrameEntry {
+    width: u32,
+    height: u32,
+    raw_size: usize,
+    payload: Range<usize>,
+}
+
+/// Walk the frame headers and record where each payload lives, without
+/// decompressing anything.
+fn scan_frames(
+    bytes: &[u8],
+    metadata: &BmMetadata,
+    bytes_per_pixel: usize,
+) -> Result<Vec<BmFrameEntry>> {
+    let mut entries = Vec::with_capacity(metadata.image_count as usize);
     let mut offset = HEADER_SIZE;
 
     for frame_index in 0..metadata.image_count {
@@ -221,15 +442,13 @@ pub fn decode_bm_with_seed(bytes: &[u8], initial_seed: Option<&[u8]>) -> Result<
             .checked_mul(bytes_per_pixel)
             .context("BM pixel buffer size overflow")?;
 
-        let data = match metadata.codec {
+        let payload = match metadata.codec {
             0 => {
                 ensure!(
                     offset + raw_size <= bytes.len(),
                     "frame {frame_index} raw pixel data truncated"
                 );
-                let slice = &bytes[offset..offset + raw_size];
-                offset += raw_size;
-                slice.to_vec()
+                offset..offset + raw_size
             }
             3 => {
                 ensure!(
@@ -243,226 +462,532 @@ pub fn decode_bm_with_seed(bytes: &[u8], initial_seed: Option<&[u8]>) -> Result<
                     offset + compressed_len <= bytes.len(),
                     "frame {frame_index} compressed data truncated"
                 );
-                let compressed = &bytes[offset..offset + compressed_len];
-                offset += compressed_len;
-                let mut buffer = vec![0u8; raw_size];
-                let seed = if frame_index == 0 {
-                    initial_seed
-                } else {
-                    Some(&frames[(frame_index - 1) as usize].data[..])
-                };
-                decompress_codec3(compressed, &mut buffer, seed)
-                    .with_context(|| format!("decompressing frame {frame_index}"))?;
-                buffer
+                offset..offset + compressed_len
             }
             other => bail!("unsupported BM codec {other}"),
         };
+        offset = payload.end;
 
-        frames.push(BmFrame {
+        entries.push(BmFrameEntry {
             width: frame_width,
             height: frame_height,
-            data,
+            raw_size,
+            payload,
         });
     }
 
-    Ok(BmFile {
-        codec: metadata.codec,
-        bits_per_pixel: metadata.bits_per_pixel,
-        image_count: metadata.image_count,
-        width: metadata.width,
-        height: metadata.height,
-        format: metadata.format,
-        frames,
+    Ok(entries)
+}
+
+/// Decode one frame; codec3 frames need the previous frame (or the external
+/// seed for frame 0) as `seed`.
+fn decode_frame(
+    bytes: &[u8],
+    codec: u32,
+    frame_index: usize,
+    entry: &BmFrameEntry,
+    seed: Option<&[u8]>,
+) -> Result<BmFrame> {
+    let payload = &bytes[entry.payload.clone()];
+    let data = match codec {
+        0 => payload.to_vec(),
+        3 => {
+            let mut buffer = vec![0u8; entry.raw_size];
+            decompress_codec3(payload, &mut buffer, seed)
+                .with_context(|| format!("decompressing frame {frame_index}"))?;
+            buffer
+        }
+        other => bail!("unsupported BM codec {other}"),
+    };
+    Ok(BmFrame {
+        width: entry.width,
+        height: entry.height,
+        data,
     })
 }
 
-fn read_u16_from(stream: &mut &[u8]) -> Result<u16> {
-    ensure!(
-        stream.len() >= 2,
-        "codec3 stream exhausted while reading u16"
-    );
-    let value = u16::from_le_bytes([stream[0], stream[1]]);
-    *stream = &stream[2..];
-    Ok(value)
+impl BmFile {
+    /// Index the frames in `bytes` without decoding them. `seed` primes
+    /// codec3 frame 0, as in [`decode_bm_with_seed`]. Frames are decoded on
+    /// request and kept in [`BmFrameCache::shared`].
+    pub fn open_lazy(bytes: impl Into<Arc<[u8]>>, seed: Option<Arc<[u8]>>) -> Result<LazyBmFile> {
+        let bytes = bytes.into();
+        let (metadata, bytes_per_pixel) = parse_bm_header(&bytes)?;
+        let frames = scan_frames(&bytes, &metadata, bytes_per_pixel)?;
+        if let (Some(seed), Some(first)) = (&seed, frames.first()) {
+            ensure!(
+                metadata.codec != 3 || seed.len() == first.raw_size,
+                "codec3 seed length {} does not match frame size {}",
+                seed.len(),
+                first.raw_size
+            );
+        }
+
+        static NEXT_ID: AtomicU64 = AtomicU64::new(0);
+        Ok(LazyBmFile {
+            id: NEXT_ID.fetch_add(1, Ordering::Relaxed),
+            bytes,
+            metadata,
+            frames,
+            seed,
+            cache: BmFrameCache::shared(),
+        })
+    }
 }
 
-fn read_u8_from(stream: &mut &[u8]) -> Result<u8> {
-    ensure!(
-        stream.len() >= 1,
-        "codec3 stream exhausted while reading byte"
-    );
-    let value = stream[0];
-    *stream = &stream[1..];
-    Ok(value)
+/// BM container with a frame offset table; see [`BmFile::open_lazy`].
+///
+/// Codec3 frames are seeded by their predecessor, so decoding frame *n*
+/// resumes from the nearest cached frame before it and caches every frame on
+/// the way. Dropping the file releases its cache entries.
+pub struct LazyBmFile {
+    id: u64,
+    bytes: Arc<[u8]>,
+    metadata: BmMetadata,
+    frames: Vec<BmFrameEntry>,
+    seed: Option<Arc<[u8]>>,
+    cache: Arc<BmFrameCache>,
 }
 
-fn decompress_codec3(compressed: &[u8], result: &mut [u8], seed: Option<&[u8]>) -> Result<()> {
-    ensure!(
-        compressed.len() >= 2,
-        "BM codec3 payload too small for bitstream initialiser"
-    );
+impl LazyBmFile {
+    /// Use `cache` instead of the process-wide one.
+    pub fn with_cache(mut self, cache: Arc<BmFrameCache>) -> Self {
+        self.cache.remove_file(self.id);
+        self.cache = cache;
+        self
+    }
 
-    const WINDOW_SIZE: usize = 0x1000;
-    let mut window = vec![0u8; WINDOW_SIZE + result.len()];
-    if let Some(seed) = seed {
+    pub fn metadata(&self) -> BmMetadata {
+        self.metadata
+    }
+
+    pub fn frame_count(&self) -> usize {
+        self.frames.len()
+    }
+
+    pub fn frame(&self, index: usize) -> Result<Arc<BmFrame>> {
         ensure!(
-            seed.len() == result.len(),
-            "codec3 seed length {} does not match target length {}",
-            seed.len(),
-            result.len()
+            index < self.frames.len(),
+            "BM frame {index} out of range ({} frames)",
+            self.frames.len()
         );
-        window[WINDOW_SIZE..WINDOW_SIZE + result.len()].copy_from_slice(seed);
-        let seed_tail = seed.len().min(WINDOW_SIZE);
-        let start = WINDOW_SIZE - seed_tail;
-        window[start..WINDOW_SIZE].copy_from_slice(&seed[seed.len() - seed_tail..]);
+        if let Some(frame) = self.cache.get(self.id, index) {
+            return Ok(frame);
+        }
+        if self.metadata.codec != 3 {
+            return self.decode_and_cache(index, None);
+        }
+
+        let mut start = index;
+        let mut previous = None;
+        while start > 0 {
+            if let Some(frame) = self.cache.get(self.id, start - 1) {
+                previous = Some(frame);
+                break;
+            }
+            start -= 1;
+        }
+        for frame_index in start..=index {
+            let frame = match &previous {
+                Some(previous) => self.decode_and_cache(frame_index, Some(&previous.data))?,
+                None => self.decode_and_cache(frame_index, self.seed.as_deref())?,
+            };
+            previous = Some(frame);
+        }
+        Ok(previous.expect("decoded at least one frame"))
     }
 
-    let mut stream = compressed;
-    let mut bitstr_value = read_u16_from(&mut stream)? as u32;
-    let mut bitstr_len = 16u32;
+    fn decode_and_cache(&self, index: usize, seed: Option<&[u8]>) -> Result<Arc<BmFrame>> {
+        let frame = Arc::new(decode_frame(
+            &self.bytes,
+            self.metadata.codec,
+            index,
+            &self.frames[index],
+            seed,
+        )?);
+        self.cache.insert(self.id, index, Arc::clone(&frame));
+        Ok(frame)
+    }
+}
 
-    let mut get_bit = |data: &mut &[u8]| -> Result<u32> {
-        let bit = bitstr_value & 1;
-        bitstr_len -= 1;
-        bitstr_value >>= 1;
-        if bitstr_len == 0 {
-            bitstr_value = read_u16_from(data)? as u32;
-            bitstr_len = 16;
-        }
-        Ok(bit)
-    };
+impl Drop for LazyBmFile {
+    fn drop(&mut self) {
+        self.cache.remove_file(self.id);
+    }
+}
 
-    let mut write_pos = WINDOW_SIZE;
+/// Default budget of [`BmFrameCache::shared`]: a few dozen 640x480 planes.
+pub const DEFAULT_BM_CACHE_BUDGET: usize = 64 << 20;
 
-    while write_pos - WINDOW_SIZE < result.len() {
-        let bit = get_bit(&mut stream)?;
-        if bit == 1 {
-            ensure!(
-                !stream.is_empty(),
-                "codec3 stream exhausted while reading literal"
-            );
-            let value = read_u8_from(&mut stream)?;
-            window[write_pos] = value;
-            write_pos += 1;
-            continue;
-        }
+/// Least-recently-used cache of decoded BM frames, bounded by the total size
+/// of their pixel data.
+pub struct BmFrameCache {
+    state: Mutex<BmCacheState>,
+}
 
-        let bit = get_bit(&mut stream)?;
-        let (mut copy_len, copy_offset): (usize, isize) = if bit == 0 {
-            let first = get_bit(&mut stream)? as usize;
-            let mut copy_len = first * 2;
-            let second = get_bit(&mut stream)? as usize;
-            copy_len += second + 3;
-            let offset_byte = read_u8_from(&mut stream)? as i32;
-            (copy_len, offset_byte as isize - 0x100)
-        } else {
-            let lower = read_u8_from(&mut stream)? as i32;
-            let upper = read_u8_from(&mut stream)? as i32;
-            let copy_offset = (lower | ((upper & 0xF0) << 4)) - 0x1000;
-            let mut copy_len = (upper & 0x0F) + 3;
-            if copy_len == 3 {
-                let extended = read_u8_from(&mut stream)? as i32 + 1;
-                if extended == 1 {
-                    break;
-                }
-                copy_len = extended;
+#[derive(Default)]
+struct BmCacheState {
+    budget: usize,
+    used: usize,
+    tick: u64,
+    entries: HashMap<(u64, usize), (Arc<BmFrame>, u64)>,
+    /// Last-use tick -> key, oldest first.
+    order: BTreeMap<u64, (u64, usize)>,
+}
+
+impl BmCacheState {
+    fn evict_to(&mut self, budget: usize) {
+        while self.used > budget {
+            let Some((_, key)) = self.order.pop_first() else {
+                break;
+            };
+            if let Some((frame, _)) = self.entries.remove(&key) {
+                self.used -= frame.data.len();
             }
-            (copy_len as usize, copy_offset as isize)
-        };
+        }
+    }
+}
 
-        while copy_len > 0 && write_pos - WINDOW_SIZE < result.len() {
-            let src_index = write_pos as isize + copy_offset;
-            ensure!(
-                (0..write_pos as isize).contains(&src_index),
-                "codec3 copy source out of bounds: {src_index} (write_pos={write_pos}, copy_offset={copy_offset})"
-            );
-            let value = window[src_index as usize];
-            window[write_pos] = value;
-            write_pos += 1;
-            copy_len -= 1;
+impl BmFrameCache {
+    pub fn new(budget: usize) -> Self {
+        Self {
+            state: Mutex::new(BmCacheState {
+                budget,
+                ..BmCacheState::default()
+            }),
         }
     }
 
-    result.copy_from_slice(&window[WINDOW_SIZE..WINDOW_SIZE + result.len()]);
-    Ok(())
-}
+    /// Process-wide cache used by [`BmFile::open_lazy`].
+    pub fn shared() -> Arc<Self> {
+        static SHARED: OnceLock<Arc<BmFrameCache>> = OnceLock::new();
+        Arc::clone(SHARED.get_or_init(|| Arc::new(Self::new(DEFAULT_BM_CACHE_BUDGET))))
+    }
 
-fn convert_rgb565_to_rgba8888(data: &[u8]) -> Result<Vec<u8>> {
-    ensure!(data.len() % 2 == 0, "RGB565 buffer must be even length");
-    let pixel_count = data.len() / 2;
-    let mut rgba = Vec::with_capacity(pixel_count * 4);
+    pub fn budget(&self) -> usize {
+        self.lock().budget
+    }
 
-    for chunk in data.chunks_exact(2) {
-        let value = u16::from_le_bytes([chunk[0], chunk[1]]);
-        let r = ((value >> 11) & 0x1F) as u8;
-        let g = ((value >> 5) & 0x3F) as u8;
-        let b = (value & 0x1F) as u8;
-        rgba.push((r << 3) | (r >> 2));
-        rgba.push((g << 2) | (g >> 4));
-        rgba.push((b << 3) | (b >> 2));
-        rgba.push(0xFF);
+    /// Change the byte budget, evicting least-recently-used frames to fit.
+    pub fn set_budget(&self, budget: usize) {
+        let mut state = self.lock();
+        state.budget = budget;
+        state.evict_to(budget);
     }
 
-    Ok(rgba)
+    /// Bytes of pixel data currently held.
+    pub fn used_bytes(&self) -> usize {
+        self.lock().used
+    }
+
+    pub fn len(&self) -> usize {
+        self.lock().entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn clear(&self) {
+        let mut state = self.lock();
+        state.entries.clear();
+        state.order.clear();
+        state.used = 0;
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, BmCacheState> {
+        self.state
+            .lock()
+            .unwrap_or_else(|poisoned| poisoned.into_inner())
+    }
+
+    fn get(&self, file: u64, index: usize) -> Option<Arc<BmFrame>> {
+        let mut state = self.lock();
+        state.tick += 1;
+        let tick = state.tick;
+        let (frame, last_used) = state.entries.get_mut(&(file, index))?;
+        let frame = Arc::clone(frame);
+        let previous = std::mem::replace(last_used, tick);
+        state.order.remove(&previous);
+        state.order.insert(tick, (file, index));
+        Some(frame)
+    }
+
+    fn insert(&self, file: u64, index: usize, frame: Arc<BmFrame>) {
+        let mut state = self.lock();
+        let size = frame.data.len();
+        if size > state.budget {
+            return;
+        }
+        state.tick += 1;
+        let tick = state.tick;
+        if let Some((old, last_used)) = state.entries.insert((file, index), (frame, tick)) {
+            state.used -= old.data.len();
+            state.order.remove(&last_used);
+        }
+        state.order.insert(tick, (file, index));
+        state.used += size;
+        let budget = state.budget;
+        state.evict_to(budget);
+    }
+
+    fn remove_file(&self, file: u64) {
+        let mut state = self.lock();
+        let keys: Vec<_> = state
+            .entries
+            .keys()
+            .filter(|(owner, _)| *owner == file)
+            .copied()
+            .collect();
+        for key in keys {
+            if let Some((frame, last_used)) = state.entries.remove(&key) {
+                state.used -= frame.data.len();
+                state.order.remove(&last_used);
+            }
+        }
+    }
 }
 
-fn convert_rgba8888_le(data: &[u8]) -> Result<Vec<u8>> {
-    ensure!(
-        data.len() % 4 == 0,
-        "RGBA8888 buffer must be a multiple of 4 bytes"
-    );
-    let mut rgba = Vec::with_capacity(data.len());
-    for chunk in data.chunks_exact(4) {
-        // Source ordering appears as little-endian BGRA in the original engine.
-        let b = chunk[0];
-        let g = chunk[1];
-        let r = chunk[2];
-        let a = chunk[3];
-        rgba.extend_from_slice(&[r, g, b, a]);
-    }
-    Ok(rgba)
+/// How far back a codec3 match may reach. Near the start of a frame that
+/// history is the tail of the seed frame (or zeros without one).
+const CODEC3_WINDOW: usize = 0x1000;
+
+/// Codec3 input: little-endian 16-bit control words interleaved with the
+/// literal and match bytes. The next word is fetched as soon as the current
+/// one is used up, so the reader cannot run ahead of the byte stream.
+struct Codec3Stream<'a> {
+    data: &'a [u8],
+    pos: usize,
+    bits: u32,
+    remaining: u32,
 }
 
-fn convert_zbuffer16_to_rgba8888(data: &[u8]) -> Result<Vec<u8>> {
-    ensure!(
-        data.len() % 2 == 0,
-        "Z-buffer payload must be a multiple of 2 bytes"
-    );
+impl<'a> Codec3Stream<'a> {
+    fn new(data: &'a [u8]) -> Result<Self> {
+        ensure!(
+            data.len() >= 2,
+            "BM codec3 payload too small for bitstream initialiser"
+        );
+        Ok(Self {
+            data,
+            pos: 2,
+            bits: u32::from(u16::from_le_bytes([data[0], data[1]])),
+            remaining: 16,
+        })
+    }
 
-    let mut min_value = u16::MAX;
-    let mut max_value = u16::MIN;
+    /// Take `count` control bits, least significant first.
+    #[inline]
+    fn bits(&mut self, count: u32) -> Result<u32> {
+        if count < self.remaining {
+            let value = self.bits & ((1 << count) - 1);
+            self.bits >>= count;
+            self.remaining -= count;
+            return Ok(value);
+        }
+        self.bits_across_refill(count)
+    }
 
-    for chunk in data.chunks_exact(2) {
-        let mut value = u16::from_le_bytes([chunk[0], chunk[1]]);
-        if value == 0xF81F {
-            value = 0;
+    /// Slow path of [`Self::bits`]: refill at exactly the bit that empties
+    /// the current word, before any byte that follows in the stream.
+    #[cold]
+    #[inline(never)]
+    fn bits_across_refill(&mut self, count: u32) -> Result<u32> {
+        let mut value = 0;
+        for shift in 0..count {
+            value |= (self.bits & 1) << shift;
+            self.bits >>= 1;
+            self.remaining -= 1;
+            if self.remaining == 0 {
+                ensure!(
+                    self.pos + 2 <= self.data.len(),
+                    "codec3 stream exhausted while reading u16"
+                );
+                self.bits = u32::from(u16::from_le_bytes([
+                    self.data[self.pos],
+                    self.data[self.pos + 1],
+                ]));
+                self.pos += 2;
+                self.remaining = 16;
+            }
         }
-        min_value = min_value.min(value);
-        max_value = max_value.max(value);
+        Ok(value)
     }
 
-    if min_value == u16::MAX && max_value == u16::MIN {
-        return Ok(vec![0u8; data.len() / 2 * 4]);
+    /// Consume the literal flags at the front of the current word, stopping
+    /// short of the bit that would trigger a refill, and return how many
+    /// there were (at most `limit`). Their bytes follow back to back.
+    #[inline]
+    fn literal_run(&mut self, limit: usize) -> usize {
+        let run = (!self.bits)
+            .trailing_zeros()
+            .min(self.remaining - 1)
+            .min(limit.min(16) as u32);
+        self.bits >>= run;
+        self.remaining -= run;
+        run as usize
     }
 
-    let range = max_value.saturating_sub(min_value);
-    let mut rgba = Vec::with_capacity(data.len() * 2);
+    #[inline]
+    fn take(&mut self, count: usize) -> Result<&'a [u8]> {
+        let bytes = self
+            .data
+            .get(self.pos..self.pos + count)
+            .context("codec3 stream exhausted while reading literal")?;
+        self.pos += count;
+        Ok(bytes)
+    }
 
-    for chunk in data.chunks_exact(2) {
-        let mut value = u16::from_le_bytes([chunk[0], chunk[1]]);
-        if value == 0xF81F {
-            value = 0;
+    #[inline]
+    fn byte(&mut self) -> Result<u8> {
+        let value = *self
+            .data
+            .get(self.pos)
+            .context("codec3 stream exhausted while reading byte")?;
+        self.pos += 1;
+        Ok(value)
+    }
+}
+
+/// Decode a codec3 frame straight into `result`. `seed` is the previous
+/// frame (or the paired `.bm` for a `.zbm`); its tail is the match history
+/// before the first byte, and its remainder fills anything left undecoded
+/// when the stream ends early.
+fn decompress_codec3(compressed: &[u8], result: &mut [u8], seed: Option<&[u8]>) -> Result<()> {
+    let mut stream = Codec3Stream::new(compressed)?;
+    if let Some(seed) = seed {
+        ensure!(
+            seed.len() == result.len(),
+            "codec3 seed length {} does not match target length {}",
+            seed.len(),
+            result.len()
+        );
+    }
+
+    let mut pos = 0usize;
+    while pos < result.len() {
+        let run = stream.literal_run(result.len() - pos);
+        if run > 0 {
+            result[pos..pos + run].copy_from_slice(stream.take(run)?);
+            pos += run;
+            continue;
         }
-        let normalized = if range == 0 {
-            0.0
+        if stream.bits(1)? == 1 {
+            result[pos] = stream.byte()?;
+            pos += 1;
+            continue;
+        }
+
+        let (length, distance) = if stream.bits(1)? == 0 {
+            let code = stream.bits(2)? as usize;
+            let length = ((code & 1) << 1 | code >> 1) + 3;
+            (length, 0x100 - usize::from(stream.byte()?))
         } else {
-            (value.saturating_sub(min_value)) as f32 / range as f32
+            let lower = usize::from(stream.byte()?);
+            let upper = usize::from(stream.byte()?);
+            let mut length = (upper & 0x0F) + 3;
+            if length == 3 {
+                length = usize::from(stream.byte()?) + 1;
+                if length == 1 {
+                    break;
+                }
+            }
+            (length, CODEC3_WINDOW - (lower | (upper & 0xF0) << 4))
         };
-        let gray = (normalized * 255.0).round().clamp(0.0, 255.0) as u8;
-        rgba.extend_from_slice(&[gray, gray, gray, 0xFF]);
+
+        let end = pos + length.min(result.len() - pos);
+        copy_codec3_match(result, pos, end, distance, seed);
+        pos = end;
+    }
+
+    // An end marker leaves the rest of the frame as the seed had it.
+    match seed {
+        Some(seed) => result[pos..].copy_from_slice(&seed[pos..]),
+        None => result[pos..].fill(0),
+    }
+    Ok(())
+}
+
+/// Fill `out[pos..end]` from `distance` bytes back. Every encodable distance
+/// (1..=4096) stays inside the window, so only the seed prefix needs care.
+#[inline]
+fn copy_codec3_match(
+    out: &mut [u8],
+    mut pos: usize,
+    end: usize,
+    distance: usize,
+    seed: Option<&[u8]>,
+) {
+    debug_assert!((1..=CODEC3_WINDOW).contains(&distance));
+    while pos < end && pos < distance {
+        let back = distance - pos;
+        out[pos] = seed
+            .and_then(|seed| seed.len().checked_sub(back).map(|index| seed[index]))
+            .unwrap_or(0);
+        pos += 1;
+    }
+    if pos == end {
+        return;
     }
 
-    Ok(rgba)
+    let src = pos - distance;
+    let length = end - pos;
+    if distance >= length {
+        if length <= 16 && pos + 16 <= out.len() {
+            // Most matches are short: move a fixed 16 bytes. The source is
+            // read before the write, and anything past `end` is overwritten
+            // by later tokens or the end-of-stream fill.
+            let chunk: [u8; 16] = out[src..src + 16].try_into().unwrap();
+            out[pos..pos + 16].copy_from_slice(&chunk);
+        } else {
+            out.copy_within(src..src + length, pos);
+        }
+        return;
+    }
+
+    // Overlapping match: the output repeats with period `distance`. Lay down
+    // the first `step` bytes (a whole number of periods, at least 16), then
+    // copy 16-byte chunks from `step` back, which never overlap their source.
+    let step = distance * 16usize.div_ceil(distance);
+    let head = (pos + step).min(end);
+    if distance >= 16 {
+        out.copy_within(src..src + (head - pos), pos);
+    } else {
+        for index in pos..head {
+            out[index] = out[index - distance];
+        }
+    }
+    pos = head;
+    while pos + 16 <= end {
+        let chunk: [u8; 16] = out[pos - step..pos - step + 16].try_into().unwrap();
+        out[pos..pos + 16].copy_from_slice(&chunk);
+        pos += 16;
+    }
+    for index in pos..end {
+        out[index] = out[index - distance];
+    }
+}
+
+/// Source and destination row strides for a pitched conversion.
+struct RowLayout {
+    source_row: usize,
+    row_bytes: usize,
+    pitch: usize,
+}
+
+impl RowLayout {
+    fn convert(&self, source: &[u8], dst: &mut [u8], kernel: impl Fn(&[u8], &mut [u8])) {
+        if self.pitch == self.row_bytes {
+            kernel(source, dst);
+            return;
+        }
+        for (src_row, dst_row) in source
+            .chunks_exact(self.source_row)
+            .zip(dst.chunks_mut(self.pitch))
+        {
+            kernel(src_row, &mut dst_row[..self.row_bytes]);
+        }
+    }
 }
 
 #[cfg(test)]
@@ -502,6 +1027,88 @@ mod tests {
         assert_eq!(rgba, vec![0xFF, 0x00, 0xFF, 0xFF]);
     }
 
+    #[test]
+    fn pitched_rgba_rows_match_packed_conversion() {
+        let frame = BmFrame {
+            width: 3,
+            height: 2,
+            data: [0x0000u16, 0x1234, 0xF81F, 0xFFFF, 0x0800, 0x07E0]
+                .into_iter()
+                .flat_map(u16::to_le_bytes)
+                .collect(),
+        };
+        for format in [1, 5] {
+            let metadata = BmMetadata {
+                codec: 0,
+                bits_per_pixel: 16,
+                image_count: 1,
+                width: 3,
+                height: 2,
+                format,
+            };
+            let packed = frame.as_rgba8888(&metadata).unwrap();
+            let mut pitched = vec![0xAAu8; 256 + 12];
+            frame.write_rgba8888(&metadata, &mut pitched, 256).unwrap();
+            assert_eq!(&pitched[..12], &packed[..12]);
+            assert!(pitched[12..256].iter().all(|&byte| byte == 0xAA));
+            assert_eq!(&pitched[256..], &packed[12..]);
+            assert!(frame.write_rgba8888(&metadata, &mut pitched, 8).is_err());
+            assert!(
+                frame
+                    .write_rgba8888(&metadata, &mut pitched[..255], 256)
+                    .is_err()
+            );
+        }
+    }
+
+    #[test]
+    fn depth_histogram_agrees_with_stats_and_ranks_percentiles() {
+        // 10 pixels: two zeros (one written as the sentinel), then 5..=12.
+        let values = [
+            0x0005u16,
+            0,
+            0x0006,
+            0x0007,
+            convert::DEPTH_SENTINEL,
+            0x0008,
+            0x0009,
+            0x000A,
+            0x000B,
+            0x000C,
+        ];
+        let frame = BmFrame {
+            width: 5,
+            height: 2,
+            data: values.into_iter().flat_map(u16::to_le_bytes).collect(),
+        };
+        let metadata = BmMetadata {
+            codec: 0,
+            bits_per_pixel: 16,
+            image_count: 1,
+            width: 5,
+            height: 2,
+            format: 5,
+        };
+        let histogram = frame.depth_histogram(&metadata).unwrap();
+        assert_eq!(histogram.stats(), frame.depth_stats(&metadata).unwrap());
+        assert_eq!(histogram.range(), Some((0, 12)));
+        assert_eq!(histogram.count(0), 2);
+        assert_eq!(histogram.percentile(0.0), Some(0));
+        assert_eq!(histogram.percentile(20.0), Some(0));
+        assert_eq!(histogram.percentile(21.0), Some(5));
+        assert_eq!(histogram.percentile(50.0), Some(7));
+        assert_eq!(histogram.percentile(100.0), Some(12));
+        assert_eq!(histogram.bucket_width(4), 4);
+        assert_eq!(histogram.buckets(4), vec![2, 3, 4, 1]);
+
+        let color = BmMetadata {
+            format: 1,
+            ..metadata
+        };
+        assert!(frame.depth_histogram(&color).is_err());
+        assert_eq!(DepthHistogram::from_depth16(&[]).percentile(50.0), None);
+    }
+
     #[test]
     fn decodes_zbm_with_external_seed() {
         let base_path =
@@ -547,6 +1154,21 @@ mod tests {
         );
     }
 
+    #[test]
+    fn codec3_overlapping_run_then_end_marker_keeps_seed_tail() {
+        let seed: Vec<u8> = (0..64).collect();
+        let mut output = vec![0u8; seed.len()];
+        // Flags 1,1,0,1,0,1: two literals, an extended 40-byte match two
+        // bytes back, then the end marker.
+        let compressed = [0x2B, 0x00, 0xAB, 0xCD, 0xFE, 0xF0, 39, 0x00, 0x00, 0x00];
+
+        decompress_codec3(&compressed, &mut output, Some(&seed)).expect("decode succeeds");
+
+        let run: Vec<u8> = [0xAB, 0xCD].repeat(21);
+        assert_eq!(&output[..42], run.as_slice());
+        assert_eq!(&output[42..], &seed[42..]);
+    }
+
     #[test]
     fn decodes_desk_delta_without_corruption() {
         let base_path =
@@ -600,6 +1222,112 @@ mod tests {
         }
     }
 
+    /// Codec3 BM of 4x2 16bpp frames: frame 0 is eight literals repeated by a
+    /// match, and frame `n` copies its predecessor, then overwrites its last
+    /// `n` bytes.
+    fn chained_codec3_bm(frame_count: u32) -> Vec<u8> {
+        const FRAME_LEN: usize = 16;
+        let mut data = vec![0u8; HEADER_SIZE];
+        data[0..4].copy_from_slice(MAGIC_PRIMARY);
+        data[4..8].copy_from_slice(MAGIC_SECONDARY);
+        data[8..12].copy_from_slice(&3u32.to_le_bytes());
+        data[16..20].copy_from_slice(&frame_count.to_le_bytes());
+        data[32..36].copy_from_slice(&5u32.to_le_bytes());
+        data[36..40].copy_from_slice(&16u32.to_le_bytes());
+
+        // Long match (flags 0,1): 12-bit offset from the window end, length 4..=18.
+        let long_match = |distance: usize, length: usize| {
+            let offset = 0x1000 - distance;
+            [
+                offset as u8,
+                (((offset >> 8) & 0x0F) << 4) as u8 | (length - 3) as u8,
+            ]
+        };
+
+        for frame in 0..frame_count as usize {
+            // Every frame fits in one flag word (fewer than 16 flags), so the
+            // stream is just the flags followed by the token bytes.
+            let (flags, body) = if frame == 0 {
+                let mut body: Vec<u8> = (0..8).collect();
+                body.extend_from_slice(&long_match(8, 8));
+                (0x00FFu16 | 1 << 9, body)
+            } else {
+                let keep = FRAME_LEN - frame;
+                let mut body = long_match(FRAME_LEN, keep).to_vec();
+                body.extend(std::iter::repeat_n(0xE0 | frame as u8, frame));
+                (1u16 << 1 | ((1u16 << frame) - 1) << 2, body)
+            };
+            let mut stream = flags.to_le_bytes().to_vec();
+            stream.extend_from_slice(&body);
+
+            data.extend_from_slice(&4u32.to_le_bytes());
+            data.extend_from_slice(&2u32.to_le_bytes());
+            data.extend_from_slice(&(stream.len() as u32).to_le_bytes());
+            data.extend_from_slice(&stream);
+        }
+        data[HEADER_SIZE..HEADER_SIZE + 4].copy_from_slice(&4u32.to_le_bytes());
+        data[HEADER_SIZE + 4..HEADER_SIZE + 8].copy_from_slice(&2u32.to_le_bytes());
+        data
+    }
+
+    #[test]
+    fn lazy_frames_match_eager_decode() {
+        let bytes = chained_codec3_bm(5);
+        let eager = decode_bm(&bytes).expect("eager decode");
+        let cache = Arc::new(BmFrameCache::new(1 << 20));
+        let lazy = BmFile::open_lazy(bytes.as_slice(), None)
+            .expect("index frames")
+            .with_cache(Arc::clone(&cache));
+
+        assert_eq!(lazy.frame_count(), 5);
+        assert_eq!(lazy.metadata(), eager.metadata());
+        // Frame 3 decodes 0..=3 and caches the chain; frame 4 resumes from it.
+        assert_eq!(lazy.frame(3).unwrap().data, eager.frames[3].data);
+        assert_eq!(cache.len(), 4);
+        assert!(Arc::ptr_eq(
+            &lazy.frame(2).unwrap(),
+            &lazy.frame(2).unwrap()
+        ));
+        for (index, frame) in eager.frames.iter().enumerate() {
+            assert_eq!(lazy.frame(index).unwrap().data, frame.data, "frame {index}");
+        }
+        assert!(lazy.frame(5).is_err());
+
+        drop(lazy);
+        assert!(cache.is_empty());
+        assert_eq!(cache.used_bytes(), 0);
+    }
+
+    #[test]
+    fn frame_cache_evicts_least_recently_used_within_budget() {
+        let bytes = chained_codec3_bm(4);
+        let eager = decode_bm(&bytes).expect("eager decode");
+        // Room for two 16-byte frames.
+        let cache = Arc::new(BmFrameCache::new(32));
+        let lazy = BmFile::open_lazy(bytes.as_slice(), None)
+            .unwrap()
+            .with_cache(Arc::clone(&cache));
+
+        lazy.frame(3).unwrap();
+        assert_eq!(cache.len(), 2);
+        assert_eq!(cache.used_bytes(), 32);
+        assert!(cache.get(lazy.id, 2).is_some());
+        assert!(cache.get(lazy.id, 0).is_none());
+
+        // Touch 2 so 3 is the eviction candidate, then pull frame 1 back in.
+        cache.get(lazy.id, 2);
+        assert_eq!(lazy.frame(1).unwrap().data, eager.frames[1].data);
+        assert!(cache.get(lazy.id, 3).is_none());
+        assert!(cache.get(lazy.id, 1).is_some());
+
+        cache.set_budget(16);
+        assert_eq!(cache.len(), 1);
+        cache.set_budget(0);
+        assert!(cache.is_empty());
+        assert_eq!(lazy.frame(3).unwrap().data, eager.frames[3].data);
+        assert!(cache.is_empty());
+    }
+
     fn seeded_frame_checksum(data: &[u8]) -> u64 {
         let mut acc = 0xcbf29ce484222325u64; // FNV-1a offset basis
         for byte in data {
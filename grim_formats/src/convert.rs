@@ -0,0 +1,546 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// Pixel format conversion kernels shared by the decoders.
+//
+// Each conversion has a portable scalar implementation; the per-pixel hot
+// paths add SSE2/AVX2 variants selected at runtime on x86_64. All kernels
+// write into a caller-provided buffer so per-frame conversions never allocate.
+
+/// Expand 15-bit (x1555) little-endian pixels into RGBA8, alpha forced opaque.
+///
+/// Converts `min(src.len() / 2, dst.len() / 4)` pixels.
+pub fn rgba_from_1555(src: &[u8], dst: &mut [u8]) {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: the AVX2 feature was detected at runtime.
+            return unsafe { x86::rgba_from_1555_avx2(src, dst) };
+        }
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime.
+            return unsafe { x86::rgba_from_1555_sse2(src, dst) };
+        }
+    }
+    rgba_from_1555_scalar(src, dst);
+}
+
+/// Portable reference implementation of [`rgba_from_1555`].
+pub fn rgba_from_1555_scalar(src: &[u8], dst: &mut [u8]) {
+    for (rgba, pixel) in dst.chunks_exact_mut(4).zip(src.chunks_exact(2)) {
+        let value = u16::from_le_bytes([pixel[0], pixel[1]]);
+        let r = ((value >> 10) & 0x1F) as u8;
+        let g = ((value >> 5) & 0x1F) as u8;
+        let b = (value & 0x1F) as u8;
+        rgba[0] = (r << 3) | (r >> 2);
+        rgba[1] = (g << 3) | (g >> 2);
+        rgba[2] = (b << 3) | (b >> 2);
+        rgba[3] = 0xFF;
+    }
+}
+
+/// Expand RGB565 little-endian pixels (BM colour planes) into RGBA8, alpha
+/// forced opaque.
+///
+/// Converts `min(src.len() / 2, dst.len() / 4)` pixels.
+pub fn rgba_from_565(src: &[u8], dst: &mut [u8]) {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: the AVX2 feature was detected at runtime.
+            return unsafe { x86::rgba_from_565_avx2(src, dst) };
+        }
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime.
+            return unsafe { x86::rgba_from_565_sse2(src, dst) };
+        }
+    }
+    rgba_from_565_scalar(src, dst);
+}
+
+/// Portable reference implementation of [`rgba_from_565`].
+pub fn rgba_from_565_scalar(src: &[u8], dst: &mut [u8]) {
+    for (rgba, pixel) in dst.chunks_exact_mut(4).zip(src.chunks_exact(2)) {
+        let value = u16::from_le_bytes([pixel[0], pixel[1]]);
+        let r = ((value >> 11) & 0x1F) as u8;
+        let g = ((value >> 5) & 0x3F) as u8;
+        let b = (value & 0x1F) as u8;
+        rgba[0] = (r << 3) | (r >> 2);
+        rgba[1] = (g << 2) | (g >> 4);
+        rgba[2] = (b << 3) | (b >> 2);
+        rgba[3] = 0xFF;
+    }
+}
+
+/// Reorder little-endian BGRA32 pixels into RGBA8.
+///
+/// Converts `min(src.len(), dst.len()) / 4` pixels.
+pub fn rgba_from_bgra(src: &[u8], dst: &mut [u8]) {
+    for (rgba, bgra) in dst.chunks_exact_mut(4).zip(src.chunks_exact(4)) {
+        rgba.copy_from_slice(&[bgra[2], bgra[1], bgra[0], bgra[3]]);
+    }
+}
+
+/// Z-buffer value the original engine writes for "no depth"; treated as 0.
+pub const DEPTH_SENTINEL: u16 = 0xF81F;
+
+/// Minimum and maximum of a 16-bit Z-buffer (sentinel counted as 0), or
+/// `None` when `src` holds no pixels.
+pub fn depth_range(src: &[u8]) -> Option<(u16, u16)> {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: the AVX2 feature was detected at runtime.
+            return unsafe { x86::depth_range_avx2(src) };
+        }
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime.
+            return unsafe { x86::depth_range_sse2(src) };
+        }
+    }
+    depth_range_scalar(src)
+}
+
+/// Portable reference implementation of [`depth_range`].
+pub fn depth_range_scalar(src: &[u8]) -> Option<(u16, u16)> {
+    let mut min_value = u16::MAX;
+    let mut max_value = u16::MIN;
+    for pixel in src.chunks_exact(2) {
+        let value = u16::from_le_bytes([pixel[0], pixel[1]]);
+        let value = if value == DEPTH_SENTINEL { 0 } else { value };
+        min_value = min_value.min(value);
+        max_value = max_value.max(value);
+    }
+    (src.len() >= 2).then_some((min_value, max_value))
+}
+
+/// Map 16-bit depth to opaque grey RGBA8: `min` becomes black and
+/// `min + range` white. A zero `range` yields black.
+///
+/// Converts `min(src.len() / 2, dst.len() / 4)` pixels.
+pub fn gray_from_depth16(src: &[u8], dst: &mut [u8], min: u16, range: u16) {
+    #[cfg(target_arch = "x86_64")]
+    if range != 0 {
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: the AVX2 feature was detected at runtime.
+            return unsafe { x86::gray_from_depth16_avx2(src, dst, min, range) };
+        }
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime.
+            return unsafe { x86::gray_from_depth16_sse2(src, dst, min, range) };
+        }
+    }
+    gray_from_depth16_scalar(src, dst, min, range);
+}
+
+/// Portable reference implementation of [`gray_from_depth16`].
+pub fn gray_from_depth16_scalar(src: &[u8], dst: &mut [u8], min: u16, range: u16) {
+    for (rgba, pixel) in dst.chunks_exact_mut(4).zip(src.chunks_exact(2)) {
+        let value = u16::from_le_bytes([pixel[0], pixel[1]]);
+        let value = if value == DEPTH_SENTINEL { 0 } else { value };
+        let normalized = if range == 0 {
+            0.0
+        } else {
+            value.saturating_sub(min) as f32 / range as f32
+        };
+        let gray = (normalized * 255.0).round().clamp(0.0, 255.0) as u8;
+        rgba.copy_from_slice(&[gray, gray, gray, 0xFF]);
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+mod x86 {
+    use std::arch::x86_64::*;
+
+    /// Eight pixels per iteration: split channels in 16-bit lanes, widen
+    /// 5→8 bits, then interleave `RG`/`BA` pairs into RGBA words.
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn rgba_from_1555_sse2(src: &[u8], dst: &mut [u8]) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 8;
+        unsafe {
+            let mask5 = _mm_set1_epi16(0x1F);
+            let alpha = _mm_set1_epi16(0xFF00u16 as i16);
+            for block in 0..blocks {
+                let v = _mm_loadu_si128(src.as_ptr().add(block * 16) as *const __m128i);
+                let r = _mm_and_si128(_mm_srli_epi16(v, 10), mask5);
+                let g = _mm_and_si128(_mm_srli_epi16(v, 5), mask5);
+                let b = _mm_and_si128(v, mask5);
+                let r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+                let g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+                let b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+                let rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+                let ba = _mm_or_si128(b, alpha);
+                let out = dst.as_mut_ptr().add(block * 32) as *mut __m128i;
+                _mm_storeu_si128(out, _mm_unpacklo_epi16(rg, ba));
+                _mm_storeu_si128(out.add(1), _mm_unpackhi_epi16(rg, ba));
+            }
+        }
+        let done = blocks * 8;
+        super::rgba_from_1555_scalar(&src[done * 2..], &mut dst[done * 4..]);
+    }
+
+    /// Sixteen pixels per iteration. The 16-bit unpacks work per 128-bit lane,
+    /// so the halves are reordered with a cross-lane permute before storing.
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn rgba_from_1555_avx2(src: &[u8], dst: &mut [u8]) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 16;
+        unsafe {
+            let mask5 = _mm256_set1_epi16(0x1F);
+            let alpha = _mm256_set1_epi16(0xFF00u16 as i16);
+            for block in 0..blocks {
+                let v = _mm256_loadu_si256(src.as_ptr().add(block * 32) as *const __m256i);
+                let r = _mm256_and_si256(_mm256_srli_epi16(v, 10), mask5);
+                let g = _mm256_and_si256(_mm256_srli_epi16(v, 5), mask5);
+                let b = _mm256_and_si256(v, mask5);
+                let r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+                let g = _mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2));
+                let b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+                let rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+                let ba = _mm256_or_si256(b, alpha);
+                let lo = _mm256_unpacklo_epi16(rg, ba);
+                let hi = _mm256_unpackhi_epi16(rg, ba);
+                let out = dst.as_mut_ptr().add(block * 64) as *mut __m256i;
+                _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(out.add(1), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+        }
+        let done = blocks * 16;
+        super::rgba_from_1555_scalar(&src[done * 2..], &mut dst[done * 4..]);
+    }
+
+    /// Same layout as the 1555 kernel with a 6-bit green channel.
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn rgba_from_565_sse2(src: &[u8], dst: &mut [u8]) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 8;
+        unsafe {
+            let mask5 = _mm_set1_epi16(0x1F);
+            let mask6 = _mm_set1_epi16(0x3F);
+            let alpha = _mm_set1_epi16(0xFF00u16 as i16);
+            for block in 0..blocks {
+                let v = _mm_loadu_si128(src.as_ptr().add(block * 16) as *const __m128i);
+                let r = _mm_srli_epi16(v, 11);
+                let g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+                let b = _mm_and_si128(v, mask5);
+                let r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+                let g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+                let b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+                let rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+                let ba = _mm_or_si128(b, alpha);
+                let out = dst.as_mut_ptr().add(block * 32) as *mut __m128i;
+                _mm_storeu_si128(out, _mm_unpacklo_epi16(rg, ba));
+                _mm_storeu_si128(out.add(1), _mm_unpackhi_epi16(rg, ba));
+            }
+        }
+        let done = blocks * 8;
+        super::rgba_from_565_scalar(&src[done * 2..], &mut dst[done * 4..]);
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn rgba_from_565_avx2(src: &[u8], dst: &mut [u8]) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 16;
+        unsafe {
+            let mask5 = _mm256_set1_epi16(0x1F);
+            let mask6 = _mm256_set1_epi16(0x3F);
+            let alpha = _mm256_set1_epi16(0xFF00u16 as i16);
+            for block in 0..blocks {
+                let v = _mm256_loadu_si256(src.as_ptr().add(block * 32) as *const __m256i);
+                let r = _mm256_srli_epi16(v, 11);
+                let g = _mm256_and_si256(_mm256_srli_epi16(v, 5), mask6);
+                let b = _mm256_and_si256(v, mask5);
+                let r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+                let g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+                let b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+                let rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+                let ba = _mm256_or_si256(b, alpha);
+                let lo = _mm256_unpacklo_epi16(rg, ba);
+                let hi = _mm256_unpackhi_epi16(rg, ba);
+                let out = dst.as_mut_ptr().add(block * 64) as *mut __m256i;
+                _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(out.add(1), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+        }
+        let done = blocks * 16;
+        super::rgba_from_565_scalar(&src[done * 2..], &mut dst[done * 4..]);
+    }
+
+    /// Folds a partial result for the scalar tail into a vector result.
+    fn merge_range(a: Option<(u16, u16)>, b: Option<(u16, u16)>) -> Option<(u16, u16)> {
+        match (a, b) {
+            (Some((a_min, a_max)), Some((b_min, b_max))) => {
+                Some((a_min.min(b_min), a_max.max(b_max)))
+            }
+            (a, b) => a.or(b),
+        }
+    }
+
+    /// SSE2 only has signed 16-bit min/max, so lanes are biased by 0x8000
+    /// (an order-preserving map from u16 to i16) and unbiased after the
+    /// horizontal fold.
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn depth_range_sse2(src: &[u8]) -> Option<(u16, u16)> {
+        let blocks = src.len() / 16;
+        if blocks == 0 {
+            return super::depth_range_scalar(src);
+        }
+        let (mut lo, mut hi) = ([0i16; 8], [0i16; 8]);
+        unsafe {
+            let sentinel = _mm_set1_epi16(super::DEPTH_SENTINEL as i16);
+            let bias = _mm_set1_epi16(i16::MIN);
+            let mut min_v = _mm_set1_epi16(i16::MAX);
+            let mut max_v = _mm_set1_epi16(i16::MIN);
+            for block in 0..blocks {
+                let v = _mm_loadu_si128(src.as_ptr().add(block * 16) as *const __m128i);
+                let v = _mm_andnot_si128(_mm_cmpeq_epi16(v, sentinel), v);
+                let v = _mm_xor_si128(v, bias);
+                min_v = _mm_min_epi16(min_v, v);
+                max_v = _mm_max_epi16(max_v, v);
+            }
+            _mm_storeu_si128(lo.as_mut_ptr() as *mut __m128i, min_v);
+            _mm_storeu_si128(hi.as_mut_ptr() as *mut __m128i, max_v);
+        }
+        let unbias = |lane: i16| lane as u16 ^ 0x8000;
+        let min = lo.into_iter().min().map(unbias).unwrap();
+        let max = hi.into_iter().max().map(unbias).unwrap();
+        merge_range(
+            Some((min, max)),
+            super::depth_range_scalar(&src[blocks * 16..]),
+        )
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn depth_range_avx2(src: &[u8]) -> Option<(u16, u16)> {
+        let blocks = src.len() / 32;
+        if blocks == 0 {
+            return super::depth_range_scalar(src);
+        }
+        let (mut lo, mut hi) = ([0u16; 16], [0u16; 16]);
+        unsafe {
+            let sentinel = _mm256_set1_epi16(super::DEPTH_SENTINEL as i16);
+            let mut min_v = _mm256_set1_epi16(-1);
+            let mut max_v = _mm256_setzero_si256();
+            for block in 0..blocks {
+                let v = _mm256_loadu_si256(src.as_ptr().add(block * 32) as *const __m256i);
+                let v = _mm256_andnot_si256(_mm256_cmpeq_epi16(v, sentinel), v);
+                min_v = _mm256_min_epu16(min_v, v);
+                max_v = _mm256_max_epu16(max_v, v);
+            }
+            _mm256_storeu_si256(lo.as_mut_ptr() as *mut __m256i, min_v);
+            _mm256_storeu_si256(hi.as_mut_ptr() as *mut __m256i, max_v);
+        }
+        let min = lo.into_iter().min().unwrap();
+        let max = hi.into_iter().max().unwrap();
+        merge_range(
+            Some((min, max)),
+            super::depth_range_scalar(&src[blocks * 32..]),
+        )
+    }
+
+    /// `round(d / range * 255)` for four depth deltas in 32-bit lanes, using
+    /// the scalar operation order. Rounding is half away from zero like
+    /// `f32::round`: the fraction left after truncation is exact for these
+    /// magnitudes, so comparing it against 0.5 matches bit for bit.
+    #[inline]
+    #[target_feature(enable = "sse2")]
+    unsafe fn depth_to_gray_sse2(delta: __m128i, range: __m128, scale: __m128) -> __m128i {
+        let q = _mm_mul_ps(_mm_div_ps(_mm_cvtepi32_ps(delta), range), scale);
+        let truncated = _mm_cvttps_epi32(q);
+        let fraction = _mm_sub_ps(q, _mm_cvtepi32_ps(truncated));
+        let round_up = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5)));
+        _mm_sub_epi32(truncated, round_up)
+    }
+
+    /// Eight pixels per iteration: drop the sentinel, subtract `min` with
+    /// unsigned saturation, scale in f32, then splat each grey byte to RGBA.
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn gray_from_depth16_sse2(src: &[u8], dst: &mut [u8], min: u16, range: u16) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 8;
+        unsafe {
+            let sentinel = _mm_set1_epi16(super::DEPTH_SENTINEL as i16);
+            let min_v = _mm_set1_epi16(min as i16);
+            let range_v = _mm_set1_ps(f32::from(range));
+            let scale = _mm_set1_ps(255.0);
+            let alpha = _mm_set1_epi16(0xFF00u16 as i16);
+            let zero = _mm_setzero_si128();
+            for block in 0..blocks {
+                let v = _mm_loadu_si128(src.as_ptr().add(block * 16) as *const __m128i);
+                let v = _mm_andnot_si128(_mm_cmpeq_epi16(v, sentinel), v);
+                let delta = _mm_subs_epu16(v, min_v);
+                let lo = depth_to_gray_sse2(_mm_unpacklo_epi16(delta, zero), range_v, scale);
+                let hi = depth_to_gray_sse2(_mm_unpackhi_epi16(delta, zero), range_v, scale);
+                // Deltas beyond `range` clamp to white, as in the scalar path.
+                let gray = _mm_min_epi16(_mm_packs_epi32(lo, hi), _mm_set1_epi16(0xFF));
+                let gg = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+                let ga = _mm_or_si128(gray, alpha);
+                let out = dst.as_mut_ptr().add(block * 32) as *mut __m128i;
+                _mm_storeu_si128(out, _mm_unpacklo_epi16(gg, ga));
+                _mm_storeu_si128(out.add(1), _mm_unpackhi_epi16(gg, ga));
+            }
+        }
+        let done = blocks * 8;
+        super::gray_from_depth16_scalar(&src[done * 2..], &mut dst[done * 4..], min, range);
+    }
+
+    #[inline]
+    #[target_feature(enable = "avx2")]
+    unsafe fn depth_to_gray_avx2(delta: __m256i, range: __m256, scale: __m256) -> __m256i {
+        let q = _mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(delta), range), scale);
+        let truncated = _mm256_cvttps_epi32(q);
+        let fraction = _mm256_sub_ps(q, _mm256_cvtepi32_ps(truncated));
+        let round_up =
+            _mm256_castps_si256(_mm256_cmp_ps::<_CMP_GE_OQ>(fraction, _mm256_set1_ps(0.5)));
+        _mm256_sub_epi32(truncated, round_up)
+    }
+
+    /// Sixteen pixels per iteration; the per-lane unpack/pack pairs cancel
+    /// out, and the final RGBA interleave is reordered across lanes.
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn gray_from_depth16_avx2(src: &[u8], dst: &mut [u8], min: u16, range: u16) {
+        let pixels = (src.len() / 2).min(dst.len() / 4);
+        let blocks = pixels / 16;
+        unsafe {
+            let sentinel = _mm256_set1_epi16(super::DEPTH_SENTINEL as i16);
+            let min_v = _mm256_set1_epi16(min as i16);
+            let range_v = _mm256_set1_ps(f32::from(range));
+            let scale = _mm256_set1_ps(255.0);
+            let alpha = _mm256_set1_epi16(0xFF00u16 as i16);
+            let zero = _mm256_setzero_si256();
+            for block in 0..blocks {
+                let v = _mm256_loadu_si256(src.as_ptr().add(block * 32) as *const __m256i);
+                let v = _mm256_andnot_si256(_mm256_cmpeq_epi16(v, sentinel), v);
+                let delta = _mm256_subs_epu16(v, min_v);
+                let lo = depth_to_gray_avx2(_mm256_unpacklo_epi16(delta, zero), range_v, scale);
+                let hi = depth_to_gray_avx2(_mm256_unpackhi_epi16(delta, zero), range_v, scale);
+                let gray = _mm256_min_epi16(_mm256_packs_epi32(lo, hi), _mm256_set1_epi16(0xFF));
+                let gg = _mm256_or_si256(gray, _mm256_slli_epi16(gray, 8));
+                let ga = _mm256_or_si256(gray, alpha);
+                let lo = _mm256_unpacklo_epi16(gg, ga);
+                let hi = _mm256_unpackhi_epi16(gg, ga);
+                let out = dst.as_mut_ptr().add(block * 64) as *mut __m256i;
+                _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(out.add(1), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+        }
+        let done = blocks * 16;
+        super::gray_from_depth16_scalar(&src[done * 2..], &mut dst[done * 4..], min, range);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn all_1555_pixels() -> Vec<u8> {
+        // Every 16-bit value plus an odd tail so the scalar remainder runs.
+        (0..=u16::MAX)
+            .chain([0x7FFF, 0x8001, 0x1234])
+            .flat_map(u16::to_le_bytes)
+            .collect()
+    }
+
+    #[test]
+    fn dispatched_1555_matches_scalar() {
+        let src = all_1555_pixels();
+        let mut expected = vec![0u8; src.len() * 2];
+        let mut actual = vec![0u8; src.len() * 2];
+        rgba_from_1555_scalar(&src, &mut expected);
+        rgba_from_1555(&src, &mut actual);
+        assert_eq!(actual, expected);
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    #[test]
+    fn sse2_1555_matches_scalar() {
+        let src = all_1555_pixels();
+        let mut expected = vec![0u8; src.len() * 2];
+        let mut actual = vec![0u8; src.len() * 2];
+        rgba_from_1555_scalar(&src, &mut expected);
+        unsafe { x86::rgba_from_1555_sse2(&src, &mut actual) };
+        assert_eq!(actual, expected);
+    }
+
+    #[test]
+    fn dispatched_565_matches_scalar() {
+        let src = all_1555_pixels();
+        let mut expected = vec![0u8; src.len() * 2];
+        let mut actual = vec![0u8; src.len() * 2];
+        rgba_from_565_scalar(&src, &mut expected);
+        rgba_from_565(&src, &mut actual);
+        assert_eq!(actual, expected);
+        #[cfg(target_arch = "x86_64")]
+        {
+            unsafe { x86::rgba_from_565_sse2(&src, &mut actual) };
+            assert_eq!(actual, expected);
+        }
+    }
+
+    #[test]
+    fn scalar_565_expands_channels() {
+        let mut rgba = [0u8; 8];
+        rgba_from_565_scalar(&[0x00, 0xF8, 0xE0, 0x07], &mut rgba);
+        assert_eq!(rgba, [0xFF, 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF]);
+    }
+
+    #[test]
+    fn depth_gray_kernels_match_scalar() {
+        let src = all_1555_pixels();
+        let mut expected = vec![0u8; src.len() * 2];
+        let mut actual = vec![0u8; src.len() * 2];
+        // Full range, odd ranges that exercise rounding ties, a range smaller
+        // than the data (clamps to white), and a flat plane.
+        for (min, range) in [(0, u16::MAX), (7, 0xAFEE), (100, 3), (0x8000, 510), (5, 0)] {
+            gray_from_depth16_scalar(&src, &mut expected, min, range);
+            gray_from_depth16(&src, &mut actual, min, range);
+            assert_eq!(actual, expected, "dispatch min={min} range={range}");
+            #[cfg(target_arch = "x86_64")]
+            if range != 0 {
+                actual.fill(0);
+                unsafe { x86::gray_from_depth16_sse2(&src, &mut actual, min, range) };
+                assert_eq!(actual, expected, "sse2 min={min} range={range}");
+            }
+        }
+    }
+
+    #[test]
+    fn depth_range_treats_sentinel_as_zero() {
+        let src: Vec<u8> = [0x0100u16, DEPTH_SENTINEL, 0x0040]
+            .into_iter()
+            .flat_map(u16::to_le_bytes)
+            .collect();
+        assert_eq!(depth_range(&src), Some((0, 0x0100)));
+        assert_eq!(depth_range(&[]), None);
+    }
+
+    #[test]
+    fn depth_range_kernels_match_scalar() {
+        let src = all_1555_pixels();
+        // Windows that put the extremes in the vector body, the scalar tail,
+        // or both, plus slices shorter than one vector.
+        for range in [
+            0..src.len(),
+            2..src.len() - 2,
+            0x2000..0x2040,
+            0x8100..0x8106,
+            0..2,
+        ] {
+            let window = &src[range.clone()];
+            let expected = depth_range_scalar(window);
+            assert_eq!(depth_range(window), expected, "dispatch {range:?}");
+            #[cfg(target_arch = "x86_64")]
+            {
+                let actual = unsafe { x86::depth_range_sse2(window) };
+                assert_eq!(actual, expected, "sse2 {range:?}");
+            }
+        }
+    }
+
+    #[test]
+    fn scalar_1555_expands_channels() {
+        let mut rgba = [0u8; 8];
+        rgba_from_1555_scalar(&[0x00, 0x7C, 0x1F, 0x00], &mut rgba);
+        assert_eq!(rgba, [0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF]);
+    }
+}
@@ -0,0 +1,476 @@
+//! Resolves parsed costumes into loaded, shared assets.
+//!
+//! A costume lists its models, keyframes, materials and colormaps as
+//! components. [`CostumeLoader`] loads every distinct asset once, in
+//! parallel, and hands the same `Arc` to each costume that references it;
+//! resolving a costume again (an actor swapping back to an outfit) is a
+//! cache hit returning the same handle.
+
+use std::borrow::Cow;
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex};
+
+use anyhow::{Context, Result};
+use rayon::prelude::*;
+
+use crate::cos::CosFile;
+use crate::key::KeyframeAnimation;
+use crate::lab::LabArchive;
+use crate::three_do::FlatModel;
+
+/// Somewhere costume dependencies can be read from by file name.
+pub trait AssetSource: Sync {
+    /// Bytes of the named asset, or `None` if the source does not hold it.
+    /// Names are matched case-insensitively.
+    fn read_asset(&self, name: &str) -> Option<Cow<'_, [u8]>>;
+}
+
+impl AssetSource for LabArchive {
+    fn read_asset(&self, name: &str) -> Option<Cow<'_, [u8]>> {
+        self.find_entry(name)
+            .map(|entry| Cow::Borrowed(self.read_entry_bytes(entry)))
+    }
+}
+
+/// Archives are searched in order; the first match wins.
+impl AssetSource for [LabArchive] {
+    fn read_asset(&self, name: &str) -> Option<Cow<'_, [u8]>> {
+        self.iter().find_map(|archive| archive.read_asset(name))
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AssetKind {
+    Model,
+    Keyframe,
+    Material,
+    Colormap,
+}
+
+impl AssetKind {
+    /// Maps a costume tag (`MMDL`, `KEYF`, ...) to the asset it loads.
+    /// Sprites, sounds and Lua variables have no file to resolve.
+    pub fn from_tag(tag: &str) -> Option<Self> {
+        match tag.trim().to_ascii_uppercase().as_str() {
+            "MMDL" | "MODL" => Some(AssetKind::Model),
+            "KEYF" => Some(AssetKind::Keyframe),
+            "MAT" => Some(AssetKind::Material),
+            "COLR" => Some(AssetKind::Colormap),
+            _ => None,
+        }
+    }
+}
+
+/// A loaded dependency. Materials and colormaps stay as raw bytes until
+/// there is a decoder for them.
+#[derive(Debug, Clone)]
+pub enum CostumeAsset {
+    Model(Arc<FlatModel>),
+    Keyframe(Arc<KeyframeAnimation>),
+    Material(Arc<[u8]>),
+    Colormap(Arc<[u8]>),
+}
+
+impl CostumeAsset {
+    fn load(kind: AssetKind, name: &str, bytes: &[u8]) -> Result<Self> {
+        Ok(match kind {
+            AssetKind::Model => CostumeAsset::Model(Arc::new(
+                FlatModel::from_bytes(bytes).with_context(|| format!("decoding model {name}"))?,
+            )),
+            AssetKind::Keyframe => CostumeAsset::Keyframe(Arc::new(
+                KeyframeAnimation::from_bytes(bytes)
+                    .with_context(|| format!("decoding keyframe {name}"))?,
+            )),
+            AssetKind::Material => CostumeAsset::Material(Arc::from(bytes)),
+            AssetKind::Colormap => CostumeAsset::Colormap(Arc::from(bytes)),
+        })
+    }
+
+    fn kind(&self) -> AssetKind {
+        match self {
+            CostumeAsset::Model(_) => AssetKind::Model,
+            CostumeAsset::Keyframe(_) => AssetKind::Keyframe,
+            CostumeAsset::Material(_) => AssetKind::Material,
+            CostumeAsset::Colormap(_) => AssetKind::Colormap,
+        }
+    }
+}
+
+/// A dependency that was missing from the source or failed to decode.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct AssetFailure {
+    pub name: String,
+    pub reason: String,
+}
+
+#[derive(Debug, Clone)]
+pub struct ResolvedComponent {
+    pub id: i32,
+    pub tag: String,
+    pub name: String,
+    /// Index of the parent component in [`ResolvedCostume::components`].
+    pub parent: Option<usize>,
+    /// `None` for tags without a file, and for dependencies that failed.
+    pub asset: Option<CostumeAsset>,
+    /// For models, each entry of the model's material list, in order.
+    pub materials: Vec<Option<Arc<[u8]>>>,
+}
+
+#[derive(Debug)]
+pub struct ResolvedCostume {
+    pub name: String,
+    pub components: Vec<ResolvedComponent>,
+    pub failures: Vec<AssetFailure>,
+}
+
+impl ResolvedCostume {
+    pub fn models(&self) -> impl Iterator<Item = (&ResolvedComponent, &Arc<FlatModel>)> + '_ {
+        self.components
+            .iter()
+            .filter_map(|component| match &component.asset {
+                Some(CostumeAsset::Model(model)) => Some((component, model)),
+                _ => None,
+            })
+    }
+
+    pub fn keyframe(&self, name: &str) -> Option<&Arc<KeyframeAnimation>> {
+        self.components
+            .iter()
+            .find_map(|component| match &component.asset {
+                Some(CostumeAsset::Keyframe(keyframe))
+                    if component.name.eq_ignore_ascii_case(name) =>
+                {
+                    Some(keyframe)
+                }
+                _ => None,
+            })
+    }
+
+    pub fn is_complete(&self) -> bool {
+        self.failures.is_empty()
+    }
+}
+
+/// Shared cache of costume dependencies and resolved costumes, keyed by
+/// lowercase file name. Safe to share between threads.
+#[derive(Debug, Default)]
+pub struct CostumeLoader {
+    assets: Mutex<HashMap<String, CostumeAsset>>,
+    costumes: Mutex<HashMap<String, Arc<ResolvedCostume>>>,
+}
+
+impl CostumeLoader {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Reads, parses and resolves the costume `name` from `source`, or
+    /// returns the handle from an earlier call.
+    pub fn load<S: AssetSource + ?Sized>(
+        &self,
+        name: &str,
+        source: &S,
+    ) -> Result<Arc<ResolvedCostume>> {
+        if let Some(costume) = self.cached_costume(name) {
+            return Ok(costume);
+        }
+        let bytes = source
+            .read_asset(name)
+            .with_context(|| format!("costume {name} not found"))?;
+        let costume = CosFile::parse_bytes(&bytes).with_context(|| format!("parsing {name}"))?;
+        Ok(self.resolve(name, &costume, source))
+    }
+
+    /// Resolves an already parsed costume and caches it under `name`.
+    /// Missing or undecodable dependencies are reported in
+    /// [`ResolvedCostume::failures`] rather than failing the costume.
+    pub fn resolve<S: AssetSource + ?Sized>(
+        &self,
+        name: &str,
+        costume: &CosFile,
+        source: &S,
+    ) -> Arc<ResolvedCostume> {
+        if let Some(resolved) = self.cached_costume(name) {
+            return resolved;
+        }
+
+        let tag_kinds: HashMap<i32, (&str, Option<AssetKind>)> = costume
+            .tags
+            .iter()
+            .map(|tag| (tag.id, (tag.tag.as_str(), AssetKind::from_tag(&tag.tag))))
+            .collect();
+        let wanted: Vec<(AssetKind, &str)> = costume
+            .components
+            .iter()
+            .filter_map(|component| {
+                let (_, kind) = tag_kinds.get(&component.tag_id)?;
+                Some(((*kind)?, component.name.as_str()))
+            })
+            .collect();
+        let mut failures = self.load_missing(&wanted, source);
+
+        // Models name their materials, which are only known once the models
+        // themselves are loaded.
+        let models: Vec<Arc<FlatModel>> = wanted
+            .iter()
+            .filter_map(|(_, name)| match self.cached_asset(name) {
+                Some(CostumeAsset::Model(model)) => Some(model),
+                _ => None,
+            })
+            .collect();
+        let materials: Vec<(AssetKind, &str)> = models
+            .iter()
+            .flat_map(|model| &model.materials)
+            .map(|material| (AssetKind::Material, material.as_str()))
+            .collect();
+        failures.extend(self.load_missing(&materials, source));
+
+        let index_of: HashMap<i32, usize> = costume
+            .components
+            .iter()
+            .enumerate()
+            .map(|(index, component)| (component.id, index))
+            .collect();
+        let components = costume
+            .components
+            .iter()
+            .map(|component| {
+                let (tag, kind) = tag_kinds
+                    .get(&component.tag_id)
+                    .copied()
+                    .unwrap_or(("", None));
+                let asset = kind
+                    .and_then(|_| self.cached_asset(&component.name))
+                    .filter(|asset| Some(asset.kind()) == kind);
+                let materials = match &asset {
+                    Some(CostumeAsset::Model(model)) => model
+                        .materials
+                        .iter()
+                        .map(|material| match self.cached_asset(material) {
+                            Some(CostumeAsset::Material(bytes)) => Some(bytes),
+                            _ => None,
+                        })
+                        .collect(),
+                    _ => Vec::new(),
+                };
+                ResolvedComponent {
+                    id: component.id,
+                    tag: tag.to_string(),
+                    name: component.name.clone(),
+                    parent: index_of.get(&component.parent_id).copied(),
+                    asset,
+                    materials,
+                }
+            })
+            .collect();
+
+        let resolved = Arc::new(ResolvedCostume {
+            name: name.to_string(),
+            components,
+            failures,
+        });
+        // Another thread may have resolved the same costume meanwhile; keep
+        // whichever landed first so every caller shares one handle.
+        self.costumes
+            .lock()
+            .unwrap()
+            .entry(name.to_ascii_lowercase())
+            .or_insert(resolved)
+            .clone()
+    }
+
+    pub fn cached_costume(&self, name: &str) -> Option<Arc<ResolvedCostume>> {
+        self.costumes
+            .lock()
+            .unwrap()
+            .get(&name.to_ascii_lowercase())
+            .cloned()
+    }
+
+    /// Number of distinct dependencies held across all costumes.
+    pub fn asset_count(&self) -> usize {
+        self.assets.lock().unwrap().len()
+    }
+
+    fn cached_asset(&self, name: &str) -> Option<CostumeAsset> {
+        self.assets
+            .lock()
+            .unwrap()
+            .get(&name.to_ascii_lowercase())
+            .cloned()
+    }
+
+    /// Loads every dependency not already cached, in parallel, without
+    /// holding the cache lock while decoding.
+    fn load_missing<S: AssetSource + ?Sized>(
+        &self,
+        wanted: &[(AssetKind, &str)],
+        source: &S,
+    ) -> Vec<AssetFailure> {
+        let mut pending: Vec<(AssetKind, String)> = {
+            let assets = self.assets.lock().unwrap();
+            wanted
+                .iter()
+                .map(|&(kind, name)| (kind, name.to_ascii_lowercase()))
+                .filter(|(_, key)| !assets.contains_key(key))
+                .collect()
+        };
+        pending.sort_by(|a, b| a.1.cmp(&b.1));
+        pending.dedup_by(|a, b| a.1 == b.1);
+
+        let loaded: Vec<(String, Result<CostumeAsset>)> = pending
+            .into_par_iter()
+            .map(|(kind, key)| {
+                let asset = source
+                    .read_asset(&key)
+                    .with_context(|| format!("{key} not found"))
+                    .and_then(|bytes| CostumeAsset::load(kind, &key, &bytes));
+                (key, asset)
+            })
+            .collect();
+
+        let mut failures = Vec::new();
+        let mut assets = self.assets.lock().unwrap();
+        for (key, asset) in loaded {
+            match asset {
+                Ok(asset) => {
+                    assets.entry(key).or_insert(asset);
+                }
+                Err(err) => failures.push(AssetFailure {
+                    name: key,
+                    reason: format!("{err:#}"),
+                }),
+            }
+        }
+        failures
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[derive(Default)]
+    struct MemorySource {
+        files: HashMap<String, Vec<u8>>,
+        reads: Mutex<Vec<String>>,
+    }
+
+    impl MemorySource {
+        fn insert(&mut self, name: &str, bytes: Vec<u8>) {
+            self.files.insert(name.to_string(), bytes);
+        }
+    }
+
+    impl AssetSource for MemorySource {
+        fn read_asset(&self, name: &str) -> Option<Cow<'_, [u8]>> {
+            self.reads.lock().unwrap().push(name.to_string());
+            self.files
+                .iter()
+                .find(|(file, _)| file.eq_ignore_ascii_case(name))
+                .map(|(_, bytes)| Cow::Borrowed(bytes.as_slice()))
+        }
+    }
+
+    /// A 3DO with no geosets or nodes, naming `materials`.
+    fn empty_model(name: &str, materials: &[&str]) -> Vec<u8> {
+        let mut out = Vec::new();
+        let name_field = |out: &mut Vec<u8>, value: &str| {
+            let mut field = [0u8; 32];
+            field[..value.len()].copy_from_slice(value.as_bytes());
+            out.extend_from_slice(&field);
+        };
+        out.extend_from_slice(b"LDOM");
+        out.extend_from_slice(&(materials.len() as u32).to_le_bytes());
+        for material in materials {
+            name_field(&mut out, material);
+        }
+        name_field(&mut out, name);
+        out.extend_from_slice(&[0u8; 4]);
+        out.extend_from_slice(&0u32.to_le_bytes()); // geosets
+        out.extend_from_slice(&0u32.to_le_bytes());
+        out.extend_from_slice(&0u32.to_le_bytes()); // nodes
+        out.extend_from_slice(&1.0f32.to_le_bytes());
+        out.extend_from_slice(&[0u8; 36 + 12]);
+        out
+    }
+
+    fn empty_keyframe() -> Vec<u8> {
+        let mut out = vec![0u8; 180];
+        out[..4].copy_from_slice(b"FYEK");
+        out
+    }
+
+    fn costume(body: &str) -> String {
+        format!(
+            "costume v0.1\nsection tags\n    0 'MMDL' fs Model\n    1 'KEYF' fs Keyframe\n    2 'LUAV' fs Lua\nsection components\n{body}"
+        )
+    }
+
+    #[test]
+    fn shares_assets_across_costumes_and_reuses_handles() {
+        let mut source = MemorySource::default();
+        source.insert("suit.3do", empty_model("suit", &["suit.mat", "tie.mat"]));
+        source.insert("SUIT.MAT", vec![1, 2, 3]);
+        source.insert("ma_idle.key", empty_keyframe());
+        source.insert("ma_walk.key", empty_keyframe());
+        source.insert(
+            "ma.cos",
+            costume(
+                "    0 0 0 -1 suit.3do\n    1 1 0 0 ma_idle.key\n    2 1 0 0 ma_walk.key\n    3 2 0 0 ma_state\n",
+            )
+            .into_bytes(),
+        );
+        source.insert(
+            "ma_sit.cos",
+            costume("    0 0 0 -1 suit.3do\n    1 1 0 0 ma_idle.key\n    2 1 0 0 ma_sit.key\n")
+                .into_bytes(),
+        );
+
+        let loader = CostumeLoader::new();
+        let walk = loader.load("ma.cos", &source).unwrap();
+        assert_eq!(walk.components.len(), 4);
+        assert_eq!(walk.components[0].parent, None);
+        assert_eq!(walk.components[2].parent, Some(0));
+        assert_eq!(walk.components[0].tag, "MMDL");
+        assert!(walk.components[3].asset.is_none());
+        assert!(walk.keyframe("MA_WALK.KEY").is_some());
+        let (_, suit) = walk.models().next().unwrap();
+        assert_eq!(suit.name.as_deref(), Some("suit"));
+        assert_eq!(
+            walk.components[0].materials[0].as_deref(),
+            Some(&[1, 2, 3][..])
+        );
+        assert!(walk.components[0].materials[1].is_none());
+        assert_eq!(
+            walk.failures,
+            vec![AssetFailure {
+                name: "tie.mat".to_string(),
+                reason: "tie.mat not found".to_string(),
+            }]
+        );
+        assert_eq!(loader.asset_count(), 4);
+
+        let sit = loader.load("MA_SIT.COS", &source).unwrap();
+        assert!(Arc::ptr_eq(
+            walk.models().next().unwrap().1,
+            sit.models().next().unwrap().1
+        ));
+        assert!(Arc::ptr_eq(
+            walk.keyframe("ma_idle.key").unwrap(),
+            sit.keyframe("ma_idle.key").unwrap()
+        ));
+        assert_eq!(sit.failures.len(), 2);
+
+        // Shared dependencies were read once; swapping back is a cache hit.
+        let reads_before = source.reads.lock().unwrap().len();
+        assert!(Arc::ptr_eq(&loader.load("ma.cos", &source).unwrap(), &walk));
+        assert_eq!(source.reads.lock().unwrap().len(), reads_before);
+        let reads = source.reads.lock().unwrap();
+        assert_eq!(reads.iter().filter(|name| *name == "suit.3do").count(), 1);
+        assert_eq!(
+            reads.iter().filter(|name| *name == "ma_idle.key").count(),
+            1
+        );
+    }
+}
@@ -0,0 +1,751 @@
+//! Binary keyframe animations (`.key`, `FYEK` magic).
+//!
+//! Keys are kept as structure-of-arrays: the animation owns one arena per
+//! channel (frame, flags, position/rotation values and their per-frame
+//! deltas) and each joint's track is a contiguous range inside them.
+//! [`PoseSampler`] first finds the active key of every track, then
+//! evaluates all channels of all joints in one vectorised pass.
+//!
+//! Rotations are Euler angles in degrees, so there is no quaternion slerp:
+//! sampling extrapolates each channel along the key's stored delta, and
+//! [`Pose::blend_toward`] interpolates angles along the shorter arc.
+
+use std::ops::Range;
+
+use anyhow::{Context, Result, bail, ensure};
+
+const MAGIC: &[u8; 4] = b"FYEK";
+const HEADER_SIZE: usize = 180;
+const MARKER_FRAMES_AT: usize = 72;
+const MARKER_VALUES_AT: usize = 104;
+/// The marker frame and value tables are eight entries apart.
+const MAX_MARKERS: usize = (MARKER_VALUES_AT - MARKER_FRAMES_AT) / 4;
+const TRACK_HEADER_SIZE: usize = 44;
+const KEY_SIZE: usize = 56;
+/// Rate used when the header leaves the frame rate unset.
+const DEFAULT_FPS: f32 = 15.0;
+
+/// Animation flag that freezes each key instead of extrapolating along its
+/// deltas (the "shaking" animations rely on this).
+pub const KEY_FLAG_NO_DELTA: u32 = 0x100;
+
+/// Channels per joint, in [`Pose::channels`] order: position x/y/z, then
+/// pitch, yaw and roll in degrees.
+pub const POSE_CHANNELS: usize = 6;
+
+/// Arena slot reserved for joints without a track; all of its channels are
+/// zero so the gather pass needs no per-joint branch.
+const EMPTY_KEY: u32 = 0;
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct KeyMarker {
+    pub frame: f32,
+    pub value: u32,
+}
+
+/// One joint's keys as parallel slices.
+#[derive(Debug, Clone, Copy)]
+pub struct KeyTrack<'a> {
+    pub name: &'a str,
+    pub frames: &'a [f32],
+    pub flags: &'a [u32],
+    pub values: [&'a [f32]; POSE_CHANNELS],
+    pub deltas: [&'a [f32]; POSE_CHANNELS],
+}
+
+#[derive(Debug, Clone)]
+struct TrackSlot {
+    name: String,
+    keys: Range<usize>,
+}
+
+#[derive(Debug, Clone)]
+pub struct KeyframeAnimation {
+    pub name: String,
+    pub flags: u32,
+    /// Node type mask; the engine only animates model nodes whose type
+    /// intersects it.
+    pub node_type: u32,
+    pub fps: f32,
+    pub num_frames: u32,
+    pub markers: Vec<KeyMarker>,
+    /// Indexed by joint number; `None` for joints the file leaves alone.
+    tracks: Vec<Option<TrackSlot>>,
+    frames: Vec<f32>,
+    key_flags: Vec<u32>,
+    values: [Vec<f32>; POSE_CHANNELS],
+    deltas: [Vec<f32>; POSE_CHANNELS],
+}
+
+impl KeyframeAnimation {
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self> {
+        ensure!(
+            bytes.len() >= HEADER_SIZE,
+            "keyframe file is {} bytes, shorter than its {HEADER_SIZE}-byte header",
+            bytes.len()
+        );
+        if &bytes[..4] != MAGIC {
+            bail!("not a binary keyframe file (missing FYEK magic)");
+        }
+
+        let name = fixed_string(&bytes[4..36]);
+        let flags = u32_at(bytes, 40)?;
+        let node_type = u32_at(bytes, 48)?;
+        let declared_fps = f32_at(bytes, 52)?;
+        let fps = if declared_fps.is_finite() && declared_fps > 0.0 {
+            declared_fps
+        } else {
+            DEFAULT_FPS
+        };
+        let num_frames = u32_at(bytes, 56)?;
+        let num_joints = u32_at(bytes, 60)? as usize;
+        let num_markers = u32_at(bytes, 68)? as usize;
+        ensure!(
+            num_markers <= MAX_MARKERS,
+            "keyframe file declares {num_markers} markers, at most {MAX_MARKERS} fit"
+        );
+        let markers = (0..num_markers)
+            .map(|index| {
+                Ok(KeyMarker {
+                    frame: f32_at(bytes, MARKER_FRAMES_AT + index * 4)?,
+                    value: u32_at(bytes, MARKER_VALUES_AT + index * 4)?,
+                })
+            })
+            .collect::<Result<Vec<_>>>()?;
+        ensure!(
+            num_joints <= (bytes.len() - HEADER_SIZE) / TRACK_HEADER_SIZE,
+            "keyframe file declares {num_joints} joints but holds only {} bytes of tracks",
+            bytes.len() - HEADER_SIZE
+        );
+
+        let mut animation = KeyframeAnimation {
+            name,
+            flags,
+            node_type,
+            fps,
+            num_frames,
+            markers,
+            tracks: vec![None; num_joints],
+            frames: vec![0.0],
+            key_flags: vec![0],
+            values: std::array::from_fn(|_| vec![0.0]),
+            deltas: std::array::from_fn(|_| vec![0.0]),
+        };
+
+        let mut pos = HEADER_SIZE;
+        for track in 0..num_joints {
+            let header = bytes
+                .get(pos..pos + TRACK_HEADER_SIZE)
+                .with_context(|| format!("track {track} header is truncated"))?;
+            let joint = u32_at(header, 32)? as usize;
+            let num_keys = u32_at(header, 36)? as usize;
+            pos += TRACK_HEADER_SIZE;
+            let keys = num_keys
+                .checked_mul(KEY_SIZE)
+                .and_then(|len| bytes.get(pos..pos.checked_add(len)?))
+                .with_context(|| format!("track {track} declares {num_keys} keys past the end"))?;
+            pos += keys.len();
+
+            ensure!(
+                joint < num_joints,
+                "track {track} targets joint {joint} of {num_joints}"
+            );
+            // Some files (ma_rest.key) repeat a joint number with a blank
+            // name; the first track for a joint wins.
+            if animation.tracks[joint].is_some() {
+                continue;
+            }
+            let start = animation.frames.len();
+            for key in keys.chunks_exact(KEY_SIZE) {
+                animation.push_key(key)?;
+            }
+            ensure!(
+                animation.frames.len() <= i32::MAX as usize,
+                "keyframe file holds too many keys"
+            );
+            animation.tracks[joint] = Some(TrackSlot {
+                name: fixed_string(&header[..32]),
+                keys: start..animation.frames.len(),
+            });
+        }
+        Ok(animation)
+    }
+
+    fn push_key(&mut self, key: &[u8]) -> Result<()> {
+        self.frames.push(f32_at(key, 0)?);
+        self.key_flags.push(u32_at(key, 4)?);
+        for channel in 0..POSE_CHANNELS {
+            self.values[channel].push(f32_at(key, 8 + channel * 4)?);
+            self.deltas[channel].push(f32_at(key, 32 + channel * 4)?);
+        }
+        Ok(())
+    }
+
+    /// Number of joint slots, animated or not.
+    pub fn joint_count(&self) -> usize {
+        self.tracks.len()
+    }
+
+    /// Total keys across all tracks.
+    pub fn key_count(&self) -> usize {
+        self.frames.len() - 1
+    }
+
+    pub fn track(&self, joint: usize) -> Option<KeyTrack<'_>> {
+        let slot = self.tracks.get(joint)?.as_ref()?;
+        let keys = slot.keys.clone();
+        Some(KeyTrack {
+            name: &slot.name,
+            frames: &self.frames[keys.clone()],
+            flags: &self.key_flags[keys.clone()],
+            values: std::array::from_fn(|channel| &self.values[channel][keys.clone()]),
+            deltas: std::array::from_fn(|channel| &self.deltas[channel][keys.clone()]),
+        })
+    }
+
+    /// Playback length in seconds.
+    pub fn duration(&self) -> f32 {
+        self.num_frames as f32 / self.fps
+    }
+
+    /// Animation frame shown at `time` seconds; playback holds the last frame.
+    pub fn frame_at(&self, time: f32) -> f32 {
+        (time * self.fps).min(self.num_frames as f32)
+    }
+
+    fn uses_deltas(&self) -> bool {
+        self.flags & KEY_FLAG_NO_DELTA == 0
+    }
+}
+
+/// Per-joint transforms produced by [`PoseSampler`], one array per channel.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct Pose {
+    pub channels: [Vec<f32>; POSE_CHANNELS],
+    /// Whether the animation has a track for each joint; unanimated joints
+    /// sample as zero and should keep their rest transform.
+    pub animated: Vec<bool>,
+}
+
+impl Pose {
+    pub fn joint_count(&self) -> usize {
+        self.animated.len()
+    }
+
+    pub fn position(&self, joint: usize) -> [f32; 3] {
+        std::array::from_fn(|axis| self.channels[axis][joint])
+    }
+
+    /// `[pitch, yaw, roll]` in degrees.
+    pub fn rotation(&self, joint: usize) -> [f32; 3] {
+        std::array::from_fn(|axis| self.channels[3 + axis][joint])
+    }
+
+    fn resize(&mut self, joints: usize) {
+        for channel in &mut self.channels {
+            channel.resize(joints, 0.0);
+        }
+        self.animated.resize(joints, false);
+    }
+
+    /// Moves every joint `fade` of the way toward `target`: positions lerp,
+    /// angles take the shorter arc. Joints only animated in `target` snap in
+    /// from zero, matching how chores fade keyframes over the rest pose.
+    pub fn blend_toward(&mut self, target: &Pose, fade: f32) {
+        let joints = self.joint_count().max(target.joint_count());
+        self.resize(joints);
+        for (channel, (current, target)) in
+            self.channels.iter_mut().zip(&target.channels).enumerate()
+        {
+            let len = target.len().min(current.len());
+            blend_channel(&mut current[..len], &target[..len], fade, channel >= 3);
+        }
+        for (animated, target) in self.animated.iter_mut().zip(&target.animated) {
+            *animated |= *target;
+        }
+    }
+}
+
+/// Reusable scratch for sampling; keeps per-joint key lookups between calls
+/// so steady-state sampling does not allocate.
+#[derive(Debug, Default)]
+pub struct PoseSampler {
+    keys: Vec<u32>,
+    offsets: Vec<f32>,
+}
+
+impl PoseSampler {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Samples every joint at `time` seconds into `pose`.
+    pub fn sample(&mut self, animation: &KeyframeAnimation, time: f32, pose: &mut Pose) {
+        self.sample_frame(animation, animation.frame_at(time), pose);
+    }
+
+    pub fn sample_frame(&mut self, animation: &KeyframeAnimation, frame: f32, pose: &mut Pose) {
+        self.locate(animation, frame, pose);
+        for channel in 0..POSE_CHANNELS {
+            evaluate_channel(
+                &self.keys,
+                &self.offsets,
+                &animation.values[channel],
+                &animation.deltas[channel],
+                &mut pose.channels[channel],
+            );
+        }
+    }
+
+    /// Reference implementation of [`PoseSampler::sample_frame`].
+    pub fn sample_frame_scalar(
+        &mut self,
+        animation: &KeyframeAnimation,
+        frame: f32,
+        pose: &mut Pose,
+    ) {
+        self.locate(animation, frame, pose);
+        for channel in 0..POSE_CHANNELS {
+            evaluate_channel_scalar(
+                &self.keys,
+                &self.offsets,
+                &animation.values[channel],
+                &animation.deltas[channel],
+                &mut pose.channels[channel],
+            );
+        }
+    }
+
+    /// Finds each track's last key at or before `frame`. Playback moves
+    /// forward a little at a time, so the previous call's key is tried first
+    /// and a binary search only runs when the frame left its neighbourhood.
+    /// Before a track's first key the first key is extrapolated backwards,
+    /// as the engine does.
+    fn locate(&mut self, animation: &KeyframeAnimation, frame: f32, pose: &mut Pose) {
+        let joints = animation.joint_count();
+        let uses_deltas = animation.uses_deltas();
+        self.keys.resize(joints, EMPTY_KEY);
+        self.offsets.resize(joints, 0.0);
+        pose.resize(joints);
+        let lookups = self.keys.iter_mut().zip(&mut self.offsets);
+        for ((slot, animated), (key, offset)) in
+            animation.tracks.iter().zip(&mut pose.animated).zip(lookups)
+        {
+            let found = slot.as_ref().filter(|slot| !slot.keys.is_empty());
+            *animated = found.is_some();
+            let Some(slot) = found else {
+                *key = EMPTY_KEY;
+                *offset = 0.0;
+                continue;
+            };
+            let frames = &animation.frames[slot.keys.clone()];
+            let hint = (*key as usize)
+                .checked_sub(slot.keys.start)
+                .filter(|&hint| hint < frames.len())
+                .unwrap_or(0);
+            let found = seek_key(frames, hint, frame);
+            *key = (slot.keys.start + found) as u32;
+            *offset = if uses_deltas {
+                frame - frames[found]
+            } else {
+                0.0
+            };
+        }
+    }
+}
+
+/// Index of the last key at or before `frame` (0 if there is none), starting
+/// from `hint`; equivalent to a binary search over the whole track.
+fn seek_key(frames: &[f32], hint: usize, frame: f32) -> usize {
+    let at_or_before = |key: &f32| *key <= frame;
+    if frames[hint] > frame {
+        return frames[..hint]
+            .partition_point(at_or_before)
+            .saturating_sub(1);
+    }
+    match frames.get(hint + 1) {
+        Some(next) if *next <= frame => {
+            let key = hint + 1;
+            key + frames[key + 1..].partition_point(at_or_before)
+        }
+        _ => hint,
+    }
+}
+
+/// `out[i] = values[keys[i]] + offsets[i] * deltas[keys[i]]`.
+fn evaluate_channel(
+    keys: &[u32],
+    offsets: &[f32],
+    values: &[f32],
+    deltas: &[f32],
+    out: &mut [f32],
+) {
+    assert!(keys.len() == offsets.len() && keys.len() == out.len());
+    assert_eq!(values.len(), deltas.len());
+    #[cfg(target_arch = "x86_64")]
+    {
+        // The SIMD kernels gather without bounds checks.
+        debug_assert!(keys.iter().all(|&key| (key as usize) < values.len()));
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: the AVX2 feature was detected at runtime, and every key
+            // was produced by `locate` from a track range inside the arenas.
+            return unsafe { x86::evaluate_channel_avx2(keys, offsets, values, deltas, out) };
+        }
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime; keys as above.
+            return unsafe { x86::evaluate_channel_sse2(keys, offsets, values, deltas, out) };
+        }
+    }
+    evaluate_channel_scalar(keys, offsets, values, deltas, out)
+}
+
+fn evaluate_channel_scalar(
+    keys: &[u32],
+    offsets: &[f32],
+    values: &[f32],
+    deltas: &[f32],
+    out: &mut [f32],
+) {
+    for ((out, &key), &offset) in out.iter_mut().zip(keys).zip(offsets) {
+        let key = key as usize;
+        *out = values[key] + offset * deltas[key];
+    }
+}
+
+fn blend_channel(current: &mut [f32], target: &[f32], fade: f32, angular: bool) {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if is_x86_feature_detected!("sse2") {
+            // SAFETY: the SSE2 feature was detected at runtime.
+            return unsafe { x86::blend_channel_sse2(current, target, fade, angular) };
+        }
+    }
+    blend_channel_scalar(current, target, fade, angular)
+}
+
+fn blend_channel_scalar(current: &mut [f32], target: &[f32], fade: f32, angular: bool) {
+    for (current, &target) in current.iter_mut().zip(target) {
+        let mut delta = target - *current;
+        if angular {
+            delta = wrap_degrees(delta);
+        }
+        *current += delta * fade;
+    }
+}
+
+/// Maps an angle difference into [-180, 180], rounding half-turns to even
+/// and multiplying by the reciprocal exactly as the SSE2 kernel does.
+fn wrap_degrees(delta: f32) -> f32 {
+    delta - (delta * (1.0 / 360.0)).round_ties_even() * 360.0
+}
+
+fn u32_at(bytes: &[u8], offset: usize) -> Result<u32> {
+    bytes
+        .get(offset..offset + 4)
+        .map(|word| u32::from_le_bytes(word.try_into().unwrap()))
+        .with_context(|| format!("keyframe data truncated at offset {offset}"))
+}
+
+fn f32_at(bytes: &[u8], offset: usize) -> Result<f32> {
+    u32_at(bytes, offset).map(f32::from_bits)
+}
+
+fn fixed_string(bytes: &[u8]) -> String {
+    let end = bytes.iter().position(|&b| b == 0).unwrap_or(bytes.len());
+    String::from_utf8_lossy(&bytes[..end]).into_owned()
+}
+
+#[cfg(target_arch = "x86_64")]
+mod x86 {
+    use std::arch::x86_64::*;
+
+    /// Eight joints per iteration with hardware gathers; callers guarantee
+    /// every key indexes both `values` and `deltas`.
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn evaluate_channel_avx2(
+        keys: &[u32],
+        offsets: &[f32],
+        values: &[f32],
+        deltas: &[f32],
+        out: &mut [f32],
+    ) {
+        let blocks = out.len() / 8;
+        unsafe {
+            for block in 0..blocks {
+                let at = block * 8;
+                let index = _mm256_loadu_si256(keys.as_ptr().add(at) as *const __m256i);
+                let value = _mm256_i32gather_ps::<4>(values.as_ptr(), index);
+                let delta = _mm256_i32gather_ps::<4>(deltas.as_ptr(), index);
+                let offset = _mm256_loadu_ps(offsets.as_ptr().add(at));
+                let sample = _mm256_add_ps(value, _mm256_mul_ps(offset, delta));
+                _mm256_storeu_ps(out.as_mut_ptr().add(at), sample);
+            }
+        }
+        let done = blocks * 8;
+        super::evaluate_channel_scalar(
+            &keys[done..],
+            &offsets[done..],
+            values,
+            deltas,
+            &mut out[done..],
+        );
+    }
+
+    /// Four joints per iteration; SSE2 has no gather, so lanes are loaded
+    /// individually and only the arithmetic is vectorised.
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn evaluate_channel_sse2(
+        keys: &[u32],
+        offsets: &[f32],
+        values: &[f32],
+        deltas: &[f32],
+        out: &mut [f32],
+    ) {
+        let blocks = out.len() / 4;
+        unsafe {
+            let values = values.as_ptr();
+            let deltas = deltas.as_ptr();
+            for block in 0..blocks {
+                let at = block * 4;
+                let [a, b, c, d] = [0, 1, 2, 3].map(|lane| *keys.get_unchecked(at + lane) as usize);
+                let value = _mm_setr_ps(
+                    *values.add(a),
+                    *values.add(b),
+                    *values.add(c),
+                    *values.add(d),
+                );
+                let delta = _mm_setr_ps(
+                    *deltas.add(a),
+                    *deltas.add(b),
+                    *deltas.add(c),
+                    *deltas.add(d),
+                );
+                let offset = _mm_loadu_ps(offsets.as_ptr().add(at));
+                let sample = _mm_add_ps(value, _mm_mul_ps(offset, delta));
+                _mm_storeu_ps(out.as_mut_ptr().add(at), sample);
+            }
+        }
+        let done = blocks * 4;
+        super::evaluate_channel_scalar(
+            &keys[done..],
+            &offsets[done..],
+            values,
+            deltas,
+            &mut out[done..],
+        );
+    }
+
+    /// Angle wrapping uses the round-to-nearest float-to-int conversion, so
+    /// differences beyond ±2^31 turns are not meaningful (nor are they in
+    /// keyframe data).
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn blend_channel_sse2(
+        current: &mut [f32],
+        target: &[f32],
+        fade: f32,
+        angular: bool,
+    ) {
+        let blocks = current.len().min(target.len()) / 4;
+        unsafe {
+            let fade_v = _mm_set1_ps(fade);
+            let turn = _mm_set1_ps(360.0);
+            let per_turn = _mm_set1_ps(1.0 / 360.0);
+            for block in 0..blocks {
+                let at = block * 4;
+                let now = _mm_loadu_ps(current.as_ptr().add(at));
+                let mut delta = _mm_sub_ps(_mm_loadu_ps(target.as_ptr().add(at)), now);
+                if angular {
+                    let turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(delta, per_turn)));
+                    delta = _mm_sub_ps(delta, _mm_mul_ps(turns, turn));
+                }
+                let blended = _mm_add_ps(now, _mm_mul_ps(delta, fade_v));
+                _mm_storeu_ps(current.as_mut_ptr().add(at), blended);
+            }
+        }
+        let done = blocks * 4;
+        super::blend_channel_scalar(&mut current[done..], &target[done..], fade, angular);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// `(joint, name, keys)` tracks; each key is `(frame, [values], [deltas])`.
+    type TestTrack<'a> = (u32, &'a str, Vec<(f32, [f32; 6], [f32; 6])>);
+
+    /// Files hold one track record per joint slot, so the joint count is the
+    /// number of tracks.
+    fn key_file(flags: u32, num_frames: u32, tracks: &[TestTrack<'_>]) -> Vec<u8> {
+        let mut bytes = vec![0u8; HEADER_SIZE];
+        bytes[..4].copy_from_slice(MAGIC);
+        bytes[4..15].copy_from_slice(b"ma_walk.key");
+        bytes[40..44].copy_from_slice(&flags.to_le_bytes());
+        bytes[48..52].copy_from_slice(&0xFFFFu32.to_le_bytes());
+        bytes[56..60].copy_from_slice(&num_frames.to_le_bytes());
+        bytes[60..64].copy_from_slice(&(tracks.len() as u32).to_le_bytes());
+        bytes[68..72].copy_from_slice(&1u32.to_le_bytes());
+        bytes[72..76].copy_from_slice(&4.0f32.to_le_bytes());
+        bytes[104..108].copy_from_slice(&2u32.to_le_bytes());
+        for (joint, name, keys) in tracks {
+            let mut header = [0u8; TRACK_HEADER_SIZE];
+            header[..name.len()].copy_from_slice(name.as_bytes());
+            header[32..36].copy_from_slice(&joint.to_le_bytes());
+            header[36..40].copy_from_slice(&(keys.len() as u32).to_le_bytes());
+            bytes.extend_from_slice(&header);
+            for (frame, values, deltas) in keys {
+                bytes.extend_from_slice(&frame.to_le_bytes());
+                bytes.extend_from_slice(&0u32.to_le_bytes());
+                for value in values.iter().chain(deltas) {
+                    bytes.extend_from_slice(&value.to_le_bytes());
+                }
+            }
+        }
+        bytes
+    }
+
+    #[test]
+    fn parses_tracks_and_extrapolates_along_deltas() {
+        let hip = vec![
+            (
+                0.0,
+                [1.0, 2.0, 3.0, 10.0, 20.0, 30.0],
+                [0.5, 0.0, -1.0, 2.0, 0.0, 0.0],
+            ),
+            (4.0, [3.0, 2.0, -1.0, 18.0, 20.0, 30.0], [0.0; 6]),
+        ];
+        let head = vec![(
+            2.0,
+            [0.0, 0.0, 1.0, 0.0, 90.0, 0.0],
+            [0.0, 0.0, 0.0, 0.0, 5.0, 0.0],
+        )];
+        // Joint 2 is listed twice; the blank duplicate is ignored.
+        let bytes = key_file(
+            0,
+            8,
+            &[
+                (2, "head", head),
+                (0, "hip", hip),
+                (2, "", vec![(0.0, [9.0; 6], [9.0; 6])]),
+            ],
+        );
+        let animation = KeyframeAnimation::from_bytes(&bytes).unwrap();
+        assert_eq!(animation.name, "ma_walk.key");
+        assert_eq!(animation.fps, DEFAULT_FPS);
+        assert_eq!(
+            animation.markers,
+            vec![KeyMarker {
+                frame: 4.0,
+                value: 2
+            }]
+        );
+        assert_eq!(animation.joint_count(), 3);
+        assert_eq!(animation.key_count(), 3);
+        assert!(animation.track(1).is_none());
+        let hip = animation.track(0).unwrap();
+        assert_eq!(hip.name, "hip");
+        assert_eq!(hip.frames, &[0.0, 4.0]);
+        assert_eq!(hip.values[3], &[10.0, 18.0]);
+        assert_eq!(animation.track(2).unwrap().name, "head");
+
+        let mut sampler = PoseSampler::new();
+        let mut pose = Pose::default();
+        sampler.sample_frame(&animation, 3.0, &mut pose);
+        assert_eq!(pose.animated, vec![true, false, true]);
+        assert_eq!(pose.position(0), [2.5, 2.0, 0.0]);
+        assert_eq!(pose.rotation(0), [16.0, 20.0, 30.0]);
+        assert_eq!(pose.position(1), [0.0; 3]);
+        assert_eq!(pose.rotation(2), [0.0, 95.0, 0.0]);
+        // Before the first key, the first key is extrapolated backwards.
+        sampler.sample_frame(&animation, 1.0, &mut pose);
+        assert_eq!(pose.rotation(2), [0.0, 85.0, 0.0]);
+        // Time is clamped to the last frame.
+        sampler.sample(&animation, 10.0, &mut pose);
+        assert_eq!(pose.position(0), [3.0, 2.0, -1.0]);
+
+        let frozen = KeyframeAnimation::from_bytes(&key_file(
+            KEY_FLAG_NO_DELTA,
+            8,
+            &[(0, "hip", vec![(0.0, [1.0; 6], [1.0; 6])])],
+        ))
+        .unwrap();
+        sampler.sample_frame(&frozen, 3.0, &mut pose);
+        assert_eq!(pose.position(0), [1.0; 3]);
+
+        let mut bad = bytes.clone();
+        bad[..4].copy_from_slice(b"KEYF");
+        assert!(KeyframeAnimation::from_bytes(&bad).is_err());
+        let out_of_range = key_file(0, 8, &[(1, "hip", Vec::new())]);
+        assert!(KeyframeAnimation::from_bytes(&out_of_range).is_err());
+        assert!(KeyframeAnimation::from_bytes(&bytes[..bytes.len() - 1]).is_err());
+    }
+
+    #[test]
+    fn simd_sampling_and_blending_match_scalar() {
+        // An odd joint count with a few keyless tracks exercises every tail.
+        let tracks: Vec<TestTrack<'_>> = (0..37u32)
+            .map(|joint| {
+                let keys = (0..=joint % 7)
+                    .filter(|_| joint % 5 != 3)
+                    .map(|key| {
+                        let base = (joint * 13 + key * 7) as f32;
+                        let values = std::array::from_fn(|c| base * 0.37 - c as f32 * 41.0);
+                        let deltas = std::array::from_fn(|c| (base - c as f32) * 0.11 - 2.0);
+                        (key as f32 * 2.5, values, deltas)
+                    })
+                    .collect();
+                (joint, "joint", keys)
+            })
+            .collect();
+        let animation = KeyframeAnimation::from_bytes(&key_file(0, 20, &tracks)).unwrap();
+
+        let mut sampler = PoseSampler::new();
+        let (mut expected, mut actual) = (Pose::default(), Pose::default());
+        let mut previous = Pose::default();
+        for step in 0..=40 {
+            let frame = step as f32 * 0.5 - 0.25;
+            sampler.sample_frame_scalar(&animation, frame, &mut expected);
+            sampler.sample_frame(&animation, frame, &mut actual);
+            assert_eq!(actual, expected, "frame {frame}");
+
+            let mut blended = previous.clone();
+            blended.blend_toward(&actual, 0.3);
+            let mut reference = previous.clone();
+            reference.resize(actual.joint_count());
+            for (channel, (current, target)) in reference
+                .channels
+                .iter_mut()
+                .zip(&actual.channels)
+                .enumerate()
+            {
+                blend_channel_scalar(current, target, 0.3, channel >= 3);
+            }
+            assert_eq!(blended.channels, reference.channels, "frame {frame}");
+            previous = actual.clone();
+        }
+
+        // Seeking backwards from cached keys agrees with a cold lookup.
+        for frame in [1.0, 13.0, -1.0, 7.5] {
+            sampler.sample_frame(&animation, frame, &mut actual);
+            PoseSampler::new().sample_frame_scalar(&animation, frame, &mut expected);
+            assert_eq!(actual, expected, "frame {frame}");
+        }
+    }
+
+    #[test]
+    fn angles_blend_along_the_shorter_arc() {
+        let mut pose = Pose {
+            channels: std::array::from_fn(|_| vec![170.0; 5]),
+            animated: vec![true; 5],
+        };
+        let target = Pose {
+            channels: std::array::from_fn(|_| vec![-170.0; 5]),
+            animated: vec![true; 5],
+        };
+        pose.blend_toward(&target, 0.5);
+        // Positions lerp straight through zero, angles wrap through 180.
+        assert_eq!(pose.position(4), [0.0; 3]);
+        assert_eq!(pose.rotation(4), [180.0; 3]);
+        assert_eq!(pose.rotation(0), [180.0; 3]);
+    }
+}
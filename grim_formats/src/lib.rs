@@ -1,20 +1,39 @@
 pub mod blocky16;
 pub mod bm;
+pub mod convert;
 pub mod cos;
+pub mod costume;
+pub mod key;
 pub mod lab;
+pub mod mesh_cache;
+pub mod sector_index;
 pub mod set;
 pub mod snm;
 pub mod three_do;
+pub mod vima;
 
 pub use blocky16::Blocky16Decoder;
 pub use bm::{
-    BmFile, BmFrame, BmMetadata, DepthStats, decode_bm, decode_bm_with_seed, peek_bm_metadata,
+    BmFile, BmFrame, BmFrameCache, BmMetadata, DEFAULT_BM_CACHE_BUDGET, DepthHistogram, DepthStats,
+    LazyBmFile, decode_bm, decode_bm_with_seed, peek_bm_metadata,
 };
 pub use cos::{CosComponent, CosFile, CosTag};
+pub use costume::{
+    AssetFailure, AssetKind, AssetSource, CostumeAsset, CostumeLoader, ResolvedComponent,
+    ResolvedCostume,
+};
+pub use key::{KeyMarker, KeyTrack, KeyframeAnimation, Pose, PoseSampler};
 pub use lab::{LabArchive, LabEntry, LabTypeId};
-pub use set::{Sector, SectorKind, SetFile, Vec3};
-pub use snm::{SnmAudioInfo, SnmFile, SnmFrame, SnmHeader, SnmSubChunk};
+pub use mesh_cache::{CachedMesh, CachedModel, MeshCacheFile};
+pub use sector_index::{PointIndex, SectorIndex, polygon_contains};
+pub use set::{Sector, SectorKind, SectorView, SetFile, SetView, Setup, SetupView, Vec3};
+pub use snm::{
+    MappedSnm, SnmAudioInfo, SnmChunkSpan, SnmFile, SnmFrame, SnmFrameEntry, SnmFrameIndex,
+    SnmFrameView, SnmHeader, SnmStream, SnmSubChunk,
+};
 pub use three_do::{
-    Face as ThreeDoFace, Geoset as ThreeDoGeoset, Mesh as ThreeDoMesh, Model as ThreeDoModel,
-    Node as ThreeDoNode, Triangle as ThreeDoTriangle,
+    Face as ThreeDoFace, FlatDraw as ThreeDoFlatDraw, FlatGeoset as ThreeDoFlatGeoset,
+    FlatMesh as ThreeDoFlatMesh, FlatModel as ThreeDoFlatModel, Geoset as ThreeDoGeoset,
+    Mesh as ThreeDoMesh, Model as ThreeDoModel, Node as ThreeDoNode, Triangle as ThreeDoTriangle,
 };
+pub use vima::VimaDecoder;
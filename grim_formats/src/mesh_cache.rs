@@ -0,0 +1,668 @@
+//! Compact binary cache for flattened 3DO models.
+//!
+//! A cache file holds a fixed header, record tables for materials, meshes
+//! and nodes, a string pool, and then the raw vertex and index buffers of
+//! every mesh. Every section is 4-byte aligned, so a memory-mapped file can
+//! hand its buffers straight to the GPU; loading only walks the tables.
+//! Files are named after a hash of the source `.3do` bytes, so an edited
+//! model gets a new entry and stale ones are never looked up again.
+
+use std::fs::{self, File};
+use std::ops::Range;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use anyhow::{Context, Result, bail, ensure};
+use bytemuck::Pod;
+use memmap2::{Mmap, MmapOptions};
+
+use crate::three_do::{FlatDraw, FlatGeoset, FlatMesh, FlatModel, Node};
+
+const MAGIC: &[u8; 4] = b"G3DC";
+/// Bumped whenever the layout or the flattening rules change.
+pub const MESH_CACHE_VERSION: u32 = 1;
+pub const MESH_CACHE_EXTENSION: &str = "g3dc";
+
+const HEADER_SIZE: usize = 64;
+const MESH_RECORD_WORDS: usize = 16;
+const NODE_RECORD_WORDS: usize = 19;
+/// Encodes `None` in index fields and in the model name length.
+const NONE: u32 = u32::MAX;
+
+/// 64-bit FNV-1a over the source `.3do` bytes; the cache key.
+pub fn content_hash(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf2_9ce4_8422_2325, |hash, &byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+/// Where the cache entry for `hash` lives under `dir`.
+pub fn cache_path(dir: &Path, hash: u64) -> PathBuf {
+    dir.join(format!("{hash:016x}.{MESH_CACHE_EXTENSION}"))
+}
+
+/// Write `bytes` to `path` through a temp file and a rename, so readers never
+/// see a half-written file. Each call gets its own temp file, so concurrent
+/// writers of the same path race only on the rename; the last one wins.
+pub fn write_atomic(path: &Path, bytes: &[u8]) -> Result<()> {
+    static PARTIALS: AtomicU64 = AtomicU64::new(0);
+    let mut partial = path.as_os_str().to_owned();
+    partial.push(format!(
+        ".{}.{}.partial",
+        std::process::id(),
+        PARTIALS.fetch_add(1, Ordering::Relaxed)
+    ));
+    let partial = PathBuf::from(partial);
+    let written = fs::write(&partial, bytes)
+        .with_context(|| format!("writing {}", partial.display()))
+        .and_then(|_| {
+            fs::rename(&partial, path).with_context(|| format!("renaming to {}", path.display()))
+        });
+    if written.is_err() {
+        let _ = fs::remove_file(&partial);
+    }
+    written
+}
+
+/// Serialise `model` into the cache layout.
+pub fn encode_flat_model(model: &FlatModel, content_hash: u64) -> Result<Vec<u8>> {
+    let meshes: Vec<&FlatMesh> = model
+        .geosets
+        .iter()
+        .flat_map(|geoset| &geoset.meshes)
+        .collect();
+
+    let mut out = vec![0u8; HEADER_SIZE];
+    let materials_at = reserve_words(&mut out, model.materials.len() * 2);
+    let geosets_at = reserve_words(&mut out, model.geosets.len());
+    let meshes_at = reserve_words(&mut out, meshes.len() * MESH_RECORD_WORDS);
+    let nodes_at = reserve_words(&mut out, model.nodes.len() * NODE_RECORD_WORDS);
+
+    let mut strings = StringPool::default();
+    let name = match &model.name {
+        Some(name) => strings.add(name),
+        None => [0, NONE],
+    };
+    let mut words = Vec::new();
+    for material in &model.materials {
+        words.extend(strings.add(material));
+    }
+    patch_words(&mut out, materials_at, &words);
+
+    words.clear();
+    for geoset in &model.geosets {
+        words.push(to_u32(geoset.meshes.len(), "geoset mesh count")?);
+    }
+    patch_words(&mut out, geosets_at, &words);
+
+    let mut node_words = Vec::with_capacity(model.nodes.len() * NODE_RECORD_WORDS);
+    for node in &model.nodes {
+        node_words.extend(strings.add(&node.name));
+        node_words.extend([
+            node.flags,
+            node.node_type,
+            optional_index(node.mesh_index)?,
+            node.depth,
+            node.num_children,
+            optional_index(node.parent)?,
+            optional_index(node.child)?,
+            optional_index(node.sibling)?,
+        ]);
+        node_words.extend(
+            node.pivot
+                .iter()
+                .chain(&node.position)
+                .chain(&node.rotation_yaw_pitch_roll)
+                .map(|value| value.to_bits()),
+        );
+    }
+    patch_words(&mut out, nodes_at, &node_words);
+
+    let mesh_names: Vec<[u32; 2]> = meshes.iter().map(|mesh| strings.add(&mesh.name)).collect();
+    let pool_at = out.len();
+    out.extend_from_slice(&strings.bytes);
+    pad_to_word(&mut out);
+    let pool_offset = to_u32(pool_at, "string pool offset")?;
+
+    let mut mesh_words = Vec::with_capacity(meshes.len() * MESH_RECORD_WORDS);
+    for (mesh, name) in meshes.iter().zip(&mesh_names) {
+        let draws: Vec<[u32; 3]> = mesh
+            .draws
+            .iter()
+            .map(|draw| {
+                Ok([
+                    optional_index(draw.material_index)?,
+                    draw.first_index,
+                    draw.index_count,
+                ])
+            })
+            .collect::<Result<_>>()?;
+        mesh_words.extend([
+            name[0] + pool_offset,
+            name[1],
+            mesh.geometry_mode,
+            mesh.lighting_mode,
+            mesh.texture_mode,
+            mesh.shadow,
+            mesh.radius.to_bits(),
+            to_u32(mesh.positions.len(), "vertex count")?,
+            to_u32(mesh.indices.len(), "index count")?,
+            to_u32(draws.len(), "draw count")?,
+            append_buffer(&mut out, &mesh.positions)?,
+            append_buffer(&mut out, &mesh.normals)?,
+            append_buffer(&mut out, &mesh.uvs)?,
+            append_buffer(&mut out, &mesh.intensities)?,
+            append_buffer(&mut out, &mesh.indices)?,
+            append_buffer(&mut out, &draws)?,
+        ]);
+    }
+    patch_words(&mut out, meshes_at, &mesh_words);
+
+    // String offsets were pool-relative until the pool was placed.
+    rebase_strings(
+        &mut out,
+        materials_at,
+        model.materials.len(),
+        2,
+        pool_offset,
+    );
+    rebase_strings(
+        &mut out,
+        nodes_at,
+        model.nodes.len(),
+        NODE_RECORD_WORDS,
+        pool_offset,
+    );
+
+    let total = to_u32(out.len(), "cache size")?;
+    let header = [
+        u32::from_le_bytes(*MAGIC),
+        MESH_CACHE_VERSION,
+        content_hash as u32,
+        (content_hash >> 32) as u32,
+        model.radius.to_bits(),
+        model.insert_offset[0].to_bits(),
+        model.insert_offset[1].to_bits(),
+        model.insert_offset[2].to_bits(),
+        if name[1] == NONE {
+            0
+        } else {
+            name[0] + pool_offset
+        },
+        name[1],
+        to_u32(model.materials.len(), "material count")?,
+        to_u32(model.geosets.len(), "geoset count")?,
+        to_u32(meshes.len(), "mesh count")?,
+        to_u32(model.nodes.len(), "node count")?,
+        total,
+        0,
+    ];
+    patch_words(&mut out, 0, &header);
+    Ok(out)
+}
+
+/// A validated view over a cache buffer. Mesh buffers borrow from the
+/// input; only the small per-mesh and per-node tables are decoded.
+#[derive(Debug, Clone)]
+pub struct CachedModel<'a> {
+    pub content_hash: u64,
+    pub name: Option<&'a str>,
+    pub materials: Vec<&'a str>,
+    pub meshes: Vec<CachedMesh<'a>>,
+    /// Ranges of `meshes` belonging to each geoset.
+    pub geosets: Vec<Range<usize>>,
+    pub nodes: Vec<Node>,
+    pub radius: f32,
+    pub insert_offset: [f32; 3],
+}
+
+#[derive(Debug, Clone, Copy)]
+pub struct CachedMesh<'a> {
+    pub name: &'a str,
+    pub geometry_mode: u32,
+    pub lighting_mode: u32,
+    pub texture_mode: u32,
+    pub shadow: u32,
+    pub radius: f32,
+    pub positions: &'a [[f32; 3]],
+    pub normals: &'a [[f32; 3]],
+    pub uvs: &'a [[f32; 2]],
+    pub intensities: &'a [f32],
+    pub indices: &'a [u32],
+    draws: &'a [[u32; 3]],
+}
+
+impl<'a> CachedMesh<'a> {
+    pub fn draws(&self) -> impl Iterator<Item = FlatDraw> + 'a {
+        self.draws
+            .iter()
+            .map(|&[material, first_index, index_count]| FlatDraw {
+                material_index: from_optional_index(material),
+                first_index,
+                index_count,
+            })
+    }
+
+    pub fn to_flat_mesh(&self) -> FlatMesh {
+        FlatMesh {
+            name: self.name.to_string(),
+            geometry_mode: self.geometry_mode,
+            lighting_mode: self.lighting_mode,
+            texture_mode: self.texture_mode,
+            shadow: self.shadow,
+            radius: self.radius,
+            positions: self.positions.to_vec(),
+            normals: self.normals.to_vec(),
+            uvs: self.uvs.to_vec(),
+            intensities: self.intensities.to_vec(),
+            indices: self.indices.to_vec(),
+            draws: self.draws().collect(),
+        }
+    }
+}
+
+impl<'a> CachedModel<'a> {
+    /// Validate and index a cache buffer. The buffer must be 4-byte aligned,
+    /// which memory maps and [`MeshCacheFile`] always are.
+    pub fn parse(bytes: &'a [u8]) -> Result<Self> {
+        ensure!(
+            cfg!(target_endian = "little"),
+            "mesh cache buffers are only readable on little-endian hosts"
+        );
+        ensure!(
+            bytes.as_ptr() as usize % 4 == 0,
+            "mesh cache buffer is not 4-byte aligned"
+        );
+        ensure!(bytes.len() >= HEADER_SIZE, "mesh cache shorter than header");
+        let header: &[u32] = section(bytes, 0, HEADER_SIZE / 4)?;
+        ensure!(&bytes[0..4] == MAGIC, "mesh cache missing G3DC magic");
+        ensure!(
+            header[1] == MESH_CACHE_VERSION,
+            "mesh cache version {} does not match {MESH_CACHE_VERSION}",
+            header[1]
+        );
+        ensure!(
+            header[14] as usize == bytes.len(),
+            "mesh cache is {} bytes, header records {}",
+            bytes.len(),
+            header[14]
+        );
+
+        let material_count = header[10] as usize;
+        let geoset_count = header[11] as usize;
+        let mesh_count = header[12] as usize;
+        let node_count = header[13] as usize;
+
+        let mut at = HEADER_SIZE;
+        let material_refs: &[[u32; 2]] = section(bytes, at, material_count)?;
+        at += material_count * 8;
+        let geoset_counts: &[u32] = section(bytes, at, geoset_count)?;
+        at += geoset_count * 4;
+        let mesh_records: &[[u32; MESH_RECORD_WORDS]] = section(bytes, at, mesh_count)?;
+        at += mesh_count * MESH_RECORD_WORDS * 4;
+        let node_records: &[[u32; NODE_RECORD_WORDS]] = section(bytes, at, node_count)?;
+
+        let name = match header[9] {
+            NONE => None,
+            len => Some(string(bytes, header[8], len)?),
+        };
+        let materials = material_refs
+            .iter()
+            .map(|&[offset, len]| string(bytes, offset, len))
+            .collect::<Result<_>>()?;
+
+        let mut geosets = Vec::with_capacity(geoset_count);
+        let mut start = 0usize;
+        for &count in geoset_counts {
+            let end = start + count as usize;
+            ensure!(end <= mesh_count, "mesh cache geoset table overruns meshes");
+            geosets.push(start..end);
+            start = end;
+        }
+
+        let meshes = mesh_records
+            .iter()
+            .map(|record| {
+                let vertices = record[7] as usize;
+                let indices = record[8] as usize;
+                let draws = record[9] as usize;
+                Ok(CachedMesh {
+                    name: string(bytes, record[0], record[1])?,
+                    geometry_mode: record[2],
+                    lighting_mode: record[3],
+                    texture_mode: record[4],
+                    shadow: record[5],
+                    radius: f32::from_bits(record[6]),
+                    positions: section(bytes, record[10] as usize, vertices)?,
+                    normals: section(bytes, record[11] as usize, vertices)?,
+                    uvs: section(bytes, record[12] as usize, vertices)?,
+                    intensities: section(bytes, record[13] as usize, vertices)?,
+                    indices: section(bytes, record[14] as usize, indices)?,
+                    draws: section(bytes, record[15] as usize, draws)?,
+                })
+            })
+            .collect::<Result<_>>()?;
+
+        let nodes = node_records
+            .iter()
+            .map(|record| {
+                let floats = |at: usize| {
+                    [
+                        f32::from_bits(record[at]),
+                        f32::from_bits(record[at + 1]),
+                        f32::from_bits(record[at + 2]),
+                    ]
+                };
+                Ok(Node {
+                    name: string(bytes, record[0], record[1])?.to_string(),
+                    flags: record[2],
+                    node_type: record[3],
+                    mesh_index: from_optional_index(record[4]),
+                    depth: record[5],
+                    num_children: record[6],
+                    parent: from_optional_index(record[7]),
+                    child: from_optional_index(record[8]),
+                    sibling: from_optional_index(record[9]),
+                    pivot: floats(10),
+                    position: floats(13),
+                    rotation_yaw_pitch_roll: floats(16),
+                })
+            })
+            .collect::<Result<_>>()?;
+
+        Ok(CachedModel {
+            content_hash: u64::from(header[2]) | u64::from(header[3]) << 32,
+            name,
+            materials,
+            meshes,
+            geosets,
+            nodes,
+            radius: f32::from_bits(header[4]),
+            insert_offset: [
+                f32::from_bits(header[5]),
+                f32::from_bits(header[6]),
+                f32::from_bits(header[7]),
+            ],
+        })
+    }
+
+    /// Owned copy in the shape [`FlatModel::from_bytes`] produces.
+    pub fn to_flat_model(&self) -> FlatModel {
+        FlatModel {
+            name: self.name.map(str::to_string),
+            materials: self.materials.iter().map(|name| name.to_string()).collect(),
+            geosets: self
+                .geosets
+                .iter()
+                .map(|range| FlatGeoset {
+                    meshes: self.meshes[range.clone()]
+                        .iter()
+                        .map(CachedMesh::to_flat_mesh)
+                        .collect(),
+                })
+                .collect(),
+            nodes: self.nodes.clone(),
+            radius: self.radius,
+            insert_offset: self.insert_offset,
+        }
+    }
+}
+
+/// Memory-mapped cache entry; see [`cache_path`].
+#[derive(Debug)]
+pub struct MeshCacheFile {
+    path: PathBuf,
+    mmap: Mmap,
+}
+
+impl MeshCacheFile {
+    /// Map `path` and validate it once.
+    pub fn open(path: impl AsRef<Path>) -> Result<Self> {
+        let path = path.as_ref().to_path_buf();
+        let file = File::open(&path)
+            .with_context(|| format!("failed to open mesh cache {}", path.display()))?;
+        let mmap = unsafe { MmapOptions::new().map(&file) }
+            .with_context(|| format!("failed to memory-map mesh cache {}", path.display()))?;
+        CachedModel::parse(&mmap)
+            .with_context(|| format!("invalid mesh cache {}", path.display()))?;
+        Ok(MeshCacheFile { path, mmap })
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    pub fn model(&self) -> CachedModel<'_> {
+        CachedModel::parse(&self.mmap).expect("mesh cache validated in open")
+    }
+}
+
+#[derive(Default)]
+struct StringPool {
+    bytes: Vec<u8>,
+}
+
+impl StringPool {
+    /// Returns the pool-relative offset and length of `text`.
+    fn add(&mut self, text: &str) -> [u32; 2] {
+        let offset = self.bytes.len() as u32;
+        self.bytes.extend_from_slice(text.as_bytes());
+        [offset, text.len() as u32]
+    }
+}
+
+fn reserve_words(out: &mut Vec<u8>, words: usize) -> usize {
+    let at = out.len();
+    out.resize(at + words * 4, 0);
+    at
+}
+
+fn patch_words(out: &mut [u8], at: usize, words: &[u32]) {
+    for (slot, word) in out[at..at + words.len() * 4].chunks_exact_mut(4).zip(words) {
+        slot.copy_from_slice(&word.to_le_bytes());
+    }
+}
+
+fn rebase_strings(out: &mut [u8], at: usize, records: usize, stride: usize, pool: u32) {
+    for record in 0..records {
+        let slot = at + record * stride * 4;
+        let offset = u32::from_le_bytes(out[slot..slot + 4].try_into().unwrap());
+        out[slot..slot + 4].copy_from_slice(&(offset + pool).to_le_bytes());
+    }
+}
+
+fn pad_to_word(out: &mut Vec<u8>) {
+    out.resize(out.len().next_multiple_of(4), 0);
+}
+
+fn append_buffer<T: Pod>(out: &mut Vec<u8>, values: &[T]) -> Result<u32> {
+    let at = to_u32(out.len(), "buffer offset")?;
+    for word in bytemuck::cast_slice::<T, u32>(values) {
+        out.extend_from_slice(&word.to_le_bytes());
+    }
+    Ok(at)
+}
+
+fn section<T: Pod>(bytes: &[u8], offset: usize, count: usize) -> Result<&[T]> {
+    let len = count
+        .checked_mul(std::mem::size_of::<T>())
+        .context("mesh cache section size overflows")?;
+    let Some(slice) = offset
+        .checked_add(len)
+        .and_then(|end| bytes.get(offset..end))
+    else {
+        bail!("mesh cache section {offset:#x}+{len:#x} overruns the file");
+    };
+    bytemuck::try_cast_slice(slice)
+        .map_err(|err| anyhow::anyhow!("mesh cache section {offset:#x} is misaligned: {err:?}"))
+}
+
+fn string(bytes: &[u8], offset: u32, len: u32) -> Result<&str> {
+    let start = offset as usize;
+    let text = start
+        .checked_add(len as usize)
+        .and_then(|end| bytes.get(start..end))
+        .context("mesh cache string overruns the file")?;
+    std::str::from_utf8(text).context("mesh cache string is not UTF-8")
+}
+
+fn to_u32(value: usize, what: &str) -> Result<u32> {
+    u32::try_from(value).with_context(|| format!("{what} does not fit u32"))
+}
+
+fn optional_index(index: Option<usize>) -> Result<u32> {
+    match index {
+        Some(index) => {
+            let index = to_u32(index, "index")?;
+            ensure!(index != NONE, "index {index} collides with the None marker");
+            Ok(index)
+        }
+        None => Ok(NONE),
+    }
+}
+
+fn from_optional_index(raw: u32) -> Option<usize> {
+    (raw != NONE).then_some(raw as usize)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sample_model() -> FlatModel {
+        let quad = FlatMesh {
+            name: "body".to_string(),
+            geometry_mode: 3,
+            lighting_mode: 1,
+            texture_mode: 2,
+            shadow: 0,
+            radius: 2.5,
+            positions: vec![
+                [0.0, 0.0, 0.0],
+                [1.0, 0.0, 0.0],
+                [1.0, 1.0, 0.0],
+                [0.0, 1.0, 0.0],
+            ],
+            normals: vec![[0.0, 0.0, 1.0]; 4],
+            uvs: vec![[0.0, 0.0], [1.0, 0.0], [1.0, 1.0], [0.0, 1.0]],
+            intensities: vec![0.25; 4],
+            indices: vec![0, 1, 2, 0, 2, 3],
+            draws: vec![
+                FlatDraw {
+                    material_index: Some(1),
+                    first_index: 0,
+                    index_count: 3,
+                },
+                FlatDraw {
+                    material_index: None,
+                    first_index: 3,
+                    index_count: 3,
+                },
+            ],
+        };
+        let empty = FlatMesh {
+            name: "lod".to_string(),
+            positions: Vec::new(),
+            normals: Vec::new(),
+            uvs: Vec::new(),
+            intensities: Vec::new(),
+            indices: Vec::new(),
+            draws: Vec::new(),
+            ..quad.clone()
+        };
+        FlatModel {
+            name: Some("tube".to_string()),
+            materials: vec!["a.mat".to_string(), "bc.mat".to_string()],
+            geosets: vec![
+                FlatGeoset { meshes: vec![quad] },
+                FlatGeoset {
+                    meshes: vec![empty],
+                },
+            ],
+            nodes: vec![Node {
+                name: "root".to_string(),
+                flags: 0,
+                node_type: 1,
+                mesh_index: Some(0),
+                depth: 0,
+                num_children: 0,
+                parent: None,
+                child: None,
+                sibling: None,
+                pivot: [0.0, 0.5, 0.0],
+                position: [1.0, 2.0, 3.0],
+                rotation_yaw_pitch_roll: [90.0, 0.0, -45.0],
+            }],
+            radius: 4.0,
+            insert_offset: [0.1, 0.2, 0.3],
+        }
+    }
+
+    #[test]
+    fn cache_round_trips_flat_model() {
+        let model = sample_model();
+        let bytes = encode_flat_model(&model, 0x0123_4567_89AB_CDEF).unwrap();
+        // Vec<u32> storage guarantees the alignment a memory map would give.
+        let mut words = vec![0u32; bytes.len() / 4];
+        bytemuck::cast_slice_mut::<u32, u8>(&mut words).copy_from_slice(&bytes);
+        let cached = CachedModel::parse(bytemuck::cast_slice(&words)).unwrap();
+
+        assert_eq!(cached.content_hash, 0x0123_4567_89AB_CDEF);
+        assert_eq!(cached.geosets, vec![0..1, 1..2]);
+        assert_eq!(cached.meshes[0].indices, &[0, 1, 2, 0, 2, 3]);
+        assert_eq!(
+            format!("{:?}", cached.to_flat_model()),
+            format!("{model:?}")
+        );
+
+        let unnamed = FlatModel {
+            name: None,
+            ..model
+        };
+        let bytes = encode_flat_model(&unnamed, 1).unwrap();
+        let mut words = vec![0u32; bytes.len() / 4];
+        bytemuck::cast_slice_mut::<u32, u8>(&mut words).copy_from_slice(&bytes);
+        assert_eq!(
+            CachedModel::parse(bytemuck::cast_slice(&words))
+                .unwrap()
+                .name,
+            None
+        );
+    }
+
+    #[test]
+    fn parse_rejects_truncated_or_foreign_buffers() {
+        let bytes = encode_flat_model(&sample_model(), 7).unwrap();
+        let mut words = vec![0u32; bytes.len() / 4];
+        bytemuck::cast_slice_mut::<u32, u8>(&mut words).copy_from_slice(&bytes);
+        let aligned: &[u8] = bytemuck::cast_slice(&words);
+
+        assert!(CachedModel::parse(&aligned[..aligned.len() - 4]).is_err());
+        assert!(CachedModel::parse(&aligned[1..]).is_err());
+        let mut stale = words.clone();
+        stale[1] = MESH_CACHE_VERSION + 1;
+        assert!(CachedModel::parse(bytemuck::cast_slice(&stale)).is_err());
+    }
+
+    #[test]
+    fn cache_path_uses_hex_hash() {
+        assert_eq!(
+            cache_path(Path::new("cache"), 0xAB),
+            Path::new("cache").join("00000000000000ab.g3dc")
+        );
+        assert_ne!(content_hash(b"LDOM"), content_hash(b"LDOn"));
+    }
+
+    #[test]
+    fn write_atomic_replaces_without_leaving_partials() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("index.json");
+        write_atomic(&path, b"first").unwrap();
+        write_atomic(&path, b"second").unwrap();
+        assert_eq!(fs::read(&path).unwrap(), b"second");
+        assert_eq!(fs::read_dir(dir.path()).unwrap().count(), 1);
+
+        let missing = dir.path().join("missing").join("index.json");
+        assert!(write_atomic(&missing, b"x").is_err());
+    }
+}
@@ -0,0 +1,717 @@
+//! Point location over set sectors.
+//!
+//! [`SectorIndex`] answers "which sector of this kind holds this point" for
+//! the engine's per-actor, per-tick sector queries. Sectors are partitioned
+//! by kind, and each partition buckets sector bounds into a uniform grid, so
+//! a lookup only runs the polygon test on the few sectors whose bounds cover
+//! the point's cell; misses find the nearest centroid through a
+//! [`PointIndex`], a second grid over the centroids. Results are identical
+//! to [`SectorIndex::locate_linear`], the scan the engine used before: the
+//! first containing sector in file order, else the sector whose vertex
+//! centroid is nearest.
+
+use crate::set::{SectorKind, SetFile};
+
+/// Cross-product tolerance for treating a point as lying on an edge.
+const EDGE_EPSILON: f32 = 1e-4;
+/// Cells per sector a partition's grid aims for.
+const CELLS_PER_SECTOR: usize = 2;
+const MAX_GRID_CELLS: usize = 64 * 64;
+
+#[derive(Debug, Clone)]
+pub struct SectorIndex {
+    vertices: Vec<(f32, f32)>,
+    /// Per sector, in input order: its range in `vertices`.
+    spans: Vec<(u32, u32)>,
+    /// Per sector: `[min_x, min_y, max_x, max_y]`, widened to cover every
+    /// point the edge test accepts.
+    bounds: Vec<[f32; 4]>,
+    partitions: Vec<Partition>,
+}
+
+#[derive(Debug, Clone)]
+struct Partition {
+    kind: SectorKind,
+    /// Sector indices of this kind, ascending.
+    members: Vec<u32>,
+    /// Buckets sector indices by widened bounds.
+    sectors: Grid,
+    /// Vertex centroids in `members` order, for the nearest-sector fallback.
+    centroids: PointIndex,
+}
+
+/// Nearest-point queries over a fixed point set, e.g. sector centroids or
+/// camera setup targets. Matches [`PointIndex::nearest_linear`]: the point
+/// with the smallest squared distance, ties going to the earlier one, and
+/// distances that are NaN or overflow never winning.
+#[derive(Debug, Clone)]
+pub struct PointIndex {
+    points: Vec<(f32, f32)>,
+    /// Buckets positions in `points`; non-finite points are left out since
+    /// they can never come out nearest.
+    grid: Grid,
+    /// Largest coordinate magnitude, for the search's rounding slack.
+    magnitude: f32,
+}
+
+/// Uniform grid over a partition's extent, stored CSR style: the items in
+/// cell `c` are `cell_items[cell_starts[c]..cell_starts[c + 1]]`, ascending.
+/// Coordinates outside the extent clamp to the border cells.
+#[derive(Debug, Clone)]
+struct Grid {
+    origin: (f32, f32),
+    cell_scale: (f32, f32),
+    columns: usize,
+    rows: usize,
+    cell_starts: Vec<u32>,
+    cell_items: Vec<u32>,
+}
+
+impl SectorIndex {
+    /// Indexes polygons given in file order; results refer to that order.
+    pub fn new<'a, I>(sectors: I) -> Self
+    where
+        I: IntoIterator<Item = (SectorKind, &'a [(f32, f32)])>,
+    {
+        let mut vertices = Vec::new();
+        let mut spans = Vec::new();
+        let mut kinds = Vec::new();
+        for (kind, polygon) in sectors {
+            let start = vertices.len() as u32;
+            vertices.extend_from_slice(polygon);
+            spans.push((start, vertices.len() as u32));
+            kinds.push(kind);
+        }
+
+        let mut index = SectorIndex {
+            vertices,
+            spans,
+            bounds: Vec::with_capacity(kinds.len()),
+            partitions: Vec::new(),
+        };
+        for sector in 0..kinds.len() {
+            let bounds = widened_bounds(index.polygon(sector));
+            index.bounds.push(bounds);
+        }
+        for kind in [
+            SectorKind::Walk,
+            SectorKind::Camera,
+            SectorKind::Special,
+            SectorKind::Other,
+        ] {
+            let members: Vec<u32> = (0..kinds.len() as u32)
+                .filter(|&sector| kinds[sector as usize] == kind)
+                .collect();
+            if !members.is_empty() {
+                let partition = Partition::build(kind, members, &index);
+                index.partitions.push(partition);
+            }
+        }
+        index
+    }
+
+    pub fn from_set_file(file: &SetFile) -> Self {
+        let polygons: Vec<(SectorKind, Vec<(f32, f32)>)> = file
+            .sectors
+            .iter()
+            .map(|sector| {
+                let vertices = sector.vertices.iter().map(|v| (v.x, v.y)).collect();
+                (sector.kind, vertices)
+            })
+            .collect();
+        Self::new(
+            polygons
+                .iter()
+                .map(|(kind, vertices)| (*kind, vertices.as_slice())),
+        )
+    }
+
+    pub fn len(&self) -> usize {
+        self.spans.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.spans.is_empty()
+    }
+
+    /// Index of the first `kind` sector containing `point`, else of the
+    /// `kind` sector with the nearest centroid; `None` if there are none.
+    pub fn locate(&self, kind: SectorKind, point: (f32, f32)) -> Option<usize> {
+        self.containing(kind, point)
+            .or_else(|| self.partition(kind)?.nearest(point))
+    }
+
+    /// Index of the first `kind` sector containing `point`, without the
+    /// nearest-centroid fallback of [`SectorIndex::locate`].
+    pub fn containing(&self, kind: SectorKind, point: (f32, f32)) -> Option<usize> {
+        let partition = self.partition(kind)?;
+        partition.candidates(point).iter().find_map(|&sector| {
+            let sector = sector as usize;
+            let [min_x, min_y, max_x, max_y] = self.bounds[sector];
+            let inside =
+                point.0 >= min_x && point.0 <= max_x && point.1 >= min_y && point.1 <= max_y;
+            (inside && polygon_contains(point, self.polygon(sector))).then_some(sector)
+        })
+    }
+
+    /// Reference for [`SectorIndex::locate`]: tests every sector in order.
+    pub fn locate_linear(&self, kind: SectorKind, point: (f32, f32)) -> Option<usize> {
+        let partition = self.partition(kind)?;
+        for &sector in &partition.members {
+            if polygon_contains(point, self.polygon(sector as usize)) {
+                return Some(sector as usize);
+            }
+        }
+        partition.nearest_linear(point)
+    }
+
+    fn partition(&self, kind: SectorKind) -> Option<&Partition> {
+        self.partitions
+            .iter()
+            .find(|partition| partition.kind == kind)
+    }
+
+    fn polygon(&self, sector: usize) -> &[(f32, f32)] {
+        let (start, end) = self.spans[sector];
+        &self.vertices[start as usize..end as usize]
+    }
+}
+
+impl Partition {
+    fn build(kind: SectorKind, members: Vec<u32>, index: &SectorIndex) -> Self {
+        let centroids: Vec<(f32, f32)> = members
+            .iter()
+            .map(|&sector| centroid(index.polygon(sector as usize)))
+            .collect();
+
+        // Degenerate polygons never contain anything; only their centroids
+        // take part, in the fallback. Sectors left open on the -x side (see
+        // `widened_bounds`) only contribute their right edge to the extent.
+        let located: Vec<(u32, [f32; 4])> = members
+            .iter()
+            .filter(|&&sector| index.polygon(sector as usize).len() >= 3)
+            .map(|&sector| (sector, index.bounds[sector as usize]))
+            .collect();
+        let mut extent = EMPTY_EXTENT;
+        for (_, bounds) in &located {
+            let left = if bounds[0].is_finite() {
+                bounds[0]
+            } else {
+                bounds[2]
+            };
+            extent = union(extent, [left, bounds[1], bounds[2], bounds[3]]);
+        }
+        let sectors = Grid::new(extent, &located);
+
+        Partition {
+            kind,
+            members,
+            sectors,
+            centroids: PointIndex::new(centroids),
+        }
+    }
+
+    /// Sectors whose bounds may cover `point`, ascending. Sectors open
+    /// towards -x are listed in the border cells that far-off points clamp
+    /// to; the per-sector bounds check rejects the rest.
+    fn candidates(&self, point: (f32, f32)) -> &[u32] {
+        if self.sectors.is_empty() {
+            return &[];
+        }
+        self.sectors.cell(
+            self.sectors.column_of(point.0),
+            self.sectors.row_of(point.1),
+        )
+    }
+
+    fn nearest(&self, point: (f32, f32)) -> Option<usize> {
+        let position = self.centroids.nearest(point)?;
+        Some(self.members[position] as usize)
+    }
+
+    fn nearest_linear(&self, point: (f32, f32)) -> Option<usize> {
+        let position = self.centroids.nearest_linear(point)?;
+        Some(self.members[position] as usize)
+    }
+}
+
+impl PointIndex {
+    pub fn new(points: Vec<(f32, f32)>) -> Self {
+        let placed: Vec<(u32, [f32; 4])> = points
+            .iter()
+            .enumerate()
+            .filter(|(_, (x, y))| x.is_finite() && y.is_finite())
+            .map(|(position, &(x, y))| (position as u32, [x, y, x, y]))
+            .collect();
+        let extent = placed
+            .iter()
+            .fold(EMPTY_EXTENT, |extent, (_, point)| union(extent, *point));
+        let magnitude = placed.iter().fold(0.0f32, |magnitude, (_, point)| {
+            magnitude.max(point[0].abs()).max(point[1].abs())
+        });
+        PointIndex {
+            grid: Grid::new(extent, &placed),
+            points,
+            magnitude,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.points.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.points.is_empty()
+    }
+
+    pub fn points(&self) -> &[(f32, f32)] {
+        &self.points
+    }
+
+    /// Index of the point nearest to `point`.
+    ///
+    /// Searches rings of cells outwards from the query's cell and stops once
+    /// every unvisited cell is provably farther than the best match, widened
+    /// by a slack that covers rounding in the distances.
+    pub fn nearest(&self, point: (f32, f32)) -> Option<usize> {
+        let grid = &self.grid;
+        if grid.is_empty() || !point.0.is_finite() || !point.1.is_finite() {
+            return self.nearest_linear(point);
+        }
+        let slack = 1e-5 * (1.0 + self.magnitude.max(point.0.abs()).max(point.1.abs()));
+        let (column, row) = (grid.column_of(point.0), grid.row_of(point.1));
+        let mut best: Option<u32> = None;
+        let mut best_distance = f32::MAX;
+        for ring in 0.. {
+            let (first_column, last_column) = (
+                column.saturating_sub(ring),
+                (column + ring).min(grid.columns - 1),
+            );
+            let (first_row, last_row) = (row.saturating_sub(ring), (row + ring).min(grid.rows - 1));
+            for cell_row in first_row..=last_row {
+                for cell_column in first_column..=last_column {
+                    if cell_column.abs_diff(column).max(cell_row.abs_diff(row)) != ring {
+                        continue;
+                    }
+                    for &position in grid.cell(cell_column, cell_row) {
+                        let distance = distance_squared(point, self.points[position as usize]);
+                        if distance < best_distance
+                            || (distance == best_distance && best.is_some_and(|b| position < b))
+                        {
+                            best_distance = distance;
+                            best = Some(position);
+                        }
+                    }
+                }
+            }
+
+            // Distance from the query to the nearest cell outside the box.
+            let mut clearance = f32::INFINITY;
+            if first_column > 0 {
+                clearance = clearance.min(point.0 - grid.column_edge(first_column));
+            }
+            if last_column + 1 < grid.columns {
+                clearance = clearance.min(grid.column_edge(last_column + 1) - point.0);
+            }
+            if first_row > 0 {
+                clearance = clearance.min(point.1 - grid.row_edge(first_row));
+            }
+            if last_row + 1 < grid.rows {
+                clearance = clearance.min(grid.row_edge(last_row + 1) - point.1);
+            }
+            if clearance == f32::INFINITY {
+                break;
+            }
+            let clearance = clearance - slack;
+            if clearance > 0.0 && clearance * clearance > best_distance {
+                break;
+            }
+        }
+        best.map(|position| position as usize)
+    }
+
+    /// Reference for [`PointIndex::nearest`]: scans every point in order.
+    pub fn nearest_linear(&self, point: (f32, f32)) -> Option<usize> {
+        let mut best = None;
+        let mut best_distance = f32::MAX;
+        for (position, &candidate) in self.points.iter().enumerate() {
+            let distance = distance_squared(point, candidate);
+            if distance < best_distance {
+                best_distance = distance;
+                best = Some(position);
+            }
+        }
+        best
+    }
+}
+
+fn distance_squared(a: (f32, f32), b: (f32, f32)) -> f32 {
+    let dx = a.0 - b.0;
+    let dy = a.1 - b.1;
+    dx * dx + dy * dy
+}
+
+const EMPTY_EXTENT: [f32; 4] = [f32::MAX, f32::MAX, f32::MIN, f32::MIN];
+
+fn union(a: [f32; 4], b: [f32; 4]) -> [f32; 4] {
+    [
+        a[0].min(b[0]),
+        a[1].min(b[1]),
+        a[2].max(b[2]),
+        a[3].max(b[3]),
+    ]
+}
+
+impl Grid {
+    /// Sizes a grid at about `CELLS_PER_SECTOR` cells per item, shaped to
+    /// `extent`, and buckets each item into every cell its box overlaps.
+    fn new(extent: [f32; 4], items: &[(u32, [f32; 4])]) -> Self {
+        let mut grid = Grid {
+            origin: (extent[0], extent[1]),
+            cell_scale: (0.0, 0.0),
+            columns: 0,
+            rows: 0,
+            cell_starts: vec![0],
+            cell_items: Vec::new(),
+        };
+        if items.is_empty() || !extent.iter().all(|value| value.is_finite()) {
+            return grid;
+        }
+
+        let width = (extent[2] - extent[0]).max(f32::EPSILON);
+        let height = (extent[3] - extent[1]).max(f32::EPSILON);
+        let target = (items.len() * CELLS_PER_SECTOR).clamp(1, MAX_GRID_CELLS) as f32;
+        grid.columns = ((target * width / height).sqrt().round() as usize).clamp(1, 64);
+        grid.rows = ((target / grid.columns as f32).round() as usize).clamp(1, 64);
+        grid.cell_scale = (grid.columns as f32 / width, grid.rows as f32 / height);
+
+        // Count, prefix-sum, then fill, visiting items in order so every
+        // cell lists them ascending.
+        let cells = grid.columns * grid.rows;
+        let mut counts = vec![0u32; cells + 1];
+        for (_, bounds) in items {
+            grid.for_each_cell(*bounds, |cell| counts[cell + 1] += 1);
+        }
+        for cell in 0..cells {
+            counts[cell + 1] += counts[cell];
+        }
+        let mut cursor = counts.clone();
+        let mut filled = vec![0u32; counts[cells] as usize];
+        for (item, bounds) in items {
+            grid.for_each_cell(*bounds, |cell| {
+                filled[cursor[cell] as usize] = *item;
+                cursor[cell] += 1;
+            });
+        }
+        grid.cell_starts = counts;
+        grid.cell_items = filled;
+        grid
+    }
+
+    fn is_empty(&self) -> bool {
+        self.columns == 0
+    }
+
+    /// Saturating float casts clamp negative, NaN and -inf coordinates to
+    /// the first column.
+    fn column_of(&self, x: f32) -> usize {
+        (((x - self.origin.0) * self.cell_scale.0) as usize).min(self.columns - 1)
+    }
+
+    fn row_of(&self, y: f32) -> usize {
+        (((y - self.origin.1) * self.cell_scale.1) as usize).min(self.rows - 1)
+    }
+
+    fn column_edge(&self, column: usize) -> f32 {
+        self.origin.0 + column as f32 / self.cell_scale.0
+    }
+
+    fn row_edge(&self, row: usize) -> f32 {
+        self.origin.1 + row as f32 / self.cell_scale.1
+    }
+
+    fn cell(&self, column: usize, row: usize) -> &[u32] {
+        let cell = row * self.columns + column;
+        &self.cell_items[self.cell_starts[cell] as usize..self.cell_starts[cell + 1] as usize]
+    }
+
+    fn for_each_cell(&self, bounds: [f32; 4], mut visit: impl FnMut(usize)) {
+        let (first_column, last_column) = (self.column_of(bounds[0]), self.column_of(bounds[2]));
+        let (first_row, last_row) = (self.row_of(bounds[1]), self.row_of(bounds[3]));
+        for row in first_row..=last_row {
+            for column in first_column..=last_column {
+                visit(row * self.columns + column);
+            }
+        }
+    }
+}
+
+/// Vertex average, matching the engine's sector centroid.
+pub fn centroid(vertices: &[(f32, f32)]) -> (f32, f32) {
+    if vertices.is_empty() {
+        return (0.0, 0.0);
+    }
+    let (sum_x, sum_y) = vertices
+        .iter()
+        .fold((0.0, 0.0), |acc, (x, y)| (acc.0 + x, acc.1 + y));
+    let count = vertices.len() as f32;
+    (sum_x / count, sum_y / count)
+}
+
+/// Whether `point` lies inside or on the edge of a sector polygon. Polygons
+/// with fewer than three vertices contain nothing.
+pub fn polygon_contains(point: (f32, f32), vertices: &[(f32, f32)]) -> bool {
+    if vertices.len() < 3 {
+        return false;
+    }
+    if point_on_polygon_edge(point, vertices) {
+        return true;
+    }
+    ray_cast_contains(point, vertices)
+}
+
+/// Polygon bounds grown by how far off an edge the edge test still accepts
+/// a point: `EDGE_EPSILON / length` from the line, and never more than half
+/// the edge length. A relative slack absorbs rounding in both tests.
+///
+/// The ray cast skips edges spanning less than `1e-6` in y, which flips its
+/// parity for points level with such an edge anywhere to the polygon's
+/// left, so polygons with one are left unbounded towards -x.
+fn widened_bounds(vertices: &[(f32, f32)]) -> [f32; 4] {
+    let mut bounds = [f32::MAX, f32::MAX, f32::MIN, f32::MIN];
+    let mut margin = 0.0f32;
+    let mut magnitude = 0.0f32;
+    let mut open_left = false;
+    let mut prev = vertices.last().copied().unwrap_or_default();
+    for &(x, y) in vertices {
+        bounds[0] = bounds[0].min(x);
+        bounds[1] = bounds[1].min(y);
+        bounds[2] = bounds[2].max(x);
+        bounds[3] = bounds[3].max(y);
+        magnitude = magnitude.max(x.abs()).max(y.abs());
+        let length = ((x - prev.0).powi(2) + (y - prev.1).powi(2)).sqrt();
+        if length > 0.0 {
+            margin = margin.max((EDGE_EPSILON / length).min(length * 0.5));
+        }
+        let rise = (y - prev.1).abs();
+        open_left |= rise > 0.0 && rise <= 1e-6;
+        prev = (x, y);
+    }
+    let margin = margin + 1e-5 * (1.0 + magnitude);
+    [
+        if open_left {
+            f32::NEG_INFINITY
+        } else {
+            bounds[0] - margin
+        },
+        bounds[1] - margin,
+        bounds[2] + margin,
+        bounds[3] + margin,
+    ]
+}
+
+fn point_on_polygon_edge(point: (f32, f32), vertices: &[(f32, f32)]) -> bool {
+    if vertices.len() < 2 {
+        return false;
+    }
+    let mut prev = vertices.last().copied().unwrap();
+    for &current in vertices {
+        if point_on_segment(point, prev, current) {
+            return true;
+        }
+        prev = current;
+    }
+    false
+}
+
+fn point_on_segment(point: (f32, f32), a: (f32, f32), b: (f32, f32)) -> bool {
+    let (px, py) = point;
+    let (ax, ay) = a;
+    let (bx, by) = b;
+    let cross = (py - ay) * (bx - ax) - (px - ax) * (by - ay);
+    if cross.abs() > EDGE_EPSILON {
+        return false;
+    }
+    let dot = (px - ax) * (px - bx) + (py - ay) * (py - by);
+    dot <= 0.0
+}
+
+fn ray_cast_contains(point: (f32, f32), vertices: &[(f32, f32)]) -> bool {
+    let (px, py) = point;
+    let mut inside = false;
+    let mut j = vertices.len() - 1;
+    for i in 0..vertices.len() {
+        let (xi, yi) = vertices[i];
+        let (xj, yj) = vertices[j];
+        if (yi > py) != (yj > py) {
+            let denom = yj - yi;
+            if denom.abs() > 1e-6 {
+                let xinters = (py - yi) * (xj - xi) / denom + xi;
+                if xinters > px {
+                    inside = !inside;
+                }
+            }
+        }
+        j = i;
+    }
+    inside
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// A `cols` x `rows` tiling of unit quads sharing edges, alternating
+    /// walk and camera kinds, with an overlapping walk triangle, a
+    /// degenerate walk sector and a lone special sector appended.
+    fn tiled_polygons(cols: usize, rows: usize) -> Vec<(SectorKind, Vec<(f32, f32)>)> {
+        let mut polygons = Vec::new();
+        for row in 0..rows {
+            for col in 0..cols {
+                let (x, y) = (col as f32, row as f32);
+                let kind = if (row + col) % 3 == 0 {
+                    SectorKind::Camera
+                } else {
+                    SectorKind::Walk
+                };
+                polygons.push((
+                    kind,
+                    vec![(x, y), (x + 1.0, y), (x + 1.0, y + 1.0), (x, y + 1.0)],
+                ));
+            }
+        }
+        polygons.push((
+            SectorKind::Walk,
+            vec![
+                (0.5, 0.5),
+                (cols as f32 - 0.5, 0.75),
+                (1.25, rows as f32 - 0.5),
+            ],
+        ));
+        polygons.push((SectorKind::Walk, vec![(2.0, 2.0), (3.0, 3.0)]));
+        polygons.push((
+            SectorKind::Special,
+            vec![(-3.0, -3.0), (-2.0, -3.0), (-2.5, -2.0)],
+        ));
+        polygons
+    }
+
+    fn build(polygons: &[(SectorKind, Vec<(f32, f32)>)]) -> SectorIndex {
+        SectorIndex::new(
+            polygons
+                .iter()
+                .map(|(kind, vertices)| (*kind, vertices.as_slice())),
+        )
+    }
+
+    #[test]
+    fn indexed_lookup_matches_linear_scan() {
+        let mut polygons = tiled_polygons(12, 7);
+        // An edge too shallow for the ray cast to count, far to the right.
+        polygons.push((
+            SectorKind::Walk,
+            vec![(20.0, 0.5), (21.0, 0.5 + 5e-7), (21.0, 1.5), (20.0, 1.5)],
+        ));
+        let index = build(&polygons);
+        assert_eq!(index.len(), polygons.len());
+
+        // Quarter-unit steps land exactly on shared edges and corners;
+        // the range runs well outside the tiling to exercise the fallback.
+        let mut checked = 0;
+        for step_y in -20..=48 {
+            for step_x in -20..=68 {
+                let point = (step_x as f32 * 0.25, step_y as f32 * 0.25);
+                for kind in [
+                    SectorKind::Walk,
+                    SectorKind::Camera,
+                    SectorKind::Special,
+                    SectorKind::Other,
+                ] {
+                    assert_eq!(
+                        index.locate(kind, point),
+                        index.locate_linear(kind, point),
+                        "{kind:?} at {point:?}"
+                    );
+                    checked += 1;
+                }
+            }
+        }
+        assert!(checked > 20_000);
+
+        // Just off an edge, inside the edge tolerance but outside the quad.
+        let near_edge = (3.0 - 5e-5, 0.5);
+        assert_eq!(
+            index.locate(SectorKind::Walk, near_edge),
+            index.locate_linear(SectorKind::Walk, near_edge)
+        );
+        for step_x in -40..=100 {
+            let point = (step_x as f32 * 0.25, 0.5 + 2.5e-7);
+            assert_eq!(
+                index.locate(SectorKind::Walk, point),
+                index.locate_linear(SectorKind::Walk, point),
+                "{point:?}"
+            );
+        }
+        for point in [(-1e3, 2.0), (5e3, -7e3), (6.0, 1e30), (f32::INFINITY, 0.0)] {
+            assert_eq!(
+                index.locate(SectorKind::Walk, point),
+                index.locate_linear(SectorKind::Walk, point),
+                "{point:?}"
+            );
+        }
+        assert_eq!(index.locate(SectorKind::Other, (1.0, 1.0)), None);
+        assert_eq!(
+            index.locate(SectorKind::Walk, (f32::NAN, 1.0)),
+            index.locate_linear(SectorKind::Walk, (f32::NAN, 1.0))
+        );
+    }
+
+    #[test]
+    fn first_sector_in_file_order_wins_and_misses_fall_back_to_nearest() {
+        let polygons = tiled_polygons(4, 4);
+        let index = build(&polygons);
+        let triangle = 16;
+
+        // (1.5, 1.5) lies in both walk quad 5 and the later triangle.
+        assert_eq!(polygons[5].0, SectorKind::Walk);
+        assert_eq!(index.locate(SectorKind::Walk, (1.5, 1.5)), Some(5));
+        assert!(polygon_contains((1.5, 1.5), &polygons[triangle].1));
+
+        // Shared edge between walk quads 1 and 2 resolves to the first.
+        assert_eq!(index.locate(SectorKind::Walk, (2.0, 0.5)), Some(1));
+
+        // Far away, the special sector is the only candidate of its kind and
+        // walk sectors fall back to the closest centroid.
+        assert_eq!(index.locate(SectorKind::Special, (100.0, 100.0)), Some(18));
+        assert_eq!(index.locate(SectorKind::Walk, (100.0, 100.0)), Some(11));
+        assert!(!polygon_contains((2.5, 2.5), &polygons[17].1));
+    }
+
+    #[test]
+    fn nearest_point_matches_scan_with_ties_and_unusable_points() {
+        let mut points: Vec<(f32, f32)> = (0..200)
+            .map(|i| ((i % 17) as f32 * 1.5, (i / 17) as f32 * 0.75))
+            .collect();
+        // Duplicates tie with earlier entries; non-finite points never win.
+        points.push((3.0, 1.5));
+        points.push((f32::NAN, 0.0));
+        points.push((f32::INFINITY, 2.0));
+        let index = PointIndex::new(points);
+        assert_eq!(index.len(), 203);
+
+        for step_y in -10..=60 {
+            for step_x in -10..=110 {
+                let point = (step_x as f32 * 0.3, step_y as f32 * 0.2);
+                assert_eq!(
+                    index.nearest(point),
+                    index.nearest_linear(point),
+                    "{point:?}"
+                );
+            }
+        }
+        assert_eq!(index.nearest((3.0, 1.5)), Some(36));
+        assert_eq!(index.nearest((f32::NAN, 1.0)), None);
+        assert_eq!(index.nearest((3e30, 3e30)), None);
+        assert_eq!(PointIndex::new(Vec::new()).nearest((0.0, 0.0)), None);
+    }
+}
@@ -1,6 +1,7 @@
-use std::str::Lines;
+use std::ops::Range;
+use std::str::FromStr;
 
-use anyhow::{Result, anyhow};
+use anyhow::{Context, Result, anyhow, bail, ensure};
 
 #[derive(Debug, Clone, PartialEq)]
 pub struct Vec3 {
@@ -62,45 +63,206 @@ pub struct SetFile {
 
 impl SetFile {
     pub fn parse(input: &[u8]) -> Result<Self> {
-        let text = String::from_utf8(input.to_vec())?;
-        let normalized = text.replace("\r\n", "\n");
-        let mut lines = normalized.lines();
+        Ok(SetView::parse(input)?.to_set_file())
+    }
+}
+
+/// A `.set` parsed in place. Names borrow from the input, and all sectors
+/// share one vertex arena and one triangle arena.
+#[derive(Debug, Clone, PartialEq)]
+pub struct SetView<'a> {
+    pub colormaps: Vec<&'a str>,
+    pub setups: Vec<SetupView<'a>>,
+    pub sectors: Vec<SectorView<'a>>,
+    /// `x, y, z` for every sector vertex, sector after sector.
+    pub vertices: Vec<f32>,
+    pub triangles: Vec<[usize; 3]>,
+}
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct SetupView<'a> {
+    pub name: &'a str,
+    pub background: Option<&'a str>,
+    pub zbuffer: Option<&'a str>,
+    pub position: Option<Vec3>,
+    pub interest: Option<Vec3>,
+    pub roll: Option<f32>,
+    pub fov: Option<f32>,
+    pub near_clip: Option<f32>,
+    pub far_clip: Option<f32>,
+}
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct SectorView<'a> {
+    pub name: &'a str,
+    pub id: i32,
+    pub kind: SectorKind,
+    pub default_visibility: Option<&'a str>,
+    pub height: f32,
+    /// Vertex indices (not float offsets) into [`SetView::vertices`].
+    pub vertices: Range<usize>,
+    /// Indices into [`SetView::triangles`].
+    pub triangles: Range<usize>,
+}
+
+impl<'a> SetView<'a> {
+    /// Parses in a single pass over `input`, which must be UTF-8. Lines may
+    /// end in `\n` or `\r\n`.
+    pub fn parse(input: &'a [u8]) -> Result<Self> {
+        let text = std::str::from_utf8(input).context("set file is not UTF-8")?;
+        Parser::new(text).parse()
+    }
+
+    /// `x, y, z` floats of one sector's vertices.
+    pub fn sector_vertices(&self, sector: &SectorView<'_>) -> &[f32] {
+        &self.vertices[sector.vertices.start * 3..sector.vertices.end * 3]
+    }
+
+    pub fn sector_points(&self, sector: &SectorView<'_>) -> impl Iterator<Item = Vec3> + '_ {
+        self.sector_vertices(sector)
+            .chunks_exact(3)
+            .map(|xyz| Vec3 {
+                x: xyz[0],
+                y: xyz[1],
+                z: xyz[2],
+            })
+    }
 
-        let mut parser = Parser::new(&mut lines);
-        parser.parse()
+    pub fn sector_triangles(&self, sector: &SectorView<'_>) -> &[[usize; 3]] {
+        &self.triangles[sector.triangles.clone()]
+    }
+
+    pub fn to_set_file(&self) -> SetFile {
+        SetFile {
+            name: None,
+            colormaps: self.colormaps.iter().map(|name| name.to_string()).collect(),
+            setups: self
+                .setups
+                .iter()
+                .map(|setup| Setup {
+                    name: setup.name.to_string(),
+                    background: setup.background.map(str::to_string),
+                    zbuffer: setup.zbuffer.map(str::to_string),
+                    position: setup.position.clone(),
+                    interest: setup.interest.clone(),
+                    roll: setup.roll,
+                    fov: setup.fov,
+                    near_clip: setup.near_clip,
+                    far_clip: setup.far_clip,
+                })
+                .collect(),
+            sectors: self
+                .sectors
+                .iter()
+                .map(|sector| Sector {
+                    name: sector.name.to_string(),
+                    id: sector.id,
+                    kind: sector.kind,
+                    default_visibility: sector.default_visibility.map(str::to_string),
+                    height: sector.height,
+                    vertices: self.sector_points(sector).collect(),
+                    triangles: self.sector_triangles(sector).to_vec(),
+                })
+                .collect(),
+        }
     }
 }
 
+/// Line cursor and output arenas. Lines are trimmed slices of the input;
+/// block readers (`vertices:`, `triangles:`) pull further lines from the
+/// same cursor, so those lines are never treated as keys.
 struct Parser<'a> {
-    lines: &'a mut Lines<'a>,
+    text: &'a str,
+    offset: usize,
+    line: usize,
+    vertices: Vec<f32>,
+    triangles: Vec<[usize; 3]>,
 }
 
 impl<'a> Parser<'a> {
-    fn new(lines: &'a mut Lines<'a>) -> Self {
-        Self { lines }
+    fn new(text: &'a str) -> Self {
+        Self {
+            text,
+            offset: 0,
+            line: 0,
+            vertices: Vec::new(),
+            triangles: Vec::new(),
+        }
     }
 
-    fn parse(&mut self) -> Result<SetFile> {
+    fn next_line(&mut self) -> Option<&'a str> {
+        let bytes = self.text.as_bytes();
+        if self.offset >= bytes.len() {
+            return None;
+        }
+        let start = self.offset;
+        let end = bytes[start..]
+            .iter()
+            .position(|&byte| byte == b'\n')
+            .map_or(bytes.len(), |len| start + len);
+        self.offset = end + 1;
+        self.line += 1;
+        Some(trim(&self.text[start..end]))
+    }
+
+    fn number<T>(&self, token: &str) -> Result<T>
+    where
+        T: FromStr,
+        T::Err: std::error::Error + Send + Sync + 'static,
+    {
+        token
+            .parse()
+            .with_context(|| format!("line {}: invalid number {token:?}", self.line))
+    }
+
+    fn last_number<T>(&self, line: &str) -> Result<Option<T>>
+    where
+        T: FromStr,
+        T::Err: std::error::Error + Send + Sync + 'static,
+    {
+        last_token(line).map(|token| self.number(token)).transpose()
+    }
+
+    fn vec3(&self, raw: &str) -> Result<Vec3> {
+        let mut parts = tokens(raw);
+        let (Some(x), Some(y), Some(z)) = (parts.next(), parts.next(), parts.next()) else {
+            bail!("line {}: invalid vertex line: {raw}", self.line);
+        };
+        Ok(Vec3 {
+            x: self.number(x)?,
+            y: self.number(y)?,
+            z: self.number(z)?,
+        })
+    }
+
+    fn triangle(&self, raw: &str) -> Result<[usize; 3]> {
+        let mut parts = tokens(raw);
+        let (Some(a), Some(b), Some(c)) = (parts.next(), parts.next(), parts.next()) else {
+            bail!("line {}: invalid triangle line: {raw}", self.line);
+        };
+        Ok([self.number(a)?, self.number(b)?, self.number(c)?])
+    }
+
+    fn parse(mut self) -> Result<SetView<'a>> {
         let mut colormaps = Vec::new();
         let mut setups = Vec::new();
         let mut sectors = Vec::new();
         let mut section = Section::None;
-        let mut current_setup: Option<SetupBuilder> = None;
-        let mut current_sector: Option<SectorBuilder> = None;
+        let mut current_setup: Option<SetupView<'a>> = None;
+        let mut current_sector: Option<SectorBuilder<'a>> = None;
 
-        while let Some(raw_line) = self.lines.next() {
-            let line = raw_line.trim();
+        while let Some(line) = self.next_line() {
             if line.is_empty() {
                 continue;
             }
 
             if let Some(value) = line.strip_prefix("section:") {
-                section = Section::from_name(value.trim());
-                if let Some(builder) = current_setup.take() {
-                    setups.push(builder.finish());
+                section = Section::from_name(trim(value));
+                if let Some(setup) = current_setup.take() {
+                    setups.push(setup);
                 }
                 if let Some(builder) = current_sector.take() {
-                    sectors.push(builder.finish()?);
+                    sectors.push(builder.finish(&self)?);
                 }
                 continue;
             }
@@ -111,299 +273,299 @@ impl<'a> Parser<'a> {
                         // value unused currently
                     } else if let Some(value) = line.strip_prefix("colormap") {
                         // Format: colormap <name>
-                        let parts: Vec<&str> = value.split_whitespace().collect();
-                        if let Some(name) = parts.last() {
-                            colormaps.push((*name).to_string());
+                        if let Some(name) = last_token(value) {
+                            colormaps.push(name);
                         }
                     }
                 }
                 Section::Setups => {
                     if line.starts_with("setup") {
-                        if let Some(builder) = current_setup.take() {
-                            setups.push(builder.finish());
+                        if let Some(setup) = current_setup.take() {
+                            setups.push(setup);
                         }
-                        let name = line
-                            .split_whitespace()
-                            .last()
-                            .ok_or_else(|| anyhow!("missing setup name"))?;
-                        current_setup = Some(SetupBuilder::new(name));
-                    } else if let Some(builder) = current_setup.as_mut() {
-                        builder.consume_line(line)?;
+                        let name = last_token(line)
+                            .ok_or_else(|| anyhow!("line {}: missing setup name", self.line))?;
+                        current_setup = Some(SetupView::new(name));
+                    } else if let Some(setup) = current_setup.as_mut() {
+                        self.setup_line(setup, line)?;
                     }
                 }
                 Section::Sectors => {
                     if line.starts_with("sector") {
                         if let Some(builder) = current_sector.take() {
-                            sectors.push(builder.finish()?);
+                            sectors.push(builder.finish(&self)?);
                         }
-                        let name = line
-                            .split_whitespace()
-                            .last()
-                            .ok_or_else(|| anyhow!("missing sector name"))?;
-                        current_sector = Some(SectorBuilder::new(name));
+                        let name = last_token(line)
+                            .ok_or_else(|| anyhow!("line {}: missing sector name", self.line))?;
+                        current_sector = Some(SectorBuilder::new(name, &self));
                     } else if let Some(builder) = current_sector.as_mut() {
-                        builder.consume_line(line, self.lines)?;
+                        self.sector_line(builder, line)?;
                     }
                 }
                 Section::Other | Section::None => {}
             }
         }
 
-        if let Some(builder) = current_setup.take() {
-            setups.push(builder.finish());
+        if let Some(setup) = current_setup.take() {
+            setups.push(setup);
         }
         if let Some(builder) = current_sector.take() {
-            sectors.push(builder.finish()?);
+            sectors.push(builder.finish(&self)?);
         }
 
-        Ok(SetFile {
-            name: None,
+        Ok(SetView {
             colormaps,
             setups,
             sectors,
+            vertices: self.vertices,
+            triangles: self.triangles,
         })
     }
-}
 
-#[derive(Debug, Clone)]
-struct SetupBuilder {
-    name: String,
-    background: Option<String>,
-    zbuffer: Option<String>,
-    position: Option<Vec3>,
-    interest: Option<Vec3>,
-    roll: Option<f32>,
-    fov: Option<f32>,
-    near_clip: Option<f32>,
-    far_clip: Option<f32>,
-}
-
-impl SetupBuilder {
-    fn new(name: impl Into<String>) -> Self {
-        Self {
-            name: name.into(),
-            background: None,
-            zbuffer: None,
-            position: None,
-            interest: None,
-            roll: None,
-            fov: None,
-            near_clip: None,
-            far_clip: None,
+    fn setup_line(&self, setup: &mut SetupView<'a>, line: &'a str) -> Result<()> {
+        if line.starts_with("background") {
+            if let Some(value) = last_token(line) {
+                setup.background = Some(value);
+            }
+        } else if line.starts_with("zbuffer") {
+            if let Some(value) = last_token(line) {
+                setup.zbuffer = Some(value);
+            }
+        } else if let Some(rest) = line.strip_prefix("position") {
+            setup.position = self.keyed_vec3(line, rest)?.or(setup.position.take());
+        } else if let Some(rest) = line.strip_prefix("interest") {
+            setup.interest = self.keyed_vec3(line, rest)?.or(setup.interest.take());
+        } else if line.starts_with("roll") {
+            setup.roll = self.last_number(line)?.or(setup.roll);
+        } else if line.starts_with("fov") {
+            setup.fov = self.last_number(line)?.or(setup.fov);
+        } else if line.starts_with("nclip") {
+            setup.near_clip = self.last_number(line)?.or(setup.near_clip);
+        } else if line.starts_with("fclip") {
+            setup.far_clip = self.last_number(line)?.or(setup.far_clip);
         }
+        Ok(())
     }
 
-    fn finish(self) -> Setup {
-        Setup {
-            name: self.name,
-            background: self.background,
-            zbuffer: self.zbuffer,
-            position: self.position,
-            interest: self.interest,
-            roll: self.roll,
-            fov: self.fov,
-            near_clip: self.near_clip,
-            far_clip: self.far_clip,
+    /// `position x y z`: the three values after the key's own token, and
+    /// only when all three are present.
+    fn keyed_vec3(&self, line: &str, rest: &str) -> Result<Option<Vec3>> {
+        if tokens(line).count() < 4 {
+            return Ok(None);
         }
+        // The key token may run on past the prefix ("positions 1 2 3").
+        self.vec3(after_first_space(rest)).map(Some)
     }
 
-    fn consume_line(&mut self, line: &str) -> Result<()> {
-        if line.starts_with("background") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.background = Some(value.to_string());
-            }
-        } else if line.starts_with("zbuffer") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.zbuffer = Some(value.to_string());
-            }
-        } else if line.starts_with("position") {
-            let parts: Vec<&str> = line.split_whitespace().collect();
-            if parts.len() >= 4 {
-                let tail = parts[1..].join(" ");
-                self.position = Some(parse_vec3(&tail)?);
-            }
-        } else if line.starts_with("interest") {
-            let parts: Vec<&str> = line.split_whitespace().collect();
-            if parts.len() >= 4 {
-                let tail = parts[1..].join(" ");
-                self.interest = Some(parse_vec3(&tail)?);
-            }
-        } else if line.starts_with("roll") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.roll = Some(value.parse()?);
+    fn sector_line(&mut self, sector: &mut SectorBuilder<'a>, line: &'a str) -> Result<()> {
+        if line.starts_with("ID") {
+            let id = last_token(line)
+                .ok_or_else(|| anyhow!("line {}: missing sector ID value", self.line))?;
+            sector.id = Some(self.number(id)?);
+        } else if line.starts_with("type") {
+            if let Some(value) = last_token(line) {
+                sector.kind = Some(SectorKind::from_str(value));
             }
-        } else if line.starts_with("fov") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.fov = Some(value.parse()?);
+        } else if line.starts_with("default visibility") {
+            if let Some(value) = last_token(line) {
+                sector.default_visibility = Some(value);
             }
-        } else if line.starts_with("nclip") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.near_clip = Some(value.parse()?);
+        } else if line.starts_with("height") {
+            sector.height = self.last_number(line)?.or(sector.height);
+        } else if line.starts_with("numvertices") {
+            sector.expected_vertices = self.last_number(line)?.or(sector.expected_vertices);
+        } else if let Some(rest) = line.strip_prefix("vertices:") {
+            let expected = sector.expected_vertices.ok_or_else(|| {
+                anyhow!(
+                    "line {}: numvertices must precede vertices block",
+                    self.line
+                )
+            })?;
+            let target_len = self.vertices.len() + expected * 3;
+            let mut raw = trim(rest);
+            loop {
+                if !raw.is_empty() {
+                    let Vec3 { x, y, z } = self.vec3(raw)?;
+                    self.vertices.extend_from_slice(&[x, y, z]);
+                }
+                if self.vertices.len() >= target_len {
+                    break;
+                }
+                raw = self.next_line().ok_or_else(|| {
+                    anyhow!("line {}: unexpected EOF reading vertices", self.line)
+                })?;
             }
-        } else if line.starts_with("fclip") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.far_clip = Some(value.parse()?);
+        } else if line.starts_with("numtris") {
+            sector.expected_tris = self.last_number(line)?.or(sector.expected_tris);
+        } else if let Some(rest) = line.strip_prefix("triangles:") {
+            let expected = sector.expected_tris.ok_or_else(|| {
+                anyhow!("line {}: numtris must precede triangles block", self.line)
+            })?;
+            let target_len = self.triangles.len() + expected;
+            let mut raw = trim(rest);
+            loop {
+                if !raw.is_empty() {
+                    let triangle = self.triangle(raw)?;
+                    self.triangles.push(triangle);
+                }
+                if self.triangles.len() >= target_len {
+                    break;
+                }
+                raw = self.next_line().ok_or_else(|| {
+                    anyhow!("line {}: unexpected EOF reading triangles", self.line)
+                })?;
             }
         }
         Ok(())
     }
 }
 
-struct SectorBuilder {
-    name: String,
+impl<'a> SetupView<'a> {
+    fn new(name: &'a str) -> Self {
+        Self {
+            name,
+            background: None,
+            zbuffer: None,
+            position: None,
+            interest: None,
+            roll: None,
+            fov: None,
+            near_clip: None,
+            far_clip: None,
+        }
+    }
+}
+
+struct SectorBuilder<'a> {
+    name: &'a str,
+    /// Line of the `sector` key, cited by the checks in `finish`.
+    line: usize,
     id: Option<i32>,
     kind: Option<SectorKind>,
-    default_visibility: Option<String>,
+    default_visibility: Option<&'a str>,
     height: Option<f32>,
     expected_vertices: Option<usize>,
     expected_tris: Option<usize>,
-    vertices: Vec<Vec3>,
-    triangles: Vec<[usize; 3]>,
+    /// Arena lengths when the sector started.
+    first_vertex: usize,
+    first_triangle: usize,
 }
 
-impl SectorBuilder {
-    fn new(name: impl Into<String>) -> Self {
+impl<'a> SectorBuilder<'a> {
+    fn new(name: &'a str, parser: &Parser<'_>) -> Self {
         Self {
-            name: name.into(),
+            name,
+            line: parser.line,
             id: None,
             kind: None,
             default_visibility: None,
             height: None,
             expected_vertices: None,
             expected_tris: None,
-            vertices: Vec::new(),
-            triangles: Vec::new(),
+            first_vertex: parser.vertices.len() / 3,
+            first_triangle: parser.triangles.len(),
         }
     }
 
-    fn finish(self) -> Result<Sector> {
+    fn finish(self, parser: &Parser<'_>) -> Result<SectorView<'a>> {
         let id = self
             .id
-            .ok_or_else(|| anyhow!("sector '{}' missing ID", self.name))?;
+            .ok_or_else(|| anyhow!("line {}: sector '{}' missing ID", self.line, self.name))?;
         let kind = self
             .kind
-            .ok_or_else(|| anyhow!("sector '{}' missing type", self.name))?;
+            .ok_or_else(|| anyhow!("line {}: sector '{}' missing type", self.line, self.name))?;
         let height = self
             .height
-            .ok_or_else(|| anyhow!("sector '{}' missing height", self.name))?;
+            .ok_or_else(|| anyhow!("line {}: sector '{}' missing height", self.line, self.name))?;
+        let vertices = self.first_vertex..parser.vertices.len() / 3;
+        let triangles = self.first_triangle..parser.triangles.len();
         if let Some(expected) = self.expected_vertices {
-            if expected != self.vertices.len() {
-                return Err(anyhow!(
-                    "sector '{}' expected {} vertices, found {}",
-                    self.name,
-                    expected,
-                    self.vertices.len()
-                ));
-            }
+            ensure!(
+                expected == vertices.len(),
+                "line {}: sector '{}' expected {} vertices, found {}",
+                self.line,
+                self.name,
+                expected,
+                vertices.len()
+            );
         }
         if let Some(expected) = self.expected_tris {
-            if expected != self.triangles.len() {
-                return Err(anyhow!(
-                    "sector '{}' expected {} triangles, found {}",
-                    self.name,
-                    expected,
-                    self.triangles.len()
-                ));
-            }
+            ensure!(
+                expected == triangles.len(),
+                "line {}: sector '{}' expected {} triangles, found {}",
+                self.line,
+                self.name,
+                expected,
+                triangles.len()
+            );
         }
-        Ok(Sector {
+        Ok(SectorView {
             name: self.name,
             id,
             kind,
             default_visibility: self.default_visibility,
             height,
-            vertices: self.vertices,
-            triangles: self.triangles,
+            vertices,
+            triangles,
         })
     }
+}
 
-    fn consume_line(&mut self, line: &str, lines: &mut Lines<'_>) -> Result<()> {
-        if line.starts_with("ID") {
-            let id = line
-                .split_whitespace()
-                .last()
-                .ok_or_else(|| anyhow!("missing sector ID value"))?;
-            self.id = Some(id.parse()?);
-        } else if line.starts_with("type") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.kind = Some(SectorKind::from_str(value));
-            }
-        } else if line.starts_with("default visibility") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.default_visibility = Some(value.to_string());
-            }
-        } else if line.starts_with("height") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.height = Some(value.parse()?);
-            }
-        } else if line.starts_with("numvertices") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.expected_vertices = Some(value.parse()?);
-            }
-        } else if line.starts_with("vertices:") {
-            let expected = self
-                .expected_vertices
-                .ok_or_else(|| anyhow!("numvertices must precede vertices block"))?;
-            let target_len = self.vertices.len() + expected;
-            let tail = line.splitn(2, ':').nth(1).unwrap_or("").trim();
-            if !tail.is_empty() {
-                self.vertices.push(parse_vec3(tail)?);
-            }
-            while self.vertices.len() < target_len {
-                let raw = lines
-                    .next()
-                    .ok_or_else(|| anyhow!("unexpected EOF reading vertices"))?;
-                let trimmed = raw.trim();
-                if trimmed.is_empty() {
-                    continue;
-                }
-                self.vertices.push(parse_vec3(trimmed)?);
-            }
-        } else if line.starts_with("numtris") {
-            if let Some(value) = line.split_whitespace().last() {
-                self.expected_tris = Some(value.parse()?);
-            }
-        } else if line.starts_with("triangles:") {
-            let expected = self
-                .expected_tris
-                .ok_or_else(|| anyhow!("numtris must precede triangles block"))?;
-            let target_len = self.triangles.len() + expected;
-            let tail = line.splitn(2, ':').nth(1).unwrap_or("").trim();
-            if !tail.is_empty() {
-                self.triangles.push(parse_triangle(tail)?);
-            }
-            while self.triangles.len() < target_len {
-                let raw = lines
-                    .next()
-                    .ok_or_else(|| anyhow!("unexpected EOF reading triangles"))?;
-                let trimmed = raw.trim();
-                if trimmed.is_empty() {
-                    continue;
-                }
-                self.triangles.push(parse_triangle(trimmed)?);
-            }
-        }
-        Ok(())
-    }
+/// The whitespace `str::trim` and `split_whitespace` recognise in ASCII.
+/// Every helper below splits only at these bytes, so slices stay on char
+/// boundaries.
+fn is_space_byte(byte: u8) -> bool {
+    matches!(byte, b' ' | b'\t' | b'\n' | b'\r' | 0x0b | 0x0c)
 }
 
-fn parse_vec3(raw: &str) -> Result<Vec3> {
-    let parts: Vec<&str> = raw.split_whitespace().collect();
-    if parts.len() < 3 {
-        return Err(anyhow!("invalid vertex line: {raw}"));
-    }
-    let x: f32 = parts[0].parse()?;
-    let y: f32 = parts[1].parse()?;
-    let z: f32 = parts[2].parse()?;
-    Ok(Vec3 { x, y, z })
+fn trim(value: &str) -> &str {
+    let bytes = value.as_bytes();
+    let Some(start) = bytes.iter().position(|&byte| !is_space_byte(byte)) else {
+        return "";
+    };
+    let end = bytes
+        .iter()
+        .rposition(|&byte| !is_space_byte(byte))
+        .unwrap()
+        + 1;
+    &value[start..end]
 }
 
-fn parse_triangle(raw: &str) -> Result<[usize; 3]> {
-    let parts: Vec<&str> = raw.split_whitespace().collect();
-    if parts.len() < 3 {
-        return Err(anyhow!("invalid triangle line: {raw}"));
-    }
-    Ok([parts[0].parse()?, parts[1].parse()?, parts[2].parse()?])
+/// Text from the first whitespace byte on, or `""` if there is none.
+fn after_first_space(value: &str) -> &str {
+    value
+        .as_bytes()
+        .iter()
+        .position(|&byte| is_space_byte(byte))
+        .map_or("", |at| &value[at..])
+}
+
+fn tokens(value: &str) -> impl Iterator<Item = &str> {
+    let bytes = value.as_bytes();
+    let mut offset = 0;
+    std::iter::from_fn(move || {
+        while offset < bytes.len() && is_space_byte(bytes[offset]) {
+            offset += 1;
+        }
+        if offset == bytes.len() {
+            return None;
+        }
+        let start = offset;
+        while offset < bytes.len() && !is_space_byte(bytes[offset]) {
+            offset += 1;
+        }
+        Some(&value[start..offset])
+    })
+}
+
+fn last_token(value: &str) -> Option<&str> {
+    let bytes = value.as_bytes();
+    let end = bytes.iter().rposition(|&byte| !is_space_byte(byte))? + 1;
+    let start = bytes[..end]
+        .iter()
+        .rposition(|&byte| is_space_byte(byte))
+        .map_or(0, |at| at + 1);
+    Some(&value[start..end])
 }
 
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -450,4 +612,43 @@ mod tests {
         assert_eq!(sector.triangles.len(), 1);
         assert_eq!(sector.triangles[0], [0, 1, 2]);
     }
+
+    #[test]
+    fn view_borrows_names_and_reads_crlf_input() {
+        let crlf = SAMPLE.replace('\n', "\r\n");
+        let view = SetView::parse(crlf.as_bytes()).expect("parse view");
+        let input = crlf.as_bytes().as_ptr_range();
+        let sector = &view.sectors[0];
+        assert_eq!(sector.name, "foo");
+        assert!(input.contains(&sector.name.as_ptr()));
+        assert_eq!(sector.default_visibility, Some("visible"));
+        assert_eq!(view.colormaps, ["primary.cmp"]);
+        assert_eq!(view.setups[0].name, "cam_a");
+
+        assert_eq!(sector.vertices, 0..3);
+        assert_eq!(
+            view.sector_vertices(sector),
+            [0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0]
+        );
+        assert_eq!(view.sector_triangles(sector), [[0, 1, 2]]);
+        assert_eq!(
+            view.to_set_file(),
+            SetFile::parse(SAMPLE.as_bytes()).expect("parse owned")
+        );
+
+        let truncated = SAMPLE.replace("numtris 1", "numtris 2");
+        let err = SetView::parse(truncated.as_bytes()).expect_err("truncated block");
+        assert!(err.to_string().contains("EOF reading triangles"));
+        let bad = SAMPLE.replace("0.50", "half");
+        let err = SetView::parse(bad.as_bytes()).expect_err("bad height");
+        assert!(err.to_string().contains("line 20"), "{err}");
+
+        let untyped = SAMPLE.replace("\ttype\t\twalk", "");
+        let err = SetView::parse(untyped.as_bytes()).expect_err("untyped sector");
+        assert!(
+            err.to_string()
+                .starts_with("line 16: sector 'foo' missing type"),
+            "{err}"
+        );
+    }
 }
@@ -1,9 +1,12 @@
 use std::io::{Read, Seek, SeekFrom};
 use std::path::{Path, PathBuf};
+use std::time::Duration;
 
-use crate::blocky16::Blocky16Decoder;
-use anyhow::{Context, Result, bail};
-use byteorder::{BigEndian, LittleEndian, ReadBytesExt};
+use crate::blocky16::{self, Blocky16Decoder};
+use crate::vima::VimaDecoder;
+use anyhow::{Context, Result, bail, ensure};
+use byteorder::{BigEndian, ByteOrder, LittleEndian, ReadBytesExt};
+use memmap2::{Mmap, MmapOptions};
 
 /// FourCC helper constants.
 const TAG_SANM: u32 = u32::from_be_bytes(*b"SANM");
@@ -36,6 +39,20 @@ pub struct SnmHeader {
     pub flags: u16,
 }
 
+impl SnmHeader {
+    /// Presentation interval between frames.
+    ///
+    /// Retail headers store microseconds per frame (66667 for 15 fps); small
+    /// values are treated as a plain frames-per-second count.
+    pub fn frame_interval(&self) -> Option<Duration> {
+        match self.frame_rate {
+            0 => None,
+            rate if rate > 1000 => Some(Duration::from_micros(u64::from(rate))),
+            fps => Some(Duration::from_secs(1) / fps),
+        }
+    }
+}
+
 /// Audio stream description pulled from the `FLHD` metadata.
 #[derive(Debug, Clone, Copy)]
 pub struct SnmAudioInfo {
@@ -78,6 +95,20 @@ impl SnmFrame {
             None => Ok(false),
         }
     }
+
+    /// Decode the VIMA `Wave` payload, appending interleaved PCM to `out`.
+    /// Returns the number of samples appended (0 when the frame has no audio).
+    pub fn decode_wave(
+        &self,
+        decoder: &VimaDecoder,
+        channels: usize,
+        out: &mut Vec<i16>,
+    ) -> Result<usize> {
+        match self.wave.as_deref() {
+            Some(payload) => decoder.decode_wave_chunk(payload, channels, out),
+            None => Ok(0),
+        }
+    }
 }
 
 /// Unhandled sub-chunk captured for inspection/debugging.
@@ -99,65 +130,28 @@ impl SnmFile {
         Ok(parsed)
     }
 
+    /// Memory-map an SNM file and index its frames without copying payloads.
+    ///
+    /// Only chunk headers are visited; `Bl16`/`Wave` payloads are borrowed from
+    /// the mapping when a frame is requested.
+    pub fn open_mmap(path: impl AsRef<Path>) -> Result<MappedSnm> {
+        let path = path.as_ref();
+        let file = std::fs::File::open(path)
+            .with_context(|| format!("failed to open SNM file {}", path.display()))?;
+        let mmap = unsafe { MmapOptions::new().map(&file) }
+            .with_context(|| format!("failed to memory-map SNM file {}", path.display()))?;
+        let index = SnmFrameIndex::scan(&mmap)
+            .with_context(|| format!("failed to index SNM file {}", path.display()))?;
+        Ok(MappedSnm {
+            source: path.to_path_buf(),
+            mmap,
+            index,
+        })
+    }
+
     /// Parse an SNM file from an arbitrary reader.
     pub fn read_from<R: Read + Seek>(mut reader: R) -> Result<Self> {
-        let magic = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read SNM magic")?;
-        if magic != TAG_SANM && magic != TAG_ANIM {
-            bail!("unsupported SNM magic {:08x}", magic);
-        }
-
-        let _file_size = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read SNM file size")?;
-
-        let header_tag = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read header chunk tag")?;
-        let header_size = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read header chunk size")?;
-
-        let header_start = reader
-            .stream_position()
-            .context("failed to capture header start")?;
-
-        let header = match header_tag {
-            TAG_SHDR => parse_shdr(&mut reader).context("failed to parse SHDR header")?,
-            TAG_AHDR => bail!("demo SMUSH headers are not supported yet"),
-            _ => bail!("unexpected header chunk {:08x}", header_tag),
-        };
-
-        // Align to even boundary as per SMUSH chunk rules.
-        let mut next_chunk = header_start + header_size as u64;
-        if header_size & 1 != 0 {
-            next_chunk += 1;
-        }
-        reader
-            .seek(SeekFrom::Start(next_chunk))
-            .context("failed to seek past SHDR chunk")?;
-
-        // Expect an `FLHD` chunk that describes the frame payloads.
-        let flhd_tag = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read FLHD tag")?;
-        if flhd_tag != TAG_FLHD {
-            bail!("expected FLHD chunk, found {:08x}", flhd_tag);
-        }
-
-        let flhd_size = reader
-            .read_u32::<BigEndian>()
-            .context("failed to read FLHD size")?;
-        let mut flhd = vec![0u8; flhd_size as usize];
-        reader
-            .read_exact(&mut flhd)
-            .context("failed to read FLHD payload")?;
-        if flhd_size & 1 != 0 {
-            reader.seek(SeekFrom::Current(1)).ok();
-        }
-
-        let audio = parse_flhd(&flhd).context("failed to parse FLHD metadata")?;
+        let (header, audio) = read_prelude(&mut reader)?;
 
         let mut frames = Vec::new();
         let mut frame_index = 0u32;
@@ -224,6 +218,412 @@ impl SnmFile {
     }
 }
 
+/// Byte range of a frame sub-chunk payload relative to the start of the SNM.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SnmChunkSpan {
+    pub offset: u32,
+    pub len: u32,
+}
+
+impl SnmChunkSpan {
+    fn slice<'a>(&self, bytes: &'a [u8]) -> &'a [u8] {
+        let start = self.offset as usize;
+        &bytes[start..start + self.len as usize]
+    }
+}
+
+/// Payload locations for one `FRME` chunk.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SnmFrameEntry {
+    pub blocky16: Option<SnmChunkSpan>,
+    pub wave: Option<SnmChunkSpan>,
+}
+
+/// Compact frame offset table built by scanning chunk headers only.
+///
+/// The index does not own the container bytes; pair it with the slice it was
+/// built from (an mmap, a LAB entry) to borrow payloads on demand.
+#[derive(Debug, Clone)]
+pub struct SnmFrameIndex {
+    pub header: SnmHeader,
+    pub audio: Option<SnmAudioInfo>,
+    pub frames: Vec<SnmFrameEntry>,
+}
+
+impl SnmFrameIndex {
+    /// Walk the container headers in `bytes` and record where each frame's
+    /// payloads live. Payload bytes are bounds-checked but never copied.
+    pub fn scan(bytes: &[u8]) -> Result<Self> {
+        ensure!(
+            bytes.len() <= u32::MAX as usize,
+            "SNM container too large to index ({} bytes)",
+            bytes.len()
+        );
+
+        let mut cursor = std::io::Cursor::new(bytes);
+        let (header, audio) = read_prelude(&mut cursor)?;
+        let mut pos = cursor.position() as usize;
+
+        let mut frames = Vec::with_capacity(header.frame_count as usize);
+        while bytes.len() - pos.min(bytes.len()) >= 8 {
+            let tag = BigEndian::read_u32(&bytes[pos..pos + 4]);
+            let size = BigEndian::read_u32(&bytes[pos + 4..pos + 8]) as usize;
+            let start = pos + 8;
+            let end = start
+                .checked_add(size)
+                .filter(|&end| end <= bytes.len())
+                .with_context(|| {
+                    format!(
+                        "chunk {:08x} at offset {pos} extends beyond file (size {size})",
+                        tag
+                    )
+                })?;
+
+            match tag {
+                TAG_ANNO => {}
+                TAG_FRME => {
+                    let frame_index = frames.len();
+                    let entry = scan_frame(bytes, start, end)
+                        .with_context(|| format!("failed to index frame payload {frame_index}"))?;
+                    frames.push(entry);
+                }
+                _ => bail!("unexpected chunk {:08x} in frame stream", tag),
+            }
+
+            pos = end + (size & 1);
+        }
+
+        Ok(Self {
+            header,
+            audio,
+            frames,
+        })
+    }
+
+    pub fn len(&self) -> usize {
+        self.frames.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.frames.is_empty()
+    }
+
+    /// Borrow frame `index` from the container bytes this index was built from.
+    pub fn frame<'a>(&self, bytes: &'a [u8], index: usize) -> Option<SnmFrameView<'a>> {
+        let entry = self.frames.get(index)?;
+        Some(SnmFrameView {
+            index: index as u32,
+            blocky16: entry.blocky16.map(|span| span.slice(bytes)),
+            wave: entry.wave.map(|span| span.slice(bytes)),
+        })
+    }
+}
+
+fn scan_frame(bytes: &[u8], start: usize, end: usize) -> Result<SnmFrameEntry> {
+    let mut entry = SnmFrameEntry {
+        blocky16: None,
+        wave: None,
+    };
+    let mut pos = start;
+    while end - pos >= 8 {
+        let tag = BigEndian::read_u32(&bytes[pos..pos + 4]);
+        let sub_size = BigEndian::read_u32(&bytes[pos + 4..pos + 8]) as usize;
+        let payload_start = pos + 8;
+        ensure!(
+            sub_size <= end - payload_start,
+            "sub-chunk {:08x} overruns FRME ({sub_size} bytes)",
+            tag
+        );
+        let span = SnmChunkSpan {
+            offset: payload_start as u32,
+            len: sub_size as u32,
+        };
+        match tag {
+            TAG_BL16 => entry.blocky16 = Some(span),
+            TAG_WAVE => entry.wave = Some(span),
+            _ => {}
+        }
+        pos = (payload_start + sub_size + (sub_size & 1)).min(end);
+    }
+    Ok(entry)
+}
+
+/// Frame payloads borrowed from an indexed container.
+#[derive(Debug, Clone, Copy)]
+pub struct SnmFrameView<'a> {
+    pub index: u32,
+    pub blocky16: Option<&'a [u8]>,
+    pub wave: Option<&'a [u8]>,
+}
+
+impl SnmFrameView<'_> {
+    /// Blocky16 sequence number for this frame, if it carries a video payload.
+    pub fn blocky16_seq(&self) -> Option<u16> {
+        self.blocky16.and_then(blocky16::frame_seq)
+    }
+
+    /// Decode the Blocky16 payload into 1555 output. Returns `false` when absent.
+    pub fn decode_blocky16(&self, decoder: &mut Blocky16Decoder, out: &mut [u8]) -> Result<bool> {
+        match self.blocky16 {
+            Some(payload) => {
+                decoder.decode(out, payload)?;
+                Ok(true)
+            }
+            None => Ok(false),
+        }
+    }
+
+    /// Decode the Blocky16 payload into RGBA output. Returns `false` when absent.
+    pub fn decode_blocky16_rgba(
+        &self,
+        decoder: &mut Blocky16Decoder,
+        out: &mut [u8],
+    ) -> Result<bool> {
+        match self.blocky16 {
+            Some(payload) => {
+                decoder.decode_rgba(out, payload)?;
+                Ok(true)
+            }
+            None => Ok(false),
+        }
+    }
+
+    /// Decode the VIMA `Wave` payload, appending interleaved PCM to `out`.
+    /// Returns the number of samples appended (0 when the frame has no audio).
+    pub fn decode_wave(
+        &self,
+        decoder: &VimaDecoder,
+        channels: usize,
+        out: &mut Vec<i16>,
+    ) -> Result<usize> {
+        match self.wave {
+            Some(payload) => decoder.decode_wave_chunk(payload, channels, out),
+            None => Ok(0),
+        }
+    }
+}
+
+/// Memory-mapped SNM with a frame offset index; see [`SnmFile::open_mmap`].
+#[derive(Debug)]
+pub struct MappedSnm {
+    source: PathBuf,
+    mmap: Mmap,
+    index: SnmFrameIndex,
+}
+
+impl MappedSnm {
+    pub fn source(&self) -> &Path {
+        &self.source
+    }
+
+    pub fn header(&self) -> &SnmHeader {
+        &self.index.header
+    }
+
+    pub fn audio(&self) -> Option<SnmAudioInfo> {
+        self.index.audio
+    }
+
+    pub fn index(&self) -> &SnmFrameIndex {
+        &self.index
+    }
+
+    pub fn frame_count(&self) -> usize {
+        self.index.len()
+    }
+
+    pub fn frame(&self, index: usize) -> Option<SnmFrameView<'_>> {
+        self.index.frame(&self.mmap, index)
+    }
+
+    pub fn frames(&self) -> impl Iterator<Item = SnmFrameView<'_>> + '_ {
+        (0..self.index.len()).filter_map(move |index| self.frame(index))
+    }
+
+    /// Instantiate a Blocky16 decoder sized to this movie.
+    pub fn blocky16_decoder(&self) -> Result<Blocky16Decoder> {
+        Blocky16Decoder::new(self.index.header.width, self.index.header.height)
+    }
+
+    /// Number of bytes needed to hold a decoded Blocky16 frame (1555 pixels).
+    pub fn blocky16_frame_len(&self) -> usize {
+        self.index.header.width as usize * self.index.header.height as usize * 2
+    }
+
+    /// Number of bytes needed to hold a decoded Blocky16 frame in RGBA.
+    pub fn blocky16_rgba_len(&self) -> usize {
+        self.index.header.width as usize * self.index.header.height as usize * 4
+    }
+}
+
+/// Sequential SNM reader that yields one frame at a time.
+///
+/// Each `FRME` chunk is read into a single reusable buffer, so the reader only
+/// needs `Read` (a pipe or a LAB entry slice works) and memory stays bounded by
+/// the largest frame.
+pub struct SnmStream<R> {
+    reader: R,
+    header: SnmHeader,
+    audio: Option<SnmAudioInfo>,
+    buffer: Vec<u8>,
+    next_index: u32,
+    finished: bool,
+}
+
+impl<R: Read> SnmStream<R> {
+    /// Read the container prelude and position the stream at the first frame.
+    pub fn new(mut reader: R) -> Result<Self> {
+        let (header, audio) = read_prelude(&mut reader)?;
+        Ok(Self {
+            reader,
+            header,
+            audio,
+            buffer: Vec::new(),
+            next_index: 0,
+            finished: false,
+        })
+    }
+
+    pub fn header(&self) -> &SnmHeader {
+        &self.header
+    }
+
+    pub fn audio(&self) -> Option<SnmAudioInfo> {
+        self.audio
+    }
+
+    /// Instantiate a Blocky16 decoder sized to this movie.
+    pub fn blocky16_decoder(&self) -> Result<Blocky16Decoder> {
+        Blocky16Decoder::new(self.header.width, self.header.height)
+    }
+
+    /// Read the next frame. Payload slices borrow the stream's chunk buffer and
+    /// are invalidated by the following call. Returns `None` at end of stream.
+    pub fn next_frame(&mut self) -> Result<Option<SnmFrameView<'_>>> {
+        if self.finished {
+            return Ok(None);
+        }
+
+        loop {
+            let tag = match self.reader.read_u32::<BigEndian>() {
+                Ok(val) => val,
+                Err(err) if err.kind() == std::io::ErrorKind::UnexpectedEof => {
+                    self.finished = true;
+                    return Ok(None);
+                }
+                Err(err) => return Err(err).context("failed to read next chunk tag"),
+            };
+
+            let size = self
+                .reader
+                .read_u32::<BigEndian>()
+                .context("failed to read chunk size")?;
+
+            if tag == TAG_ANNO {
+                skip_bytes(&mut self.reader, u64::from(size) + u64::from(size & 1))
+                    .context("failed to skip ANNO chunk")?;
+                continue;
+            }
+
+            if tag != TAG_FRME {
+                bail!("unexpected chunk {:08x} in frame stream", tag);
+            }
+
+            let frame_index = self.next_index;
+            self.buffer.resize(size as usize, 0);
+            self.reader
+                .read_exact(&mut self.buffer)
+                .with_context(|| format!("failed to read FRME payload at frame {frame_index}"))?;
+            if size & 1 != 0 {
+                skip_bytes(&mut self.reader, 1).ok();
+            }
+
+            let entry = scan_frame(&self.buffer, 0, self.buffer.len())
+                .with_context(|| format!("failed to parse frame payload {frame_index}"))?;
+            self.next_index += 1;
+
+            let bytes = self.buffer.as_slice();
+            return Ok(Some(SnmFrameView {
+                index: frame_index,
+                blocky16: entry.blocky16.map(|span| span.slice(bytes)),
+                wave: entry.wave.map(|span| span.slice(bytes)),
+            }));
+        }
+    }
+}
+
+/// Read the container magic plus the `SHDR`/`FLHD` chunks, leaving the reader
+/// positioned at the first frame-stream chunk.
+fn read_prelude<R: Read>(reader: &mut R) -> Result<(SnmHeader, Option<SnmAudioInfo>)> {
+    let magic = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read SNM magic")?;
+    if magic != TAG_SANM && magic != TAG_ANIM {
+        bail!("unsupported SNM magic {:08x}", magic);
+    }
+
+    let _file_size = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read SNM file size")?;
+
+    let header_tag = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read header chunk tag")?;
+    let header_size = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read header chunk size")?;
+
+    // Buffer the header chunk so non-seekable readers (pipes, LAB slices) work.
+    let mut header_bytes = vec![0u8; header_size as usize];
+    reader
+        .read_exact(&mut header_bytes)
+        .context("failed to read header chunk payload")?;
+
+    let header = match header_tag {
+        TAG_SHDR => {
+            parse_shdr(&mut header_bytes.as_slice()).context("failed to parse SHDR header")?
+        }
+        TAG_AHDR => bail!("demo SMUSH headers are not supported yet"),
+        _ => bail!("unexpected header chunk {:08x}", header_tag),
+    };
+
+    // Align to even boundary as per SMUSH chunk rules.
+    if header_size & 1 != 0 {
+        skip_bytes(reader, 1).context("failed to skip SHDR padding")?;
+    }
+
+    // Expect an `FLHD` chunk that describes the frame payloads.
+    let flhd_tag = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read FLHD tag")?;
+    if flhd_tag != TAG_FLHD {
+        bail!("expected FLHD chunk, found {:08x}", flhd_tag);
+    }
+
+    let flhd_size = reader
+        .read_u32::<BigEndian>()
+        .context("failed to read FLHD size")?;
+    let mut flhd = vec![0u8; flhd_size as usize];
+    reader
+        .read_exact(&mut flhd)
+        .context("failed to read FLHD payload")?;
+    if flhd_size & 1 != 0 {
+        skip_bytes(reader, 1).ok();
+    }
+
+    let audio = parse_flhd(&flhd).context("failed to parse FLHD metadata")?;
+    Ok((header, audio))
+}
+
+/// Discard `count` bytes from a reader that may not support seeking.
+fn skip_bytes<R: Read>(reader: &mut R, count: u64) -> std::io::Result<()> {
+    let skipped = std::io::copy(&mut reader.by_ref().take(count), &mut std::io::sink())?;
+    if skipped != count {
+        return Err(std::io::ErrorKind::UnexpectedEof.into());
+    }
+    Ok(())
+}
+
 fn parse_shdr<R: Read>(reader: &mut R) -> Result<SnmHeader> {
     let version = reader
         .read_u16::<LittleEndian>()
@@ -408,3 +808,135 @@ fn parse_frame(index: u32, data: &[u8]) -> Result<SnmFrame> {
         extra_chunks,
     })
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write;
+    use tempfile::NamedTempFile;
+
+    fn chunk(tag: &[u8; 4], payload: &[u8]) -> Vec<u8> {
+        let mut out = Vec::new();
+        out.extend_from_slice(tag);
+        out.extend_from_slice(&(payload.len() as u32).to_be_bytes());
+        out.extend_from_slice(payload);
+        if payload.len() & 1 != 0 {
+            out.push(0);
+        }
+        out
+    }
+
+    /// Build a minimal SANM container with one `Bl16` (and optional `Wave`)
+    /// sub-chunk per frame.
+    fn synthetic_snm(frames: &[(&[u8], Option<&[u8]>)]) -> Vec<u8> {
+        let mut shdr = Vec::new();
+        shdr.extend_from_slice(&2u16.to_le_bytes()); // version
+        shdr.extend_from_slice(&(frames.len() as u32).to_le_bytes());
+        shdr.extend_from_slice(&0u16.to_le_bytes());
+        shdr.extend_from_slice(&8u16.to_le_bytes()); // width
+        shdr.extend_from_slice(&8u16.to_le_bytes()); // height
+        shdr.extend_from_slice(&0u16.to_le_bytes());
+        shdr.extend_from_slice(&15u32.to_le_bytes()); // frame rate
+        shdr.extend_from_slice(&0u16.to_le_bytes()); // flags
+
+        let mut wave_header = Vec::new();
+        wave_header.extend_from_slice(&22050u32.to_le_bytes());
+        wave_header.extend_from_slice(&2u32.to_le_bytes());
+        let flhd = chunk(b"Wave", &wave_header);
+
+        let mut body = chunk(b"SHDR", &shdr);
+        body.extend(chunk(b"FLHD", &flhd));
+        body.extend(chunk(b"ANNO", b"note"));
+        for (bl16, wave) in frames {
+            let mut frme = chunk(b"Bl16", bl16);
+            if let Some(wave) = wave {
+                frme.extend(chunk(b"Wave", wave));
+            }
+            frme.extend(chunk(b"XTRA", b"xyz"));
+            body.extend(chunk(b"FRME", &frme));
+        }
+
+        let mut out = Vec::new();
+        out.extend_from_slice(b"SANM");
+        out.extend_from_slice(&(body.len() as u32).to_be_bytes());
+        out.extend(body);
+        out
+    }
+
+    #[test]
+    fn mmap_index_matches_buffered_parse() {
+        let data = synthetic_snm(&[
+            (b"frame-zero", Some(b"pcm0")),
+            (b"frame-one!!", None),
+            (b"f2", Some(b"pcm-two")),
+        ]);
+        let mut file = NamedTempFile::new().unwrap();
+        file.write_all(&data).unwrap();
+
+        let parsed = SnmFile::read_from(std::io::Cursor::new(&data)).unwrap();
+        let mapped = SnmFile::open_mmap(file.path()).unwrap();
+
+        assert_eq!(mapped.header().frame_count, 3);
+        assert_eq!(mapped.header().frame_rate, 15);
+        assert_eq!(mapped.audio().map(|a| a.sample_rate), Some(22050));
+        assert_eq!(mapped.frame_count(), parsed.frames.len());
+        for (view, owned) in mapped.frames().zip(&parsed.frames) {
+            assert_eq!(view.index, owned.index);
+            assert_eq!(view.blocky16, owned.blocky16.as_deref());
+            assert_eq!(view.wave, owned.wave.as_deref());
+        }
+        assert!(mapped.frame(3).is_none());
+    }
+
+    /// Reader that hands out a few bytes per call, like a pipe would.
+    struct Trickle<'a>(&'a [u8]);
+
+    impl Read for Trickle<'_> {
+        fn read(&mut self, buf: &mut [u8]) -> std::io::Result<usize> {
+            let len = buf.len().min(self.0.len()).min(3);
+            buf[..len].copy_from_slice(&self.0[..len]);
+            self.0 = &self.0[len..];
+            Ok(len)
+        }
+    }
+
+    #[test]
+    fn stream_yields_frames_from_non_seekable_reader() {
+        let data = synthetic_snm(&[(b"frame-zero", Some(b"pcm0")), (b"frame-one!!", None)]);
+        let parsed = SnmFile::read_from(std::io::Cursor::new(&data)).unwrap();
+
+        let mut stream = SnmStream::new(Trickle(&data)).unwrap();
+        assert_eq!(stream.header().frame_count, 2);
+        assert_eq!(stream.audio().map(|a| a.channels), Some(2));
+
+        let mut seen = 0;
+        while let Some(view) = stream.next_frame().unwrap() {
+            let owned = &parsed.frames[seen];
+            assert_eq!(view.index, owned.index);
+            assert_eq!(view.blocky16, owned.blocky16.as_deref());
+            assert_eq!(view.wave, owned.wave.as_deref());
+            seen += 1;
+        }
+        assert_eq!(seen, 2);
+        assert!(stream.next_frame().unwrap().is_none());
+    }
+
+    #[test]
+    fn frame_interval_accepts_micros_or_fps() {
+        let mut header = SnmFile::read_from(std::io::Cursor::new(synthetic_snm(&[])))
+            .unwrap()
+            .header;
+        assert_eq!(header.frame_interval(), Some(Duration::from_secs(1) / 15));
+        header.frame_rate = 66_667;
+        assert_eq!(header.frame_interval(), Some(Duration::from_micros(66_667)));
+        header.frame_rate = 0;
+        assert_eq!(header.frame_interval(), None);
+    }
+
+    #[test]
+    fn index_rejects_truncated_frame() {
+        let mut data = synthetic_snm(&[(b"frame-zero", None)]);
+        data.truncate(data.len() - 4);
+        assert!(SnmFrameIndex::scan(&data).is_err());
+    }
+}
@@ -1,12 +1,20 @@
+use std::collections::HashMap;
 use std::convert::TryFrom;
-use std::io::{Cursor, Read, Seek, SeekFrom};
 
-use anyhow::{Context, Result, bail};
-use byteorder::{LittleEndian, ReadBytesExt};
+use anyhow::{Context, Result, bail, ensure};
+use bytemuck::Pod;
 use serde::Serialize;
 
 const MODL_MAGIC: u32 = 0x4d4f444c; // 'MODL' little-endian stored as 'LDOM'
 
+/// Fixed part of a face record, up to the vertex index list.
+const FACE_HEADER_SIZE: usize = 76;
+
+/// Texture-vertex keys used while flattening; real texture vertex indices are
+/// bounds-checked against the mesh and never reach these values.
+const UNTEXTURED: u32 = u32::MAX;
+const UNSET: u32 = u32::MAX - 1;
+
 /// Fully decoded 3DO model data.
 #[derive(Debug, Clone, Serialize)]
 pub struct Model {
@@ -20,67 +28,18 @@ pub struct Model {
 
 impl Model {
     pub fn from_bytes(bytes: &[u8]) -> Result<Self> {
-        let mut cursor = Cursor::new(bytes);
-
-        let magic = cursor.read_u32::<LittleEndian>()?;
-        if magic != MODL_MAGIC {
-            bail!("unexpected 3DO magic {magic:#010x}, expected MODL");
-        }
-
-        let num_materials = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("material count does not fit usize")?;
-        let mut materials = Vec::with_capacity(num_materials);
-        for _ in 0..num_materials {
-            materials.push(read_fixed_string(&mut cursor, 32)?);
-        }
-
-        let model_name = read_fixed_string(&mut cursor, 32)?;
-
-        // Unknown pointer or flags, currently unused.
-        cursor.read_u32::<LittleEndian>()?;
-
-        let num_geosets = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("geoset count does not fit usize")?;
-        let mut geosets = Vec::with_capacity(num_geosets);
-        for _ in 0..num_geosets {
-            geosets.push(Geoset::read(&mut cursor)?);
-        }
-
-        // Skip pointer table.
-        cursor.read_u32::<LittleEndian>()?;
-
-        let num_nodes = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("hierarchy node count does not fit usize")?;
-        let mut nodes = Vec::with_capacity(num_nodes);
-        for _ in 0..num_nodes {
-            nodes.push(Node::read(&mut cursor)?);
-        }
-
-        let radius = cursor.read_f32::<LittleEndian>()?;
-        skip_bytes(&mut cursor, 36)?;
-        let insert_offset = [
-            cursor.read_f32::<LittleEndian>()?,
-            cursor.read_f32::<LittleEndian>()?,
-            cursor.read_f32::<LittleEndian>()?,
-        ];
-
+        let parts = parse_model(bytes, |record| Ok(Mesh::from(record)))?;
         Ok(Model {
-            name: if model_name.is_empty() {
-                None
-            } else {
-                Some(model_name)
-            },
-            materials,
-            geosets,
-            nodes,
-            radius,
-            insert_offset,
+            name: parts.name,
+            materials: parts.materials,
+            geosets: parts
+                .geosets
+                .into_iter()
+                .map(|meshes| Geoset { meshes })
+                .collect(),
+            nodes: parts.nodes,
+            radius: parts.radius,
+            insert_offset: parts.insert_offset,
         })
     }
 
@@ -98,20 +57,6 @@ pub struct Geoset {
     pub meshes: Vec<Mesh>,
 }
 
-impl Geoset {
-    fn read(cursor: &mut Cursor<&[u8]>) -> Result<Self> {
-        let num_meshes = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("mesh count does not fit usize")?;
-        let mut meshes = Vec::with_capacity(num_meshes);
-        for _ in 0..num_meshes {
-            meshes.push(Mesh::read(cursor)?);
-        }
-        Ok(Geoset { meshes })
-    }
-}
-
 #[derive(Debug, Clone, Serialize)]
 pub struct Mesh {
     pub name: String,
@@ -127,60 +72,25 @@ pub struct Mesh {
     pub faces: Vec<Face>,
 }
 
-impl Mesh {
-    fn read(cursor: &mut Cursor<&[u8]>) -> Result<Self> {
-        let name = read_fixed_string(cursor, 32)?;
-        // Skip mesh pointer.
-        cursor.read_u32::<LittleEndian>()?;
-        let geometry_mode = cursor.read_u32::<LittleEndian>()?;
-        let lighting_mode = cursor.read_u32::<LittleEndian>()?;
-        let texture_mode = cursor.read_u32::<LittleEndian>()?;
-
-        let num_vertices: usize = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("vertex count does not fit usize")?;
-        let num_texture_vertices: usize = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("texture vertex count does not fit usize")?;
-        let num_faces: usize = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("face count does not fit usize")?;
-
-        let vertices = read_vec3_list(cursor, num_vertices)?;
-        let texture_vertices = read_vec2_list(cursor, num_texture_vertices)?;
-        let vertex_intensity = read_scalar_list(cursor, num_vertices)?;
-        skip_bytes(cursor, bytes_for(num_vertices, 4)?)?;
-
-        let mut faces = Vec::with_capacity(num_faces);
-        for _ in 0..num_faces {
-            faces.push(Face::read(cursor)?);
+impl From<MeshRecord<'_>> for Mesh {
+    fn from(record: MeshRecord<'_>) -> Self {
+        Mesh {
+            name: record.name,
+            geometry_mode: record.geometry_mode,
+            lighting_mode: record.lighting_mode,
+            texture_mode: record.texture_mode,
+            shadow: record.shadow,
+            radius: record.radius,
+            vertices: record.vertices,
+            vertex_intensity: record.vertex_intensity,
+            vertex_normals: record.vertex_normals,
+            texture_vertices: record.texture_vertices,
+            faces: record.faces.iter().map(Face::from).collect(),
         }
-
-        let vertex_normals = read_vec3_list(cursor, num_vertices)?;
-        let shadow = cursor.read_u32::<LittleEndian>()?;
-        // Skip padding pointer.
-        cursor.read_u32::<LittleEndian>()?;
-        let radius = cursor.read_f32::<LittleEndian>()?;
-        skip_bytes(cursor, 24)?;
-
-        Ok(Mesh {
-            name,
-            geometry_mode,
-            lighting_mode,
-            texture_mode,
-            shadow,
-            radius,
-            vertices,
-            vertex_intensity,
-            vertex_normals,
-            texture_vertices,
-            faces,
-        })
     }
+}
 
+impl Mesh {
     pub fn triangles(&self) -> Vec<Triangle> {
         let mut tris = Vec::new();
         for (face_index, face) in self.faces.iter().enumerate() {
@@ -222,53 +132,19 @@ pub struct Face {
     pub material_index: Option<usize>,
 }
 
-impl Face {
-    fn read(cursor: &mut Cursor<&[u8]>) -> Result<Self> {
-        // Skip face pointer to next.
-        cursor.read_u32::<LittleEndian>()?;
-        let face_type = cursor.read_u32::<LittleEndian>()?;
-        let geo = cursor.read_u32::<LittleEndian>()?;
-        let light = cursor.read_u32::<LittleEndian>()?;
-        let tex = cursor.read_u32::<LittleEndian>()?;
-        let num_vertices: usize = cursor
-            .read_u32::<LittleEndian>()?
-            .try_into()
-            .context("face vertex count does not fit usize")?;
-
-        // Skip surface pointers.
-        cursor.read_u32::<LittleEndian>()?;
-        let tex_ptr = cursor.read_u32::<LittleEndian>()?;
-        let material_ptr_flag = cursor.read_u32::<LittleEndian>()?;
-        skip_bytes(cursor, 12)?;
-        let extra_light = cursor.read_f32::<LittleEndian>()?;
-        skip_bytes(cursor, 12)?;
-        let normal = [
-            cursor.read_f32::<LittleEndian>()?,
-            cursor.read_f32::<LittleEndian>()?,
-            cursor.read_f32::<LittleEndian>()?,
-        ];
-
-        let vertex_indices = read_u32_list(cursor, num_vertices)?;
-
-        let tex_indices = if tex_ptr != 0 {
-            Some(read_u32_list(cursor, num_vertices)?)
-        } else {
-            None
-        };
-
-        let material_index = read_optional_index(cursor, material_ptr_flag)?;
-
-        Ok(Face {
-            face_type,
-            geo,
-            light,
-            tex,
-            extra_light,
-            vertex_indices,
-            tex_indices,
-            normal,
-            material_index,
-        })
+impl From<&FaceRecord<'_>> for Face {
+    fn from(record: &FaceRecord<'_>) -> Self {
+        Face {
+            face_type: record.face_type,
+            geo: record.geo,
+            light: record.light,
+            tex: record.tex,
+            extra_light: record.extra_light,
+            vertex_indices: le_words(record.vertex_indices),
+            tex_indices: record.tex_indices.map(le_words),
+            normal: record.normal,
+            material_index: record.material_index,
+        }
     }
 }
 
@@ -297,36 +173,34 @@ pub struct Node {
 }
 
 impl Node {
-    fn read(cursor: &mut Cursor<&[u8]>) -> Result<Self> {
-        let name = read_fixed_string(cursor, 64)?;
-        let flags = cursor.read_u32::<LittleEndian>()?;
+    fn read(reader: &mut Reader<'_>) -> Result<Self> {
+        let name = reader.fixed_string(64)?;
+        let flags = reader.u32()?;
         // Skip pointer to controller data.
-        cursor.read_u32::<LittleEndian>()?;
-        let node_type = cursor.read_u32::<LittleEndian>()?;
-        let mesh_raw = cursor.read_i32::<LittleEndian>()?;
+        reader.u32()?;
+        let node_type = reader.u32()?;
+        let mesh_raw = reader.i32()?;
         let mesh_index = if mesh_raw >= 0 {
             Some(usize::try_from(mesh_raw).context("mesh index does not fit usize")?)
         } else {
             None
         };
 
-        let depth = cursor.read_u32::<LittleEndian>()?;
-        let parent_flag = cursor.read_u32::<LittleEndian>()?;
-        let num_children = cursor.read_u32::<LittleEndian>()?;
-        let child_flag = cursor.read_u32::<LittleEndian>()?;
-        let sibling_flag = cursor.read_u32::<LittleEndian>()?;
+        let depth = reader.u32()?;
+        let parent_flag = reader.u32()?;
+        let num_children = reader.u32()?;
+        let child_flag = reader.u32()?;
+        let sibling_flag = reader.u32()?;
 
-        let pivot = read_vec3(cursor)?;
-        let position = read_vec3(cursor)?;
-        let pitch = cursor.read_f32::<LittleEndian>()?;
-        let yaw = cursor.read_f32::<LittleEndian>()?;
-        let roll = cursor.read_f32::<LittleEndian>()?;
+        let pivot = reader.vec3()?;
+        let position = reader.vec3()?;
+        let [pitch, yaw, roll] = reader.vec3()?;
 
-        skip_bytes(cursor, 48)?;
+        reader.skip(48)?;
 
-        let parent = read_optional_index(cursor, parent_flag)?;
-        let child = read_optional_index(cursor, child_flag)?;
-        let sibling = read_optional_index(cursor, sibling_flag)?;
+        let parent = reader.optional_index(parent_flag)?;
+        let child = reader.optional_index(child_flag)?;
+        let sibling = reader.optional_index(sibling_flag)?;
 
         Ok(Node {
             name,
@@ -345,83 +219,617 @@ impl Node {
     }
 }
 
-fn read_fixed_string(cursor: &mut Cursor<&[u8]>, len: usize) -> Result<String> {
-    let mut buf = vec![0u8; len];
-    cursor.read_exact(&mut buf)?;
-    let end = buf.iter().position(|&b| b == 0).unwrap_or(len);
-    let text = std::str::from_utf8(&buf[..end])
-        .context("fixed string was not valid UTF-8")?
-        .trim_end()
-        .to_string();
-    Ok(text)
+/// 3DO model flattened for rendering: faces are fanned into one `u32` index
+/// buffer per mesh at load, and vertex attributes sit in parallel arrays that
+/// can be handed to the GPU with `bytemuck::cast_slice`.
+#[derive(Debug, Clone, Serialize)]
+pub struct FlatModel {
+    pub name: Option<String>,
+    pub materials: Vec<String>,
+    pub geosets: Vec<FlatGeoset>,
+    pub nodes: Vec<Node>,
+    pub radius: f32,
+    pub insert_offset: [f32; 3],
 }
 
-fn read_vec3_list(cursor: &mut Cursor<&[u8]>, count: usize) -> Result<Vec<[f32; 3]>> {
-    let mut values = Vec::with_capacity(count);
-    for _ in 0..count {
-        values.push(read_vec3(cursor)?);
+impl FlatModel {
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self> {
+        let parts = parse_model(bytes, FlatMesh::from_record)?;
+        Ok(FlatModel {
+            name: parts.name,
+            materials: parts.materials,
+            geosets: parts
+                .geosets
+                .into_iter()
+                .map(|meshes| FlatGeoset { meshes })
+                .collect(),
+            nodes: parts.nodes,
+            radius: parts.radius,
+            insert_offset: parts.insert_offset,
+        })
     }
-    Ok(values)
 }
 
-fn read_vec2_list(cursor: &mut Cursor<&[u8]>, count: usize) -> Result<Vec<[f32; 2]>> {
-    let mut values = Vec::with_capacity(count);
-    for _ in 0..count {
-        values.push(read_vec2(cursor)?);
+#[derive(Debug, Clone, Serialize)]
+pub struct FlatGeoset {
+    pub meshes: Vec<FlatMesh>,
+}
+
+/// One renderable mesh. 3DO faces index positions and texture coordinates
+/// separately, so every distinct (vertex, texture vertex) pair becomes its own
+/// render vertex; all attribute arrays have the same length.
+#[derive(Debug, Clone, Serialize)]
+pub struct FlatMesh {
+    pub name: String,
+    pub geometry_mode: u32,
+    pub lighting_mode: u32,
+    pub texture_mode: u32,
+    pub shadow: u32,
+    pub radius: f32,
+    pub positions: Vec<[f32; 3]>,
+    pub normals: Vec<[f32; 3]>,
+    /// `[0.0, 0.0]` for corners of untextured faces.
+    pub uvs: Vec<[f32; 2]>,
+    pub intensities: Vec<f32>,
+    /// Triangle list, three indices per triangle, in face order.
+    pub indices: Vec<u32>,
+    /// Ranges of `indices` drawn with one material; consecutive faces that
+    /// share a material are merged.
+    pub draws: Vec<FlatDraw>,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize)]
+pub struct FlatDraw {
+    pub material_index: Option<usize>,
+    pub first_index: u32,
+    pub index_count: u32,
+}
+
+impl FlatMesh {
+    fn from_record(record: MeshRecord<'_>) -> Result<Self> {
+        let vertex_count = record.vertices.len();
+        let tex_count = record.texture_vertices.len();
+        let mut mesh = FlatMesh {
+            name: record.name,
+            geometry_mode: record.geometry_mode,
+            lighting_mode: record.lighting_mode,
+            texture_mode: record.texture_mode,
+            shadow: record.shadow,
+            radius: record.radius,
+            positions: Vec::with_capacity(vertex_count),
+            normals: Vec::with_capacity(vertex_count),
+            uvs: Vec::with_capacity(vertex_count),
+            intensities: Vec::with_capacity(vertex_count),
+            indices: Vec::new(),
+            draws: Vec::new(),
+        };
+
+        // Most vertices are only used with one texture vertex: the first
+        // pairing seen for each vertex lives in `first`, and only the rare
+        // extra pairings go through the hash map.
+        let mut first = vec![(UNSET, 0u32); vertex_count];
+        let mut extra = HashMap::new();
+        let mut corners = Vec::new();
+        for (face_index, face) in record.faces.iter().enumerate() {
+            let sides = face.vertex_indices.len() / 4;
+            if sides < 3 {
+                continue;
+            }
+
+            corners.clear();
+            for corner in 0..sides {
+                let vertex = face.vertex(corner);
+                ensure!(
+                    (vertex as usize) < vertex_count,
+                    "mesh {} face {face_index} references vertex {vertex} of {vertex_count}",
+                    mesh.name
+                );
+                let tex = face.tex(corner);
+                if let Some(tex) = tex {
+                    ensure!(
+                        (tex as usize) < tex_count,
+                        "mesh {} face {face_index} references texture vertex {tex} of {tex_count}",
+                        mesh.name
+                    );
+                }
+
+                let tex_key = tex.unwrap_or(UNTEXTURED);
+                let (first_tex, first_index) = first[vertex as usize];
+                let known = if first_tex == tex_key {
+                    Some(first_index)
+                } else {
+                    extra.get(&(vertex, tex_key)).copied()
+                };
+                let index = match known {
+                    Some(index) => index,
+                    None => {
+                        let index = u32::try_from(mesh.positions.len())
+                            .context("render vertex count does not fit u32")?;
+                        let slot = vertex as usize;
+                        mesh.positions.push(record.vertices[slot]);
+                        mesh.normals.push(record.vertex_normals[slot]);
+                        mesh.intensities.push(record.vertex_intensity[slot]);
+                        mesh.uvs.push(
+                            tex.map_or([0.0; 2], |tex| record.texture_vertices[tex as usize]),
+                        );
+                        if first_tex == UNSET {
+                            first[slot] = (tex_key, index);
+                        } else {
+                            extra.insert((vertex, tex_key), index);
+                        }
+                        index
+                    }
+                };
+                corners.push(index);
+            }
+
+            let first_index =
+                u32::try_from(mesh.indices.len()).context("index count does not fit u32")?;
+            // 3DO faces are authored as convex polygons, so treat them as a simple fan.
+            for pair in corners[1..].windows(2) {
+                mesh.indices
+                    .extend_from_slice(&[corners[0], pair[0], pair[1]]);
+            }
+            let index_count = (sides as u32 - 2) * 3;
+
+            match mesh.draws.last_mut() {
+                Some(draw) if draw.material_index == face.material_index => {
+                    draw.index_count += index_count;
+                }
+                _ => mesh.draws.push(FlatDraw {
+                    material_index: face.material_index,
+                    first_index,
+                    index_count,
+                }),
+            }
+        }
+
+        Ok(mesh)
     }
-    Ok(values)
 }
 
-fn read_vec3(cursor: &mut Cursor<&[u8]>) -> Result<[f32; 3]> {
-    Ok([
-        cursor.read_f32::<LittleEndian>()?,
-        cursor.read_f32::<LittleEndian>()?,
-        cursor.read_f32::<LittleEndian>()?,
-    ])
+/// Model-level fields shared by [`Model`] and [`FlatModel`], with meshes
+/// already converted by the caller's builder.
+struct ModelParts<M> {
+    name: Option<String>,
+    materials: Vec<String>,
+    geosets: Vec<Vec<M>>,
+    nodes: Vec<Node>,
+    radius: f32,
+    insert_offset: [f32; 3],
 }
 
-fn read_vec2(cursor: &mut Cursor<&[u8]>) -> Result<[f32; 2]> {
-    Ok([
-        cursor.read_f32::<LittleEndian>()?,
-        cursor.read_f32::<LittleEndian>()?,
-    ])
+fn parse_model<M>(
+    bytes: &[u8],
+    mut build_mesh: impl FnMut(MeshRecord<'_>) -> Result<M>,
+) -> Result<ModelParts<M>> {
+    let mut reader = Reader::new(bytes);
+
+    let magic = reader.u32()?;
+    if magic != MODL_MAGIC {
+        bail!("unexpected 3DO magic {magic:#010x}, expected MODL");
+    }
+
+    let num_materials = reader.count("material")?;
+    let mut materials = Vec::with_capacity(num_materials);
+    for _ in 0..num_materials {
+        materials.push(reader.fixed_string(32)?);
+    }
+
+    let model_name = reader.fixed_string(32)?;
+
+    // Unknown pointer or flags, currently unused.
+    reader.u32()?;
+
+    let num_geosets = reader.count("geoset")?;
+    let mut geosets = Vec::with_capacity(num_geosets);
+    for _ in 0..num_geosets {
+        let num_meshes = reader.count("mesh")?;
+        let mut meshes = Vec::with_capacity(num_meshes);
+        for _ in 0..num_meshes {
+            meshes.push(build_mesh(MeshRecord::read(&mut reader)?)?);
+        }
+        geosets.push(meshes);
+    }
+
+    // Skip pointer table.
+    reader.u32()?;
+
+    let num_nodes = reader.count("hierarchy node")?;
+    let mut nodes = Vec::with_capacity(num_nodes);
+    for _ in 0..num_nodes {
+        nodes.push(Node::read(&mut reader)?);
+    }
+
+    let radius = reader.f32()?;
+    reader.skip(36)?;
+    let insert_offset = reader.vec3()?;
+
+    Ok(ModelParts {
+        name: if model_name.is_empty() {
+            None
+        } else {
+            Some(model_name)
+        },
+        materials,
+        geosets,
+        nodes,
+        radius,
+        insert_offset,
+    })
+}
+
+/// A mesh as stored on disk. Attribute arrays are bulk-copied; face index
+/// lists stay borrowed from the input until a builder consumes them.
+struct MeshRecord<'a> {
+    name: String,
+    geometry_mode: u32,
+    lighting_mode: u32,
+    texture_mode: u32,
+    shadow: u32,
+    radius: f32,
+    vertices: Vec<[f32; 3]>,
+    vertex_intensity: Vec<f32>,
+    vertex_normals: Vec<[f32; 3]>,
+    texture_vertices: Vec<[f32; 2]>,
+    faces: Vec<FaceRecord<'a>>,
+}
+
+impl<'a> MeshRecord<'a> {
+    fn read(reader: &mut Reader<'a>) -> Result<Self> {
+        let name = reader.fixed_string(32)?;
+        // Skip mesh pointer.
+        reader.u32()?;
+        let geometry_mode = reader.u32()?;
+        let lighting_mode = reader.u32()?;
+        let texture_mode = reader.u32()?;
+
+        let num_vertices = reader.count("vertex")?;
+        let num_texture_vertices = reader.count("texture vertex")?;
+        let num_faces = reader.count("face")?;
+
+        let vertices = reader.words(num_vertices)?;
+        let texture_vertices = reader.words(num_texture_vertices)?;
+        let vertex_intensity = reader.words(num_vertices)?;
+        reader.skip(bytes_for(num_vertices, 4)?)?;
+
+        let mut faces = Vec::with_capacity(num_faces);
+        for _ in 0..num_faces {
+            faces.push(FaceRecord::read(reader)?);
+        }
+
+        let vertex_normals = reader.words(num_vertices)?;
+        let shadow = reader.u32()?;
+        // Skip padding pointer.
+        reader.u32()?;
+        let radius = reader.f32()?;
+        reader.skip(24)?;
+
+        Ok(MeshRecord {
+            name,
+            geometry_mode,
+            lighting_mode,
+            texture_mode,
+            shadow,
+            radius,
+            vertices,
+            vertex_intensity,
+            vertex_normals,
+            texture_vertices,
+            faces,
+        })
+    }
+}
+
+/// A face as stored on disk; index lists are raw little-endian `u32`s.
+struct FaceRecord<'a> {
+    face_type: u32,
+    geo: u32,
+    light: u32,
+    tex: u32,
+    extra_light: f32,
+    normal: [f32; 3],
+    vertex_indices: &'a [u8],
+    tex_indices: Option<&'a [u8]>,
+    material_index: Option<usize>,
+}
+
+impl<'a> FaceRecord<'a> {
+    fn read(reader: &mut Reader<'a>) -> Result<Self> {
+        let header = reader.take(FACE_HEADER_SIZE)?;
+        let field =
+            |offset: usize| u32::from_le_bytes(header[offset..offset + 4].try_into().unwrap());
+        // Offset 0 is the pointer to the next face; 24 the surface pointer;
+        // 36..48 and 52..64 are unused.
+        let face_type = field(4);
+        let geo = field(8);
+        let light = field(12);
+        let tex = field(16);
+        let num_vertices =
+            usize::try_from(field(20)).context("face vertex count does not fit usize")?;
+        let tex_ptr = field(28);
+        let material_ptr_flag = field(32);
+        let extra_light = f32::from_bits(field(48));
+        let normal = [
+            f32::from_bits(field(64)),
+            f32::from_bits(field(68)),
+            f32::from_bits(field(72)),
+        ];
+
+        let list_len = bytes_for(num_vertices, 4)?;
+        let vertex_indices = reader.take(list_len)?;
+        let tex_indices = if tex_ptr != 0 {
+            Some(reader.take(list_len)?)
+        } else {
+            None
+        };
+
+        let material_index = reader.optional_index(material_ptr_flag)?;
+
+        Ok(FaceRecord {
+            face_type,
+            geo,
+            light,
+            tex,
+            extra_light,
+            normal,
+            vertex_indices,
+            tex_indices,
+            material_index,
+        })
+    }
+
+    fn vertex(&self, corner: usize) -> u32 {
+        word_at(self.vertex_indices, corner)
+    }
+
+    fn tex(&self, corner: usize) -> Option<u32> {
+        self.tex_indices.map(|indices| word_at(indices, corner))
+    }
+}
+
+/// Bounds-checked little-endian reader over a model buffer.
+struct Reader<'a> {
+    bytes: &'a [u8],
+    pos: usize,
 }
 
-fn read_scalar_list(cursor: &mut Cursor<&[u8]>, count: usize) -> Result<Vec<f32>> {
-    let mut values = Vec::with_capacity(count);
-    for _ in 0..count {
-        values.push(cursor.read_f32::<LittleEndian>()?);
+impl<'a> Reader<'a> {
+    fn new(bytes: &'a [u8]) -> Self {
+        Reader { bytes, pos: 0 }
+    }
+
+    fn take(&mut self, len: usize) -> Result<&'a [u8]> {
+        let end = self
+            .pos
+            .checked_add(len)
+            .filter(|&end| end <= self.bytes.len())
+            .with_context(|| {
+                format!(
+                    "3DO data truncated: need {len} bytes at offset {:#x}, have {}",
+                    self.pos,
+                    self.bytes.len() - self.pos
+                )
+            })?;
+        let slice = &self.bytes[self.pos..end];
+        self.pos = end;
+        Ok(slice)
+    }
+
+    fn skip(&mut self, len: usize) -> Result<()> {
+        self.take(len).map(|_| ())
+    }
+
+    fn u32(&mut self) -> Result<u32> {
+        Ok(u32::from_le_bytes(self.take(4)?.try_into().unwrap()))
+    }
+
+    fn i32(&mut self) -> Result<i32> {
+        Ok(self.u32()? as i32)
+    }
+
+    fn f32(&mut self) -> Result<f32> {
+        Ok(f32::from_bits(self.u32()?))
+    }
+
+    fn vec3(&mut self) -> Result<[f32; 3]> {
+        Ok([self.f32()?, self.f32()?, self.f32()?])
+    }
+
+    fn count(&mut self, what: &str) -> Result<usize> {
+        usize::try_from(self.u32()?).with_context(|| format!("{what} count does not fit usize"))
+    }
+
+    /// `count` values made of little-endian 32-bit words, copied in bulk.
+    fn words<T: Pod>(&mut self, count: usize) -> Result<Vec<T>> {
+        let len = bytes_for(count, std::mem::size_of::<T>())?;
+        Ok(le_words(self.take(len)?))
+    }
+
+    fn fixed_string(&mut self, len: usize) -> Result<String> {
+        let buf = self.take(len)?;
+        let end = buf.iter().position(|&b| b == 0).unwrap_or(len);
+        let text = std::str::from_utf8(&buf[..end])
+            .context("fixed string was not valid UTF-8")?
+            .trim_end()
+            .to_string();
+        Ok(text)
+    }
+
+    fn optional_index(&mut self, flag: u32) -> Result<Option<usize>> {
+        if flag == 0 {
+            return Ok(None);
+        }
+        let raw = self.u32()?;
+        let index = usize::try_from(raw).context("optional index does not fit usize")?;
+        Ok(Some(index))
     }
-    Ok(values)
 }
 
-fn read_u32_list(cursor: &mut Cursor<&[u8]>, count: usize) -> Result<Vec<u32>> {
-    let mut values = Vec::with_capacity(count);
-    for _ in 0..count {
-        values.push(cursor.read_u32::<LittleEndian>()?);
+/// Reinterpret little-endian bytes as `T`, a type built from 32-bit words.
+/// Aligned input is a single cast and copy; LAB entries sit at arbitrary
+/// offsets, so unaligned input falls back to an unaligned copy.
+fn le_words<T: Pod>(bytes: &[u8]) -> Vec<T> {
+    let mut values: Vec<T> = match bytemuck::try_cast_slice(bytes) {
+        Ok(values) => values.to_vec(),
+        Err(_) => bytemuck::pod_collect_to_vec(bytes),
+    };
+    // No-op on little-endian hosts.
+    for word in bytemuck::cast_slice_mut::<T, u32>(&mut values) {
+        *word = u32::from_le(*word);
     }
-    Ok(values)
+    values
 }
 
-fn skip_bytes(cursor: &mut Cursor<&[u8]>, count: i64) -> Result<()> {
-    cursor
-        .seek(SeekFrom::Current(count))
-        .context("failed to skip bytes")?;
-    Ok(())
+fn word_at(bytes: &[u8], index: usize) -> u32 {
+    u32::from_le_bytes(bytes[index * 4..index * 4 + 4].try_into().unwrap())
 }
 
-fn bytes_for(count: usize, size: usize) -> Result<i64> {
-    let bytes = count
+fn bytes_for(count: usize, size: usize) -> Result<usize> {
+    count
         .checked_mul(size)
-        .context("byte count overflow while skipping")?;
-    i64::try_from(bytes).context("byte count does not fit i64")
+        .context("byte count overflow while reading 3DO arrays")
 }
 
-fn read_optional_index(cursor: &mut Cursor<&[u8]>, flag: u32) -> Result<Option<usize>> {
-    if flag == 0 {
-        return Ok(None);
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn push_u32(out: &mut Vec<u8>, value: u32) {
+        out.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn push_f32s(out: &mut Vec<u8>, values: &[f32]) {
+        for value in values {
+            out.extend_from_slice(&value.to_le_bytes());
+        }
+    }
+
+    fn push_name(out: &mut Vec<u8>, name: &str, len: usize) {
+        let mut field = vec![0u8; len];
+        field[..name.len()].copy_from_slice(name.as_bytes());
+        out.extend_from_slice(&field);
+    }
+
+    fn push_face(out: &mut Vec<u8>, vertices: &[u32], tex: Option<&[u32]>, material: Option<u32>) {
+        let mut header = [0u8; FACE_HEADER_SIZE];
+        header[4..8].copy_from_slice(&1u32.to_le_bytes());
+        header[20..24].copy_from_slice(&(vertices.len() as u32).to_le_bytes());
+        header[28..32].copy_from_slice(&u32::from(tex.is_some()).to_le_bytes());
+        header[32..36].copy_from_slice(&u32::from(material.is_some()).to_le_bytes());
+        header[48..52].copy_from_slice(&0.5f32.to_le_bytes());
+        header[72..76].copy_from_slice(&1.0f32.to_le_bytes());
+        out.extend_from_slice(&header);
+        vertices.iter().for_each(|&index| push_u32(out, index));
+        tex.into_iter()
+            .flatten()
+            .for_each(|&index| push_u32(out, index));
+        material.into_iter().for_each(|index| push_u32(out, index));
+    }
+
+    /// One mesh: a textured quad (material 0), a triangle reusing vertex 0
+    /// with a different texture vertex (material 0), and an untextured
+    /// triangle (material 1).
+    fn sample_model() -> Vec<u8> {
+        let mut out = Vec::new();
+        push_u32(&mut out, MODL_MAGIC);
+        push_u32(&mut out, 2);
+        push_name(&mut out, "wall.mat", 32);
+        push_name(&mut out, "trim.mat", 32);
+        push_name(&mut out, "sample", 32);
+        push_u32(&mut out, 0);
+
+        push_u32(&mut out, 1); // geosets
+        push_u32(&mut out, 1); // meshes
+        push_name(&mut out, "body", 32);
+        push_u32(&mut out, 0);
+        [3, 1, 2].iter().for_each(|&mode| push_u32(&mut out, mode));
+        [5, 5, 3]
+            .iter()
+            .for_each(|&count| push_u32(&mut out, count));
+        for vertex in 0..5 {
+            push_f32s(&mut out, &[vertex as f32, 0.0, 1.0]);
+        }
+        for tex in 0..5 {
+            push_f32s(&mut out, &[tex as f32 / 4.0, 1.0]);
+        }
+        push_f32s(&mut out, &[0.1, 0.2, 0.3, 0.4, 0.5]);
+        out.extend_from_slice(&[0u8; 5 * 4]);
+        push_face(&mut out, &[0, 1, 2, 3], Some(&[0, 1, 2, 3]), Some(0));
+        push_face(&mut out, &[0, 3, 4], Some(&[4, 3, 4]), Some(0));
+        push_face(&mut out, &[4, 2, 1], None, Some(1));
+        for _ in 0..5 {
+            push_f32s(&mut out, &[0.0, 0.0, 1.0]);
+        }
+        push_u32(&mut out, 0);
+        push_u32(&mut out, 0);
+        push_f32s(&mut out, &[2.5]);
+        out.extend_from_slice(&[0u8; 24]);
+
+        push_u32(&mut out, 0);
+        push_u32(&mut out, 0); // nodes
+        push_f32s(&mut out, &[4.0]);
+        out.extend_from_slice(&[0u8; 36]);
+        push_f32s(&mut out, &[1.0, 2.0, 3.0]);
+        out
+    }
+
+    #[test]
+    fn flat_mesh_splits_vertices_by_texture_vertex_and_groups_materials() {
+        let bytes = sample_model();
+        let model = Model::from_bytes(&bytes).unwrap();
+        let flat = FlatModel::from_bytes(&bytes).unwrap();
+        assert_eq!(flat.name.as_deref(), Some("sample"));
+        assert_eq!(flat.insert_offset, [1.0, 2.0, 3.0]);
+
+        let mesh = &flat.geosets[0].meshes[0];
+        assert_eq!(mesh.indices, [0, 1, 2, 0, 2, 3, 4, 3, 5, 6, 7, 8]);
+        assert_eq!(mesh.positions.len(), 9);
+        assert_eq!(mesh.normals.len(), 9);
+        assert_eq!(mesh.intensities[4], 0.1);
+        assert_eq!(mesh.uvs[4], [1.0, 1.0]);
+        assert_eq!(mesh.uvs[6], [0.0, 0.0]);
+        assert_eq!(
+            mesh.draws,
+            [
+                FlatDraw {
+                    material_index: Some(0),
+                    first_index: 0,
+                    index_count: 9,
+                },
+                FlatDraw {
+                    material_index: Some(1),
+                    first_index: 9,
+                    index_count: 3,
+                },
+            ]
+        );
+
+        // Every flat triangle is the nested triangle with the same corners.
+        let nested = &model.geosets[0].meshes[0];
+        for (tri, corners) in nested.triangles().iter().zip(mesh.indices.chunks_exact(3)) {
+            for (slot, &index) in corners.iter().enumerate() {
+                let vertex = tri.vertex_indices[slot] as usize;
+                assert_eq!(mesh.positions[index as usize], nested.vertices[vertex]);
+            }
+        }
+    }
+
+    #[test]
+    fn unaligned_input_parses_identically() {
+        let bytes = sample_model();
+        let mut shifted = vec![0u8; bytes.len() + 1];
+        shifted[1..].copy_from_slice(&bytes);
+        let aligned = FlatModel::from_bytes(&bytes).unwrap();
+        let unaligned = FlatModel::from_bytes(&shifted[1..]).unwrap();
+        let (a, b) = (
+            &aligned.geosets[0].meshes[0],
+            &unaligned.geosets[0].meshes[0],
+        );
+        assert_eq!(
+            (&a.positions, &a.uvs, &a.indices),
+            (&b.positions, &b.uvs, &b.indices)
+        );
+        assert!(FlatModel::from_bytes(&bytes[..bytes.len() - 4]).is_err());
     }
-    let raw = cursor.read_u32::<LittleEndian>()?;
-    let index = usize::try_from(raw).context("optional index does not fit usize")?;
-    Ok(Some(index))
 }
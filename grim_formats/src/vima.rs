@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// VIMA audio decoder translated from ScummVM
+// (engines/grim/movie/codecs/vima.cpp).
+//
+// Retail SNM `Wave` sub-chunks carry VIMA, a variable bit-width IMA ADPCM
+// variant. Each chunk starts with a big-endian sample count followed by the
+// compressed stream; channels are stored one after another and interleaved
+// on output.
+
+use anyhow::{Context, Result, ensure};
+
+/// Standard IMA ADPCM step table.
+const IMC_TABLE1: [u16; 89] = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66,
+    73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449,
+    494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272,
+    2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,
+    10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+];
+
+/// Step-index adjustments, one table per code width (2..=7 bits), indexed by
+/// the magnitude bits of the code.
+const IMC_OTHER_TABLE1: [i8; 2] = [-1, 4];
+const IMC_OTHER_TABLE2: [i8; 4] = [-1, -1, 2, 8];
+const IMC_OTHER_TABLE3: [i8; 8] = [-1, -1, -1, -1, 1, 2, 4, 6];
+const IMC_OTHER_TABLE4: [i8; 16] = [-1, -1, -1, -1, -1, -1, -1, -1, 1, 1, 1, 2, 2, 4, 5, 6];
+const IMC_OTHER_TABLE5: [i8; 32] = [
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,
+    4, 4, 5, 5, 6, 6,
+];
+const IMC_OTHER_TABLE6: [i8; 64] = [
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4,
+    4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6,
+];
+const IMC_OFFSETS: [&[i8]; 6] = [
+    &IMC_OTHER_TABLE1,
+    &IMC_OTHER_TABLE2,
+    &IMC_OTHER_TABLE3,
+    &IMC_OTHER_TABLE4,
+    &IMC_OTHER_TABLE5,
+    &IMC_OTHER_TABLE6,
+];
+
+/// Decoder with the precomputed delta tables; build once and reuse.
+pub struct VimaDecoder {
+    /// Code width in bits for each step index.
+    bits_table: [u8; 89],
+    /// `dest_table[step * 64 + code]`: partial delta sums for every code.
+    dest_table: Vec<u16>,
+}
+
+impl Default for VimaDecoder {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl VimaDecoder {
+    pub fn new() -> Self {
+        let mut bits_table = [0u8; 89];
+        for (bits, &step) in bits_table.iter_mut().zip(IMC_TABLE1.iter()) {
+            let mut put = 1u8;
+            let mut value = ((u32::from(step) * 4) / 7) / 2;
+            while value != 0 {
+                value /= 2;
+                put += 1;
+            }
+            *bits = put.clamp(3, 8) - 1;
+        }
+
+        let mut dest_table = vec![0u16; IMC_TABLE1.len() * 64];
+        for code in 0..64usize {
+            for (step_index, &step) in IMC_TABLE1.iter().enumerate() {
+                let mut put = 0u32;
+                let mut value = u32::from(step);
+                let mut count = 32usize;
+                while count != 0 {
+                    if code & count != 0 {
+                        put += value;
+                    }
+                    count >>= 1;
+                    value >>= 1;
+                }
+                dest_table[step_index * 64 + code] = put as u16;
+            }
+        }
+
+        Self {
+            bits_table,
+            dest_table,
+        }
+    }
+
+    /// Decode one SNM `Wave` sub-chunk payload, appending interleaved PCM to
+    /// `out`. Returns the number of samples appended.
+    pub fn decode_wave_chunk(
+        &self,
+        payload: &[u8],
+        channels: usize,
+        out: &mut Vec<i16>,
+    ) -> Result<usize> {
+        ensure!(payload.len() >= 4, "VIMA chunk too short for sample count");
+        let mut sample_count = i32::from_be_bytes(payload[0..4].try_into().unwrap());
+        let mut data = &payload[4..];
+        if sample_count < 0 {
+            // Extended header: skip a word and re-read the real count.
+            ensure!(data.len() >= 8, "VIMA chunk truncated in extended header");
+            sample_count = i32::from_be_bytes(data[4..8].try_into().unwrap());
+            data = &data[8..];
+        }
+        ensure!(
+            sample_count >= 0,
+            "VIMA chunk reports negative sample count {sample_count}"
+        );
+
+        // Codes are at least two bits, so a payload cannot describe more than
+        // four samples per byte; a larger count means a corrupt header.
+        let total = (sample_count as usize)
+            .checked_mul(channels.max(1))
+            .filter(|&total| total <= data.len().saturating_mul(4))
+            .with_context(|| {
+                format!(
+                    "VIMA chunk claims {sample_count} samples x {channels} channel(s) \
+                     but holds only {} byte(s)",
+                    data.len()
+                )
+            })?;
+        let start = out.len();
+        out.resize(start + total, 0);
+        self.decode(data, &mut out[start..])?;
+        Ok(total)
+    }
+
+    /// Decode a raw VIMA stream into `dest` (interleaved when stereo).
+    ///
+    /// Reads past the end of `src` yield zero bits, matching the tolerant
+    /// behaviour of the other SMUSH decoders here.
+    pub fn decode(&self, src: &[u8], dest: &mut [i16]) -> Result<()> {
+        let mut reader = ByteReader { src, pos: 0 };
+
+        let mut step_indices = [0u8; 2];
+        let mut predictors = [0i16; 2];
+        let mut channels = 1usize;
+
+        step_indices[0] = reader.byte();
+        if step_indices[0] & 0x80 != 0 {
+            step_indices[0] = !step_indices[0];
+            channels = 2;
+        }
+        predictors[0] = reader.be_u16() as i16;
+        if channels > 1 {
+            step_indices[1] = reader.byte();
+            predictors[1] = reader.be_u16() as i16;
+        }
+        ensure!(
+            step_indices[..channels].iter().all(|&index| index <= 88),
+            "VIMA initial step index out of range"
+        );
+
+        let samples = dest.len() / channels;
+        let mut bits = u32::from(reader.be_u16());
+        let mut bit_ptr = 0u32;
+
+        for channel in 0..channels {
+            let mut step_index = i32::from(step_indices[channel]);
+            let mut output = i32::from(predictors[channel]);
+
+            for sample in 0..samples {
+                let num_bits = u32::from(self.bits_table[step_index as usize]);
+                bit_ptr += num_bits;
+                let mut high_bit = 1u32 << (num_bits - 1);
+                let low_bits = high_bit - 1;
+                let mut value = (bits >> (16 - bit_ptr)) & (high_bit | low_bits);
+
+                if bit_ptr > 7 {
+                    bits = ((bits & 0xFF) << 8) | u32::from(reader.byte());
+                    bit_ptr -= 8;
+                }
+
+                if value & high_bit != 0 {
+                    value ^= high_bit;
+                } else {
+                    high_bit = 0;
+                }
+
+                if value == low_bits {
+                    // Escape code: an absolute 16-bit sample follows.
+                    let mut literal = ((bits << bit_ptr) as i16 as i32) & !0xFF;
+                    bits = ((bits & 0xFF) << 8) | u32::from(reader.byte());
+                    literal |= ((bits >> (8 - bit_ptr)) & 0xFF) as i32;
+                    bits = ((bits & 0xFF) << 8) | u32::from(reader.byte());
+                    output = literal as i16 as i32;
+                } else {
+                    let index = ((value << (7 - num_bits)) as usize) | ((step_index as usize) << 6);
+                    let mut delta = i32::from(self.dest_table[index]);
+                    if value != 0 {
+                        delta += i32::from(IMC_TABLE1[step_index as usize] >> (num_bits - 1));
+                    }
+                    if high_bit != 0 {
+                        delta = -delta;
+                    }
+                    output = (output + delta).clamp(-0x8000, 0x7FFF);
+                }
+
+                dest[sample * channels + channel] = output as i16;
+
+                step_index += i32::from(IMC_OFFSETS[num_bits as usize - 2][value as usize]);
+                step_index = step_index.clamp(0, 88);
+            }
+        }
+        Ok(())
+    }
+}
+
+struct ByteReader<'a> {
+    src: &'a [u8],
+    pos: usize,
+}
+
+impl ByteReader<'_> {
+    fn byte(&mut self) -> u8 {
+        let value = self.src.get(self.pos).copied().unwrap_or(0);
+        self.pos += 1;
+        value
+    }
+
+    fn be_u16(&mut self) -> u16 {
+        u16::from_be_bytes([self.byte(), self.byte()])
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn code_widths_span_two_to_seven_bits() {
+        let decoder = VimaDecoder::new();
+        assert_eq!(decoder.bits_table[0], 2);
+        assert_eq!(decoder.bits_table[88], 7);
+        assert!(decoder.bits_table.windows(2).all(|pair| pair[0] <= pair[1]));
+    }
+
+    #[test]
+    fn zero_codes_hold_the_predictor() {
+        // Mono, step index 0, predictor 0x0123, then all-zero 2-bit codes.
+        let stream = [0x00, 0x01, 0x23, 0x00, 0x00, 0x00, 0x00];
+        let mut pcm = [0i16; 8];
+        VimaDecoder::new().decode(&stream, &mut pcm).unwrap();
+        assert!(pcm.iter().all(|&sample| sample == 0x0123));
+    }
+
+    #[test]
+    fn escape_code_loads_literal_sample() {
+        // Mono, step 0 (2-bit codes); code 0b01 is the escape (value == low bits)
+        // and the next 16 bits are the literal 0x1234: 01|0001_0010_0011_0100.
+        let stream = [0x00, 0x00, 0x00, 0x44, 0x8D, 0x00, 0x00];
+        let mut pcm = [0i16; 1];
+        VimaDecoder::new().decode(&stream, &mut pcm).unwrap();
+        assert_eq!(pcm[0], 0x1234);
+    }
+
+    #[test]
+    fn wave_chunk_interleaves_stereo_output() {
+        // Stereo flag via inverted step byte; both channels hold their predictor.
+        let mut payload = 4i32.to_be_bytes().to_vec();
+        payload.extend_from_slice(&[!0u8, 0x00, 0x10, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00]);
+        let mut pcm = Vec::new();
+        let appended = VimaDecoder::new()
+            .decode_wave_chunk(&payload, 2, &mut pcm)
+            .unwrap();
+        assert_eq!(appended, 8);
+        assert_eq!(pcm, [0x10, 0x20, 0x10, 0x20, 0x10, 0x20, 0x10, 0x20]);
+    }
+
+    #[test]
+    fn wave_chunk_rejects_counts_the_payload_cannot_hold() {
+        let mut payload = i32::MAX.to_be_bytes().to_vec();
+        payload.extend_from_slice(&[0x00, 0x01, 0x23, 0x00, 0x00]);
+        let mut pcm = Vec::new();
+        assert!(
+            VimaDecoder::new()
+                .decode_wave_chunk(&payload, 2, &mut pcm)
+                .is_err()
+        );
+        assert!(pcm.is_empty());
+    }
+}
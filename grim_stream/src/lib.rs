@@ -244,6 +244,25 @@ pub struct StateUpdate {
     pub events: Vec<String>,
     #[serde(skip_serializing_if = "Option::is_none")]
     pub active_movie: Option<String>,
+    /// Frame pacing snapshot; attached periodically rather than every update.
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub frame_stats: Option<FrameStats>,
+}
+
+/// Rolling frame pacing statistics from the engine's fixed-timestep loop.
+#[derive(Debug, Clone, Serialize, Deserialize, PartialEq)]
+pub struct FrameStats {
+    /// Ticks covered by the per-tick work percentiles below.
+    pub window: u32,
+    pub p50_ms: f32,
+    pub p99_ms: f32,
+    pub max_ms: f32,
+    /// Ticks whose work took longer than one step, since startup.
+    pub overruns: u64,
+    /// Extra ticks simulated to make up for late frames, since startup.
+    pub catch_up_ticks: u64,
+    /// Ticks skipped because the backlog exceeded the catch-up limit, since startup.
+    pub dropped_ticks: u64,
 }
 
 /// Error conditions returned by the protocol helpers.
@@ -355,4 +374,42 @@ mod tests {
         let decoded: MovieControl = decode_payload(payload).unwrap();
         assert_eq!(decoded, control);
     }
+
+    #[test]
+    fn state_update_frame_stats_round_trip() {
+        let update = StateUpdate {
+            seq: 7,
+            host_time_ns: 0,
+            frame: Some(300),
+            position: None,
+            yaw: None,
+            active_setup: None,
+            active_hotspot: None,
+            coverage: Vec::new(),
+            events: Vec::new(),
+            active_movie: None,
+            frame_stats: Some(FrameStats {
+                window: 300,
+                p50_ms: 4.5,
+                p99_ms: 31.0,
+                max_ms: 48.25,
+                overruns: 2,
+                catch_up_ticks: 1,
+                dropped_ticks: 0,
+            }),
+        };
+        let bytes = encode_message(MessageKind::StateUpdate, &update).unwrap();
+        let (_, payload) = decode_envelope(&bytes).unwrap();
+        let decoded: StateUpdate = decode_payload(payload).unwrap();
+        assert_eq!(decoded.frame_stats, update.frame_stats);
+
+        let bare = StateUpdate {
+            frame_stats: None,
+            ..update
+        };
+        let bytes = encode_message(MessageKind::StateUpdate, &bare).unwrap();
+        let (_, payload) = decode_envelope(&bytes).unwrap();
+        let decoded: StateUpdate = decode_payload(payload).unwrap();
+        assert!(decoded.frame_stats.is_none());
+    }
 }
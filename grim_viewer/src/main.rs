@@ -12,6 +12,7 @@ mod display;
 mod layout;
 mod live_stream;
 mod movie;
+mod movie_audio;
 mod overlay;
 
 use anyhow::{Result, anyhow};
@@ -1094,10 +1095,19 @@ fn resolve_movie_path(install_root: &Path, start: &MovieStart) -> Result<PathBuf
         return Ok(fallback);
     }
 
+    // Retail installs only ship the original SMUSH movies, which decode natively.
+    let retail = install_root
+        .join("Movies")
+        .join(format!("{fallback_name}.snm"));
+    if retail.is_file() {
+        return Ok(retail);
+    }
+
     Err(anyhow!(
-        "movie {} missing relative path and fallback {} not found",
+        "movie {} missing relative path and fallbacks {} / {} not found",
         start.name,
-        fallback.display()
+        fallback.display(),
+        retail.display()
     ))
 }
 
@@ -1155,6 +1165,7 @@ fn pump_movie_playback(
 
                 let upload_ms = upload_start.elapsed().as_secs_f64() * 1000.0;
                 active.record_upload(viewer, upload_ms, Instant::now());
+                active.playback.recycle(frame);
                 outcome.needs_redraw = true;
                 continue;
             } else if let Some(deadline) = active.pending_deadline() {
@@ -1189,6 +1200,7 @@ fn pump_movie_playback(
 
                             let upload_ms = upload_start.elapsed().as_secs_f64() * 1000.0;
                             active.record_upload(viewer, upload_ms, Instant::now());
+                            active.playback.recycle(frame);
                             outcome.needs_redraw = true;
                         }
                         FrameSchedule::Deferred(deadline) => {
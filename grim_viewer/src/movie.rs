@@ -10,7 +10,8 @@ use std::time::{Duration, Instant};
 
 use anyhow::{Context, Result, anyhow};
 use crossbeam_channel;
-use crossbeam_channel::{Receiver, Sender};
+use crossbeam_channel::{Receiver, RecvTimeoutError, Sender};
+use grim_formats::SnmFile;
 use gstreamer as gst;
 use gstreamer::prelude::*;
 use gstreamer_app::{AppSink, AppSinkCallbacks};
@@ -18,6 +19,8 @@ use gstreamer_video::VideoInfo;
 use image::codecs::png::PngEncoder;
 use image::{ColorType, ImageEncoder};
 
+use crate::movie_audio::{self, AudioSync, MovieAudio};
+
 #[derive(Debug, Clone)]
 pub struct MovieFrame {
     pub width: u32,
@@ -37,6 +40,14 @@ pub enum MoviePlaybackEvent {
 
 static FRAME_DUMP_CONFIG: OnceLock<FrameDumpConfig> = OnceLock::new();
 const MOVIE_EVENT_QUEUE_DEPTH: usize = 8;
+// Frame buffers waiting to be reused; a couple beyond the queue covers the
+// frame being presented and one held by the viewer's scheduler.
+const MOVIE_FRAME_POOL_DEPTH: usize = MOVIE_EVENT_QUEUE_DEPTH + 2;
+// Upper bound on how long the native worker sleeps between audio clock checks.
+const NATIVE_AUDIO_SYNC_POLL: Duration = Duration::from_millis(5);
+/// Frame intervals the audio clock may stand still before video falls back
+/// to wall-clock pacing.
+const NATIVE_AUDIO_STALL_FRAMES: u32 = 4;
 // Treat the pipeline as complete if no video frames arrive within this window.
 const VIDEO_IDLE_EOS_THRESHOLD: Duration = Duration::from_millis(250);
 
@@ -288,6 +299,7 @@ enum MoviePlayerCommand {
 pub struct MoviePlayback {
     events: Receiver<MoviePlaybackEvent>,
     commands: Sender<MoviePlayerCommand>,
+    recycled: Sender<Vec<u8>>,
     join: Option<thread::JoinHandle<()>>,
 }
 
@@ -300,8 +312,18 @@ impl MoviePlayback {
 
         let (event_tx, event_rx) = crossbeam_channel::bounded(MOVIE_EVENT_QUEUE_DEPTH);
         let (command_tx, command_rx) = crossbeam_channel::unbounded();
+        // Only the native worker reuses buffers; for the others the receiver
+        // is dropped here and recycled frames are simply freed.
+        let (recycle_tx, recycle_rx) = crossbeam_channel::bounded(MOVIE_FRAME_POOL_DEPTH);
 
-        let handle = if use_ffmpeg_decoder() {
+        let handle = if use_native_decoder(&movie_path) {
+            thread::Builder::new()
+                .name("grim_movie_native".to_string())
+                .spawn(move || {
+                    run_native_pipeline(movie_path, event_tx.clone(), command_rx, recycle_rx)
+                })
+                .context("failed to spawn native movie playback thread")?
+        } else if use_ffmpeg_decoder() {
             thread::Builder::new()
                 .name("grim_movie_ffmpeg".to_string())
                 .spawn(move || run_ffmpeg_pipeline(movie_path, event_tx.clone(), command_rx))
@@ -317,6 +339,7 @@ impl MoviePlayback {
         Ok(Self {
             events: event_rx,
             commands: command_tx,
+            recycled: recycle_tx,
             join: Some(handle),
         })
     }
@@ -325,6 +348,11 @@ impl MoviePlayback {
         self.events.try_recv()
     }
 
+    /// Hand a presented frame's buffer back to the decoder for reuse.
+    pub fn recycle(&self, frame: MovieFrame) {
+        let _ = self.recycled.try_send(frame.pixels);
+    }
+
     pub fn skip(&self) {
         let _ = self
             .commands
@@ -363,6 +391,208 @@ fn use_ffmpeg_decoder() -> bool {
     )
 }
 
+/// Retail SMUSH movies decode in-process unless a specific backend is forced
+/// through `GRIM_MOVIE_DECODER`.
+fn use_native_decoder(path: &Path) -> bool {
+    let is_snm = path
+        .extension()
+        .and_then(|ext| ext.to_str())
+        .map(|ext| ext.eq_ignore_ascii_case("snm"))
+        .unwrap_or(false);
+    let forced_external = matches!(
+        std::env::var("GRIM_MOVIE_DECODER")
+            .unwrap_or_default()
+            .to_ascii_lowercase()
+            .as_str(),
+        "ffmpeg" | "1" | "true" | "gstreamer"
+    );
+    is_snm && !forced_external
+}
+
+fn run_native_pipeline(
+    path: PathBuf,
+    event_tx: Sender<MoviePlaybackEvent>,
+    command_rx: Receiver<MoviePlayerCommand>,
+    recycle_rx: Receiver<Vec<u8>>,
+) {
+    if let Err(err) = run_native_pipeline_inner(&path, event_tx.clone(), command_rx, recycle_rx) {
+        let _ = event_tx.send(MoviePlaybackEvent::Error(err.to_string()));
+    }
+}
+
+/// Decode SNM/Blocky16 frames directly with `grim_formats`.
+///
+/// The bounded event channel acts as the ring of pre-decoded frames: the
+/// worker runs at most `MOVIE_EVENT_QUEUE_DEPTH` frames ahead of the viewer,
+/// which paces presentation from the timestamps derived from the SNM header.
+/// When the soundtrack is being played (see `movie_audio`), each frame is
+/// held back until the audio clock reaches its timestamp instead. Pixel
+/// buffers come back from the viewer through `recycle_rx` once presented.
+fn run_native_pipeline_inner(
+    path: &Path,
+    event_tx: Sender<MoviePlaybackEvent>,
+    command_rx: Receiver<MoviePlayerCommand>,
+    recycle_rx: Receiver<Vec<u8>>,
+) -> Result<()> {
+    let movie = SnmFile::open_mmap(path)?;
+    let header = *movie.header();
+    let width = u32::from(header.width);
+    let height = u32::from(header.height);
+    let stride_bytes = movie.blocky16_rgba_len() / header.height.max(1) as usize;
+    let frame_interval = header.frame_interval();
+    let mut decoder = movie
+        .blocky16_decoder()
+        .with_context(|| anyhow!("failed to create Blocky16 decoder for {:?}", path))?;
+
+    println!(
+        "[grim_viewer] native SNM pipeline decoding {} ({}x{}, {} frames, interval={:?})",
+        path.display(),
+        width,
+        height,
+        movie.frame_count(),
+        frame_interval
+    );
+
+    let mut audio = match (movie.audio(), movie_audio::wav_path_from_env(path)) {
+        (Some(info), Some(wav_path)) => {
+            println!(
+                "[grim_viewer] native SNM audio {} Hz x{} -> {}",
+                info.sample_rate,
+                info.channels,
+                wav_path.display()
+            );
+            Some(MovieAudio::start(info, wav_path)?)
+        }
+        _ => None,
+    };
+
+    let frame_pool = FramePool {
+        returned: recycle_rx,
+        len: movie.blocky16_rgba_len(),
+    };
+    let mut audio_sync = AudioSync::new(
+        frame_interval.unwrap_or(NATIVE_AUDIO_SYNC_POLL) * NATIVE_AUDIO_STALL_FRAMES,
+    );
+    let mut frames_sent: u64 = 0;
+    for view in movie.frames() {
+        if let Some(audio) = audio.as_mut() {
+            audio.queue_frame(&view)?;
+        }
+
+        if view.blocky16.is_none() {
+            continue;
+        }
+        let mut pixels = frame_pool.take();
+        view.decode_blocky16_rgba(&mut decoder, &mut pixels)
+            .with_context(|| anyhow!("failed to decode SNM frame {}", view.index))?;
+
+        maybe_dump_decoded_frame(
+            "native",
+            path,
+            frames_sent,
+            width,
+            height,
+            stride_bytes,
+            &pixels,
+        );
+
+        let frame = MovieFrame {
+            width,
+            height,
+            stride: stride_bytes as u32,
+            pixels,
+            timestamp: frame_interval.map(|interval| interval.mul_f64(f64::from(view.index))),
+        };
+
+        // Slave video to the audio clock: hold the frame until its timestamp
+        // has been played, still honouring stop requests while waiting. If
+        // the soundtrack stops short, `AudioSync` paces by wall time instead.
+        if let (Some(audio), Some(timestamp)) = (audio.as_ref(), frame.timestamp) {
+            let stop =
+                audio_sync.wait_until(audio.clock(), timestamp, NATIVE_AUDIO_SYNC_POLL, |wait| {
+                    match command_rx.recv_timeout(wait) {
+                        Ok(command) => Some(Ok(command)),
+                        Err(RecvTimeoutError::Timeout) => None,
+                        Err(RecvTimeoutError::Disconnected) => Some(Err(())),
+                    }
+                });
+            if let Some(command) = stop {
+                return stop_native_pipeline(path, &event_tx, command);
+            }
+        }
+
+        // Block on whichever comes first: room in the ring or a stop request.
+        crossbeam_channel::select! {
+            send(event_tx, MoviePlaybackEvent::Frame(frame)) -> result => {
+                if let Err(err) = result {
+                    return Err(anyhow!("failed to forward native frame: {err:?}"));
+                }
+            }
+            recv(command_rx) -> command => {
+                return stop_native_pipeline(path, &event_tx, command.map_err(|_| ()));
+            }
+        }
+        frames_sent = frames_sent.saturating_add(1);
+    }
+
+    if let Some(audio) = audio {
+        let stats = audio.finish()?;
+        println!(
+            "[grim_viewer] native SNM audio wrote {} frames plus {} of underrun silence",
+            stats.frames_written, stats.underrun_frames
+        );
+    }
+
+    println!(
+        "[grim_viewer] native SNM pipeline reached end {} (frames={})",
+        path.display(),
+        frames_sent
+    );
+    let _ = event_tx.send(MoviePlaybackEvent::Finished);
+    Ok(())
+}
+
+/// RGBA buffers for the native pipeline, reusing the ones the viewer has
+/// handed back before allocating.
+struct FramePool {
+    returned: Receiver<Vec<u8>>,
+    len: usize,
+}
+
+impl FramePool {
+    fn take(&self) -> Vec<u8> {
+        while let Ok(buffer) = self.returned.try_recv() {
+            if buffer.len() == self.len {
+                return buffer;
+            }
+        }
+        vec![0u8; self.len]
+    }
+}
+
+fn stop_native_pipeline(
+    path: &Path,
+    event_tx: &Sender<MoviePlaybackEvent>,
+    command: Result<MoviePlayerCommand, ()>,
+) -> Result<()> {
+    match command {
+        Ok(MoviePlayerCommand::Stop(MovieStopReason::Skipped)) => {
+            println!(
+                "[grim_viewer] native SNM pipeline skip requested {}",
+                path.display()
+            );
+            let _ = event_tx.send(MoviePlaybackEvent::Skipped);
+        }
+        Ok(MoviePlayerCommand::Stop(MovieStopReason::Shutdown)) | Err(()) => {
+            println!(
+                "[grim_viewer] native SNM pipeline shutdown {}",
+                path.display()
+            );
+        }
+    }
+    Ok(())
+}
+
 fn run_ffmpeg_pipeline(
     path: PathBuf,
     event_tx: Sender<MoviePlaybackEvent>,
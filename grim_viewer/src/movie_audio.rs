@@ -0,0 +1,621 @@
+//! Audio path for native SNM playback.
+//!
+//! The movie worker decodes VIMA `Wave` chunks and pushes interleaved PCM into
+//! a lock-free single-producer/single-consumer ring. An output sink drains the
+//! ring at the device rate and advances an [`AudioClock`]; video frames are
+//! released against that clock so picture follows sound, falling back to wall
+//! time while the clock stands still (see [`AudioSync`]). The viewer has no
+//! audio device yet, so the only sink is a headless one that writes the
+//! stream to a WAV file in real time (`GRIM_MOVIE_AUDIO_WAV`).
+
+use std::cell::UnsafeCell;
+use std::fs::File;
+use std::io::{BufWriter, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use anyhow::{Context, Result};
+use grim_formats::{SnmAudioInfo, SnmFrameView, VimaDecoder};
+
+/// Sink period: how much audio is consumed per wake-up.
+const SINK_PERIOD: Duration = Duration::from_millis(10);
+/// Ring depth in seconds of audio; video waits on the clock, so this only
+/// has to absorb decode jitter.
+const RING_SECONDS: usize = 2;
+
+/// Destination for the headless sink: `GRIM_MOVIE_AUDIO_WAV` names a WAV file,
+/// or a directory that receives `<movie>.wav`.
+pub fn wav_path_from_env(movie_path: &Path) -> Option<PathBuf> {
+    let target = PathBuf::from(std::env::var_os("GRIM_MOVIE_AUDIO_WAV")?);
+    if target.is_dir() {
+        let stem = movie_path
+            .file_stem()
+            .and_then(|stem| stem.to_str())
+            .unwrap_or("movie");
+        Some(target.join(format!("{stem}.wav")))
+    } else {
+        Some(target)
+    }
+}
+
+/// Decoder, ring and sink for one movie's soundtrack.
+pub struct MovieAudio {
+    decoder: VimaDecoder,
+    channels: usize,
+    producer: RingProducer,
+    clock: Arc<AudioClock>,
+    sink: WavSink,
+    scratch: Vec<i16>,
+}
+
+impl MovieAudio {
+    pub fn start(info: SnmAudioInfo, wav_path: PathBuf) -> Result<Self> {
+        let format = PcmFormat {
+            sample_rate: info.sample_rate,
+            channels: info.channels.clamp(1, 2) as u16,
+        };
+        let channels = usize::from(format.channels);
+        let (producer, consumer) =
+            sample_ring(format.sample_rate as usize * channels * RING_SECONDS);
+        let clock = Arc::new(AudioClock::new(format.sample_rate));
+        let sink = WavSink::spawn(wav_path, format, consumer, clock.clone())?;
+        Ok(Self {
+            decoder: VimaDecoder::new(),
+            channels,
+            producer,
+            clock,
+            sink,
+            scratch: Vec::new(),
+        })
+    }
+
+    pub fn clock(&self) -> &AudioClock {
+        &self.clock
+    }
+
+    /// Decode the frame's `Wave` chunk (if any) and queue it for the sink,
+    /// waiting for ring space when the sink falls behind.
+    pub fn queue_frame(&mut self, frame: &SnmFrameView<'_>) -> Result<()> {
+        self.scratch.clear();
+        frame
+            .decode_wave(&self.decoder, self.channels, &mut self.scratch)
+            .with_context(|| format!("failed to decode audio for SNM frame {}", frame.index))?;
+        let mut queued = 0;
+        while queued < self.scratch.len() {
+            queued += self.producer.push(&self.scratch[queued..]);
+            if queued < self.scratch.len() {
+                // A full ring only drains while the sink is alive.
+                self.sink.ensure_running()?;
+                thread::sleep(SINK_PERIOD / 2);
+            }
+        }
+        Ok(())
+    }
+
+    /// Drain the queued audio and finalise the WAV file.
+    pub fn finish(self) -> Result<WavSinkStats> {
+        self.sink.join()
+    }
+}
+
+struct RingShared {
+    slots: Box<[UnsafeCell<i16>]>,
+    mask: usize,
+    /// Total samples written; only the producer stores.
+    head: AtomicUsize,
+    /// Total samples read; only the consumer stores.
+    tail: AtomicUsize,
+}
+
+// SAFETY: a slot is only touched by the producer while it lies outside
+// `tail..head` and only by the consumer while inside it; the acquire/release
+// pairs on `head`/`tail` order those accesses.
+unsafe impl Sync for RingShared {}
+
+/// Create a ring holding at least `capacity` samples (rounded up to a power of two).
+pub fn sample_ring(capacity: usize) -> (RingProducer, RingConsumer) {
+    let capacity = capacity.max(2).next_power_of_two();
+    let shared = Arc::new(RingShared {
+        slots: (0..capacity).map(|_| UnsafeCell::new(0)).collect(),
+        mask: capacity - 1,
+        head: AtomicUsize::new(0),
+        tail: AtomicUsize::new(0),
+    });
+    (
+        RingProducer {
+            shared: shared.clone(),
+        },
+        RingConsumer { shared },
+    )
+}
+
+pub struct RingProducer {
+    shared: Arc<RingShared>,
+}
+
+impl RingProducer {
+    /// Copy as many samples as fit; returns how many were written.
+    pub fn push(&mut self, samples: &[i16]) -> usize {
+        let shared = &*self.shared;
+        let head = shared.head.load(Ordering::Relaxed);
+        let tail = shared.tail.load(Ordering::Acquire);
+        let free = shared.slots.len() - head.wrapping_sub(tail);
+        let count = free.min(samples.len());
+        for (offset, &sample) in samples[..count].iter().enumerate() {
+            let slot = &shared.slots[head.wrapping_add(offset) & shared.mask];
+            // SAFETY: the slot is free (outside `tail..head`), see `RingShared`.
+            unsafe { *slot.get() = sample };
+        }
+        shared
+            .head
+            .store(head.wrapping_add(count), Ordering::Release);
+        count
+    }
+}
+
+pub struct RingConsumer {
+    shared: Arc<RingShared>,
+}
+
+impl RingConsumer {
+    pub fn is_empty(&self) -> bool {
+        let shared = &*self.shared;
+        shared.head.load(Ordering::Acquire) == shared.tail.load(Ordering::Relaxed)
+    }
+
+    /// Copy up to `out.len()` queued samples; returns how many were read.
+    pub fn pop(&mut self, out: &mut [i16]) -> usize {
+        let shared = &*self.shared;
+        let tail = shared.tail.load(Ordering::Relaxed);
+        let head = shared.head.load(Ordering::Acquire);
+        let count = head.wrapping_sub(tail).min(out.len());
+        for (offset, sample) in out[..count].iter_mut().enumerate() {
+            let slot = &shared.slots[tail.wrapping_add(offset) & shared.mask];
+            // SAFETY: the slot is filled (inside `tail..head`), see `RingShared`.
+            *sample = unsafe { *slot.get() };
+        }
+        shared
+            .tail
+            .store(tail.wrapping_add(count), Ordering::Release);
+        count
+    }
+}
+
+/// Playback position in sample frames, advanced by the audio sink.
+#[derive(Debug)]
+pub struct AudioClock {
+    sample_rate: u32,
+    frames_played: AtomicU64,
+}
+
+impl AudioClock {
+    pub fn new(sample_rate: u32) -> Self {
+        Self {
+            sample_rate: sample_rate.max(1),
+            frames_played: AtomicU64::new(0),
+        }
+    }
+
+    pub fn advance(&self, frames: u64) {
+        self.frames_played.fetch_add(frames, Ordering::Release);
+    }
+
+    pub fn position(&self) -> Duration {
+        let frames = self.frames_played.load(Ordering::Acquire);
+        Duration::from_secs(frames / u64::from(self.sample_rate))
+            + Duration::from_nanos(
+                (frames % u64::from(self.sample_rate)) * 1_000_000_000
+                    / u64::from(self.sample_rate),
+            )
+    }
+}
+
+/// Releases video frames against an [`AudioClock`].
+///
+/// When the clock stops moving for `stall_limit` (the soundtrack ended, has
+/// not started yet, or ran dry), frames are paced by wall time from the last
+/// audio position until the clock moves again, so a short or missing
+/// soundtrack cannot hold the picture forever.
+#[derive(Debug)]
+pub struct AudioSync {
+    stall_limit: Duration,
+    last_position: Duration,
+    last_moved: Instant,
+}
+
+impl AudioSync {
+    pub fn new(stall_limit: Duration) -> Self {
+        Self {
+            stall_limit,
+            last_position: Duration::ZERO,
+            last_moved: Instant::now(),
+        }
+    }
+
+    /// Time left until the frame at `timestamp` is due; zero once it is.
+    fn remaining(&mut self, clock: &AudioClock, timestamp: Duration, now: Instant) -> Duration {
+        let position = clock.position();
+        if position != self.last_position {
+            self.last_position = position;
+            self.last_moved = now;
+        }
+        let stalled = now.saturating_duration_since(self.last_moved);
+        if stalled < self.stall_limit {
+            // Look again when the stall would switch to wall-clock pacing.
+            return timestamp
+                .saturating_sub(position)
+                .min(self.stall_limit - stalled);
+        }
+        timestamp.saturating_sub(position + stalled)
+    }
+
+    /// Blocks until the frame at `timestamp` is due. `wait` sleeps for at
+    /// most the given time (never more than `poll`) and returns `Some` to
+    /// abandon the wait, e.g. for a stop request.
+    pub fn wait_until<T>(
+        &mut self,
+        clock: &AudioClock,
+        timestamp: Duration,
+        poll: Duration,
+        mut wait: impl FnMut(Duration) -> Option<T>,
+    ) -> Option<T> {
+        loop {
+            let remaining = self.remaining(clock, timestamp, Instant::now());
+            if remaining.is_zero() {
+                return None;
+            }
+            if let Some(stop) = wait(remaining.min(poll)) {
+                return Some(stop);
+            }
+        }
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+pub struct PcmFormat {
+    pub sample_rate: u32,
+    pub channels: u16,
+}
+
+/// Headless sink: drains the ring at the stream rate into a WAV file, padding
+/// underruns with silence the way a real device would.
+///
+/// The clock only counts samples taken from the ring, so it stalls rather than
+/// runs ahead while the decoder is behind, and the period schedule starts with
+/// the first queued sample rather than when the sink is spawned.
+pub struct WavSink {
+    finished: Arc<AtomicBool>,
+    join: Option<thread::JoinHandle<Result<WavSinkStats>>>,
+}
+
+#[derive(Debug, Default, Clone, Copy)]
+pub struct WavSinkStats {
+    /// Sample frames taken from the ring; the clock has advanced by exactly this.
+    pub frames_written: u64,
+    /// Silent frames written to cover underruns.
+    pub underrun_frames: u64,
+}
+
+impl WavSink {
+    pub fn spawn(
+        path: PathBuf,
+        format: PcmFormat,
+        consumer: RingConsumer,
+        clock: Arc<AudioClock>,
+    ) -> Result<Self> {
+        let finished = Arc::new(AtomicBool::new(false));
+        let thread_finished = finished.clone();
+        let join = thread::Builder::new()
+            .name("grim_movie_audio".to_string())
+            .spawn(move || run_wav_sink(&path, format, consumer, &clock, &thread_finished))
+            .context("failed to spawn movie audio sink thread")?;
+        Ok(Self {
+            finished,
+            join: Some(join),
+        })
+    }
+
+    /// Errors if the sink thread has exited before being told to finish,
+    /// returning its error when it failed.
+    pub fn ensure_running(&mut self) -> Result<()> {
+        if self.join.as_ref().is_some_and(|join| !join.is_finished()) {
+            return Ok(());
+        }
+        match self.join.take().map(|join| join.join()) {
+            Some(Ok(Err(err))) => Err(err.context("movie audio sink failed")),
+            Some(Err(_)) => Err(anyhow::anyhow!("movie audio sink thread panicked")),
+            Some(Ok(Ok(_))) | None => Err(anyhow::anyhow!("movie audio sink stopped")),
+        }
+    }
+
+    /// Signal end of stream; the sink drains what is queued and stops.
+    pub fn finish(&self) {
+        self.finished.store(true, Ordering::Release);
+    }
+
+    /// Finish and wait for the WAV file to be finalised.
+    pub fn join(mut self) -> Result<WavSinkStats> {
+        self.finish();
+        match self.join.take().map(|join| join.join()) {
+            Some(Ok(result)) => result,
+            Some(Err(_)) => Err(anyhow::anyhow!("movie audio sink thread panicked")),
+            None => Ok(WavSinkStats::default()),
+        }
+    }
+}
+
+impl Drop for WavSink {
+    fn drop(&mut self) {
+        self.finish();
+        if let Some(join) = self.join.take() {
+            let _ = join.join();
+        }
+    }
+}
+
+fn run_wav_sink(
+    path: &Path,
+    format: PcmFormat,
+    mut consumer: RingConsumer,
+    clock: &AudioClock,
+    finished: &AtomicBool,
+) -> Result<WavSinkStats> {
+    let file = File::create(path).with_context(|| format!("creating {}", path.display()))?;
+    let mut writer = BufWriter::new(file);
+    write_wav_header(&mut writer, format, 0)?;
+
+    let channels = usize::from(format.channels.max(1));
+    let period_frames =
+        ((u64::from(format.sample_rate) * SINK_PERIOD.as_micros() as u64) / 1_000_000).max(1);
+    let mut period = vec![0i16; period_frames as usize * channels];
+    let mut bytes = Vec::with_capacity(period.len() * 2);
+    let mut stats = WavSinkStats::default();
+
+    // Nothing to play until the first push; starting the schedule earlier
+    // would begin the stream with an underrun.
+    while consumer.is_empty() && !finished.load(Ordering::Acquire) {
+        thread::sleep(SINK_PERIOD / 4);
+    }
+    let started = Instant::now();
+    let mut periods: u32 = 0;
+
+    loop {
+        let deadline = started + SINK_PERIOD * periods;
+        if let Some(wait) = deadline.checked_duration_since(Instant::now()) {
+            thread::sleep(wait);
+        }
+        periods += 1;
+
+        // Read the flag before draining so samples pushed before `finish` are kept.
+        let done = finished.load(Ordering::Acquire);
+        let read = consumer.pop(&mut period);
+        let frames = read / channels;
+        if frames == 0 && done {
+            break;
+        }
+        let padded = if done {
+            frames
+        } else {
+            period[frames * channels..].fill(0);
+            stats.underrun_frames += period_frames - frames as u64;
+            period_frames as usize
+        };
+
+        bytes.clear();
+        for sample in &period[..padded * channels] {
+            bytes.extend_from_slice(&sample.to_le_bytes());
+        }
+        writer
+            .write_all(&bytes)
+            .with_context(|| format!("writing {}", path.display()))?;
+        stats.frames_written += frames as u64;
+        clock.advance(frames as u64);
+    }
+
+    let data_len = (stats.frames_written + stats.underrun_frames) * channels as u64 * 2;
+    writer
+        .seek(SeekFrom::Start(0))
+        .with_context(|| format!("finalising {}", path.display()))?;
+    write_wav_header(&mut writer, format, data_len as u32)?;
+    writer
+        .flush()
+        .with_context(|| format!("finalising {}", path.display()))?;
+    Ok(stats)
+}
+
+/// 44-byte canonical PCM16 header.
+fn write_wav_header<W: Write>(writer: &mut W, format: PcmFormat, data_len: u32) -> Result<()> {
+    let block_align = format.channels * 2;
+    let mut header = Vec::with_capacity(44);
+    header.extend_from_slice(b"RIFF");
+    header.extend_from_slice(&(36 + data_len).to_le_bytes());
+    header.extend_from_slice(b"WAVEfmt ");
+    header.extend_from_slice(&16u32.to_le_bytes());
+    header.extend_from_slice(&1u16.to_le_bytes());
+    header.extend_from_slice(&format.channels.to_le_bytes());
+    header.extend_from_slice(&format.sample_rate.to_le_bytes());
+    header.extend_from_slice(&(format.sample_rate * u32::from(block_align)).to_le_bytes());
+    header.extend_from_slice(&block_align.to_le_bytes());
+    header.extend_from_slice(&16u16.to_le_bytes());
+    header.extend_from_slice(b"data");
+    header.extend_from_slice(&data_len.to_le_bytes());
+    writer
+        .write_all(&header)
+        .context("failed to write WAV header")
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn ring_wraps_and_reports_partial_transfers() {
+        let (mut producer, mut consumer) = sample_ring(6);
+        assert_eq!(producer.push(&[1, 2, 3, 4, 5, 6, 7, 8, 9]), 8);
+        let mut out = [0i16; 5];
+        assert_eq!(consumer.pop(&mut out), 5);
+        assert_eq!(out, [1, 2, 3, 4, 5]);
+        assert_eq!(producer.push(&[10, 11, 12, 13, 14, 15]), 5);
+        let mut rest = [0i16; 16];
+        assert_eq!(consumer.pop(&mut rest), 8);
+        assert_eq!(&rest[..8], &[6, 7, 8, 10, 11, 12, 13, 14]);
+        assert_eq!(consumer.pop(&mut rest), 0);
+    }
+
+    #[test]
+    fn ring_transfers_across_threads_in_order() {
+        let (mut producer, mut consumer) = sample_ring(64);
+        let writer = thread::spawn(move || {
+            let samples: Vec<i16> = (0..10_000).map(|value| value as i16).collect();
+            let mut sent = 0;
+            while sent < samples.len() {
+                sent += producer.push(&samples[sent..]);
+                thread::yield_now();
+            }
+        });
+        let mut received = Vec::new();
+        let mut chunk = [0i16; 37];
+        while received.len() < 10_000 {
+            let read = consumer.pop(&mut chunk);
+            received.extend_from_slice(&chunk[..read]);
+            thread::yield_now();
+        }
+        writer.join().unwrap();
+        assert!(received.iter().enumerate().all(|(i, &v)| v == i as i16));
+    }
+
+    #[test]
+    fn wav_sink_writes_stream_and_advances_clock() {
+        let path =
+            std::env::temp_dir().join(format!("grim_viewer_wav_sink_{}.wav", std::process::id()));
+        let format = PcmFormat {
+            sample_rate: 8_000,
+            channels: 2,
+        };
+        let (mut producer, consumer) = sample_ring(4_096);
+        let clock = Arc::new(AudioClock::new(format.sample_rate));
+        let samples: Vec<i16> = (0..800).map(|value| value as i16).collect();
+        assert_eq!(producer.push(&samples), samples.len());
+
+        let sink = WavSink::spawn(path.clone(), format, consumer, clock.clone()).unwrap();
+        let stats = sink.join().unwrap();
+        assert_eq!(stats.frames_written, 400);
+        assert_eq!(clock.position(), Duration::from_millis(50));
+
+        let bytes = std::fs::read(&path).unwrap();
+        let _ = std::fs::remove_file(&path);
+        assert_eq!(&bytes[0..4], b"RIFF");
+        assert_eq!(u32::from_le_bytes(bytes[40..44].try_into().unwrap()), 1_600);
+        assert_eq!(bytes.len(), 44 + 1_600);
+        assert_eq!(i16::from_le_bytes([bytes[46], bytes[47]]), 1);
+    }
+
+    #[test]
+    fn wav_sink_clock_skips_underrun_padding() {
+        let path = std::env::temp_dir().join(format!(
+            "grim_viewer_wav_underrun_{}.wav",
+            std::process::id()
+        ));
+        let format = PcmFormat {
+            sample_rate: 8_000,
+            channels: 2,
+        };
+        let (mut producer, consumer) = sample_ring(4_096);
+        let clock = Arc::new(AudioClock::new(format.sample_rate));
+        let sink = WavSink::spawn(path.clone(), format, consumer, clock.clone()).unwrap();
+
+        // Nothing is played before the first push.
+        thread::sleep(SINK_PERIOD * 3);
+        assert_eq!(clock.position(), Duration::ZERO);
+
+        // One period of audio, then a gap of several periods.
+        let period: Vec<i16> = (0..160).map(|value| value as i16).collect();
+        assert_eq!(producer.push(&period), period.len());
+        thread::sleep(SINK_PERIOD * 4);
+        assert_eq!(clock.position(), Duration::from_millis(10));
+        assert_eq!(producer.push(&period), period.len());
+
+        let stats = sink.join().unwrap();
+        let _ = std::fs::remove_file(&path);
+        assert_eq!(stats.frames_written, 160);
+        assert!(stats.underrun_frames > 0);
+        assert_eq!(
+            clock.position(),
+            Duration::from_nanos(stats.frames_written * 1_000_000_000 / 8_000)
+        );
+    }
+
+    #[test]
+    fn video_outlasting_the_soundtrack_reaches_the_end() {
+        let path =
+            std::env::temp_dir().join(format!("grim_viewer_wav_short_{}.wav", std::process::id()));
+        let format = PcmFormat {
+            sample_rate: 8_000,
+            channels: 2,
+        };
+        let (mut producer, consumer) = sample_ring(4_096);
+        let clock = Arc::new(AudioClock::new(format.sample_rate));
+        // 50 ms of audio under 300 ms of video.
+        let samples = vec![0i16; 800];
+        assert_eq!(producer.push(&samples), samples.len());
+        let sink = WavSink::spawn(path.clone(), format, consumer, clock.clone()).unwrap();
+
+        let interval = Duration::from_millis(20);
+        let mut sync = AudioSync::new(interval * 4);
+        let started = Instant::now();
+        for index in 0..15 {
+            let stopped: Option<()> =
+                sync.wait_until(&clock, interval * index, SINK_PERIOD / 2, |wait| {
+                    thread::sleep(wait);
+                    None
+                });
+            assert!(stopped.is_none());
+        }
+        let elapsed = started.elapsed();
+
+        sink.join().unwrap();
+        let _ = std::fs::remove_file(&path);
+        assert_eq!(clock.position(), Duration::from_millis(50));
+        // Paced by the audio, then by wall time once it ran out.
+        assert!(elapsed >= Duration::from_millis(250), "{elapsed:?}");
+        assert!(elapsed < Duration::from_secs(2), "{elapsed:?}");
+    }
+
+    #[test]
+    fn audio_sync_wait_can_be_abandoned() {
+        let clock = AudioClock::new(8_000);
+        let mut sync = AudioSync::new(Duration::from_secs(60));
+        let mut polls = 0;
+        let stopped = sync.wait_until(&clock, Duration::from_secs(10), SINK_PERIOD, |wait| {
+            assert!(wait <= SINK_PERIOD);
+            polls += 1;
+            (polls == 3).then_some("stop")
+        });
+        assert_eq!(stopped, Some("stop"));
+        assert_eq!(polls, 3);
+    }
+
+    #[test]
+    fn sink_liveness_check_surfaces_its_error() {
+        let (_producer, consumer) = sample_ring(16);
+        let format = PcmFormat {
+            sample_rate: 8_000,
+            channels: 1,
+        };
+        let clock = Arc::new(AudioClock::new(format.sample_rate));
+        // A directory cannot be created as a file, so the sink exits with an error.
+        let mut sink = WavSink::spawn(std::env::temp_dir(), format, consumer, clock).unwrap();
+        let deadline = Instant::now() + Duration::from_secs(5);
+        let err = loop {
+            match sink.ensure_running() {
+                Err(err) => break err,
+                Ok(()) if Instant::now() < deadline => thread::sleep(SINK_PERIOD),
+                Ok(()) => panic!("sink kept running"),
+            }
+        };
+        assert!(format!("{err:#}").contains("movie audio sink failed"));
+    }
+}